@@ -0,0 +1,224 @@
+// Measures the bounding volume hierarchy over a field of randomly placed boxes: how long it takes
+// to build and to refit after the boxes move, and how long frustum culling, ray and point queries
+// take with it compared to testing every box. Also checks it gets the same answers as testing
+// every box
+//
+// Usage: bench_bvh [box count] [queries]
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <stdlib.h>
+
+#include <math.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bvh.h"
+#include "culling.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double microsecondsSince(Clock::time_point start)
+{
+    return chrono::duration<double, micro>(Clock::now() - start).count();
+}
+
+static float randomFloat(float low, float high)
+{
+    return low + (high - low)*(float)rand()/(float)RAND_MAX;
+}
+
+static bool boxOutside(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec4 planes[6])
+{
+    for(int i=0; i<6; i++)
+    {
+        glm::vec3 furthest((planes[i].x > 0.0f) ? boundsMax.x : boundsMin.x,
+                           (planes[i].y > 0.0f) ? boundsMax.y : boundsMin.y,
+                           (planes[i].z > 0.0f) ? boundsMax.z : boundsMin.z);
+        if(glm::dot(glm::vec3(planes[i]), furthest) + planes[i].w < 0.0f)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static float rayBox(const glm::vec3& origin, const glm::vec3& direction,
+                    const glm::vec3& boundsMin, const glm::vec3& boundsMax, float maxDistance)
+{
+    glm::vec3 t1 = (boundsMin - origin)/direction;
+    glm::vec3 t2 = (boundsMax - origin)/direction;
+    glm::vec3 entries = glm::min(t1, t2);
+    glm::vec3 exits = glm::max(t1, t2);
+    float entry = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+    float exit = std::min(std::min(exits.x, exits.y), std::min(exits.z, maxDistance));
+    return (entry <= exit) ? entry : maxDistance;
+}
+
+static glm::vec3 randomDirection()
+{
+    glm::vec3 direction(randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f));
+    return glm::normalize(direction + glm::vec3(1e-4f));
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = (argc > 1) ? atoi(argv[1]) : 100000;
+    int queries = (argc > 2) ? atoi(argv[2]) : 1000;
+    if((count == 0) || (queries <= 0))
+    {
+        cout << "Usage: bench_bvh [box count] [queries]" << endl;
+        return 1;
+    }
+
+    // Boxes spread through a 100 unit cube, like objects in a big scene
+    srand(1);
+    vector<glm::vec3> boundsMin(count), boundsMax(count);
+    for(size_t i=0; i<count; i++)
+    {
+        glm::vec3 center(randomFloat(-50.0f, 50.0f), randomFloat(-50.0f, 50.0f), randomFloat(-50.0f, 50.0f));
+        glm::vec3 halfSize(randomFloat(0.1f, 1.0f), randomFloat(0.1f, 1.0f), randomFloat(0.1f, 1.0f));
+        boundsMin[i] = center - halfSize;
+        boundsMax[i] = center + halfSize;
+    }
+
+    BoundingVolumeHierarchy bvh;
+    Clock::time_point start = Clock::now();
+    bvh.build(boundsMin.data(), boundsMax.data(), count);
+    double buildMicroseconds = microsecondsSince(start);
+
+    // Nudge a tenth of the boxes, as if their objects had been moved
+    for(size_t i=0; i<count; i+=10)
+    {
+        glm::vec3 offset(randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f));
+        boundsMin[i] += offset;
+        boundsMax[i] += offset;
+    }
+    start = Clock::now();
+    bvh.refit(boundsMin.data(), boundsMax.data());
+    double refitMicroseconds = microsecondsSince(start);
+
+    // Frustum culling from the middle of the field, against testing every box
+    glm::mat4 projection = glm::perspective(glm::radians(30.0f), 4.0f/3.0f, 0.1f, 100.0f);
+    vector<unsigned char> visible(count);
+    double bvhCullMicroseconds = 0.0;
+    double linearCullMicroseconds = 0.0;
+    size_t visibleTotal = 0;
+    bool valid = true;
+    int views = std::min(queries, 100);
+    for(int view=0; view<views; view++)
+    {
+        float angle = 2.0f*3.14159265f*view/views;
+        glm::mat4 viewMatrix = glm::lookAt(glm::vec3(0.0f), glm::vec3(cos(angle), 0.3f, sin(angle)),
+                                           glm::vec3(0,1,0));
+        glm::vec4 planes[6];
+        extractFrustumPlanes(projection*viewMatrix, planes);
+
+        start = Clock::now();
+        size_t visibleCount = bvh.cullFrustum(planes, visible.data());
+        bvhCullMicroseconds += microsecondsSince(start);
+
+        start = Clock::now();
+        size_t linearCount = 0;
+        bool matches = true;
+        for(size_t i=0; i<count; i++)
+        {
+            bool inside = !boxOutside(boundsMin[i], boundsMax[i], planes);
+            linearCount += inside;
+            matches = matches && (inside == (visible[i] != 0));
+        }
+        linearCullMicroseconds += microsecondsSince(start);
+        if(!matches || (linearCount != visibleCount))
+        {
+            cout << "Frustum culling differs from testing every box in view " << view << endl;
+            valid = false;
+        }
+        visibleTotal += visibleCount;
+    }
+
+    // Closest box along rays from random points in random directions
+    double bvhRayMicroseconds = 0.0;
+    double linearRayMicroseconds = 0.0;
+    const float maxDistance = 1000.0f;
+    int rayHits = 0;
+    for(int query=0; query<queries; query++)
+    {
+        glm::vec3 origin(randomFloat(-60.0f, 60.0f), randomFloat(-60.0f, 60.0f), randomFloat(-60.0f, 60.0f));
+        glm::vec3 direction = randomDirection();
+
+        start = Clock::now();
+        float distance;
+        int hit = bvh.raycast(origin, direction, maxDistance,
+            [&](unsigned int primitive, float closest)
+            {
+                return rayBox(origin, direction, boundsMin[primitive], boundsMax[primitive], closest);
+            }, &distance);
+        bvhRayMicroseconds += microsecondsSince(start);
+
+        start = Clock::now();
+        int linearHit = -1;
+        float linearDistance = maxDistance;
+        for(size_t i=0; i<count; i++)
+        {
+            float boxDistance = rayBox(origin, direction, boundsMin[i], boundsMax[i], linearDistance);
+            if(boxDistance < linearDistance)
+            {
+                linearDistance = boxDistance;
+                linearHit = i;
+            }
+        }
+        linearRayMicroseconds += microsecondsSince(start);
+        // NOTE: Boxes can overlap, so two can be hit at the same distance
+        if((hit < 0) != (linearHit < 0) || ((hit >= 0) && (distance != linearDistance)))
+        {
+            cout << "Ray " << query << " hits box " << hit << " at " << distance << " instead of box "
+                 << linearHit << " at " << linearDistance << endl;
+            valid = false;
+        }
+        rayHits += (hit >= 0);
+    }
+
+    // Boxes containing random points
+    double bvhPointMicroseconds = 0.0;
+    size_t pointHits = 0;
+    vector<unsigned int> found;
+    for(int query=0; query<queries; query++)
+    {
+        glm::vec3 point(randomFloat(-50.0f, 50.0f), randomFloat(-50.0f, 50.0f), randomFloat(-50.0f, 50.0f));
+        found.clear();
+        start = Clock::now();
+        bvh.queryPoint(point, &found);
+        bvhPointMicroseconds += microsecondsSince(start);
+
+        size_t expected = 0;
+        for(size_t i=0; i<count; i++)
+        {
+            expected += !glm::any(glm::lessThan(point, boundsMin[i])) &&
+                        !glm::any(glm::greaterThan(point, boundsMax[i]));
+        }
+        if(found.size() != expected)
+        {
+            cout << "Point " << query << " is in " << found.size() << " boxes instead of " << expected << endl;
+            valid = false;
+        }
+        pointHits += found.size();
+    }
+
+    cout << count << " boxes, " << bvh.nodeCount() << " nodes (" << bvh.nodeCount()*sizeof(BVHNode)/1024
+         << " KB)" << endl;
+    cout << "Build:   " << buildMicroseconds/1000.0 << " ms" << endl;
+    cout << "Refit:   " << refitMicroseconds/1000.0 << " ms" << endl;
+    cout << "Frustum: " << bvhCullMicroseconds/views << " us per view, testing every box "
+         << linearCullMicroseconds/views << " us (" << (double)visibleTotal/views << " visible)" << endl;
+    cout << "Ray:     " << bvhRayMicroseconds/queries << " us per ray, testing every box "
+         << linearRayMicroseconds/queries << " us (" << rayHits << " of " << queries << " hit)" << endl;
+    cout << "Point:   " << bvhPointMicroseconds/queries << " us per point (" << pointHits << " boxes found)"
+         << endl;
+    cout << (valid ? "Results match" : "Results DIFFER") << endl;
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// Measures frustum culling of bounding spheres: the SIMD test against the one-at-a-time version
+// over a field of randomly placed spheres, seen by a camera that turns around in the middle of
+// it. Also checks that both versions agree on every sphere
+//
+// Usage: bench_culling [sphere count] [iterations]
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <stdlib.h>
+
+#include <math.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "culling.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double microsecondsSince(Clock::time_point start)
+{
+    return chrono::duration<double, micro>(Clock::now() - start).count();
+}
+
+static float randomFloat(float low, float high)
+{
+    return low + (high - low)*(float)rand()/(float)RAND_MAX;
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = (argc > 1) ? atoi(argv[1]) : 100000;
+    int iterations = (argc > 2) ? atoi(argv[2]) : 100;
+    if((count == 0) || (iterations <= 0))
+    {
+        cout << "Usage: bench_culling [sphere count] [iterations]" << endl;
+        return 1;
+    }
+
+    // Spheres spread through a 100 unit cube, with the same projection as the viewer
+    srand(1);
+    vector<float> centerX(count), centerY(count), centerZ(count), radius(count);
+    for(size_t i=0; i<count; i++)
+    {
+        centerX[i] = randomFloat(-50.0f, 50.0f);
+        centerY[i] = randomFloat(-50.0f, 50.0f);
+        centerZ[i] = randomFloat(-50.0f, 50.0f);
+        radius[i] = randomFloat(0.1f, 1.0f);
+    }
+    glm::mat4 projection = glm::perspective(glm::radians(30.0f), 4.0f/3.0f, 0.1f, 100.0f);
+
+    vector<unsigned char> visible(count), visibleScalar(count);
+    double simdMicroseconds = 0.0;
+    double scalarMicroseconds = 0.0;
+    size_t visibleTotal = 0;
+    bool valid = true;
+    for(int iteration=0; iteration<iterations; iteration++)
+    {
+        float angle = 2.0f*3.14159265f*iteration/iterations;
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(cos(angle), 0.3f, sin(angle)),
+                                     glm::vec3(0,1,0));
+        glm::vec4 planes[6];
+        extractFrustumPlanes(projection*view, planes);
+
+        Clock::time_point start = Clock::now();
+        size_t visibleCount = cullSpheres(centerX.data(), centerY.data(), centerZ.data(),
+                                          radius.data(), count, planes, visible.data());
+        simdMicroseconds += microsecondsSince(start);
+
+        start = Clock::now();
+        size_t scalarCount = cullSpheresScalar(centerX.data(), centerY.data(), centerZ.data(),
+                                               radius.data(), count, planes, visibleScalar.data());
+        scalarMicroseconds += microsecondsSince(start);
+
+        if((visibleCount != scalarCount) || (visible != visibleScalar))
+        {
+            cout << "SIMD and scalar culling disagree on iteration " << iteration << endl;
+            valid = false;
+        }
+        visibleTotal += visibleCount;
+    }
+
+    double visibleAverage = (double)visibleTotal/iterations;
+    cout << count << " spheres, " << iterations << " views" << endl;
+    cout << "Visible " << visibleAverage << ", culled " << count - visibleAverage
+         << " per view" << endl;
+    cout << cullingInstructionSet() << ": " << simdMicroseconds/iterations << " us per view" << endl;
+    cout << "scalar: " << scalarMicroseconds/iterations << " us per view ("
+         << scalarMicroseconds/simdMicroseconds << "x slower)" << endl;
+    cout << (valid ? "Results match" : "Results DIFFER") << endl;
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,307 @@
+// Splits meshes into meshlets and measures how many triangles culling them discards from cameras
+// looking at the side of the object from all around it, next to how many triangles face away
+// from the camera (the most that backface culling could skip). Checks the meshlets keep every
+// triangle, stay within the vertex and triangle limits, and that every meshlet culled by its
+// cone really has only triangles facing away. Then builds them again with a few tighter cone
+// settings (see buildMeshlets), to show what the side views gain against how many more meshlets
+// it takes
+//
+// Usage: bench_meshlets <path of an object> [more objects...]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <set>
+
+#include <math.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "geometry.h"
+#include "meshlets.h"
+#include "culling.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static const int VIEW_COUNT = 8;
+
+// Cone settings tried after the defaults, as (cone weight, min join dot) pairs
+static const float CONE_SETTINGS[][2] = {{0.5f, 0.5f}, {0.5f, 0.7f}, {16.0f, 0.6f}, {16.0f, 0.8f},
+                                         {16.0f, 0.9f}};
+static const int CONE_SETTING_COUNT = sizeof(CONE_SETTINGS)/sizeof(CONE_SETTINGS[0]);
+
+static vector<unsigned int> sortedTriangles(const vector<unsigned int>& indices)
+{
+    vector<unsigned int> triangles(indices);
+    for(size_t i=0; i<triangles.size(); i+=3)
+    {
+        // Rotate each triangle to start at its smallest index, which keeps its winding
+        unsigned int* t = &triangles[i];
+        rotate(t, min_element(t, t + 3), t + 3);
+    }
+    vector<unsigned long long> keys;
+    for(size_t i=0; i<triangles.size(); i+=3)
+    {
+        keys.push_back(((unsigned long long)triangles[i] << 42) |
+                       ((unsigned long long)triangles[i+1] << 21) | triangles[i+2]);
+    }
+    sort(keys.begin(), keys.end());
+    vector<unsigned int> result;
+    for(size_t i=0; i<keys.size(); i++)
+    {
+        result.push_back(keys[i] >> 42);
+        result.push_back((keys[i] >> 21) & 0x1fffff);
+        result.push_back(keys[i] & 0x1fffff);
+    }
+    return result;
+}
+
+// Whether the triangle faces away from (or is edge on to) the camera
+static bool facesAway(const unsigned int* triangle, const float* positions, const glm::vec3& camera)
+{
+    glm::vec3 p0(positions[3*triangle[0]], positions[3*triangle[0]+1], positions[3*triangle[0]+2]);
+    glm::vec3 p1(positions[3*triangle[1]], positions[3*triangle[1]+1], positions[3*triangle[1]+2]);
+    glm::vec3 p2(positions[3*triangle[2]], positions[3*triangle[2]+1], positions[3*triangle[2]+2]);
+    glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+    // A little slack for rounding, relative to the size of the triangle and its distance
+    return glm::dot(p0 - camera, normal) >= -1e-5f*glm::length(normal)*glm::length(p0 - camera);
+}
+
+// Averages over cameras looking at the side of the object from all around it
+struct SideViews
+{
+    double culled;//percent of triangles culled by the frustum and cones together
+    double coneCulled;//the part of that the cones culled
+    double backfacing;//percent of triangles facing away
+    double cullMicroseconds;//for all the views
+    bool valid;//whether every meshlet culled by its cone had only triangles facing away
+};
+
+static SideViews cullFromSide(GeometryData& geometry, const vector<unsigned int>& indices,
+                              const vector<Meshlet>& meshlets, bool printViews)
+{
+    // The viewer's lens (30 degrees, 4:3), far enough back that the whole object is in view, so
+    // that what's culled is down to the cones rather than the frustum
+    glm::mat4 projection = glm::perspective(glm::radians(30.0f), 4.0f/3.0f, 0.1f, 1000.0f);
+    glm::vec3 center = 0.5f*(glm::make_vec3(geometry.boundsMin()) +
+                             glm::make_vec3(geometry.boundsMax()));
+    float distance = geometry.boundingRadius()/sinf(glm::radians(15.0f));
+    vector<unsigned char> visible(meshlets.size());
+    vector<unsigned char> inFrustum(meshlets.size());
+    vector<float> centerX;
+    vector<float> centerY;
+    vector<float> centerZ;
+    vector<float> radius;
+    for(size_t m=0; m<meshlets.size(); m++)
+    {
+        centerX.push_back(meshlets[m].center[0]);
+        centerY.push_back(meshlets[m].center[1]);
+        centerZ.push_back(meshlets[m].center[2]);
+        radius.push_back(meshlets[m].radius);
+    }
+    SideViews side;
+    side.culled = 0.0;
+    side.coneCulled = 0.0;
+    side.backfacing = 0.0;
+    side.cullMicroseconds = 0.0;
+    side.valid = true;
+    size_t indexCount = indices.size();
+    const float* positions = (const float*)geometry.vertexData();
+    for(int view=0; view<VIEW_COUNT; view++)
+    {
+        float angle = 2.0f*3.14159265f*view/VIEW_COUNT;
+        glm::vec3 camera = center + distance*glm::vec3(cos(angle), 0.0f, sin(angle));
+        glm::mat4 viewProjection = projection*glm::lookAt(camera, center, glm::vec3(0,1,0));
+        glm::vec4 planes[6];
+        extractFrustumPlanes(viewProjection, planes);
+
+        Clock::time_point start = Clock::now();
+        cullMeshlets(meshlets.data(), meshlets.size(), planes, camera, visible.data());
+        side.cullMicroseconds += chrono::duration<double, micro>(Clock::now() - start).count();
+
+        // The spheres alone, to tell what the cones added
+        cullSpheres(centerX.data(), centerY.data(), centerZ.data(), radius.data(), meshlets.size(),
+                    planes, inFrustum.data());
+        size_t culledTriangles = 0;
+        size_t coneCulledTriangles = 0;
+        for(size_t m=0; m<meshlets.size(); m++)
+        {
+            if(visible[m])
+            {
+                continue;
+            }
+            culledTriangles += meshlets[m].triangleCount;
+            if(!inFrustum[m])
+            {
+                continue;
+            }
+            coneCulledTriangles += meshlets[m].triangleCount;
+            for(unsigned int t=0; t<meshlets[m].triangleCount; t++)
+            {
+                if(!facesAway(&indices[meshlets[m].firstIndex + 3*t], positions, camera))
+                {
+                    cout << "  meshlet " << m << " was culled but has a triangle facing the camera"
+                         << endl;
+                    side.valid = false;
+                    break;
+                }
+            }
+        }
+        size_t backfacing = 0;
+        for(size_t i=0; i<indexCount; i+=3)
+        {
+            backfacing += facesAway(&indices[i], positions, camera);
+        }
+
+        float culledPercent = 100.0f*culledTriangles/(indexCount/3);
+        side.culled += culledPercent/VIEW_COUNT;
+        side.coneCulled += 100.0*coneCulledTriangles/(indexCount/3)/VIEW_COUNT;
+        side.backfacing += 100.0*backfacing/(indexCount/3)/VIEW_COUNT;
+        if(!printViews)
+        {
+            continue;
+        }
+        cout << "  view " << view << " (" << (int)(360.0f*view/VIEW_COUNT) << " degrees): culled "
+             << culledPercent << "% of triangles (" << 100.0f*coneCulledTriangles/(indexCount/3)
+             << "% by cones), " << 100.0f*backfacing/(indexCount/3) << "% face away" << endl;
+    }
+    return side;
+}
+
+static bool measure(const char* path)
+{
+    GeometryData geometry;
+    GeometryLoadOptions options;
+    options.useCache = false;
+    options.optimizeMesh = true;
+    geometry.loadFromOBJFile(path, options);
+    size_t vertexCount = geometry.vertexCount();
+    size_t indexCount = geometry.indexCount();
+    if(indexCount == 0)
+    {
+        cout << path << " has no triangles" << endl;
+        return false;
+    }
+    vector<unsigned int> original(indexCount);
+    for(size_t i=0; i<indexCount; i++)
+    {
+        original[i] = (geometry.indexSize() == 2) ?
+                      ((const unsigned short*)geometry.indexData())[i] :
+                      ((const unsigned int*)geometry.indexData())[i];
+    }
+    const float* positions = (const float*)geometry.vertexData();
+
+    vector<unsigned int> indices(original);
+    vector<Meshlet> meshlets;
+    Clock::time_point start = Clock::now();
+    buildMeshlets(indices.data(), indices.size(), positions, vertexCount, &meshlets);
+    double buildMilliseconds = chrono::duration<double, milli>(Clock::now() - start).count();
+
+    cout << fixed << setprecision(2);
+    cout << path << ": " << indexCount/3 << " triangles, " << meshlets.size() << " meshlets in "
+         << buildMilliseconds << " ms" << endl;
+
+    bool valid = (sortedTriangles(indices) == sortedTriangles(original));
+    if(!valid)
+    {
+        cout << "  the meshlets don't have the same triangles as the mesh" << endl;
+    }
+    size_t nextIndex = 0;
+    size_t totalVertices = 0;
+    size_t coneCount = 0;
+    for(size_t m=0; m<meshlets.size(); m++)
+    {
+        const Meshlet& meshlet = meshlets[m];
+        set<unsigned int> used(indices.begin() + meshlet.firstIndex,
+                               indices.begin() + meshlet.firstIndex + 3*meshlet.triangleCount);
+        if((meshlet.firstIndex != nextIndex) || (used.size() != meshlet.vertexCount) ||
+           (meshlet.vertexCount > MESHLET_MAX_VERTICES) ||
+           (meshlet.triangleCount > MESHLET_MAX_TRIANGLES))
+        {
+            cout << "  meshlet " << m << " is out of place or over the limits" << endl;
+            valid = false;
+        }
+        nextIndex += 3*meshlet.triangleCount;
+        totalVertices += meshlet.vertexCount;
+        coneCount += (meshlet.coneCutoff <= 1.0f);
+    }
+    valid = valid && (nextIndex == indexCount);
+    cout << "  " << (float)(indexCount/3)/meshlets.size() << " triangles and "
+         << (float)totalVertices/meshlets.size() << " vertices per meshlet, "
+         << 100.0f*coneCount/meshlets.size() << "% have a usable cone" << endl;
+
+    SideViews side = cullFromSide(geometry, indices, meshlets, true);
+    valid = valid && side.valid;
+    cout << "  from the side: " << side.culled << "% culled on average by the frustum and cones "
+         << "together (" << side.coneCulled << "% by cones), out of the " << side.backfacing
+         << "% facing away, " << side.cullMicroseconds/VIEW_COUNT << " us per view" << endl;
+
+    // From prac1 --bench's orbit (5.2 units from the origin, bobbing up and down), which is close
+    // enough to a large object for the frustum to take out most of it as well
+    glm::mat4 viewerProjection = glm::perspective(glm::radians(30.0f), 4.0f/3.0f, 0.1f, 100.0f);
+    vector<unsigned char> visible(meshlets.size());
+    double orbitCulled = 0.0;
+    for(int view=0; view<VIEW_COUNT; view++)
+    {
+        float angle = 2.0f*3.14159265f*view/VIEW_COUNT;
+        glm::vec3 camera(5.2f*cos(angle), 3.0f*sin(2.0f*angle), 5.2f*sin(angle));
+        glm::mat4 viewProjection = viewerProjection*glm::lookAt(camera, glm::vec3(0.0f),
+                                                                glm::vec3(0,1,0));
+        glm::vec4 planes[6];
+        extractFrustumPlanes(viewProjection, planes);
+        cullMeshlets(meshlets.data(), meshlets.size(), planes, camera, visible.data());
+        for(size_t m=0; m<meshlets.size(); m++)
+        {
+            orbitCulled += visible[m] ? 0.0 : 100.0*meshlets[m].triangleCount/(indexCount/3);
+        }
+    }
+    cout << "  from the benchmark's orbit: " << orbitCulled/VIEW_COUNT
+         << "% culled on average by the frustum and cones together" << endl;
+
+    // Tighter cones against more, smaller meshlets
+    cout << "  with other cone settings (the defaults are " << MESHLET_CONE_WEIGHT << " and "
+         << MESHLET_MIN_JOIN_DOT << "):" << endl;
+    for(int i=0; i<CONE_SETTING_COUNT; i++)
+    {
+        vector<unsigned int> settingIndices(original);
+        vector<Meshlet> settingMeshlets;
+        buildMeshlets(settingIndices.data(), settingIndices.size(), positions, vertexCount,
+                      &settingMeshlets, CONE_SETTINGS[i][0], CONE_SETTINGS[i][1]);
+        size_t settingVertices = 0;
+        for(size_t m=0; m<settingMeshlets.size(); m++)
+        {
+            settingVertices += settingMeshlets[m].vertexCount;
+        }
+        SideViews settingSide = cullFromSide(geometry, settingIndices, settingMeshlets, false);
+        valid = valid && settingSide.valid;
+        cout << "    cone weight " << CONE_SETTINGS[i][0] << ", min join dot "
+             << CONE_SETTINGS[i][1] << ": " << settingMeshlets.size() << " meshlets ("
+             << (float)(indexCount/3)/settingMeshlets.size() << " triangles and "
+             << (float)settingVertices/settingMeshlets.size() << " vertices each), "
+             << settingSide.coneCulled << "% culled by cones from the side" << endl;
+    }
+    return valid;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        cout << "Usage: bench_meshlets <path of an object> [more objects...]" << endl;
+        return 1;
+    }
+
+    bool valid = true;
+    for(int i=1; i<argc; i++)
+    {
+        valid = measure(argv[i]) && valid;
+    }
+    cout << (valid ? "Meshlets are valid" : "Meshlets are INVALID") << endl;
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+// Measures the vertex cache optimization passes offline: simulates FIFO and LRU post-transform
+// caches of a few sizes over each mesh before and after optimizing, times every pass, and checks
+// that the optimized mesh still contains exactly the same triangles
+//
+// Usage: bench_meshopt <path of an object> [more objects...]
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "geometry.h"
+#include "meshopt.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+static vector<unsigned int> copyIndices(GeometryData& geometry)
+{
+    vector<unsigned int> result(geometry.indexCount());
+    for(size_t i=0; i<result.size(); i++)
+    {
+        result[i] = (geometry.indexSize() == 2) ? ((unsigned short*)geometry.indexData())[i] :
+                                                  ((unsigned int*)geometry.indexData())[i];
+    }
+    return result;
+}
+
+// Every triangle as its three corner positions, starting from the smallest corner so that the
+// winding is kept but the starting corner doesn't matter, and sorted
+static vector<vector<float> > triangleSet(const vector<unsigned int>& indices, const float* positions)
+{
+    vector<vector<float> > triangles(indices.size()/3);
+    for(size_t t=0; t<triangles.size(); t++)
+    {
+        vector<float> corners[3];
+        for(int corner=0; corner<3; corner++)
+        {
+            const float* position = &positions[indices[t*3 + corner]*3];
+            corners[corner].assign(position, position + 3);
+        }
+        int first = min_element(corners, corners + 3) - corners;
+        for(int corner=0; corner<3; corner++)
+        {
+            const vector<float>& p = corners[(first + corner) % 3];
+            triangles[t].insert(triangles[t].end(), p.begin(), p.end());
+        }
+    }
+    sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+static void printStats(const char* label, const vector<unsigned int>& indices, size_t vertexCount)
+{
+    const int cacheSizes[3] = {16, 32, 64};
+    cout << "  " << left << setw(12) << label << right;
+    for(int model=0; model<2; model++)
+    {
+        for(int i=0; i<3; i++)
+        {
+            VertexCacheStats stats = analyzeVertexCache(indices.data(), indices.size(), vertexCount,
+                                                        cacheSizes[i], (VertexCacheModel)model);
+            cout << setw(7) << stats.acmr << "/" << left << setw(6) << stats.atvr << right;
+        }
+    }
+    cout << endl;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        cout << "Usage: bench_meshopt <path of an object> [more objects...]" << endl;
+        return 1;
+    }
+
+    bool allIdentical = true;
+    cout << fixed << setprecision(3);
+    for(int arg=1; arg<argc; arg++)
+    {
+        GeometryData geometry;
+        GeometryLoadOptions options;
+        options.useCache = false;
+        geometry.loadFromOBJFile(argv[arg], options);
+        if(geometry.indexCount() == 0)
+        {
+            continue;
+        }
+
+        size_t vertexCount = geometry.vertexCount();
+        const float* positions = (const float*)geometry.vertexData();
+        vector<unsigned int> original = copyIndices(geometry);
+
+        vector<unsigned int> cacheOptimized(original);
+        Clock::time_point start = Clock::now();
+        optimizeVertexCache(cacheOptimized.data(), cacheOptimized.size(), vertexCount);
+        double cacheTime = millisecondsSince(start);
+
+        vector<unsigned int> overdrawOptimized(cacheOptimized);
+        start = Clock::now();
+        optimizeOverdraw(overdrawOptimized.data(), overdrawOptimized.size(), positions,
+                         vertexCount, 16);
+        double overdrawTime = millisecondsSince(start);
+
+        vector<unsigned int> fetchOptimized(overdrawOptimized);
+        vector<unsigned int> remap;
+        start = Clock::now();
+        size_t usedVertices = optimizeVertexFetch(fetchOptimized.data(), fetchOptimized.size(),
+                                                  vertexCount, &remap);
+        vector<float> remappedPositions(positions, positions + vertexCount*3);
+        remapVertexArray(&remappedPositions, 3, remap, usedVertices);
+        double fetchTime = millisecondsSince(start);
+
+        bool identical = (triangleSet(original, positions) ==
+                          triangleSet(fetchOptimized, remappedPositions.data()));
+        allIdentical = allIdentical && identical;
+
+        cout << endl;
+        cout << argv[arg] << ": " << vertexCount << " vertices, " << original.size()/3
+             << " triangles" << endl;
+        cout << "  ACMR/ATVR     FIFO 16       FIFO 32       FIFO 64       "
+             << "LRU 16        LRU 32        LRU 64" << endl;
+        printStats("original", original, vertexCount);
+        printStats("vertex cache", cacheOptimized, vertexCount);
+        printStats("+ overdraw", overdrawOptimized, vertexCount);
+        cout << "  Vertex cache pass: " << cacheTime << " ms, overdraw pass: " << overdrawTime
+             << " ms, vertex fetch pass: " << fetchTime << " ms" << endl;
+        cout << "  Triangles after optimizing: " << (identical ? "identical" : "MISMATCH") << endl;
+    }
+
+    return allIdentical ? 0 : 1;
+}
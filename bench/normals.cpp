@@ -0,0 +1,247 @@
+// Measures smooth normal generation over many copies of a mesh (100 copies of dragon.obj makes
+// 10 million triangles), with every thread count from 1 up to the number of cores, both
+// weightings, and with and without a crease angle. Checks that each thread count gives exactly the
+// normals one thread does, and that smoothing everything gives exactly what a plain loop adding
+// each triangle to its corners gives
+//
+// Usage: bench_normals <path of an object> [copies] [iterations] [crease angle] [max threads]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+#include <math.h>
+
+#include "geometry.h"
+#include "normals.h"
+#include "threadpool.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+struct NormalResult
+{
+    vector<float> normals;
+    vector<int> cornerNormals;
+};
+
+static double timeNormals(const vector<float>& positions, const vector<int>& corners,
+                          NormalWeighting weighting, float creaseAngle, int threadCount,
+                          int iterations, NormalResult* result)
+{
+    double best = 1e30;
+    result->cornerNormals.assign(corners.size(), -1);
+    for(int i=0; i<iterations; i++)
+    {
+        Clock::time_point start = Clock::now();
+        generateNormals(positions.data(), positions.size()/3, corners.data(),
+                        result->cornerNormals.data(), 3, corners.size()/3, weighting,
+                        creaseAngle, threadCount, &result->normals);
+        best = min(best, millisecondsSince(start));
+    }
+    return best;
+}
+
+static bool sameResult(const NormalResult& a, const NormalResult& b)
+{
+    return (a.normals.size() == b.normals.size()) && (a.cornerNormals == b.cornerNormals) &&
+           (memcmp(a.normals.data(), b.normals.data(), a.normals.size()*sizeof(float)) == 0);
+}
+
+// The obvious single threaded version: add every triangle's area weighted normal (its unit normal
+// times its doubled area) to its corners' positions, then normalize
+static double referenceNormals(const vector<float>& positions, const vector<int>& corners,
+                               NormalResult* result)
+{
+    Clock::time_point start = Clock::now();
+    vector<float> sums(positions.size(), 0.0f);
+    for(size_t i=0; i<corners.size(); i+=3)
+    {
+        const float* p0 = &positions[3*corners[i]];
+        const float* p1 = &positions[3*corners[i+1]];
+        const float* p2 = &positions[3*corners[i+2]];
+        float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        float cross[3] = {e1[1]*e2[2] - e1[2]*e2[1], e1[2]*e2[0] - e1[0]*e2[2],
+                          e1[0]*e2[1] - e1[1]*e2[0]};
+        float length = sqrtf(cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]);
+        float scale = (length > 0.0f) ? 1.0f/length : 0.0f;
+        for(int corner=0; corner<3; corner++)
+        {
+            float* sum = &sums[3*corners[i+corner]];
+            for(int k=0; k<3; k++)
+            {
+                sum[k] += (cross[k]*scale)*length;
+            }
+        }
+    }
+
+    // Numbered in position order, skipping positions no triangle uses
+    vector<int> positionNormals(positions.size()/3, -1);
+    vector<char> used(positions.size()/3, 0);
+    for(size_t i=0; i<corners.size(); i++)
+    {
+        used[corners[i]] = 1;
+    }
+    result->normals.clear();
+    for(size_t position=0; position<used.size(); position++)
+    {
+        if(!used[position])
+        {
+            continue;
+        }
+        positionNormals[position] = result->normals.size()/3;
+        const float* sum = &sums[3*position];
+        float length = sqrtf(sum[0]*sum[0] + sum[1]*sum[1] + sum[2]*sum[2]);
+        float normal[3] = {0.0f, 0.0f, 1.0f};
+        if(length > 0.0f)
+        {
+            normal[0] = sum[0]/length;
+            normal[1] = sum[1]/length;
+            normal[2] = sum[2]/length;
+        }
+        result->normals.insert(result->normals.end(), normal, normal+3);
+    }
+    result->cornerNormals.resize(corners.size());
+    for(size_t i=0; i<corners.size(); i++)
+    {
+        result->cornerNormals[i] = positionNormals[corners[i]];
+    }
+    return millisecondsSince(start);
+}
+
+static size_t invalidNormals(const NormalResult& result)
+{
+    size_t invalid = 0;
+    for(size_t i=0; i<result.normals.size(); i+=3)
+    {
+        const float* n = &result.normals[i];
+        double length = sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        invalid += !(fabs(length - 1.0) < 1e-5);
+    }
+    return invalid;
+}
+
+int main(int argc, char** argv)
+{
+    int copies = (argc > 2) ? atoi(argv[2]) : 100;
+    int iterations = (argc > 3) ? atoi(argv[3]) : 3;
+    float creaseAngle = (argc > 4) ? atof(argv[4]) : 60.0f;
+    int maxThreads = (argc > 5) ? atoi(argv[5]) : ThreadPool::hardwareThreadCount();
+    if((argc < 2) || (copies <= 0) || (iterations <= 0))
+    {
+        cout << "Usage: bench_normals <path of an object> [copies] [iterations] [crease angle] [max threads]" << endl;
+        return 1;
+    }
+
+    // The file's own normals (if any) are ignored, only its positions and triangles are used
+    GeometryData geometry;
+    GeometryLoadOptions options;
+    options.useCache = false;
+    options.generateNormals = false;
+    geometry.loadFromOBJFile(argv[1], options);
+    size_t meshVertices = geometry.vertexCount();
+    size_t meshIndexCount = geometry.indexCount();
+    if(meshIndexCount == 0)
+    {
+        cout << argv[1] << " has no triangles" << endl;
+        return 1;
+    }
+
+    // The copies sit side by side, each with its own positions
+    const float* meshPositions = (const float*)geometry.vertexData();
+    float width = geometry.boundsMax()[0] - geometry.boundsMin()[0];
+    vector<float> positions;
+    vector<int> corners;
+    positions.reserve(3*meshVertices*copies);
+    corners.reserve(meshIndexCount*copies);
+    for(int copy=0; copy<copies; copy++)
+    {
+        for(size_t v=0; v<meshVertices; v++)
+        {
+            positions.push_back(meshPositions[3*v] + copy*width);
+            positions.push_back(meshPositions[3*v + 1]);
+            positions.push_back(meshPositions[3*v + 2]);
+        }
+        for(size_t i=0; i<meshIndexCount; i++)
+        {
+            int index = (geometry.indexSize() == 2) ? ((const unsigned short*)geometry.indexData())[i] :
+                                                      ((const unsigned int*)geometry.indexData())[i];
+            corners.push_back(index + copy*meshVertices);
+        }
+    }
+    size_t triangleCount = corners.size()/3;
+
+    cout << fixed << setprecision(2);
+    cout << argv[1] << " x " << copies << ": " << positions.size()/3 << " positions, "
+         << triangleCount << " triangles" << endl;
+
+    bool valid = true;
+    NormalResult reference;
+    double referenceTime = referenceNormals(positions, corners, &reference);
+    cout << "Single loop reference (area weighted, no creases): " << referenceTime << " ms" << endl;
+
+    const NormalWeighting weightings[2] = {NORMAL_WEIGHT_AREA, NORMAL_WEIGHT_ANGLE};
+    const char* weightingNames[2] = {"area", "angle"};
+    const float creaseAngles[2] = {180.0f, creaseAngle};
+    for(int w=0; w<2; w++)
+    {
+        for(int c=0; c<2; c++)
+        {
+            NormalResult oneThread;
+            double oneThreadTime = timeNormals(positions, corners, weightings[w], creaseAngles[c],
+                                               1, iterations, &oneThread);
+            cout << weightingNames[w] << " weighted, ";
+            if(creaseAngles[c] >= 180.0f)
+            {
+                cout << "no creases: ";
+            }
+            else
+            {
+                cout << creaseAngles[c] << " degree creases: ";
+            }
+            cout << oneThread.normals.size()/3 << " normals" << endl;
+
+            size_t invalid = invalidNormals(oneThread);
+            if(invalid > 0)
+            {
+                cout << "  " << invalid << " normals aren't unit length" << endl;
+                valid = false;
+            }
+            if((weightings[w] == NORMAL_WEIGHT_AREA) && (creaseAngles[c] >= 180.0f))
+            {
+                bool matches = sameResult(oneThread, reference);
+                valid = valid && matches;
+                cout << "  " << (matches ? "identical to" : "DIFFERENT from") << " the reference" << endl;
+            }
+
+            cout << "  1 thread:   " << oneThreadTime << " ms (" << triangleCount/(oneThreadTime*1000.0)
+                 << " million triangles/s)" << endl;
+            for(int threadCount=2; threadCount<=maxThreads; threadCount*=2)
+            {
+                NormalResult threaded;
+                double threadedTime = timeNormals(positions, corners, weightings[w],
+                                                  creaseAngles[c], threadCount, iterations,
+                                                  &threaded);
+                bool identical = sameResult(threaded, oneThread);
+                valid = valid && identical;
+                cout << "  " << threadCount << " threads: " << threadedTime << " ms, "
+                     << oneThreadTime/threadedTime << "x, " << (identical ? "identical" : "MISMATCH")
+                     << endl;
+            }
+        }
+    }
+
+    cout << (valid ? "Results match" : "Results DIFFER") << endl;
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+// Compares the stream based OBJ loader against the memory-mapped one (sequential and chunked
+// across threads) and the binary mesh cache, and checks that all of them produce identical data.
+// Besides whole loads, it times parsing on its own (up to where the loaders start on normals and
+// vertices, which is the same code for both), which is what the mapped loader replaced
+//
+// Usage: bench_objload <path of an object> [iterations] [max threads]
+//        bench_objload --concat <copies> <path of an object> <output path>
+//
+// The second form writes a large test file made of repeated copies of an object, e.g. 300 copies
+// of dragon.obj gives a ~1 GB file for measuring how parsing scales with thread count
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "geometry.h"
+#include "threadpool.h"
+#include "meshcache.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+static bool sameData(void* a, void* b, int count, int components)
+{
+    if(count == 0)
+    {
+        return true;
+    }
+    return memcmp(a, b, count*components*sizeof(float)) == 0;
+}
+
+static bool sameGeometry(GeometryData& a, GeometryData& b)
+{
+    return (a.vertexCount() == b.vertexCount()) &&
+           (a.indexCount() == b.indexCount()) &&
+           (a.indexSize() == b.indexSize()) &&
+           ((a.indexCount() == 0) ||
+            (memcmp(a.indexData(), b.indexData(), a.indexCount()*a.indexSize()) == 0)) &&
+           (a.textureCoordCount() == b.textureCoordCount()) &&
+           (a.normalCount() == b.normalCount()) &&
+           sameData(a.vertexData(), b.vertexData(), a.vertexCount(), 3) &&
+           sameData(a.textureCoordData(), b.textureCoordData(), a.textureCoordCount(), 2) &&
+           sameData(a.normalData(), b.normalData(), a.normalCount(), 3);
+}
+
+// NOTE: Positive indices in every copy still refer to the first copy's vertices, which is valid
+//       OBJ and keeps the face count (and so the parsing work) proportional to the file size
+static int writeConcatenatedFile(int copies, const string& inputPath, const string& outputPath)
+{
+    ifstream input(inputPath, ios::in | ios::binary);
+    if(input.fail())
+    {
+        cout << "Unable to open obj file: " << inputPath << endl;
+        return 1;
+    }
+    string contents((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    if(!contents.empty() && (contents[contents.size()-1] != '\n'))
+    {
+        contents += '\n';
+    }
+
+    ofstream output(outputPath, ios::out | ios::binary);
+    for(int i=0; i<copies; i++)
+    {
+        output.write(contents.data(), contents.size());
+    }
+    cout << "Wrote " << (double)contents.size()*copies/(1 << 20) << " MB to " << outputPath << endl;
+    return output.fail() ? 1 : 0;
+}
+
+// Loads the file a number of times and returns the fastest time, keeping the first result. The
+// fastest parse (from the loader's "parsing" step to the one after it) goes in parseBest
+static double timeLoad(const string& path, int iterations, int threadCount, bool useStream,
+                       GeometryData* result, double* parseBest)
+{
+    double best = 1e30;
+    *parseBest = 1e30;
+    for(int i=0; i<iterations; i++)
+    {
+        GeometryData geometry;
+        GeometryLoadOptions options;
+        options.threadCount = threadCount;
+        options.useCache = false;
+        Clock::time_point parseStart;
+        double parseTime = 0.0;
+        bool parsing = false;
+        options.progress = [&](const char* step)
+        {
+            if(parsing)
+            {
+                parseTime = millisecondsSince(parseStart);
+            }
+            parsing = (strcmp(step, "parsing") == 0);
+            parseStart = Clock::now();
+        };
+
+        Clock::time_point start = Clock::now();
+        if(useStream)
+        {
+            geometry.loadFromOBJFileStream(path, options);
+        }
+        else
+        {
+            geometry.loadFromOBJFile(path, options);
+        }
+        double elapsed = millisecondsSince(start);
+        if(parsing)
+        {
+            parseTime = millisecondsSince(parseStart);
+        }
+        best = min(best, elapsed);
+        *parseBest = min(*parseBest, parseTime);
+        if(i == 0)
+        {
+            *result = geometry;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    if((argc == 5) && (string(argv[1]) == "--concat"))
+    {
+        return writeConcatenatedFile(atoi(argv[2]), argv[3], argv[4]);
+    }
+    if(argc < 2)
+    {
+        cout << "Usage: bench_objload <path of an object> [iterations] [max threads]" << endl;
+        cout << "       bench_objload --concat <copies> <path of an object> <output path>" << endl;
+        return 1;
+    }
+    string path(argv[1]);
+    int iterations = (argc > 2) ? atoi(argv[2]) : 5;
+    int maxThreads = (argc > 3) ? atoi(argv[3]) : ThreadPool::hardwareThreadCount();
+
+    ifstream sizeCheck(path, ios::in | ios::binary | ios::ate);
+    double fileSizeMB = (double)sizeCheck.tellg()/(1 << 20);
+
+    GeometryData mappedGeometry;
+    double mappedParse;
+    double mappedBest = timeLoad(path, iterations, 1, false, &mappedGeometry, &mappedParse);
+
+    // NOTE: The stream loader takes minutes on files in the hundreds of megabytes, so we only
+    //       use it as a baseline for reasonably sized inputs
+    bool runStream = (fileSizeMB < 64.0);
+    GeometryData streamGeometry;
+    double streamBest = 0.0;
+    double streamParse = 0.0;
+    if(runStream)
+    {
+        streamBest = timeLoad(path, iterations, 1, true, &streamGeometry, &streamParse);
+    }
+
+    cout << endl;
+    cout << "File:          " << path << " (" << fileSizeMB << " MB)" << endl;
+    cout << "Vertices:      " << mappedGeometry.vertexCount() << endl;
+    cout << "Triangles:     " << mappedGeometry.indexCount()/3 << endl;
+    bool allIdentical = true;
+    if(runStream)
+    {
+        bool identical = sameGeometry(streamGeometry, mappedGeometry);
+        allIdentical = allIdentical && identical;
+        cout << "Stream loader: " << streamBest << " ms (best of " << iterations << ")" << endl;
+        cout << "Mapped loader: " << mappedBest << " ms, " << streamBest/mappedBest << "x, "
+             << (identical ? "identical" : "MISMATCH") << endl;
+        cout << "Parsing only:  " << streamParse << " ms stream, " << mappedParse << " ms mapped, "
+             << streamParse/mappedParse << "x (the rest of each load is the same "
+             << mappedBest - mappedParse << " ms of normals and vertices)" << endl;
+    }
+    else
+    {
+        cout << "Mapped loader: " << mappedBest << " ms (best of " << iterations << "), "
+             << mappedParse << " ms of it parsing" << endl;
+    }
+
+    for(int threadCount=2; threadCount<=maxThreads; threadCount*=2)
+    {
+        GeometryData parallelGeometry;
+        double parallelParse;
+        double parallelBest = timeLoad(path, iterations, threadCount, false, &parallelGeometry,
+                                       &parallelParse);
+        bool identical = sameGeometry(parallelGeometry, mappedGeometry);
+        allIdentical = allIdentical && identical;
+        cout << threadCount << " threads:     " << parallelBest << " ms, "
+             << mappedBest/parallelBest << "x over 1 thread (parsing " << parallelParse << " ms), "
+             << (identical ? "identical" : "MISMATCH") << endl;
+    }
+
+    // The first cached load parses the file and writes the cache, later ones map the cache
+    remove(meshCachePath(path).c_str());
+    GeometryLoadOptions cacheOptions;
+    GeometryData coldGeometry;
+    Clock::time_point coldStart = Clock::now();
+    coldGeometry.loadFromOBJFile(path, cacheOptions);
+    double coldTime = millisecondsSince(coldStart);
+
+    double warmBest = 1e30;
+    bool warmIdentical = true;
+    for(int i=0; i<iterations; i++)
+    {
+        GeometryData warmGeometry;
+        Clock::time_point warmStart = Clock::now();
+        warmGeometry.loadFromOBJFile(path, cacheOptions);
+        double elapsed = millisecondsSince(warmStart);
+        if(elapsed < warmBest)
+        {
+            warmBest = elapsed;
+        }
+        warmIdentical = warmIdentical && sameGeometry(warmGeometry, mappedGeometry);
+    }
+    allIdentical = allIdentical && warmIdentical;
+    cout << "Cache (cold):  " << coldTime << " ms, parsing and writing the cache" << endl;
+    cout << "Cache (warm):  " << warmBest << " ms, " << mappedBest/warmBest << "x over parsing, "
+         << (warmIdentical ? "identical" : "MISMATCH") << endl;
+    remove(meshCachePath(path).c_str());
+
+    return allIdentical ? 0 : 1;
+}
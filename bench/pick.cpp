@@ -0,0 +1,123 @@
+// Measures ray casting against a mesh for mouse picking: how long building the triangle hierarchy
+// takes, and how long a ray takes through it compared to testing every triangle. Rays start
+// around the mesh and aim at random points in its bounding box. Also checks both find the same
+// hits
+//
+// Usage: bench_pick <path of an object> [rays] [rays checked against every triangle]
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <stdlib.h>
+
+#include <math.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "geometry.h"
+#include "meshraycast.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double microsecondsSince(Clock::time_point start)
+{
+    return chrono::duration<double, micro>(Clock::now() - start).count();
+}
+
+static float randomFloat(float low, float high)
+{
+    return low + (high - low)*(float)rand()/(float)RAND_MAX;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        cout << "Usage: bench_pick <path of an object> [rays] [rays checked against every triangle]" << endl;
+        return 1;
+    }
+    int rayCount = (argc > 2) ? atoi(argv[2]) : 10000;
+    int checkedCount = (argc > 3) ? atoi(argv[3]) : 100;
+
+    GeometryData geometry;
+    GeometryLoadOptions options;
+    options.useCache = false;
+    geometry.loadFromOBJFile(argv[1], options);
+    if(geometry.indexCount() == 0)
+    {
+        return 1;
+    }
+    vector<unsigned int> indices(geometry.indexCount());
+    for(int i=0; i<geometry.indexCount(); i++)
+    {
+        indices[i] = (geometry.indexSize() == 2) ? ((unsigned short*)geometry.indexData())[i] :
+                                                    ((unsigned int*)geometry.indexData())[i];
+    }
+
+    MeshRaycaster raycaster;
+    Clock::time_point start = Clock::now();
+    raycaster.build((const float*)geometry.vertexData(), indices.data(), indices.size());
+    double buildMilliseconds = microsecondsSince(start)/1000.0;
+
+    glm::vec3 boundsMin = glm::make_vec3(geometry.boundsMin());
+    glm::vec3 boundsMax = glm::make_vec3(geometry.boundsMax());
+    glm::vec3 center = 0.5f*(boundsMin + boundsMax);
+    float radius = geometry.boundingRadius();
+
+    srand(1);
+    double rayMicroseconds = 0.0;
+    double allMicroseconds = 0.0;
+    double slowestRay = 0.0;
+    int hits = 0;
+    bool valid = true;
+    for(int ray=0; ray<rayCount; ray++)
+    {
+        glm::vec3 outward = glm::normalize(glm::vec3(randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f),
+                                                     randomFloat(-1.0f, 1.0f)) + glm::vec3(1e-4f));
+        glm::vec3 origin = center + 3.0f*radius*outward;
+        glm::vec3 target(randomFloat(boundsMin.x, boundsMax.x), randomFloat(boundsMin.y, boundsMax.y),
+                         randomFloat(boundsMin.z, boundsMax.z));
+        glm::vec3 direction = glm::normalize(target - origin);
+
+        RayHit hit;
+        start = Clock::now();
+        bool found = raycaster.raycast(origin, direction, 1e30f, &hit);
+        double microseconds = microsecondsSince(start);
+        rayMicroseconds += microseconds;
+        slowestRay = std::max(slowestRay, microseconds);
+        hits += found;
+
+        if(ray < checkedCount)
+        {
+            RayHit expected;
+            start = Clock::now();
+            bool expectedFound = raycaster.raycastAll(origin, direction, 1e30f, &expected);
+            allMicroseconds += microsecondsSince(start);
+            // NOTE: The SIMD and scalar arithmetic can round differently, so distances only have
+            //       to be close (and a ray through an edge can hit either triangle)
+            if((found != expectedFound) ||
+               (found && (fabs(hit.distance - expected.distance) > 1e-4f*(1.0f + expected.distance))))
+            {
+                cout << "Ray " << ray << " hits triangle " << (found ? (int)hit.triangle : -1)
+                     << " instead of " << (expectedFound ? (int)expected.triangle : -1) << endl;
+                valid = false;
+            }
+        }
+    }
+
+    int checked = std::min(checkedCount, rayCount);
+    cout << argv[1] << ": " << raycaster.triangleCount() << " triangles, "
+         << raycaster.memoryBytes()/1024 << " KB" << endl;
+    cout << "Build: " << buildMilliseconds << " ms" << endl;
+    cout << "Ray:   " << rayMicroseconds/rayCount << " us average, " << slowestRay << " us slowest ("
+         << hits << " of " << rayCount << " hit)" << endl;
+    if(checked > 0)
+    {
+        cout << "Every triangle: " << allMicroseconds/checked << " us per ray" << endl;
+    }
+    cout << (valid ? "Results match" : "Results DIFFER") << endl;
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+// Measures LOD generation: times simplifying each mesh into its LOD chain, and prints the triangle
+// count and error of every level, along with how much the simplified surface's area differs from
+// the full mesh's (a quick check that the shape survived)
+//
+// Usage: bench_simplify <path of an object> [more objects...]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+
+#include <math.h>
+
+#include "geometry.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+static unsigned int indexAt(GeometryData& geometry, size_t index)
+{
+    size_t fullCount = geometry.indexCount();
+    void* data = (index < fullCount) ? geometry.indexData() : geometry.lodIndexData();
+    size_t offset = (index < fullCount) ? index : index - fullCount;
+    return (geometry.indexSize() == 2) ? ((unsigned short*)data)[offset] :
+                                         ((unsigned int*)data)[offset];
+}
+
+// Surface area of a level, or -1 if it uses a vertex that doesn't exist
+static double surfaceArea(GeometryData& geometry, const GeometryLOD& lod)
+{
+    const float* positions = (const float*)geometry.vertexData();
+    double area = 0.0;
+    for(unsigned int i=lod.firstIndex; i<lod.firstIndex + lod.indexCount; i+=3)
+    {
+        const float* corners[3];
+        for(int corner=0; corner<3; corner++)
+        {
+            unsigned int vertex = indexAt(geometry, i + corner);
+            if(vertex >= (unsigned int)geometry.vertexCount())
+            {
+                return -1.0;
+            }
+            corners[corner] = &positions[vertex*3];
+        }
+        double e1[3];
+        double e2[3];
+        for(int k=0; k<3; k++)
+        {
+            e1[k] = corners[1][k] - corners[0][k];
+            e2[k] = corners[2][k] - corners[0][k];
+        }
+        double cross[3] = {e1[1]*e2[2] - e1[2]*e2[1],
+                           e1[2]*e2[0] - e1[0]*e2[2],
+                           e1[0]*e2[1] - e1[1]*e2[0]};
+        area += 0.5*sqrt(cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]);
+    }
+    return area;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        cout << "Usage: bench_simplify <path of an object> [more objects...]" << endl;
+        return 1;
+    }
+
+    bool allValid = true;
+    cout << fixed;
+    for(int arg=1; arg<argc; arg++)
+    {
+        GeometryData geometry;
+        GeometryLoadOptions options;
+        options.useCache = false;
+        geometry.loadFromOBJFile(argv[arg], options);
+        if(geometry.indexCount() == 0)
+        {
+            continue;
+        }
+
+        Clock::time_point start = Clock::now();
+        geometry.generateLODs();
+        double simplifyTime = millisecondsSince(start);
+
+        const float* boundsMin = geometry.boundsMin();
+        const float* boundsMax = geometry.boundsMax();
+        double diagonal = sqrt((boundsMax[0] - boundsMin[0])*(boundsMax[0] - boundsMin[0]) +
+                               (boundsMax[1] - boundsMin[1])*(boundsMax[1] - boundsMin[1]) +
+                               (boundsMax[2] - boundsMin[2])*(boundsMax[2] - boundsMin[2]));
+
+        cout << endl;
+        cout << argv[arg] << ": " << geometry.vertexCount() << " vertices, "
+             << geometry.indexCount()/3 << " triangles, " << geometry.lodCount()
+             << " levels generated in " << setprecision(3) << simplifyTime << " ms" << endl;
+        cout << "  LOD   triangles   of full   error/diagonal   area change" << endl;
+        double fullArea = surfaceArea(geometry, geometry.lod(0));
+        for(int level=0; level<geometry.lodCount(); level++)
+        {
+            GeometryLOD lod = geometry.lod(level);
+            double area = surfaceArea(geometry, lod);
+            allValid = allValid && (area >= 0.0);
+            cout << "  " << setw(3) << level << setw(12) << lod.indexCount/3
+                 << setw(9) << setprecision(1) << 100.0*lod.indexCount/geometry.indexCount() << "%"
+                 << setw(17) << setprecision(5) << ((diagonal > 0.0) ? lod.error/diagonal : 0.0)
+                 << setw(13) << setprecision(2)
+                 << ((fullArea > 0.0) ? 100.0*(area - fullArea)/fullArea : 0.0) << "%" << endl;
+        }
+    }
+
+    return allValid ? 0 : 1;
+}
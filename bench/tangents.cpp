@@ -0,0 +1,162 @@
+// Measures tangent generation: the SIMD version against the one-triangle-at-a-time version, over
+// many copies of a mesh (so that a small one like suzanne makes a large test). Checks that both
+// versions agree and that every tangent is finite, unit length and perpendicular to its normal,
+// and compares the memory the tangent frames take with the separate tangent and bitangent arrays
+// used before
+//
+// Usage: bench_tangents <path of an object with uvs and normals> [copies] [iterations]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <stdlib.h>
+
+#include <math.h>
+
+#include "geometry.h"
+#include "tangents.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    int copies = (argc > 2) ? atoi(argv[2]) : 1000;
+    int iterations = (argc > 3) ? atoi(argv[3]) : 5;
+    if((argc < 2) || (copies <= 0) || (iterations <= 0))
+    {
+        cout << "Usage: bench_tangents <path of an object with uvs and normals> [copies] [iterations]" << endl;
+        return 1;
+    }
+
+    GeometryData geometry;
+    GeometryLoadOptions options;
+    options.useCache = false;
+    geometry.loadFromOBJFile(argv[1], options);
+    size_t meshVertices = geometry.vertexCount();
+    if((meshVertices == 0) || (geometry.textureCoordCount() == 0) || (geometry.normalCount() == 0))
+    {
+        cout << argv[1] << " has no uvs or normals to make tangents from" << endl;
+        return 1;
+    }
+
+    // The copies sit side by side, each with its own vertices
+    const float* meshPositions = (const float*)geometry.vertexData();
+    const float* meshTexCoords = (const float*)geometry.textureCoordData();
+    const float* meshNormals = (const float*)geometry.normalData();
+    size_t meshIndexCount = geometry.indexCount();
+    vector<unsigned int> meshIndices(meshIndexCount);
+    for(size_t i=0; i<meshIndexCount; i++)
+    {
+        meshIndices[i] = (geometry.indexSize() == 2) ? ((const unsigned short*)geometry.indexData())[i] :
+                                                       ((const unsigned int*)geometry.indexData())[i];
+    }
+    float width = geometry.boundsMax()[0] - geometry.boundsMin()[0];
+    size_t vertexCount = meshVertices*copies;
+    vector<float> positions, texCoords, normals;
+    vector<unsigned int> indices;
+    positions.reserve(3*vertexCount);
+    texCoords.reserve(2*vertexCount);
+    normals.reserve(3*vertexCount);
+    indices.reserve(meshIndexCount*copies);
+    for(int copy=0; copy<copies; copy++)
+    {
+        for(size_t v=0; v<meshVertices; v++)
+        {
+            positions.push_back(meshPositions[3*v] + copy*width);
+            positions.push_back(meshPositions[3*v + 1]);
+            positions.push_back(meshPositions[3*v + 2]);
+        }
+        texCoords.insert(texCoords.end(), meshTexCoords, meshTexCoords + 2*meshVertices);
+        normals.insert(normals.end(), meshNormals, meshNormals + 3*meshVertices);
+        for(size_t i=0; i<meshIndexCount; i++)
+        {
+            indices.push_back(meshIndices[i] + copy*meshVertices);
+        }
+    }
+    size_t triangleCount = indices.size()/3;
+
+    // Triangles whose uvs are in a line, which divided by zero in the old per-face code
+    size_t degenerate = 0;
+    for(size_t i=0; i<meshIndexCount; i+=3)
+    {
+        const float* uv0 = &meshTexCoords[2*meshIndices[i]];
+        const float* uv1 = &meshTexCoords[2*meshIndices[i+1]];
+        const float* uv2 = &meshTexCoords[2*meshIndices[i+2]];
+        float det = (uv1[0] - uv0[0])*(uv2[1] - uv0[1]) - (uv2[0] - uv0[0])*(uv1[1] - uv0[1]);
+        degenerate += (det == 0.0f);
+    }
+
+    vector<float> tangents(4*vertexCount), tangentsScalar(4*vertexCount);
+    double simdTime = 1e30;
+    double scalarTime = 1e30;
+    for(int iteration=0; iteration<iterations; iteration++)
+    {
+        Clock::time_point start = Clock::now();
+        generateTangents(positions.data(), texCoords.data(), normals.data(), 0, vertexCount,
+                         indices.data(), indices.size(), tangents.data());
+        simdTime = min(simdTime, millisecondsSince(start));
+
+        start = Clock::now();
+        generateTangentsScalar(positions.data(), texCoords.data(), normals.data(), 0, vertexCount,
+                               indices.data(), indices.size(), tangentsScalar.data());
+        scalarTime = min(scalarTime, millisecondsSince(start));
+    }
+
+    bool valid = true;
+    size_t mismatches = 0;
+    size_t invalidTangents = 0;
+    size_t mirrored = 0;
+    for(size_t v=0; v<vertexCount; v++)
+    {
+        const float* t = &tangents[4*v];
+        const float* n = &normals[3*v];
+        for(int k=0; k<4; k++)
+        {
+            mismatches += (fabs(t[k] - tangentsScalar[4*v + k]) > 1e-6f);
+        }
+        double length = sqrt(t[0]*t[0] + t[1]*t[1] + t[2]*t[2]);
+        double normalLength = sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        double dot = (normalLength > 0.0) ? (t[0]*n[0] + t[1]*n[1] + t[2]*n[2])/normalLength : 0.0;
+        bool finite = isfinite(t[0]) && isfinite(t[1]) && isfinite(t[2]) && ((t[3] == 1.0f) || (t[3] == -1.0f));
+        if(!finite || (fabs(length - 1.0) > 1e-4) || (fabs(dot) > 1e-4))
+        {
+            invalidTangents++;
+        }
+        mirrored += (t[3] < 0.0f);
+    }
+    if(mismatches > 0)
+    {
+        cout << "SIMD and scalar tangents disagree in " << mismatches << " values" << endl;
+        valid = false;
+    }
+    if(invalidTangents > 0)
+    {
+        cout << invalidTangents << " tangents aren't finite, unit length and perpendicular to the normal" << endl;
+        valid = false;
+    }
+
+    cout << fixed << setprecision(2);
+    cout << argv[1] << " x " << copies << ": " << vertexCount << " vertices, " << triangleCount
+         << " triangles (" << degenerate*copies << " with degenerate uvs), " << mirrored
+         << " vertices with mirrored uvs" << endl;
+    cout << tangentInstructionSet() << ": " << simdTime << " ms ("
+         << triangleCount/(simdTime*1000.0) << " million triangles/s)" << endl;
+    cout << "scalar: " << scalarTime << " ms (" << scalarTime/simdTime << "x slower)" << endl;
+    // Before, a tangent and a bitangent of 3 floats each
+    size_t tangentBytes = 4*sizeof(float)*vertexCount;
+    size_t oldTangentBytes = 6*sizeof(float)*vertexCount;
+    cout << "Tangent frames: " << tangentBytes/1024 << " KB, against " << oldTangentBytes/1024
+         << " KB with separate bitangents (" << 100.0*(oldTangentBytes - tangentBytes)/oldTangentBytes
+         << "% less)" << endl;
+    cout << (valid ? "Results match" : "Results DIFFER") << endl;
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+// Measures the packed vertex format: how much smaller each mesh's vertices get, how long packing
+// takes, and the largest error packing introduces in each attribute. Also checks that every half
+// float survives a round trip through float and back
+//
+// Usage: bench_vertexpack <path of an object> [more objects...]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+
+#include <math.h>
+
+#include "geometry.h"
+#include "vertexpack.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+static bool halfRoundTrips()
+{
+    for(unsigned int bits=0; bits<0x10000; bits++)
+    {
+        bool nan = ((bits & 0x7c00) == 0x7c00) && (bits & 0x3ff);
+        if(!nan && (packHalf(unpackHalf((uint16_t)bits)) != bits))
+        {
+            cout << "Half float 0x" << hex << bits << dec << " doesn't round trip" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static double angleDegrees(const float* a, const float* b)
+{
+    double dot = a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+    double lengths = sqrt(a[0]*a[0] + a[1]*a[1] + a[2]*a[2])*sqrt(b[0]*b[0] + b[1]*b[1] + b[2]*b[2]);
+    if(lengths <= 0.0)
+    {
+        return 0.0;
+    }
+    double cosine = dot/lengths;
+    cosine = (cosine > 1.0) ? 1.0 : ((cosine < -1.0) ? -1.0 : cosine);
+    return acos(cosine)*180.0/3.14159265358979;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        cout << "Usage: bench_vertexpack <path of an object> [more objects...]" << endl;
+        return 1;
+    }
+
+    bool valid = halfRoundTrips();
+    cout << fixed;
+    for(int arg=1; arg<argc; arg++)
+    {
+        GeometryData geometry;
+        GeometryLoadOptions options;
+        options.useCache = false;
+        geometry.loadFromOBJFile(argv[arg], options);
+        size_t vertexCount = geometry.vertexCount();
+        if(vertexCount == 0)
+        {
+            continue;
+        }
+
+        bool hasTextureCoords = (geometry.textureCoordCount() > 0);
+        bool hasNormals = (geometry.normalCount() > 0);
+        bool hasTangents = hasTextureCoords && hasNormals;
+        const float* positions = (const float*)geometry.vertexData();
+        const float* textureCoords = hasTextureCoords ? (const float*)geometry.textureCoordData() : 0;
+        const float* normals = hasNormals ? (const float*)geometry.normalData() : 0;
+        const float* tangents = hasTangents ? (const float*)geometry.tangentData() : 0;
+
+        PackedVertexLayout layout = packedVertexLayout(hasTextureCoords, hasNormals, hasTangents);
+        vector<unsigned char> packed(vertexCount*layout.stride);
+        Clock::time_point start = Clock::now();
+        packVertices(packed.data(), layout, vertexCount, positions, textureCoords, normals,
+                     tangents, geometry.boundsMin(), geometry.boundsMax());
+        double packTime = millisecondsSince(start);
+
+        size_t floatsPerVertex = 3 + (hasTextureCoords ? 2 : 0) + (hasNormals ? 3 : 0) +
+                                 (hasTangents ? 4 : 0);
+        size_t unpackedBytes = vertexCount*floatsPerVertex*sizeof(float);
+        size_t packedBytes = packed.size();
+
+        float scale[3];
+        float offset[3];
+        packedPositionTransform(geometry.boundsMin(), geometry.boundsMax(), scale, offset);
+        double extent = max(scale[0], max(scale[1], scale[2]));
+        double positionError = 0.0;
+        double texCoordError = 0.0;
+        double normalError = 0.0;
+        double tangentError = 0.0;
+        size_t handednessErrors = 0;
+        for(size_t v=0; v<vertexCount; v++)
+        {
+            const unsigned char* vertex = &packed[v*layout.stride];
+            const uint16_t* position = (const uint16_t*)(vertex + layout.positionOffset);
+            for(int k=0; k<3; k++)
+            {
+                double unpacked = position[k]/65535.0*scale[k] + offset[k];
+                positionError = max(positionError, fabs(unpacked - positions[v*3 + k])/extent);
+            }
+            if(textureCoords)
+            {
+                const uint16_t* texCoord = (const uint16_t*)(vertex + layout.texCoordOffset);
+                for(int k=0; k<2; k++)
+                {
+                    double unpacked = unpackHalf(texCoord[k]);
+                    texCoordError = max(texCoordError, fabs(unpacked - textureCoords[v*2 + k]));
+                }
+            }
+            float unpackedNormal[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            if(normals)
+            {
+                uint32_t normal = *(const uint32_t*)(vertex + layout.normalOffset);
+                unpackSnorm1010102(normal, unpackedNormal);
+                normalError = max(normalError, angleDegrees(unpackedNormal, &normals[v*3]));
+            }
+            if(tangents)
+            {
+                float unpackedTangent[4];
+                uint32_t tangent = *(const uint32_t*)(vertex + layout.tangentOffset);
+                unpackSnorm1010102(tangent, unpackedTangent);
+                tangentError = max(tangentError, angleDegrees(unpackedTangent, &tangents[v*4]));
+
+                // The bitangent the shader rebuilds is only right if the handedness survived
+                if((unpackedTangent[3] < 0.0f) != (tangents[v*4 + 3] < 0.0f))
+                {
+                    handednessErrors++;
+                }
+            }
+        }
+
+        cout << endl;
+        cout << argv[arg] << ": " << vertexCount << " vertices" << endl;
+        cout << "  " << unpackedBytes << " bytes as floats, " << packedBytes << " bytes packed ("
+             << setprecision(2) << (double)unpackedBytes/packedBytes << "x smaller) in "
+             << setprecision(3) << packTime << " ms" << endl;
+        cout << "  Largest error: position " << setprecision(7) << positionError
+             << " of the mesh size";
+        if(textureCoords)
+        {
+            cout << ", uv " << texCoordError;
+        }
+        if(normals)
+        {
+            cout << ", normal " << setprecision(3) << normalError << " degrees";
+        }
+        if(tangents)
+        {
+            cout << ", tangent " << setprecision(3) << tangentError << " degrees, "
+                 << handednessErrors << " flipped bitangents";
+        }
+        cout << endl;
+    }
+
+    return valid ? 0 : 1;
+}
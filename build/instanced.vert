@@ -0,0 +1,27 @@
+#version 330 core
+
+// Input vertex data, different for all executions of this shader.
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 vertexColor;
+// Model matrix of the copy being drawn, different for each instance (takes locations 5 to 8)
+layout(location = 5) in mat4 instanceModel;
+
+out vec3 fragmentColor;
+
+// Set once per frame (see uniformblocks.h).
+layout(std140) uniform Camera {
+	mat4 ViewProjection;
+	mat4 View;
+	mat4 Projection;
+};
+
+// Values that stay constant for the whole draw.
+uniform mat4 Dequantize;
+
+void main(){
+
+	// Output position of the vertex, in clip space : the MVP of this copy * position
+	gl_Position =  ViewProjection * instanceModel * Dequantize * vec4(position,1);
+	fragmentColor = vertexColor;
+
+}
@@ -6,13 +6,31 @@ layout(location = 1) in vec3 vertexColor;
 
 out vec3 fragmentColor;
 
+#ifdef OBJECT_BLOCK
+// Set once per frame (see uniformblocks.h).
+layout(std140) uniform Camera {
+	mat4 ViewProjection;
+	mat4 View;
+	mat4 Projection;
+};
+// Model matrix of the object being drawn, in a buffer with every object's.
+layout(std140) uniform Object {
+	mat4 Model;
+};
+uniform mat4 Dequantize;
+#else
 // Values that stay constant for the whole mesh.
 uniform mat4 MVP;
+#endif
 
 void main(){
 
 	// Output position of the vertex, in clip space : MVP * position
+#ifdef OBJECT_BLOCK
+	gl_Position =  ViewProjection * Model * Dequantize * vec4(position,1);
+#else
 	gl_Position =  MVP * vec4(position,1);
+#endif
 	fragmentColor = vertexColor;
 
 }
\ No newline at end of file
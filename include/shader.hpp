@@ -1,6 +1,13 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 
-GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path);
+// Compiles and links a vertex and fragment shader. The defines (if any) are added to both sources
+// right after their #version line. Linked programs are cached on disk next to the vertex shader
+// when the driver supports program binaries, and later calls with the same sources, defines and
+// driver load the binary instead of compiling
+GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path, const char * defines = "");
+
+// Turns the program cache off (or back on), e.g. to time compiling from source
+void SetProgramCacheEnabled(bool enabled);
 
 #endif
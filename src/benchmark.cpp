@@ -0,0 +1,622 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <chrono>
+
+#include <math.h>
+#include <string.h>
+
+#include "SDL.h"
+#include <GL/glew.h>
+
+#include "glwindow.h"
+#include "benchmark.h"
+#include "framescheduler.h"
+#include "rasterizer.h"
+#include "image.h"
+#include <shader.hpp>
+
+using namespace std;
+
+static double percentile(const vector<double>& sortedValues, double fraction)
+{
+    if(sortedValues.empty())
+    {
+        return 0.0;
+    }
+    size_t index = (size_t)ceil(fraction*sortedValues.size());
+    index = (index > 0) ? index-1 : 0;
+    return sortedValues[std::min(index, sortedValues.size()-1)];
+}
+
+static string jsonString(const string& text)
+{
+    string escaped = "\"";
+    for(size_t i=0; i<text.size(); i++)
+    {
+        if((text[i] == '"') || (text[i] == '\\'))
+        {
+            escaped += '\\';
+        }
+        escaped += text[i];
+    }
+    return escaped + "\"";
+}
+
+// How many of the frame times fall in each of a set of ranges (in ms), to show how even they are
+static const double HISTOGRAM_BOUNDS[] = {4.0, 8.0, 16.0, 33.0, 66.0};
+static const int HISTOGRAM_BUCKETS = sizeof(HISTOGRAM_BOUNDS)/sizeof(HISTOGRAM_BOUNDS[0]) + 1;
+
+static string jsonHistogram(const vector<double>& frameTimes)
+{
+    int counts[HISTOGRAM_BUCKETS] = {0};
+    for(size_t i=0; i<frameTimes.size(); i++)
+    {
+        int bucket = 0;
+        while((bucket < HISTOGRAM_BUCKETS-1) && (frameTimes[i] >= HISTOGRAM_BOUNDS[bucket]))
+        {
+            bucket++;
+        }
+        counts[bucket]++;
+    }
+    ostringstream json;
+    json << "{";
+    for(int bucket=0; bucket<HISTOGRAM_BUCKETS; bucket++)
+    {
+        ostringstream label;
+        if(bucket == 0)
+        {
+            label << "<" << HISTOGRAM_BOUNDS[0];
+        }
+        else if(bucket == HISTOGRAM_BUCKETS-1)
+        {
+            label << ">=" << HISTOGRAM_BOUNDS[bucket-1];
+        }
+        else
+        {
+            label << HISTOGRAM_BOUNDS[bucket-1] << "-" << HISTOGRAM_BOUNDS[bucket];
+        }
+        json << (bucket > 0 ? ", " : "") << jsonString(label.str()) << ": " << counts[bucket];
+    }
+    json << "}";
+    return json.str();
+}
+
+// Prints the report, or writes it to outputPath if there is one
+static int writeReport(const string& report, const string& outputPath)
+{
+    if(outputPath.empty())
+    {
+        cout << report;
+        return 0;
+    }
+    ofstream output(outputPath.c_str());
+    output << report;
+    if(output.fail())
+    {
+        cout << "Unable to write benchmark results to " << outputPath << endl;
+        return 1;
+    }
+    cout << "Wrote benchmark results to " << outputPath << endl;
+    return 0;
+}
+
+// The scripted camera: one full orbit around the origin over the run, bobbing up and down so
+// the object is seen from above and below
+static glm::vec3 orbitPosition(int frame, int frameCount)
+{
+    float t = (float)frame/(float)std::max(frameCount, 1);
+    float angle = 2.0f*3.14159265f*t;
+    float radius = 5.2f; // Same distance as the default camera at (3,3,3)
+    return glm::vec3(radius*cos(angle), 3.0f*sin(2.0f*angle), radius*sin(angle));
+}
+
+static void placeCamera(OpenGLWindow& window, int frame, int frameCount)
+{
+    window.setCamera(orbitPosition(frame, frameCount), glm::vec3(0,0,0));
+}
+
+int runFrameBenchmark(const FrameBenchmarkOptions& options)
+{
+    OpenGLWindow window;
+    window.object_1 = options.objectPath;
+    window.offscreen = true;
+    window.loadOptions.optimizeMesh = options.optimizeMesh;
+    window.loadOptions.generateLODs = options.generateLODs;
+    window.packedVertices = options.packedVertices;
+    window.instancing = options.instancing;
+    window.frustumCulling = options.frustumCulling;
+    window.meshletCulling = options.meshletCulling;
+    window.loadOptions.generateMeshlets = options.meshletCulling;
+    window.indirectDrawing = options.indirectDrawing;
+    window.uniformBuffers = options.uniformBuffers;
+    window.uploadBytesPerFrame = options.uploadBytesPerFrame;
+    window.streamingUploads = options.streamingUploads;
+    SetProgramCacheEnabled(options.programCache);
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 startupStart = SDL_GetPerformanceCounter();
+    window.initGL();
+    window.addCopies(options.instanceCount);
+    glFinish();
+    double startupMilliseconds = 1000.0*(SDL_GetPerformanceCounter() - startupStart)/frequency;
+    double loadMilliseconds = window.loadMilliseconds();
+
+    for(int frame=0; frame<options.warmupFrames; frame++)
+    {
+        placeCamera(window, frame, options.warmupFrames);
+        window.render();
+    }
+    glFinish();
+
+    // NOTE: Each frame is finished before the next one starts, so the times include the GPU
+    //       (or llvmpipe) work for that frame rather than just the cost of queueing it
+    vector<double> frameTimes;
+    frameTimes.reserve(options.frameCount);
+    vector<double> backgroundLoadFrameTimes;
+    double drawnTriangles = 0.0;
+    GLCallCounts glCalls;
+    double culledObjects = 0.0;
+    double cullMicroseconds = 0.0;
+    double culledMeshlets = 0.0;
+    double culledMeshletTriangles = 0.0;
+    double drawMicroseconds = 0.0;
+    StreamStats streamed;
+    Uint64 runStart = SDL_GetPerformanceCounter();
+    if(!options.backgroundLoadPath.empty())
+    {
+        string path = options.backgroundLoadPath;
+        window.addSecondObject(path);
+    }
+    for(int frame=0; (frame < options.frameCount) || (window.loadsPending() > 0); frame++)
+    {
+        bool loading = (window.loadsPending() > 0);
+        // Keep the (hidden) window responsive to the OS
+        SDL_Event e;
+        while(SDL_PollEvent(&e))
+        {
+        }
+
+        Uint64 frameStart = SDL_GetPerformanceCounter();
+        placeCamera(window, frame, options.frameCount);
+        window.render();
+        glFinish();
+        frameTimes.push_back(1000.0*(SDL_GetPerformanceCounter() - frameStart)/frequency);
+        if(loading)
+        {
+            backgroundLoadFrameTimes.push_back(frameTimes.back());
+        }
+        drawnTriangles += window.triangleCount();
+        GLCallCounts frameCalls = window.glCallCounts();
+        glCalls.calls += frameCalls.calls;
+        glCalls.skipped += frameCalls.skipped;
+        glCalls.draws += frameCalls.draws;
+        glCalls.uploadBytes += frameCalls.uploadBytes;
+        StreamStats frameStream = window.streamStats();
+        streamed.bytes += frameStream.bytes;
+        streamed.stalls += frameStream.stalls;
+        streamed.stallMicroseconds += frameStream.stallMicroseconds;
+        culledObjects += window.culledCount();
+        cullMicroseconds += window.cullMicroseconds();
+        culledMeshlets += window.culledMeshletCount();
+        culledMeshletTriangles += window.culledMeshletTriangles();
+        drawMicroseconds += window.drawMicroseconds();
+    }
+    double totalMilliseconds = 1000.0*(SDL_GetPerformanceCounter() - runStart)/frequency;
+
+    vector<double> sortedTimes(frameTimes);
+    sort(sortedTimes.begin(), sortedTimes.end());
+    double meanTime = 0.0;
+    for(size_t i=0; i<frameTimes.size(); i++)
+    {
+        meanTime += frameTimes[i];
+    }
+    meanTime /= std::max<size_t>(frameTimes.size(), 1);
+
+    // NOTE: With LODs the triangle count changes as the camera moves, so this is the average
+    int frameDivisor = std::max<int>(frameTimes.size(), 1);
+    double triangleCount = drawnTriangles/frameDivisor;
+    double trianglesPerSecond = (totalMilliseconds > 0.0) ?
+        drawnTriangles/(totalMilliseconds/1000.0) : 0.0;
+
+    ostringstream json;
+    json << "{" << endl;
+    json << "  \"object\": " << jsonString(options.objectPath) << "," << endl;
+    json << "  \"renderer\": " << jsonString((const char*)glGetString(GL_RENDERER)) << "," << endl;
+    json << "  \"frames\": " << frameTimes.size() << "," << endl;
+    json << "  \"optimized\": " << (options.optimizeMesh ? "true" : "false") << "," << endl;
+    json << "  \"lods\": " << (options.generateLODs ? "true" : "false") << "," << endl;
+    json << "  \"packed\": " << (options.packedVertices ? "true" : "false") << "," << endl;
+    json << "  \"instances\": " << window.objectCount() << "," << endl;
+    json << "  \"instancing\": " << (options.instancing ? "true" : "false") << "," << endl;
+    json << "  \"uniform_buffers\": " << (options.uniformBuffers ? "true" : "false") << "," << endl;
+    json << "  \"indirect\": " << (window.indirectDrawing ? "true" : "false") << "," << endl;
+    if(window.indirectDrawing)
+    {
+        json << "  \"indirect_vertex_format\": " << jsonString(GeometryArena::vertexFormat()) << ","
+             << endl;
+        json << "  \"indirect_vertex_size\": " << GeometryArena::vertexSize() << "," << endl;
+    }
+    json << "  \"vertex_bytes\": " << window.vertexBytes() << "," << endl;
+    json << "  \"triangles\": " << (long long)triangleCount << "," << endl;
+    json << "  \"load_ms\": " << loadMilliseconds << "," << endl;
+    json << "  \"startup_ms\": " << startupMilliseconds << "," << endl;
+    json << "  \"shader_ms\": " << window.shaderMilliseconds() << "," << endl;
+    json << "  \"program_cache\": " << (options.programCache ? "true" : "false") << "," << endl;
+    json << "  \"frame_ms\": {" << endl;
+    json << "    \"min\": " << (sortedTimes.empty() ? 0.0 : sortedTimes.front()) << "," << endl;
+    json << "    \"median\": " << percentile(sortedTimes, 0.5) << "," << endl;
+    json << "    \"p99\": " << percentile(sortedTimes, 0.99) << "," << endl;
+    json << "    \"max\": " << (sortedTimes.empty() ? 0.0 : sortedTimes.back()) << "," << endl;
+    json << "    \"mean\": " << meanTime << endl;
+    json << "  }," << endl;
+    json << "  \"frame_histogram\": " << jsonHistogram(frameTimes) << "," << endl;
+    if(!options.backgroundLoadPath.empty())
+    {
+        vector<double> sortedLoadTimes(backgroundLoadFrameTimes);
+        sort(sortedLoadTimes.begin(), sortedLoadTimes.end());
+        json << "  \"background_load\": {" << endl;
+        json << "    \"object\": " << jsonString(options.backgroundLoadPath) << "," << endl;
+        json << "    \"load_ms\": " << window.loadMilliseconds() << "," << endl;
+        json << "    \"upload_bytes_per_frame\": " << options.uploadBytesPerFrame << "," << endl;
+        json << "    \"frames\": " << backgroundLoadFrameTimes.size() << "," << endl;
+        json << "    \"frame_ms\": {" << endl;
+        json << "      \"median\": " << percentile(sortedLoadTimes, 0.5) << "," << endl;
+        json << "      \"p99\": " << percentile(sortedLoadTimes, 0.99) << "," << endl;
+        json << "      \"max\": " << (sortedLoadTimes.empty() ? 0.0 : sortedLoadTimes.back()) << endl;
+        json << "    }," << endl;
+        json << "    \"frame_histogram\": " << jsonHistogram(backgroundLoadFrameTimes) << endl;
+        json << "  }," << endl;
+    }
+    json << "  \"gl_calls_per_frame\": {" << endl;
+    json << "    \"calls\": " << (double)glCalls.calls/frameDivisor << "," << endl;
+    json << "    \"skipped\": " << (double)glCalls.skipped/frameDivisor << "," << endl;
+    json << "    \"draws\": " << (double)glCalls.draws/frameDivisor << "," << endl;
+    json << "    \"submit_us\": " << drawMicroseconds/frameDivisor << endl;
+    json << "  }," << endl;
+    json << "  \"culling\": {" << endl;
+    json << "    \"enabled\": " << (options.frustumCulling ? "true" : "false") << "," << endl;
+    json << "    \"visible_per_frame\": " << window.objectCount() - culledObjects/frameDivisor << "," << endl;
+    json << "    \"culled_per_frame\": " << culledObjects/frameDivisor << "," << endl;
+    json << "    \"meshlets\": " << (options.meshletCulling ? "true" : "false") << "," << endl;
+    json << "    \"meshlets_culled_per_frame\": " << culledMeshlets/frameDivisor << "," << endl;
+    json << "    \"meshlet_triangles_culled_per_frame\": " << culledMeshletTriangles/frameDivisor << "," << endl;
+    json << "    \"us_per_frame\": " << cullMicroseconds/frameDivisor << endl;
+    json << "  }," << endl;
+    json << "  \"uploads\": {" << endl;
+    json << "    \"streaming\": " << (options.streamingUploads ? "true" : "false") << "," << endl;
+    json << "    \"persistent\": " << (window.persistentStreaming() ? "true" : "false") << "," << endl;
+    json << "    \"streamed_bytes_per_frame\": " << (double)streamed.bytes/frameDivisor << "," << endl;
+    json << "    \"direct_bytes_per_frame\": " << (double)glCalls.uploadBytes/frameDivisor << "," << endl;
+    json << "    \"stalls\": " << streamed.stalls << "," << endl;
+    json << "    \"stall_us\": " << streamed.stallMicroseconds << endl;
+    json << "  }," << endl;
+    json << "  \"triangles_per_second\": " << trianglesPerSecond << endl;
+    json << "}" << endl;
+
+    window.cleanup();
+    return writeReport(json.str(), options.outputPath);
+}
+
+static string jsonSchedulerStats(const FrameSchedulerStats& stats)
+{
+    ostringstream json;
+    json << "{\"seconds\": " << stats.seconds << ", \"frames\": " << stats.frames
+         << ", \"fps\": " << ((stats.seconds > 0.0) ? stats.frames/stats.seconds : 0.0)
+         << ", \"cpu_percent\": " << stats.cpuPercent << ", \"inputs\": " << stats.inputs
+         << ", \"latency_ms\": {\"mean\": " << stats.meanLatencyMilliseconds
+         << ", \"max\": " << stats.maxLatencyMilliseconds << "}}";
+    return json.str();
+}
+
+int runPacingBenchmark(const PacingBenchmarkOptions& options)
+{
+    OpenGLWindow window;
+    window.object_1 = options.objectPath;
+    window.initGL();
+    Uint32 inputEvent = SDL_RegisterEvents(1);
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+
+    ostringstream json;
+    json << "{" << endl;
+    json << "  \"object\": " << jsonString(options.objectPath) << "," << endl;
+    json << "  \"renderer\": " << jsonString((const char*)glGetString(GL_RENDERER)) << "," << endl;
+    json << "  \"target_fps\": " << options.targetFPS << "," << endl;
+    json << "  \"inputs_per_second\": " << options.inputsPerSecond << "," << endl;
+    json << "  \"modes\": [" << endl;
+    RenderMode modes[3] = {RENDER_ON_DEMAND, RENDER_FIXED_RATE, RENDER_UNTHROTTLED};
+    for(int m=0; m<3; m++)
+    {
+        FrameScheduler scheduler(modes[m], options.targetFPS);
+        SDL_GL_SetSwapInterval(scheduler.wantsVsync() ? 1 : 0);
+        Uint64 phaseEnd = 0;
+        std::function<bool()> phaseOver = [&]() { return SDL_GetPerformanceCounter() >= phaseEnd; };
+
+        // Nothing happening, after the first frame
+        window.requestRedraw();
+        scheduler.takeStats();
+        phaseEnd = SDL_GetPerformanceCounter() + (Uint64)(options.phaseSeconds*frequency);
+        runEventLoop(window, scheduler, 0.0, phaseOver);
+        FrameSchedulerStats idle = scheduler.takeStats();
+
+        // Events at random (exponentially distributed) intervals, as if from a user
+        std::atomic<bool> injecting(true);
+        std::thread injector([&]()
+        {
+            std::mt19937 random(m);
+            std::exponential_distribution<double> interval(options.inputsPerSecond);
+            while(injecting)
+            {
+                std::this_thread::sleep_for(std::chrono::duration<double>(interval(random)));
+                SDL_Event e;
+                memset(&e, 0, sizeof(e));
+                e.type = inputEvent;
+                SDL_PushEvent(&e);
+            }
+        });
+        phaseEnd = SDL_GetPerformanceCounter() + (Uint64)(options.phaseSeconds*frequency);
+        runEventLoop(window, scheduler, 0.0, phaseOver);
+        injecting = false;
+        injector.join();
+        FrameSchedulerStats input = scheduler.takeStats();
+        SDL_FlushEvent(inputEvent);
+
+        cout << FrameScheduler::modeName(modes[m]) << ": idle CPU " << idle.cpuPercent << "%, "
+             << "input latency " << input.meanLatencyMilliseconds << " ms mean / "
+             << input.maxLatencyMilliseconds << " ms max" << endl;
+        json << "    {\"mode\": " << jsonString(FrameScheduler::modeName(modes[m]))
+             << ", \"idle\": " << jsonSchedulerStats(idle)
+             << ", \"input\": " << jsonSchedulerStats(input) << "}" << ((m < 2) ? "," : "") << endl;
+    }
+    json << "  ]" << endl;
+    json << "}" << endl;
+
+    window.cleanup();
+    return writeReport(json.str(), options.outputPath);
+}
+
+int runEventBenchmark(const EventBenchmarkOptions& options)
+{
+    OpenGLWindow window;
+    window.object_1 = options.objectPath;
+    window.offscreen = true;
+    window.verbose = false;
+    window.initGL();
+    window.addCopies(options.instanceCount);
+    for(size_t i=0; i<options.bindings.size(); i++)
+    {
+        if(!window.keyBindings.bind(options.bindings[i]))
+        {
+            cout << "Unable to bind " << options.bindings[i] << endl;
+            window.cleanup();
+            return 1;
+        }
+    }
+    window.keyBindings.unbind(COMMAND_QUIT);
+    window.keyBindings.unbind(COMMAND_ADD_OBJECT);
+    window.keyBindings.unbind(COMMAND_REMOVE);
+
+    InputRecording input;
+    if(options.replayPath.empty())
+    {
+        input.synthesize(window.keyBindings, options.eventCount, options.seed, 640, 480);
+    }
+    else if(!input.load(options.replayPath))
+    {
+        cout << "Unable to load the input recording " << options.replayPath << endl;
+        window.cleanup();
+        return 1;
+    }
+    const vector<SDL_Event>& events = input.events();
+    int keys = 0;
+    int clicks = 0;
+    for(size_t i=0; i<events.size(); i++)
+    {
+        keys += (events[i].type == SDL_KEYDOWN);
+        clicks += (events[i].type == SDL_MOUSEBUTTONDOWN);
+    }
+
+    // NOTE: Every pass starts in the same mode and axis, so the clicks in them do the same work.
+    //       Made up clicks undo each other, but what's selected carries over from the pass before
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    TransformMode startMode = window.mode;
+    Axis startAxis = window.axis;
+    vector<double> passSeconds;
+    for(int pass=0; pass<std::max(options.passes, 1); pass++)
+    {
+        window.mode = startMode;
+        window.axis = startAxis;
+        Uint64 passStart = SDL_GetPerformanceCounter();
+        for(size_t i=0; i<events.size(); i++)
+        {
+            window.handleEvent(events[i]);
+        }
+        passSeconds.push_back((double)(SDL_GetPerformanceCounter() - passStart)/frequency);
+    }
+    double fastest = *std::min_element(passSeconds.begin(), passSeconds.end());
+    double mean = 0.0;
+    for(size_t i=0; i<passSeconds.size(); i++)
+    {
+        mean += passSeconds[i]/passSeconds.size();
+    }
+    double eventsPerSecond = (fastest > 0.0) ? events.size()/fastest : 0.0;
+    cout << events.size() << " events in " << 1000.0*fastest << " ms: " << eventsPerSecond/1.0e6
+         << " million events/s" << endl;
+
+    ostringstream json;
+    json << "{" << endl;
+    json << "  \"object\": " << jsonString(options.objectPath) << "," << endl;
+    json << "  \"objects\": " << window.objectCount() << "," << endl;
+    json << "  \"source\": " << jsonString(options.replayPath.empty() ? "synthetic" : options.replayPath) << "," << endl;
+    json << "  \"seed\": " << options.seed << "," << endl;
+    json << "  \"events\": " << events.size() << "," << endl;
+    json << "  \"key_presses\": " << keys << "," << endl;
+    json << "  \"clicks\": " << clicks << "," << endl;
+    json << "  \"passes\": " << passSeconds.size() << "," << endl;
+    json << "  \"fastest_pass_ms\": " << 1000.0*fastest << "," << endl;
+    json << "  \"mean_pass_ms\": " << 1000.0*mean << "," << endl;
+    json << "  \"events_per_second\": " << eventsPerSecond << "," << endl;
+    json << "  \"nanoseconds_per_event\": " << ((events.size() > 0) ? 1.0e9*fastest/events.size() : 0.0) << endl;
+    json << "}" << endl;
+
+    window.cleanup();
+    return writeReport(json.str(), options.outputPath);
+}
+
+// The file name of a path without its directory or extension, to name the images after
+static string baseName(const string& path)
+{
+    size_t start = path.find_last_of("/\\");
+    start = (start == string::npos) ? 0 : start+1;
+    size_t end = path.find_last_of('.');
+    end = ((end == string::npos) || (end < start)) ? path.size() : end;
+    return path.substr(start, end - start);
+}
+
+// The viewer's projection (with the aspect ratio of the image) and a camera looking at the origin
+static glm::mat4 rasterViewProjection(const RasterBenchmarkOptions& options, glm::vec3 position)
+{
+    glm::mat4 projection = glm::perspective(glm::radians(30.0f),
+                                            (float)options.width/(float)options.height, 0.1f, 100.0f);
+    return projection*glm::lookAt(position, glm::vec3(0,0,0), glm::vec3(0,1,0));
+}
+
+static void rasterize(SoftwareRasterizer& rasterizer, GeometryData& geometry,
+                      const glm::mat4& viewProjection)
+{
+    rasterizer.clear(glm::vec3(0.0f, 0.0f, 0.0f));
+    rasterizer.draw(geometry, glm::mat4(1.0f), viewProjection);
+    rasterizer.finish();
+}
+
+int runRasterBenchmark(const RasterBenchmarkOptions& options)
+{
+    SoftwareRasterizer rasterizer(options.threadCount);
+    rasterizer.resize(options.width, options.height);
+    SoftwareRasterizer referenceRasterizer(1);
+    referenceRasterizer.resize(options.width, options.height);
+    GeometryLoadOptions loadOptions;
+    loadOptions.optimizeMesh = true;
+    loadOptions.generateLODs = true;
+    bool passed = true;
+
+    ostringstream json;
+    json << "{" << endl;
+    json << "  \"instruction_set\": " << jsonString(SoftwareRasterizer::instructionSet()) << "," << endl;
+    json << "  \"threads\": " << rasterizer.threadCount() << "," << endl;
+    json << "  \"width\": " << options.width << "," << endl;
+    json << "  \"height\": " << options.height << "," << endl;
+    json << "  \"objects\": [" << endl;
+    for(size_t object=0; object<options.objectPaths.size(); object++)
+    {
+        const string& path = options.objectPaths[object];
+        string name = baseName(path);
+        GeometryData geometry;
+        geometry.loadFromOBJFile(path, loadOptions);
+        if(geometry.vertexCount() == 0)
+        {
+            cout << "Unable to load " << path << endl;
+            return 1;
+        }
+
+        // The still image, from where the viewer's camera starts
+        glm::mat4 stillViewProjection = rasterViewProjection(options, glm::vec3(3,3,3));
+        rasterize(rasterizer, geometry, stillViewProjection);
+        RasterStats stats = rasterizer.stats();
+        vector<unsigned char> image;
+        rasterizer.readPixels(&image);
+        rasterize(referenceRasterizer, geometry, stillViewProjection);
+        vector<unsigned char> referenceImage;
+        referenceRasterizer.readPixels(&referenceImage);
+        bool deterministic = (image == referenceImage);
+        if(!deterministic)
+        {
+            cout << name << ": the image differs between " << rasterizer.threadCount()
+                 << " threads and 1" << endl;
+            passed = false;
+        }
+
+        if(!options.imageDirectory.empty())
+        {
+            string imagePath = options.imageDirectory + "/" + name;
+            if(!writePPM(imagePath + ".ppm", options.width, options.height, image.data()) ||
+               (options.png && !writePNG(imagePath + ".png", options.width, options.height, image.data())))
+            {
+                cout << "Unable to write " << imagePath << endl;
+                return 1;
+            }
+        }
+
+        int differentPixels = -1;
+        if(!options.goldenDirectory.empty())
+        {
+            string goldenPath = options.goldenDirectory + "/" + name + ".ppm";
+            int goldenWidth = 0;
+            int goldenHeight = 0;
+            vector<unsigned char> golden;
+            if(!readPPM(goldenPath, &goldenWidth, &goldenHeight, &golden) ||
+               (goldenWidth != options.width) || (goldenHeight != options.height))
+            {
+                cout << name << ": no " << options.width << "x" << options.height
+                     << " golden image at " << goldenPath << endl;
+                passed = false;
+            }
+            else
+            {
+                differentPixels = countDifferentPixels(image.data(), golden.data(), options.width,
+                                                       options.height, options.pixelThreshold);
+                if(differentPixels > options.tolerance*options.width*options.height)
+                {
+                    cout << name << ": " << differentPixels << " pixels differ from " << goldenPath << endl;
+                    passed = false;
+                }
+            }
+        }
+
+        vector<double> frameTimes;
+        frameTimes.reserve(options.frameCount);
+        for(int frame=0; frame<options.frameCount; frame++)
+        {
+            glm::mat4 viewProjection = rasterViewProjection(options, orbitPosition(frame, options.frameCount));
+            chrono::steady_clock::time_point frameStart = chrono::steady_clock::now();
+            rasterize(rasterizer, geometry, viewProjection);
+            frameTimes.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - frameStart).count());
+        }
+        vector<double> sortedTimes(frameTimes);
+        sort(sortedTimes.begin(), sortedTimes.end());
+        double medianTime = percentile(sortedTimes, 0.5);
+        cout << name << ": " << medianTime << " ms a frame" << endl;
+
+        json << "    {" << endl;
+        json << "      \"object\": " << jsonString(path) << "," << endl;
+        json << "      \"triangles\": " << stats.triangles << "," << endl;
+        json << "      \"culled\": " << stats.culled << "," << endl;
+        json << "      \"clipped\": " << stats.clipped << "," << endl;
+        json << "      \"tile_triangles\": " << stats.binned << "," << endl;
+        json << "      \"deterministic\": " << (deterministic ? "true" : "false") << "," << endl;
+        if(differentPixels >= 0)
+        {
+            json << "      \"golden_different_pixels\": " << differentPixels << "," << endl;
+        }
+        json << "      \"frames\": " << frameTimes.size() << "," << endl;
+        json << "      \"frame_ms\": {" << endl;
+        json << "        \"min\": " << (sortedTimes.empty() ? 0.0 : sortedTimes.front()) << "," << endl;
+        json << "        \"median\": " << medianTime << "," << endl;
+        json << "        \"p99\": " << percentile(sortedTimes, 0.99) << "," << endl;
+        json << "        \"max\": " << (sortedTimes.empty() ? 0.0 : sortedTimes.back()) << endl;
+        json << "      }," << endl;
+        json << "      \"fps\": " << ((medianTime > 0.0) ? 1000.0/medianTime : 0.0) << endl;
+        json << "    }" << ((object+1 < options.objectPaths.size()) ? "," : "") << endl;
+    }
+    json << "  ]," << endl;
+    json << "  \"passed\": " << (passed ? "true" : "false") << endl;
+    json << "}" << endl;
+
+    int result = writeReport(json.str(), options.outputPath);
+    return passed ? result : 1;
+}
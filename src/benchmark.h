@@ -0,0 +1,127 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <vector>
+
+struct FrameBenchmarkOptions
+{
+    std::string objectPath;
+    int frameCount = 300;
+    // Frames rendered (and thrown away) before timing starts, so shader compilation and first
+    // use of the buffers don't end up in the numbers
+    int warmupFrames = 10;
+    // Load the object with the vertex cache/overdraw optimization, as the viewer does
+    bool optimizeMesh = true;
+    // Generate LODs and let the renderer pick one each frame, as the viewer does
+    bool generateLODs = true;
+    // Upload packed interleaved vertices, as the viewer does
+    bool packedVertices = true;
+    // Copies of the object to draw, in a grid that takes up the space of the one object
+    int instanceCount = 1;
+    // Draw the copies with one instanced call per LOD, as the viewer does, rather than one each
+    bool instancing = true;
+    // Skip objects outside the view, as the viewer does
+    bool frustumCulling = true;
+    // Split the object into meshlets and skip the ones out of view or facing away (see
+    // OpenGLWindow::meshletCulling), which the viewer doesn't do
+    bool meshletCulling = false;
+    // Draw the whole scene with one indirect call out of a shared geometry arena (see
+    // OpenGLWindow::indirectDrawing), which the viewer doesn't do. Overrides instancing
+    bool indirectDrawing = false;
+    // Give objects drawn one at a time their model matrices from a uniform buffer written once per
+    // frame, as the viewer does, rather than an MVP uniform each
+    bool uniformBuffers = true;
+    // Send uploads and instance matrices through the stream buffer, as the viewer does
+    bool streamingUploads = true;
+    // Load the shaders from the program cache when there's a valid one, as the viewer does
+    bool programCache = true;
+    // Another object to load in the background once timing starts. The run goes on until it has
+    // been added, and the frames drawn meanwhile get their own statistics and histogram
+    std::string backgroundLoadPath;
+    // Most of the background loaded mesh to upload per frame, as the viewer does (0 for all at once)
+    int uploadBytesPerFrame = 4 << 20;
+    // Where to write the JSON report. Empty means stdout
+    std::string outputPath;
+};
+
+struct PacingBenchmarkOptions
+{
+    std::string objectPath;
+    // How long each render mode runs with no input, and then again with input
+    double phaseSeconds = 5.0;
+    // Frame rate of the fixed rate mode
+    double targetFPS = 60.0;
+    // Average rate of the simulated input
+    double inputsPerSecond = 20.0;
+    // Where to write the JSON report. Empty means stdout
+    std::string outputPath;
+};
+
+struct EventBenchmarkOptions
+{
+    std::string objectPath;
+    // Copies of the object in the scene, for clicks to pick and transform
+    int instanceCount = 1;
+    // A recording to replay (see OpenGLWindow::recording). Empty means made up events
+    std::string replayPath;
+    // How many events to make up, and the seed to make them from
+    int eventCount = 1000000;
+    unsigned int seed = 1;
+    // Times the events are handled over. The fastest pass is the one reported
+    int passes = 5;
+    // Key bindings to change first, as "key=command" (see KeyBindings::bind)
+    std::vector<std::string> bindings;
+    // Where to write the JSON report. Empty means stdout
+    std::string outputPath;
+};
+
+struct RasterBenchmarkOptions
+{
+    // Objects to render, one after another
+    std::vector<std::string> objectPaths;
+    int width = 640;
+    int height = 480;
+    // Frames timed per object while the camera orbits it
+    int frameCount = 100;
+    // Threads to rasterize with. 0 means one per hardware core
+    int threadCount = 0;
+    // Where to write each object's image, as <name>.ppm. Empty means nowhere
+    std::string imageDirectory;
+    // Write a <name>.png next to each PPM too
+    bool png = false;
+    // Where the golden images to compare against are, as <name>.ppm. Empty means no comparing
+    std::string goldenDirectory;
+    // Channels may differ from the golden image by this much before a pixel counts as different
+    int pixelThreshold = 2;
+    // Fraction of the pixels allowed to differ before an image fails
+    double tolerance = 0.001;
+    // Where to write the JSON report. Empty means stdout
+    std::string outputPath;
+};
+
+// Renders an object offscreen for a number of frames while the camera orbits it, and reports
+// frame time statistics, triangle throughput and load time as JSON. Expects SDL to be initialized
+int runFrameBenchmark(const FrameBenchmarkOptions& options);
+
+// Runs the interactive event loop (see FrameScheduler) with the object in a window, in each render
+// mode in turn: first with nothing happening, to measure idle CPU use, then with events pushed
+// from another thread at random intervals, to measure the latency from each one to the frame
+// showing it. Reports both as JSON. Expects SDL to be initialized
+int runPacingBenchmark(const PacingBenchmarkOptions& options);
+
+// Hands a stream of events (a recording, or made up ones) straight to OpenGLWindow::handleEvent as
+// fast as it can, with the object loaded into an offscreen window but nothing drawn, and reports
+// how many events a second it gets through as JSON. The same stream and bindings give the same
+// work every time. Keys bound to quitting, adding and removing objects are unbound, since those
+// would stop the run or change the scene from one pass to the next. Expects SDL to be initialized
+int runEventBenchmark(const EventBenchmarkOptions& options);
+
+// Draws each object with the SoftwareRasterizer: one image from the viewer's starting camera
+// (written out and compared against the golden one, when asked), then timed frames with the camera
+// orbiting as in runFrameBenchmark. The image is drawn again on one thread to check the result
+// doesn't depend on the thread count. Reports the timings and comparisons as JSON, and fails if
+// any image doesn't match. Needs neither SDL video nor GL, so it runs on machines without a GPU
+int runRasterBenchmark(const RasterBenchmarkOptions& options);
+
+#endif
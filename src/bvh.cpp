@@ -0,0 +1,465 @@
+#include <algorithm>
+#include <string.h>
+
+#include "bvh.h"
+
+// Candidate split positions tried along each axis
+static const int SAH_BIN_COUNT = 12;
+
+static float surfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    glm::vec3 size = boundsMax - boundsMin;
+    return 2.0f*(size.x*size.y + size.y*size.z + size.z*size.x);
+}
+
+// Where a box is relative to a frustum
+enum FrustumOverlap
+{
+    FRUSTUM_OUTSIDE,
+    FRUSTUM_INTERSECTS,
+    FRUSTUM_INSIDE
+};
+
+// NOTE: For each plane only the box corner furthest along the plane's normal can decide that the
+//       box is outside, and only the nearest corner can decide that it isn't entirely inside
+static FrustumOverlap classifyBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                                  const glm::vec4 planes[6])
+{
+    FrustumOverlap overlap = FRUSTUM_INSIDE;
+    for(int i=0; i<6; i++)
+    {
+        const glm::vec4& plane = planes[i];
+        glm::vec3 furthest((plane.x > 0.0f) ? boundsMax.x : boundsMin.x,
+                           (plane.y > 0.0f) ? boundsMax.y : boundsMin.y,
+                           (plane.z > 0.0f) ? boundsMax.z : boundsMin.z);
+        if(plane.x*furthest.x + plane.y*furthest.y + plane.z*furthest.z + plane.w < 0.0f)
+        {
+            return FRUSTUM_OUTSIDE;
+        }
+        glm::vec3 nearest((plane.x > 0.0f) ? boundsMin.x : boundsMax.x,
+                          (plane.y > 0.0f) ? boundsMin.y : boundsMax.y,
+                          (plane.z > 0.0f) ? boundsMin.z : boundsMax.z);
+        if(plane.x*nearest.x + plane.y*nearest.y + plane.z*nearest.z + plane.w < 0.0f)
+        {
+            overlap = FRUSTUM_INTERSECTS;
+        }
+    }
+    return overlap;
+}
+
+// Returns the distance along the ray where it enters the box, or a negative number if it misses
+// the box or only gets to it after maxDistance
+static float rayEntersBox(const glm::vec3& origin, const glm::vec3& inverseDirection,
+                          float maxDistance, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    glm::vec3 t1 = (boundsMin - origin)*inverseDirection;
+    glm::vec3 t2 = (boundsMax - origin)*inverseDirection;
+    glm::vec3 entries = glm::min(t1, t2);
+    glm::vec3 exits = glm::max(t1, t2);
+    float entry = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+    float exit = std::min(std::min(exits.x, exits.y), std::min(exits.z, maxDistance));
+    return (entry <= exit) ? entry : -1.0f;
+}
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+}
+
+void BoundingVolumeHierarchy::build(const glm::vec3* boundsMin, const glm::vec3* boundsMax,
+                                    size_t count, int maxLeafSize)
+{
+    nodeArray.clear();
+    primitiveIndices.resize(count);
+    for(size_t i=0; i<count; i++)
+    {
+        primitiveIndices[i] = i;
+    }
+    if(count == 0)
+    {
+        primitiveMin.clear();
+        primitiveMax.clear();
+        return;
+    }
+    maxLeafSize = std::max(maxLeafSize, 1);
+
+    std::vector<glm::vec3> centroids(count);
+    for(size_t i=0; i<count; i++)
+    {
+        centroids[i] = 0.5f*(boundsMin[i] + boundsMax[i]);
+    }
+
+    BVHNode root;
+    root.first = 0;
+    root.count = count;
+    nodeArray.reserve(2*count/maxLeafSize + 1);
+    nodeArray.push_back(root);
+
+    std::vector<unsigned int> stack(1, 0);
+    while(!stack.empty())
+    {
+        unsigned int nodeIndex = stack.back();
+        stack.pop_back();
+        unsigned int first = nodeArray[nodeIndex].first;
+        unsigned int nodeCount = nodeArray[nodeIndex].count;
+        unsigned int* primitives = &primitiveIndices[first];
+
+        glm::vec3 nodeMin = boundsMin[primitives[0]];
+        glm::vec3 nodeMax = boundsMax[primitives[0]];
+        glm::vec3 centroidMin = centroids[primitives[0]];
+        glm::vec3 centroidMax = centroidMin;
+        for(unsigned int i=1; i<nodeCount; i++)
+        {
+            nodeMin = glm::min(nodeMin, boundsMin[primitives[i]]);
+            nodeMax = glm::max(nodeMax, boundsMax[primitives[i]]);
+            centroidMin = glm::min(centroidMin, centroids[primitives[i]]);
+            centroidMax = glm::max(centroidMax, centroids[primitives[i]]);
+        }
+        nodeArray[nodeIndex].boundsMin = nodeMin;
+        nodeArray[nodeIndex].boundsMax = nodeMax;
+        if((int)nodeCount <= maxLeafSize)
+        {
+            continue;
+        }
+
+        // Sort the centroids into bins along each axis, and pick the boundary between bins where
+        // the surface area of each side times its primitive count adds up to the least
+        int bestAxis = -1;
+        int bestSplit = 0;
+        float bestCost = 0.0f;
+        for(int axis=0; axis<3; axis++)
+        {
+            float extent = centroidMax[axis] - centroidMin[axis];
+            if(extent <= 0.0f)
+            {
+                continue;
+            }
+            float binScale = SAH_BIN_COUNT/extent;
+            int binCounts[SAH_BIN_COUNT] = {0};
+            glm::vec3 binMin[SAH_BIN_COUNT];
+            glm::vec3 binMax[SAH_BIN_COUNT];
+            for(unsigned int i=0; i<nodeCount; i++)
+            {
+                unsigned int primitive = primitives[i];
+                int bin = std::min((int)((centroids[primitive][axis] - centroidMin[axis])*binScale),
+                                   SAH_BIN_COUNT-1);
+                if(binCounts[bin] == 0)
+                {
+                    binMin[bin] = boundsMin[primitive];
+                    binMax[bin] = boundsMax[primitive];
+                }
+                else
+                {
+                    binMin[bin] = glm::min(binMin[bin], boundsMin[primitive]);
+                    binMax[bin] = glm::max(binMax[bin], boundsMax[primitive]);
+                }
+                binCounts[bin]++;
+            }
+
+            // Left side costs from a sweep up, then the right side from a sweep down
+            float leftCost[SAH_BIN_COUNT];
+            int leftCount = 0;
+            glm::vec3 leftMin(0.0f), leftMax(0.0f);
+            for(int bin=0; bin<SAH_BIN_COUNT-1; bin++)
+            {
+                if(binCounts[bin] > 0)
+                {
+                    leftMin = (leftCount > 0) ? glm::min(leftMin, binMin[bin]) : binMin[bin];
+                    leftMax = (leftCount > 0) ? glm::max(leftMax, binMax[bin]) : binMax[bin];
+                    leftCount += binCounts[bin];
+                }
+                leftCost[bin] = leftCount*surfaceArea(leftMin, leftMax);
+            }
+            int rightCount = 0;
+            glm::vec3 rightMin(0.0f), rightMax(0.0f);
+            for(int bin=SAH_BIN_COUNT-1; bin>0; bin--)
+            {
+                if(binCounts[bin] > 0)
+                {
+                    rightMin = (rightCount > 0) ? glm::min(rightMin, binMin[bin]) : binMin[bin];
+                    rightMax = (rightCount > 0) ? glm::max(rightMax, binMax[bin]) : binMax[bin];
+                    rightCount += binCounts[bin];
+                }
+                if((rightCount == 0) || (rightCount == (int)nodeCount))
+                {
+                    continue;
+                }
+                float cost = leftCost[bin-1] + rightCount*surfaceArea(rightMin, rightMax);
+                if((bestAxis < 0) || (cost < bestCost))
+                {
+                    bestAxis = axis;
+                    bestSplit = bin;
+                    bestCost = cost;
+                }
+            }
+        }
+
+        unsigned int leftCount = 0;
+        if(bestAxis >= 0)
+        {
+            float splitMin = centroidMin[bestAxis];
+            float binScale = SAH_BIN_COUNT/(centroidMax[bestAxis] - splitMin);
+            unsigned int* middle = std::partition(primitives, primitives + nodeCount,
+                [&](unsigned int primitive)
+                {
+                    int bin = std::min((int)((centroids[primitive][bestAxis] - splitMin)*binScale),
+                                       SAH_BIN_COUNT-1);
+                    return bin < bestSplit;
+                });
+            leftCount = middle - primitives;
+        }
+        // Every centroid is in the same place, so any split is as good as another
+        if((leftCount == 0) || (leftCount == nodeCount))
+        {
+            leftCount = nodeCount/2;
+        }
+
+        BVHNode left;
+        left.first = first;
+        left.count = leftCount;
+        BVHNode right;
+        right.first = first + leftCount;
+        right.count = nodeCount - leftCount;
+        unsigned int leftIndex = nodeArray.size();
+        nodeArray[nodeIndex].first = leftIndex;
+        nodeArray[nodeIndex].count = 0;
+        nodeArray.push_back(left);
+        nodeArray.push_back(right);
+        stack.push_back(leftIndex);
+        stack.push_back(leftIndex + 1);
+    }
+
+    primitiveMin.resize(count);
+    primitiveMax.resize(count);
+    for(size_t i=0; i<count; i++)
+    {
+        primitiveMin[i] = boundsMin[primitiveIndices[i]];
+        primitiveMax[i] = boundsMax[primitiveIndices[i]];
+    }
+}
+
+// NOTE: Children always come after their parent in the array, so going through it backwards
+//       visits every node after its children
+void BoundingVolumeHierarchy::refit(const glm::vec3* boundsMin, const glm::vec3* boundsMax)
+{
+    for(size_t i=0; i<primitiveIndices.size(); i++)
+    {
+        primitiveMin[i] = boundsMin[primitiveIndices[i]];
+        primitiveMax[i] = boundsMax[primitiveIndices[i]];
+    }
+    for(size_t nodeIndex=nodeArray.size(); nodeIndex-->0; )
+    {
+        BVHNode& node = nodeArray[nodeIndex];
+        if(node.count > 0)
+        {
+            node.boundsMin = primitiveMin[node.first];
+            node.boundsMax = primitiveMax[node.first];
+            for(unsigned int i=node.first+1; i<node.first+node.count; i++)
+            {
+                node.boundsMin = glm::min(node.boundsMin, primitiveMin[i]);
+                node.boundsMax = glm::max(node.boundsMax, primitiveMax[i]);
+            }
+        }
+        else
+        {
+            const BVHNode& left = nodeArray[node.first];
+            const BVHNode& right = nodeArray[node.first + 1];
+            node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+            node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+        }
+    }
+}
+
+size_t BoundingVolumeHierarchy::cullFrustum(const glm::vec4 planes[6], unsigned char* visible)
+{
+    memset(visible, 0, primitiveIndices.size());
+    if(nodeArray.empty())
+    {
+        return 0;
+    }
+
+    // Each entry is a node index, with the top bit set when the node is known to be inside
+    const unsigned int INSIDE_BIT = 0x80000000u;
+    size_t visibleCount = 0;
+    traversalStack.clear();
+    traversalStack.push_back(0);
+    while(!traversalStack.empty())
+    {
+        unsigned int entry = traversalStack.back();
+        traversalStack.pop_back();
+        const BVHNode& node = nodeArray[entry & ~INSIDE_BIT];
+        bool inside = (entry & INSIDE_BIT) != 0;
+        if(!inside)
+        {
+            FrustumOverlap overlap = classifyBox(node.boundsMin, node.boundsMax, planes);
+            if(overlap == FRUSTUM_OUTSIDE)
+            {
+                continue;
+            }
+            inside = (overlap == FRUSTUM_INSIDE);
+        }
+
+        if(node.count == 0)
+        {
+            unsigned int flag = inside ? INSIDE_BIT : 0;
+            traversalStack.push_back(node.first | flag);
+            traversalStack.push_back((node.first + 1) | flag);
+            continue;
+        }
+        for(unsigned int i=node.first; i<node.first+node.count; i++)
+        {
+            if(inside || (classifyBox(primitiveMin[i], primitiveMax[i], planes) != FRUSTUM_OUTSIDE))
+            {
+                visible[primitiveIndices[i]] = 1;
+                visibleCount++;
+            }
+        }
+    }
+    return visibleCount;
+}
+
+int BoundingVolumeHierarchy::raycast(const glm::vec3& origin, const glm::vec3& direction,
+    float maxDistance, const std::function<float(unsigned int primitive, float closest)>& intersect,
+    float* distance)
+{
+    glm::vec3 inverseDirection = 1.0f/direction;
+    return raycastLeaves(origin, direction, maxDistance,
+        [&](unsigned int first, unsigned int count, float* closest)
+        {
+            int closestPrimitive = -1;
+            for(unsigned int i=first; i<first+count; i++)
+            {
+                if(rayEntersBox(origin, inverseDirection, *closest, primitiveMin[i], primitiveMax[i]) < 0.0f)
+                {
+                    continue;
+                }
+                float hit = intersect(primitiveIndices[i], *closest);
+                if(hit < *closest)
+                {
+                    *closest = hit;
+                    closestPrimitive = primitiveIndices[i];
+                }
+            }
+            return closestPrimitive;
+        }, distance);
+}
+
+int BoundingVolumeHierarchy::raycastLeaves(const glm::vec3& origin, const glm::vec3& direction,
+    float maxDistance, const std::function<int(unsigned int first, unsigned int count, float* closest)>& intersectLeaf,
+    float* distance)
+{
+    int closestPrimitive = -1;
+    float closest = maxDistance;
+    if(nodeArray.empty())
+    {
+        if(distance)
+        {
+            *distance = closest;
+        }
+        return -1;
+    }
+
+    glm::vec3 inverseDirection = 1.0f/direction;
+
+    // The nearer child goes on the stack last, so it's searched first and the closest hit so far
+    // can rule out more of the further one
+    traversalStack.clear();
+    traversalStack.push_back(0);
+    while(!traversalStack.empty())
+    {
+        const BVHNode& node = nodeArray[traversalStack.back()];
+        traversalStack.pop_back();
+        if(rayEntersBox(origin, inverseDirection, closest, node.boundsMin, node.boundsMax) < 0.0f)
+        {
+            continue;
+        }
+
+        if(node.count > 0)
+        {
+            int hit = intersectLeaf(node.first, node.count, &closest);
+            if(hit >= 0)
+            {
+                closestPrimitive = hit;
+            }
+            continue;
+        }
+
+        const BVHNode& left = nodeArray[node.first];
+        const BVHNode& right = nodeArray[node.first + 1];
+        float leftEntry = rayEntersBox(origin, inverseDirection, closest, left.boundsMin, left.boundsMax);
+        float rightEntry = rayEntersBox(origin, inverseDirection, closest, right.boundsMin, right.boundsMax);
+        if((leftEntry >= 0.0f) && (rightEntry >= 0.0f))
+        {
+            bool leftFirst = (leftEntry <= rightEntry);
+            traversalStack.push_back(leftFirst ? node.first + 1 : node.first);
+            traversalStack.push_back(leftFirst ? node.first : node.first + 1);
+        }
+        else if(leftEntry >= 0.0f)
+        {
+            traversalStack.push_back(node.first);
+        }
+        else if(rightEntry >= 0.0f)
+        {
+            traversalStack.push_back(node.first + 1);
+        }
+    }
+
+    if(distance)
+    {
+        *distance = closest;
+    }
+    return closestPrimitive;
+}
+
+void BoundingVolumeHierarchy::queryPoint(const glm::vec3& point, std::vector<unsigned int>* primitives)
+{
+    if(nodeArray.empty())
+    {
+        return;
+    }
+    traversalStack.clear();
+    traversalStack.push_back(0);
+    while(!traversalStack.empty())
+    {
+        const BVHNode& node = nodeArray[traversalStack.back()];
+        traversalStack.pop_back();
+        if(glm::any(glm::lessThan(point, node.boundsMin)) ||
+           glm::any(glm::greaterThan(point, node.boundsMax)))
+        {
+            continue;
+        }
+        if(node.count == 0)
+        {
+            traversalStack.push_back(node.first);
+            traversalStack.push_back(node.first + 1);
+            continue;
+        }
+        for(unsigned int i=node.first; i<node.first+node.count; i++)
+        {
+            if(!glm::any(glm::lessThan(point, primitiveMin[i])) &&
+               !glm::any(glm::greaterThan(point, primitiveMax[i])))
+            {
+                primitives->push_back(primitiveIndices[i]);
+            }
+        }
+    }
+}
+
+size_t BoundingVolumeHierarchy::nodeCount()
+{
+    return nodeArray.size();
+}
+
+size_t BoundingVolumeHierarchy::primitiveCount()
+{
+    return primitiveIndices.size();
+}
+
+const BVHNode* BoundingVolumeHierarchy::nodes()
+{
+    return nodeArray.data();
+}
+
+const unsigned int* BoundingVolumeHierarchy::primitiveOrder()
+{
+    return primitiveIndices.data();
+}
@@ -0,0 +1,76 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include <functional>
+#include <stddef.h>
+
+#include <glm/glm.hpp>
+
+// One node of a BoundingVolumeHierarchy (32 bytes, so two fit in a cache line)
+struct BVHNode
+{
+    glm::vec3 boundsMin;
+    // Leaf: the first of its primitives in the hierarchy's primitive order. Inner node: index of
+    // its first child (the second one comes straight after it)
+    unsigned int first;
+    glm::vec3 boundsMax;
+    // Number of primitives in a leaf, 0 for inner nodes
+    unsigned int count;
+};
+
+// A bounding volume hierarchy over a set of axis-aligned boxes (objects in a scene, triangles of a
+// mesh, ...). It's built top down, splitting each node where the surface area heuristic says
+// rays (and frustums) will have the least work to do, and the nodes are kept in one array with
+// the root first and every node's children next to each other
+class BoundingVolumeHierarchy
+{
+public:
+    BoundingVolumeHierarchy();
+
+    // Builds the hierarchy over count boxes. Leaves hold up to maxLeafSize primitives
+    void build(const glm::vec3* boundsMin, const glm::vec3* boundsMax, size_t count,
+               int maxLeafSize = 4);
+    // Updates the node bounds after the boxes have moved, keeping the same tree. Much faster than
+    // building again, but the tree gets worse as the boxes move further from where they were
+    void refit(const glm::vec3* boundsMin, const glm::vec3* boundsMax);
+
+    // Sets visible[i] to 1 for every box that is at least partly inside the frustum (see
+    // extractFrustumPlanes) and to 0 for the rest, and returns how many were visible. Whole
+    // subtrees are skipped or accepted at once when they're entirely outside or inside
+    size_t cullFrustum(const glm::vec4 planes[6], unsigned char* visible);
+
+    // Finds the closest primitive along a ray. intersect is called for each primitive whose box
+    // the ray enters before the closest hit found so far, with the distance to that hit, and
+    // returns the distance along the ray where it hits the primitive (or anything >= the closest
+    // distance for a miss). Returns the index of the closest primitive hit, or -1 if nothing was
+    // hit before maxDistance, and sets distance to where it was hit
+    int raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                const std::function<float(unsigned int primitive, float closest)>& intersect,
+                float* distance);
+    // The same search, but intersectLeaf is called once for each leaf the ray enters, with the
+    // leaf's range of the primitive order, so that it can test all of them together. It returns
+    // the primitive it found closer than closest (updating closest to the distance) or -1
+    int raycastLeaves(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+        const std::function<int(unsigned int first, unsigned int count, float* closest)>& intersectLeaf,
+        float* distance);
+    // Appends the index of every box that contains the point
+    void queryPoint(const glm::vec3& point, std::vector<unsigned int>* primitives);
+
+    size_t nodeCount();
+    size_t primitiveCount();
+    const BVHNode* nodes();
+    // Primitive indices in the order the leaves refer to them
+    const unsigned int* primitiveOrder();
+
+private:
+    std::vector<BVHNode> nodeArray;
+    std::vector<unsigned int> primitiveIndices;
+    // A copy of each primitive's box, in primitive order so leaves find theirs next to each other
+    std::vector<glm::vec3> primitiveMin;
+    std::vector<glm::vec3> primitiveMax;
+    // Nodes still to visit, kept between queries so they don't allocate
+    std::vector<unsigned int> traversalStack;
+};
+
+#endif
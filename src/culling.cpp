@@ -0,0 +1,152 @@
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "culling.h"
+
+// NOTE: glm matrices are indexed [column][row], so row r of the matrix is m[0][r], m[1][r], ...
+//       (Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-
+//       Projection Matrix")
+void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+    glm::vec4 rows[4];
+    for(int row=0; row<4; row++)
+    {
+        rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row],
+                              viewProjection[2][row], viewProjection[3][row]);
+    }
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[3] + rows[2];
+    planes[5] = rows[3] - rows[2];
+    for(int i=0; i<6; i++)
+    {
+        float length = glm::length(glm::vec3(planes[i]));
+        if(length > 0.0f)
+        {
+            planes[i] /= length;
+        }
+    }
+}
+
+static bool sphereVisible(float x, float y, float z, float radius, const glm::vec4 planes[6])
+{
+    for(int i=0; i<6; i++)
+    {
+        // NOTE: Written so that NaN bounds count as outside, as they do in the SIMD versions
+        if(!(planes[i].x*x + planes[i].y*y + planes[i].z*z + planes[i].w >= -radius))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t cullSpheresScalar(const float* centerX, const float* centerY, const float* centerZ,
+                         const float* radius, size_t count, const glm::vec4 planes[6],
+                         unsigned char* visible)
+{
+    size_t visibleCount = 0;
+    for(size_t i=0; i<count; i++)
+    {
+        visible[i] = sphereVisible(centerX[i], centerY[i], centerZ[i], radius[i], planes);
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
+
+size_t cullSpheres(const float* centerX, const float* centerY, const float* centerZ,
+                   const float* radius, size_t count, const glm::vec4 planes[6],
+                   unsigned char* visible)
+{
+    size_t visibleCount = 0;
+    size_t i = 0;
+
+#if defined(__AVX__)
+    // Eight spheres at a time: a sphere is visible when it's not entirely behind any plane, i.e.
+    // when distance >= -radius holds for all six
+    __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for(int p=0; p<6; p++)
+    {
+        planeX[p] = _mm256_set1_ps(planes[p].x);
+        planeY[p] = _mm256_set1_ps(planes[p].y);
+        planeZ[p] = _mm256_set1_ps(planes[p].z);
+        planeW[p] = _mm256_set1_ps(planes[p].w);
+    }
+    __m256 zero = _mm256_setzero_ps();
+    for(; i+8<=count; i+=8)
+    {
+        __m256 x = _mm256_loadu_ps(centerX + i);
+        __m256 y = _mm256_loadu_ps(centerY + i);
+        __m256 z = _mm256_loadu_ps(centerZ + i);
+        __m256 negativeRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(radius + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for(int p=0; p<6; p++)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x),
+                                                          _mm256_mul_ps(planeY[p], y)),
+                                            _mm256_add_ps(_mm256_mul_ps(planeZ[p], z), planeW[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+        }
+        int mask = _mm256_movemask_ps(inside);
+        // Counted lane by lane, as MSVC has no __builtin_popcount
+        for(int lane=0; lane<8; lane++)
+        {
+            visible[i+lane] = (mask >> lane) & 1;
+            visibleCount += visible[i+lane];
+        }
+    }
+#elif defined(__SSE2__)
+    // Four spheres at a time, as above
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for(int p=0; p<6; p++)
+    {
+        planeX[p] = _mm_set1_ps(planes[p].x);
+        planeY[p] = _mm_set1_ps(planes[p].y);
+        planeZ[p] = _mm_set1_ps(planes[p].z);
+        planeW[p] = _mm_set1_ps(planes[p].w);
+    }
+    __m128 zero = _mm_setzero_ps();
+    for(; i+4<=count; i+=4)
+    {
+        __m128 x = _mm_loadu_ps(centerX + i);
+        __m128 y = _mm_loadu_ps(centerY + i);
+        __m128 z = _mm_loadu_ps(centerZ + i);
+        __m128 negativeRadius = _mm_sub_ps(zero, _mm_loadu_ps(radius + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for(int p=0; p<6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x),
+                                                    _mm_mul_ps(planeY[p], y)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+        int mask = _mm_movemask_ps(inside);
+        for(int lane=0; lane<4; lane++)
+        {
+            visible[i+lane] = (mask >> lane) & 1;
+            visibleCount += visible[i+lane];
+        }
+    }
+#endif
+
+    // Whatever doesn't fill a whole vector
+    visibleCount += cullSpheresScalar(centerX + i, centerY + i, centerZ + i, radius + i,
+                                      count - i, planes, visible + i);
+    return visibleCount;
+}
+
+const char* cullingInstructionSet()
+{
+#if defined(__AVX__)
+    return "AVX";
+#elif defined(__SSE2__)
+    return "SSE";
+#else
+    return "scalar";
+#endif
+}
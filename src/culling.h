@@ -0,0 +1,29 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <stddef.h>
+#include <glm/glm.hpp>
+
+// View frustum culling of bounding spheres. The spheres are passed as separate arrays of x, y, z
+// and radius (rather than one struct per sphere) so that the SIMD version can load 4 or 8 of each
+// at once and test them against a plane together
+
+// Gets the six planes (left, right, bottom, top, near, far) of the frustum of a view projection
+// matrix, in the space the matrix takes points from. Each is (normal, distance) with the normal
+// pointing into the frustum and normalized, so plane.xyz . p + plane.w is a distance
+void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+// Sets visible[i] to 1 for every sphere that is at least partly inside the frustum and to 0 for
+// the rest, and returns how many were visible. Uses AVX or SSE when the build targets them
+size_t cullSpheres(const float* centerX, const float* centerY, const float* centerZ,
+                   const float* radius, size_t count, const glm::vec4 planes[6],
+                   unsigned char* visible);
+// The same test one sphere at a time, as a reference for the above
+size_t cullSpheresScalar(const float* centerX, const float* centerY, const float* centerZ,
+                         const float* radius, size_t count, const glm::vec4 planes[6],
+                         unsigned char* visible);
+
+// "AVX", "SSE" or "scalar", whichever cullSpheres was built with
+const char* cullingInstructionSet();
+
+#endif
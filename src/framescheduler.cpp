@@ -0,0 +1,197 @@
+#include <iostream>
+#include <algorithm>
+
+#include "framescheduler.h"
+#include "glwindow.h"
+
+using namespace std;
+
+// How long on-demand mode sleeps at a time with nothing to draw before letting the loop check on
+// other things (see SCHEDULE_IDLE)
+static const int IDLE_WAIT_MILLISECONDS = 100;
+// Fixed rate frames sleep until this long before they're due and spin for the rest, since sleeps
+// can overshoot by about a millisecond
+static const double SPIN_MILLISECONDS = 2.0;
+
+FrameScheduler::FrameScheduler(RenderMode mode, double targetFPS)
+{
+    renderMode = mode;
+    frequency = SDL_GetPerformanceFrequency();
+    framePeriod = (Uint64)(frequency/std::max(targetFPS, 1.0));
+    nextFrame = SDL_GetPerformanceCounter();
+    lastEventArrival = 0;
+    pendingInputArrival = 0;
+    takeStats();
+}
+
+SchedulerAction FrameScheduler::next(bool redrawWanted, SDL_Event* e)
+{
+    if(renderMode == RENDER_ON_DEMAND)
+    {
+        if(redrawWanted)
+        {
+            return SDL_PollEvent(e) ? eventArrived(*e) : SCHEDULE_FRAME;
+        }
+        return SDL_WaitEventTimeout(e, IDLE_WAIT_MILLISECONDS) ? eventArrived(*e) : SCHEDULE_IDLE;
+    }
+    if(renderMode == RENDER_UNTHROTTLED)
+    {
+        return SDL_PollEvent(e) ? eventArrived(*e) : SCHEDULE_FRAME;
+    }
+
+    if(SDL_PollEvent(e))
+    {
+        return eventArrived(*e);
+    }
+    Uint64 now = SDL_GetPerformanceCounter();
+    if(now < nextFrame)
+    {
+        double remaining = 1000.0*(nextFrame - now)/frequency;
+        if(remaining > SPIN_MILLISECONDS)
+        {
+            // Events wake this up early, so they're handled straight away rather than at the frame
+            if(SDL_WaitEventTimeout(e, (int)(remaining - SPIN_MILLISECONDS + 0.5)))
+            {
+                return eventArrived(*e);
+            }
+            return SCHEDULE_IDLE;
+        }
+        while(SDL_GetPerformanceCounter() < nextFrame)
+        {
+        }
+        now = nextFrame;
+    }
+
+    // NOTE: A frame that's late by more than a whole period starts the schedule again from now,
+    //       rather than drawing a burst of frames to catch up
+    nextFrame += framePeriod;
+    if(nextFrame <= now)
+    {
+        nextFrame = now + framePeriod;
+    }
+    return SCHEDULE_FRAME;
+}
+
+// NOTE: SDL timestamps events (in milliseconds) when it takes them from the OS, which can be a while
+//       before the loop gets to them, so that's counted as when they arrived
+SchedulerAction FrameScheduler::eventArrived(const SDL_Event& e)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint32 ageMilliseconds = SDL_GetTicks() - e.common.timestamp;
+    Uint64 age = (Uint64)ageMilliseconds*frequency/1000;
+    lastEventArrival = (age < now) ? now - age : now;
+    return SCHEDULE_EVENT;
+}
+
+void FrameScheduler::inputHandled()
+{
+    if(pendingInputArrival == 0)
+    {
+        pendingInputArrival = lastEventArrival;
+    }
+}
+
+void FrameScheduler::framePresented()
+{
+    statsFrames++;
+    if(pendingInputArrival != 0)
+    {
+        latencies.push_back(1000.0*(SDL_GetPerformanceCounter() - pendingInputArrival)/frequency);
+        pendingInputArrival = 0;
+    }
+}
+
+FrameSchedulerStats FrameScheduler::takeStats()
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    std::clock_t cpuNow = std::clock();
+
+    FrameSchedulerStats stats;
+    stats.seconds = (double)(now - statsStart)/frequency;
+    stats.frames = statsFrames;
+    // NOTE: clock() is the process's CPU time on POSIX systems, but wall time on Windows
+    if(stats.seconds > 0.0)
+    {
+        stats.cpuPercent = 100.0*(double)(cpuNow - statsCpuStart)/CLOCKS_PER_SEC/stats.seconds;
+    }
+    stats.inputs = latencies.size();
+    for(size_t i=0; i<latencies.size(); i++)
+    {
+        stats.meanLatencyMilliseconds += latencies[i];
+        stats.maxLatencyMilliseconds = std::max(stats.maxLatencyMilliseconds, latencies[i]);
+    }
+    if(!latencies.empty())
+    {
+        stats.meanLatencyMilliseconds /= latencies.size();
+    }
+
+    statsStart = now;
+    statsCpuStart = cpuNow;
+    statsFrames = 0;
+    latencies.clear();
+    return stats;
+}
+
+RenderMode FrameScheduler::mode()
+{
+    return renderMode;
+}
+
+bool FrameScheduler::wantsVsync()
+{
+    return renderMode == RENDER_ON_DEMAND;
+}
+
+const char* FrameScheduler::modeName(RenderMode mode)
+{
+    switch(mode)
+    {
+    case RENDER_ON_DEMAND:
+        return "on-demand";
+    case RENDER_FIXED_RATE:
+        return "fixed";
+    case RENDER_UNTHROTTLED:
+        return "unthrottled";
+    }
+    return "unknown";
+}
+
+void runEventLoop(OpenGLWindow& window, FrameScheduler& scheduler, double reportSeconds,
+                  const std::function<bool()>& stop)
+{
+    Uint64 lastReport = SDL_GetPerformanceCounter();
+    bool running = true;
+    while(running && !(stop && stop()))
+    {
+        SDL_Event e;
+        SchedulerAction action = scheduler.next(window.wantsRedraw(), &e);
+        if(action == SCHEDULE_EVENT)
+        {
+            // Check for a quit event before passing to the GLWindow
+            if((e.type == SDL_QUIT) || !window.handleEvent(e))
+            {
+                running = false;
+            }
+            else if(window.wantsRedraw())
+            {
+                scheduler.inputHandled();
+            }
+        }
+        else if(action == SCHEDULE_FRAME)
+        {
+            window.render();
+            scheduler.framePresented();
+        }
+
+        Uint64 now = SDL_GetPerformanceCounter();
+        if((reportSeconds > 0.0) && (now - lastReport >= reportSeconds*SDL_GetPerformanceFrequency()))
+        {
+            FrameSchedulerStats stats = scheduler.takeStats();
+            cout << FrameScheduler::modeName(scheduler.mode()) << ": " << stats.frames << " frames in "
+                 << stats.seconds << " s, CPU " << stats.cpuPercent << "%, " << stats.inputs
+                 << " inputs, latency " << stats.meanLatencyMilliseconds << " ms mean / "
+                 << stats.maxLatencyMilliseconds << " ms max" << endl;
+            lastReport = now;
+        }
+    }
+}
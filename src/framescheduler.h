@@ -0,0 +1,100 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <vector>
+#include <ctime>
+#include <functional>
+
+#include "SDL.h"
+
+class OpenGLWindow;
+
+// When the event loop draws a frame
+enum RenderMode
+{
+    // Only when something has changed (see OpenGLWindow::wantsRedraw). In between it sleeps in
+    // SDL_WaitEventTimeout, so a static scene takes no CPU or GPU time at all
+    RENDER_ON_DEMAND,
+    // Every 1/targetFPS seconds, whether anything changed or not. It sleeps until just before each
+    // frame is due and spins for the rest, so frames start within a few microseconds of their time
+    RENDER_FIXED_RATE,
+    // As often as possible, for benchmarking
+    RENDER_UNTHROTTLED
+};
+
+// What FrameScheduler::next woke up for
+enum SchedulerAction
+{
+    SCHEDULE_EVENT,//an event to handle
+    SCHEDULE_FRAME,//a frame to draw
+    SCHEDULE_IDLE//neither, it just stopped waiting for a while (so the loop can check on other things)
+};
+
+// What the event loop did over a stretch of time (see FrameScheduler::takeStats)
+struct FrameSchedulerStats
+{
+    double seconds = 0.0;
+    int frames = 0;
+    // Process CPU time (every thread) as a percentage of one core
+    double cpuPercent = 0.0;
+    // Events that led to a redraw, and how long from their arrival until the frame showing them was
+    // presented (swapped), on average and at worst
+    int inputs = 0;
+    double meanLatencyMilliseconds = 0.0;
+    double maxLatencyMilliseconds = 0.0;
+};
+
+// Decides when the event loop waits, handles events and draws, in one of the RenderModes, and
+// measures how much CPU time that takes and the latency from input to the frame that shows it
+class FrameScheduler
+{
+public:
+    explicit FrameScheduler(RenderMode mode = RENDER_ON_DEMAND, double targetFPS = 60.0);
+
+    // Waits for whichever comes first: an event (put in e) or the next frame being due.
+    // redrawWanted says whether anything has changed since the last frame, which is all that makes
+    // a frame due in on-demand mode
+    SchedulerAction next(bool redrawWanted, SDL_Event* e);
+    // Tells the scheduler the last event next returned changed what's drawn, so its latency is
+    // measured up to the next frame
+    void inputHandled();
+    // Call right after each frame is presented
+    void framePresented();
+
+    // Returns the stats since the last call (or since the scheduler was created)
+    FrameSchedulerStats takeStats();
+
+    RenderMode mode();
+    // Whether the window should wait for vertical sync when presenting. On-demand frames are
+    // paced by it, but in the other modes it would fight the scheduler's own timing
+    bool wantsVsync();
+
+    static const char* modeName(RenderMode mode);
+
+private:
+    SchedulerAction eventArrived(const SDL_Event& e);
+
+    RenderMode renderMode;
+    Uint64 framePeriod;//in performance counter ticks
+    Uint64 nextFrame;//when the next fixed rate frame is due
+    Uint64 frequency;
+
+    // When the last event next returned arrived, and when the oldest input not yet shown in
+    // a frame arrived (0 for none)
+    Uint64 lastEventArrival;
+    Uint64 pendingInputArrival;
+
+    Uint64 statsStart;
+    std::clock_t statsCpuStart;
+    int statsFrames;
+    std::vector<double> latencies;
+};
+
+// Runs the window's event loop with the scheduler: waits, hands events to the window, and renders
+// when a frame is due. It stops when the window is closed or handleEvent returns false, or when
+// stop (if given) returns true, which is checked once every time round the loop. With
+// reportSeconds above 0 the stats are printed that often
+void runEventLoop(OpenGLWindow& window, FrameScheduler& scheduler, double reportSeconds = 0.0,
+                  const std::function<bool()>& stop = std::function<bool()>());
+
+#endif
@@ -1,12 +1,23 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 using namespace std;
 
 #include "geometry.h"
+#include "mappedfile.h"
+#include "threadpool.h"
+#include "meshcache.h"
+#include "meshopt.h"
+#include "simplify.h"
+#include "tangents.h"
+#include "normals.h"
 
 // NOTE: The WaveFront OBJ format spec, states that meshes are allowed to be defined by faces
 //       consisting of 3 or more vertices. For the purposes of this loader (and since this is the
@@ -31,8 +42,20 @@ enum OBJDataType
     COMMENT
 };
 
-void GeometryData::loadFromOBJFile(string filename)
+GeometryData::GeometryData()
 {
+    for(int i=0; i<3; i++)
+    {
+        minimumBounds[i] = 0.0f;
+        maximumBounds[i] = 0.0f;
+    }
+    sphereRadius = 0.0f;
+    cacheHeader = 0;
+}
+
+void GeometryData::loadFromOBJFileStream(string filename, const GeometryLoadOptions& options)
+{
+    detachFromCache();
     GeometryData tempGeom;
 
     ifstream inStream;
@@ -42,6 +65,10 @@ void GeometryData::loadFromOBJFile(string filename)
         cout << "Unable to open obj file: " << filename << endl;
         return;
     }
+    if(options.progress)
+    {
+        options.progress("parsing");
+    }
 
     OBJDataType currentDataType = NONE;
     while(!inStream.eof())
@@ -69,6 +96,7 @@ void GeometryData::loadFromOBJFile(string filename)
             {
                 cout << "OBJ parse error: Expected 'v', 'f' or '#' at the start of the line" << endl;
                 cout << "Found: " << typeChar1 << typeChar2 << endl;
+                currentDataType = COMMENT;
             }
             else
             {
@@ -142,6 +170,19 @@ void GeometryData::loadFromOBJFile(string filename)
             FaceData face = {};
             for(int index=0; index<3; index++)
             {
+                // A face with fewer than 3 corners ends before the line does. Its missing corner
+                // is left at -1, and the face is dropped along with the other invalid ones
+                while((inStream.peek() == ' ') || (inStream.peek() == '\t'))
+                {
+                    inStream.get();
+                }
+                int nextChar = inStream.peek();
+                if((nextChar == '\n') || (nextChar == '\r') || (nextChar == EOF))
+                {
+                    face.vertexIndex[index] = -1;
+                    break;
+                }
+
                 inStream >> vertIndex;
                 char postVertexCheckChar = inStream.get();
                 if(postVertexCheckChar == '/')
@@ -163,12 +204,23 @@ void GeometryData::loadFromOBJFile(string filename)
                         inStream.unget(); // This is just to prevent us from consuming a newline
                     }
                 }
+                else
+                {
+                    inStream.unget(); // Same again for faces with no '/' and no trailing space
+                }
                 
                 // NOTE: We subtract 1 here because the OBJ format uses 1-based indices
                 face.vertexIndex[index] = vertIndex - 1;
                 face.texCoordIndex[index] = texCoordIndex - 1;
                 face.normalIndex[index] = normalIndex - 1;
             }
+            if(inStream.fail())
+            {
+                // Something other than a number where a corner should be. The stream would stay
+                // failed (and never reach the end) otherwise
+                inStream.clear();
+                face.vertexIndex[0] = -1;
+            }
             tempGeom.faces.push_back(face);
             currentDataType = COMMENT;
         } break;
@@ -187,130 +239,1216 @@ void GeometryData::loadFromOBJFile(string filename)
         }
     }
 
+    dropInvalidFaces(tempGeom);
 
-    // NOTE: Since our rendering pipeline supports only 1 set of indices for our data, we need to
-    //       do some post-processing here in order to lay out all the unique v/vt/vn triples
-    // TODO: We're currently just assuming all the triples are distinct, but its probably worth doing
-    //       at least a little bit of checking on that front
-    // TODO: We're deciding whether or not to add texture coords and normals on a per-face basis,
-    //       which doesn't really make sense because if there are any then there should be for all
-    //       vertices, but this way that might not be the case
-    for(int faceIndex=0; faceIndex<tempGeom.faces.size(); faceIndex++)
-    {
-        FaceData face = tempGeom.faces[faceIndex];
-        bool hasTextureCoords = (face.texCoordIndex[0] >= 0);
-        bool hasNormals = (face.normalIndex[0] >= 0);
-        for(int vertIndex=0; vertIndex<3; vertIndex++)
-        {
-            for(int i=0; i<3; i++)
-            {
-                vertices.push_back(tempGeom.vertices[(3*face.vertexIndex[vertIndex])+i]);
-            }
+    if(options.generateNormals && tempGeom.normals.empty() && !tempGeom.faces.empty())
+    {
+        if(options.progress)
+        {
+            options.progress("generating normals");
+        }
+        generateMissingNormals(tempGeom, options);
+    }
+
+    if(options.progress)
+    {
+        options.progress("building vertices");
+    }
+    buildVertexArrays(tempGeom);
+
+    cout << "Successfully loaded an OBJ with " << vertices.size()/3 << " vertices and "
+         << indices.size()/3 << " triangles" << endl;
+}
 
-            if(hasTextureCoords)
+// The mapped loader below walks the file exactly once, reading straight out of the mapping with
+// hand-rolled number parsers. Neither the stream state nor the locale is consulted, which is
+// where the stream based loader above spends nearly all of its time
+
+static const float powersOfTen[] =
+{
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+static inline bool isBlank(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\r');
+}
+
+static inline bool isDigit(char c)
+{
+    return (unsigned)(c - '0') < 10;
+}
+
+static inline const char* skipBlanks(const char* p, const char* end)
+{
+    while((p < end) && isBlank(*p))
+    {
+        p++;
+    }
+    return p;
+}
+
+static inline const char* skipLine(const char* p, const char* end)
+{
+    while((p < end) && (*p != '\n'))
+    {
+        p++;
+    }
+    return p;
+}
+
+// Parses a float starting at p (after any blanks) and returns the position just past it. The
+// result is bit-for-bit what strtof (and therefore istream::operator>>) would produce
+static inline const char* parseFloat(const char* p, const char* end, float* result)
+{
+    p = skipBlanks(p, end);
+    const char* start = p;
+
+    bool negative = false;
+    if((p < end) && ((*p == '-') || (*p == '+')))
+    {
+        negative = (*p == '-');
+        p++;
+    }
+
+    unsigned long long mantissa = 0;
+    const char* digitsStart = p;
+    while((p < end) && isDigit(*p))
+    {
+        mantissa = mantissa*10 + (*p - '0');
+        p++;
+    }
+    int digitCount = p - digitsStart;
+    int exponent = 0;
+    if((p < end) && (*p == '.'))
+    {
+        p++;
+        const char* fractionStart = p;
+        while((p < end) && isDigit(*p))
+        {
+            mantissa = mantissa*10 + (*p - '0');
+            p++;
+        }
+        exponent = -(int)(p - fractionStart);
+        digitCount -= exponent;
+    }
+    if((p < end) && ((*p == 'e') || (*p == 'E')))
+    {
+        const char* exponentStart = p;
+        p++;
+        bool negativeExponent = false;
+        if((p < end) && ((*p == '-') || (*p == '+')))
+        {
+            negativeExponent = (*p == '-');
+            p++;
+        }
+        if((p < end) && isDigit(*p))
+        {
+            int explicitExponent = 0;
+            while((p < end) && isDigit(*p))
             {
-                for(int i=0; i<2; i++)
+                if(explicitExponent < 10000)
                 {
-                    textureCoords.push_back(
-                            tempGeom.textureCoords[(2*face.texCoordIndex[vertIndex])+i]);
+                    explicitExponent = explicitExponent*10 + (*p - '0');
                 }
+                p++;
             }
-            if(hasNormals)
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        }
+        else
+        {
+            p = exponentStart;
+        }
+    }
+
+    // Trailing zeros (e.g. "1.5000000000") just make the mantissa look bigger than it is
+    while((mantissa > (1ull << 24)) && (mantissa % 10 == 0))
+    {
+        mantissa /= 10;
+        exponent++;
+    }
+
+    // NOTE: When both the mantissa and the power of ten are exactly representable as floats, a
+    //       single IEEE multiply/divide is correctly rounded, so we get the exact same result as
+    //       strtof. Anything else (long mantissas that may have overflowed, huge exponents,
+    //       inf/nan) goes to strtof itself
+    bool tokenEnded = (p == end) || isBlank(*p) || (*p == '\n') || (*p == '/');
+    if(tokenEnded && (digitCount > 0) && (digitCount <= 19) && (mantissa <= (1ull << 24)) &&
+       (exponent >= -10) && (exponent <= 10))
+    {
+        float value = (float)mantissa;
+        if(exponent < 0)
+        {
+            value /= powersOfTen[-exponent];
+        }
+        else
+        {
+            value *= powersOfTen[exponent];
+        }
+        *result = negative ? -value : value;
+        return p;
+    }
+
+    char buffer[128];
+    size_t length = 0;
+    p = start;
+    while((p < end) && !isBlank(*p) && (*p != '\n') && (length < sizeof(buffer)-1))
+    {
+        buffer[length++] = *p++;
+    }
+    buffer[length] = '\0';
+    *result = (length > 0) ? strtof(buffer, 0) : 0.0f;
+    return p;
+}
+
+static inline const char* parseInt(const char* p, const char* end, int* result)
+{
+    bool negative = false;
+    if((p < end) && ((*p == '-') || (*p == '+')))
+    {
+        negative = (*p == '-');
+        p++;
+    }
+
+    int value = 0;
+    while((p < end) && isDigit(*p))
+    {
+        value = value*10 + (*p - '0');
+        p++;
+    }
+    *result = negative ? -value : value;
+    return p;
+}
+
+// Converts an OBJ index into a 0-based one. Positive indices are 1-based, negative indices are
+// relative to the most recently defined element, and 0 means "not specified" (which maps to -1)
+static inline int resolveOBJIndex(int index, int elementCount)
+{
+    if(index < 0)
+    {
+        return elementCount + index;
+    }
+    return index - 1;
+}
+
+// Everything parsed out of one newline-aligned slice of an OBJ file. Negative face indices are
+// relative to the elements defined so far in the whole file, which a chunk can't know until the
+// chunks before it are parsed, so we remember where they are and fix them up while stitching
+struct OBJChunk
+{
+    std::vector<float> vertices;
+    std::vector<float> textureCoords;
+    std::vector<float> normals;
+    std::vector<FaceData> faces;
+
+    // Offsets into the faces array viewed as a flat array of ints (9 per face, in the order the
+    // FaceData members are declared)
+    std::vector<size_t> relativeIndexSlots;
+};
+
+static void parseOBJChunk(const char* p, const char* end, OBJChunk* chunk)
+{
+    // NOTE: Growing the arrays as we go costs more than the parsing itself on large files, so we
+    //       reserve for a generous guess of ~24 bytes per line instead. Only the pages we actually
+    //       write to get committed, so over-estimating is cheap
+    size_t estimatedLineCount = (end - p)/24 + 1;
+    chunk->vertices.reserve(3*estimatedLineCount);
+    chunk->faces.reserve(estimatedLineCount);
+
+    while(p < end)
+    {
+        p = skipBlanks(p, end);
+        if(p == end)
+        {
+            break;
+        }
+
+        char typeChar1 = *p;
+        char typeChar2 = (p+1 < end) ? p[1] : '\n';
+        if(typeChar1 == 'v')
+        {
+            if(isBlank(typeChar2))
+            {
+                float position[3];
+                p = parseFloat(p+1, end, &position[0]);
+                p = parseFloat(p, end, &position[1]);
+                p = parseFloat(p, end, &position[2]);
+                // NOTE: push_back is noticeably cheaper than a range insert for 2 or 3 floats
+                chunk->vertices.push_back(position[0]);
+                chunk->vertices.push_back(position[1]);
+                chunk->vertices.push_back(position[2]);
+            }
+            else if(typeChar2 == 't')
+            {
+                float texCoord[2];
+                p = parseFloat(p+2, end, &texCoord[0]);
+                p = parseFloat(p, end, &texCoord[1]);
+                chunk->textureCoords.push_back(texCoord[0]);
+                chunk->textureCoords.push_back(texCoord[1]);
+            }
+            else if(typeChar2 == 'n')
             {
-                for(int i=0; i<3; i++)
+                float normal[3];
+                p = parseFloat(p+2, end, &normal[0]);
+                p = parseFloat(p, end, &normal[1]);
+                p = parseFloat(p, end, &normal[2]);
+                chunk->normals.push_back(normal[0]);
+                chunk->normals.push_back(normal[1]);
+                chunk->normals.push_back(normal[2]);
+            }
+            else if(typeChar2 == 'p')
+            {
+                cout << "OBJ parse error: Free-form geometry is not supported, ignoring" << endl;
+            }
+            else
+            {
+                cout << "Unsupported data entry v" << typeChar2 << ", ignoring" << endl;
+            }
+        }
+        else if((typeChar1 == 'f') && isBlank(typeChar2))
+        {
+            // NOTE: As with the stream loader, only the first 3 vertices of a face are used
+            int counts[3];
+            counts[0] = chunk->vertices.size()/3;
+            counts[1] = chunk->textureCoords.size()/2;
+            counts[2] = chunk->normals.size()/3;
+
+            FaceData face = {};
+            int* faceSlots = &face.vertexIndex[0];
+            size_t faceSlotStart = 9*chunk->faces.size();
+            p++;
+            for(int index=0; index<3; index++)
+            {
+                int objIndices[3] = {0, 0, 0};
+
+                p = skipBlanks(p, end);
+                p = parseInt(p, end, &objIndices[0]);
+                if((p < end) && (*p == '/'))
+                {
+                    p++;
+                    if((p < end) && (*p != '/'))
+                    {
+                        p = parseInt(p, end, &objIndices[1]);
+                    }
+                    if((p < end) && (*p == '/'))
+                    {
+                        p = parseInt(p+1, end, &objIndices[2]);
+                    }
+                }
+
+                // Nearly every file only has absolute indices, which need no fixing up later
+                if((objIndices[0] | objIndices[1] | objIndices[2]) >= 0)
+                {
+                    faceSlots[index] = objIndices[0] - 1;
+                    faceSlots[3 + index] = objIndices[1] - 1;
+                    faceSlots[6 + index] = objIndices[2] - 1;
+                    continue;
+                }
+                for(int kind=0; kind<3; kind++)
                 {
-                    normals.push_back(tempGeom.normals[(3*face.normalIndex[vertIndex])+i]);
+                    int slot = 3*kind + index;
+                    faceSlots[slot] = resolveOBJIndex(objIndices[kind], counts[kind]);
+                    if(objIndices[kind] < 0)
+                    {
+                        chunk->relativeIndexSlots.push_back(faceSlotStart + slot);
+                    }
                 }
             }
+            chunk->faces.push_back(face);
+        }
+        // NOTE: Comments, groups, smoothing groups and material statements carry nothing we
+        //       use, so those lines are skipped along with the remainder of every line above
+
+        p = skipLine(p, end);
+        if(p < end)
+        {
+            p++;
+        }
+    }
+}
+
+// Copies a chunk into its slice of the combined arrays, shifting its relative indices by the
+// number of elements that were defined in earlier chunks
+static void stitchOBJChunk(const OBJChunk& chunk, const size_t* offsets,
+                           float* vertices, float* textureCoords, float* normals, FaceData* faces)
+{
+    std::copy(chunk.vertices.begin(), chunk.vertices.end(), vertices + 3*offsets[0]);
+    std::copy(chunk.textureCoords.begin(), chunk.textureCoords.end(),
+              textureCoords + 2*offsets[1]);
+    std::copy(chunk.normals.begin(), chunk.normals.end(), normals + 3*offsets[2]);
+
+    FaceData* chunkFaces = faces + offsets[3];
+    std::copy(chunk.faces.begin(), chunk.faces.end(), chunkFaces);
+
+    int* slots = &chunkFaces->vertexIndex[0];
+    for(size_t i=0; i<chunk.relativeIndexSlots.size(); i++)
+    {
+        size_t slot = chunk.relativeIndexSlots[i];
+        int kind = (slot % 9)/3;
+        slots[slot] += offsets[kind];
+    }
+}
+
+void GeometryData::loadFromOBJFile(string filename, const GeometryLoadOptions& options)
+{
+    // NOTE: Loading into geometry that already holds a mesh appends to it, which the cache
+    //       can't represent, so it's only used for fresh loads
+    bool freshLoad = (vertexCount() == 0);
+    unsigned int processingFlags = (options.optimizeMesh ? MESH_CACHE_OPTIMIZED : 0) |
+                                   (options.generateLODs ? MESH_CACHE_LODS : 0) |
+                                   (options.generateMeshlets ? MESH_CACHE_GENERATED_MESHLETS : 0);
+    float creaseAngle = 0.0f;
+    if(options.generateNormals)
+    {
+        processingFlags |= MESH_CACHE_GENERATED_NORMALS |
+                           (options.angleWeightedNormals ? 0 : MESH_CACHE_AREA_WEIGHTED_NORMALS);
+        creaseAngle = std::min(options.creaseAngle, 180.0f);
+    }
+    if(options.progress)
+    {
+        options.progress("reading cache");
+    }
+    if(options.useCache && freshLoad && loadFromCache(filename, processingFlags, creaseAngle))
+    {
+        cout << "Loaded an OBJ with " << vertexCount() << " vertices and " << indexCount()/3
+             << " triangles from its cache" << endl;
+        return;
+    }
+    detachFromCache();
+
+    MappedFile file;
+    if(!file.open(filename))
+    {
+        cout << "Unable to open obj file: " << filename << endl;
+        return;
+    }
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    if(options.progress)
+    {
+        options.progress("parsing");
+    }
+
+    // NOTE: Small files aren't worth waking threads up for, so when picking automatically we
+    //       give each thread at least a megabyte to chew on
+    int chunkCount = options.threadCount;
+    if(chunkCount <= 0)
+    {
+        chunkCount = std::min<size_t>(ThreadPool::hardwareThreadCount(),
+                                      file.size()/(1 << 20) + 1);
+    }
+
+    // Split the file into roughly equal chunks, nudging each split point forward to the start
+    // of the next line so that no record straddles two chunks
+    std::vector<const char*> chunkBounds(chunkCount+1);
+    chunkBounds[0] = begin;
+    chunkBounds[chunkCount] = end;
+    for(int i=1; i<chunkCount; i++)
+    {
+        const char* split = begin + (file.size()*i)/chunkCount;
+        if(split < chunkBounds[i-1])
+        {
+            split = chunkBounds[i-1];
+        }
+        if((split > begin) && (split[-1] != '\n'))
+        {
+            split = skipLine(split, end);
+            if(split < end)
+            {
+                split++;
+            }
+        }
+        chunkBounds[i] = split;
+    }
+
+    GeometryData tempGeom;
+    std::vector<OBJChunk> chunks(chunkCount);
+    if(chunkCount == 1)
+    {
+        parseOBJChunk(begin, end, &chunks[0]);
+        tempGeom.vertices.swap(chunks[0].vertices);
+        tempGeom.textureCoords.swap(chunks[0].textureCoords);
+        tempGeom.normals.swap(chunks[0].normals);
+        tempGeom.faces.swap(chunks[0].faces);
+    }
+    else
+    {
+        ThreadPool pool(chunkCount);
+        for(int i=0; i<chunkCount; i++)
+        {
+            OBJChunk* chunk = &chunks[i];
+            const char* chunkBegin = chunkBounds[i];
+            const char* chunkEnd = chunkBounds[i+1];
+            pool.enqueue([=]() { parseOBJChunk(chunkBegin, chunkEnd, chunk); });
+        }
+        pool.wait();
+
+        // Prefix sum the element counts so every chunk knows where its data starts in the
+        // combined arrays (and how far its relative indices need to be shifted)
+        std::vector<size_t> offsets(4*(chunkCount+1), 0);
+        for(int i=0; i<chunkCount; i++)
+        {
+            size_t* current = &offsets[4*i];
+            size_t* next = &offsets[4*(i+1)];
+            next[0] = current[0] + chunks[i].vertices.size()/3;
+            next[1] = current[1] + chunks[i].textureCoords.size()/2;
+            next[2] = current[2] + chunks[i].normals.size()/3;
+            next[3] = current[3] + chunks[i].faces.size();
         }
+        const size_t* totals = &offsets[4*chunkCount];
+        tempGeom.vertices.resize(3*totals[0]);
+        tempGeom.textureCoords.resize(2*totals[1]);
+        tempGeom.normals.resize(3*totals[2]);
+        tempGeom.faces.resize(totals[3]);
 
-        // Compute the (bi)tangent for the face, and add it for each vertex
-        if(hasTextureCoords && hasNormals)
-        {
-            int vertexStartIndex = vertices.size() - 9;
-            int uvStartIndex = textureCoords.size() - 6;
-            float* vertices = &this->vertices[vertexStartIndex];
-            float* texCoords = &textureCoords[uvStartIndex];
-
-            float deltaX1 = vertices[3] - vertices[0];
-            float deltaY1 = vertices[4] - vertices[1];
-            float deltaZ1 = vertices[5] - vertices[2];
-            float deltaX2 = vertices[6] - vertices[0];
-            float deltaY2 = vertices[7] - vertices[1];
-            float deltaZ2 = vertices[8] - vertices[2];
-
-            float deltaU1 = texCoords[2] - texCoords[0];
-            float deltaV1 = texCoords[3] - texCoords[1];
-            float deltaU2 = texCoords[4] - texCoords[0];
-            float deltaV2 = texCoords[5] - texCoords[1];
-
-            float inverseDet = 1.0f / (deltaU1*deltaV2 - deltaU2*deltaV1);
-
-            float tangentX = inverseDet * (deltaV2*deltaX1 - deltaV1*deltaX2);
-            float tangentY = inverseDet * (deltaV2*deltaY1 - deltaV1*deltaY2);
-            float tangentZ = inverseDet * (deltaV2*deltaZ1 - deltaV1*deltaZ2);
-
-            float bitangentX = inverseDet * (deltaU1*deltaX2 - deltaU2*deltaX1);
-            float bitangentY = inverseDet * (deltaU1*deltaY2 - deltaU2*deltaY1);
-            float bitangentZ = inverseDet * (deltaU1*deltaZ2 - deltaU2*deltaZ1);
-
-            float tangentLength = sqrt(tangentX*tangentX +
-                                       tangentY*tangentY +
-                                       tangentZ*tangentZ);
-            float bitangentLength = sqrt(bitangentX*bitangentX +
-                                         bitangentY*bitangentY +
-                                         bitangentZ*bitangentZ);
-
-            tangentX /= tangentLength;
-            tangentY /= tangentLength;
-            tangentZ /= tangentLength;
-            bitangentX /= bitangentLength;
-            bitangentY /= bitangentLength;
-            bitangentZ /= bitangentLength;
-
-            // NOTE: Each vertex in the face gets the same (bi)tangent pair
-            for(int vertIndex=0; vertIndex<3; vertIndex++)
+        float* vertices = tempGeom.vertices.data();
+        float* textureCoords = tempGeom.textureCoords.data();
+        float* normals = tempGeom.normals.data();
+        FaceData* faces = tempGeom.faces.data();
+        for(int i=0; i<chunkCount; i++)
+        {
+            OBJChunk* chunk = &chunks[i];
+            const size_t* chunkOffsets = &offsets[4*i];
+            pool.enqueue([=]()
             {
-                tangents.push_back(tangentX);
-                tangents.push_back(tangentY);
-                tangents.push_back(tangentZ);
+                stitchOBJChunk(*chunk, chunkOffsets, vertices, textureCoords, normals, faces);
+
+                // Free each chunk as soon as it's been copied to keep peak memory down
+                *chunk = OBJChunk();
+            });
+        }
+        pool.wait();
+    }
+    // NOTE: Only now are relative indices absolute, so this can't be done while parsing
+    dropInvalidFaces(tempGeom);
+
+    if(options.generateNormals && tempGeom.normals.empty() && !tempGeom.faces.empty())
+    {
+        if(options.progress)
+        {
+            options.progress("generating normals");
+        }
+        generateMissingNormals(tempGeom, options);
+    }
+
+    if(options.progress)
+    {
+        options.progress("building vertices");
+    }
+    buildVertexArrays(tempGeom);
+
+    cout << "Successfully loaded an OBJ with " << vertices.size()/3 << " vertices and "
+         << indices.size()/3 << " triangles" << endl;
 
-                bitangents.push_back(bitangentX);
-                bitangents.push_back(bitangentY);
-                bitangents.push_back(bitangentZ);
+    // NOTE: LODs come first so that the optimization pass reorders them along with the full mesh
+    if(options.generateLODs)
+    {
+        if(options.progress)
+        {
+            options.progress("generating LODs");
+        }
+        generateLODs();
+    }
+    if(options.optimizeMesh)
+    {
+        if(options.progress)
+        {
+            options.progress("optimizing");
+        }
+        optimizeMesh();
+    }
+    if(options.generateMeshlets)
+    {
+        if(options.progress)
+        {
+            options.progress("building meshlets");
+        }
+        generateMeshlets();
+    }
+
+    if(options.useCache && freshLoad)
+    {
+        if(options.progress)
+        {
+            options.progress("writing cache");
+        }
+        writeCache(filename, processingFlags, creaseAngle, file.data(), file.size());
+    }
+}
+
+// Whether index is below count, or -1 when it's allowed to be missing
+static inline bool validOBJIndex(int index, size_t count, bool optional)
+{
+    return (optional && (index == -1)) || ((index >= 0) && ((size_t)index < count));
+}
+
+// Removes faces with fewer than 3 corners (a missing corner's position index is left at -1) or
+// with an index past the end of the elements the file defines, which everything after parsing
+// would otherwise read and write out of bounds with. A corner without a texture coord or normal
+// (-1) is fine
+void GeometryData::dropInvalidFaces(GeometryData& tempGeom)
+{
+    size_t positionCount = tempGeom.vertices.size()/3;
+    size_t texCoordCount = tempGeom.textureCoords.size()/2;
+    size_t normalCount = tempGeom.normals.size()/3;
+    size_t kept = 0;
+    for(size_t i=0; i<tempGeom.faces.size(); i++)
+    {
+        const FaceData& face = tempGeom.faces[i];
+        bool valid = true;
+        for(int corner=0; corner<3; corner++)
+        {
+            valid = valid && validOBJIndex(face.vertexIndex[corner], positionCount, false) &&
+                    validOBJIndex(face.texCoordIndex[corner], texCoordCount, true) &&
+                    validOBJIndex(face.normalIndex[corner], normalCount, true);
+        }
+        if(valid)
+        {
+            tempGeom.faces[kept++] = face;
+        }
+    }
+    if(kept < tempGeom.faces.size())
+    {
+        cout << "Ignoring " << tempGeom.faces.size() - kept
+             << " faces with missing corners or indices out of range" << endl;
+        tempGeom.faces.resize(kept);
+    }
+}
+
+// Smooth normals for a file without vn records, which the faces then reference as if the file
+// had them, so that vertices get split along creases the same way they would at any other normal
+// seam (see normals.h). The faces have to have been through dropInvalidFaces, as generateNormals
+// reads positions straight through their indices
+void GeometryData::generateMissingNormals(GeometryData& tempGeom,
+                                          const GeometryLoadOptions& options)
+{
+    generateNormals(tempGeom.vertices.data(), tempGeom.vertices.size()/3,
+                    &tempGeom.faces[0].vertexIndex[0], &tempGeom.faces[0].normalIndex[0],
+                    sizeof(FaceData)/sizeof(int), tempGeom.faces.size(),
+                    options.angleWeightedNormals ? NORMAL_WEIGHT_ANGLE : NORMAL_WEIGHT_AREA,
+                    options.creaseAngle, options.threadCount, &tempGeom.normals);
+}
+
+void GeometryData::buildVertexArrays(GeometryData& tempGeom)
+{
+    // NOTE: Since our rendering pipeline supports only 1 set of indices for our data, we need to
+    //       do some post-processing here in order to lay out all the unique v/vt/vn triples. Each
+    //       distinct triple becomes one vertex, and every face corner becomes an index into them.
+    //       Texture coords and normals are decided on for the whole mesh: if the file has any,
+    //       then every vertex gets one (corners that don't reference one get zeros)
+    bool hasTextureCoords = !tempGeom.textureCoords.empty();
+    bool hasNormals = !tempGeom.normals.empty();
+    bool hasTangents = hasTextureCoords && hasNormals;
+
+    // Any LODs and meshlets were made from the mesh as it was, and don't include what's being added
+    lods.clear();
+    lodIndices.clear();
+    meshlets.clear();
+
+    // The triple lookup is a hash table whose buckets are the position index itself: every
+    // position has a chain of the vertices created from it so far, which is rarely longer than a
+    // few entries (one per distinct uv/normal seam through that position)
+    int positionCount = tempGeom.vertices.size()/3;
+    std::vector<int> firstVertexForPosition(positionCount, -1);
+    std::vector<int> nextVertexWithPosition;
+    std::vector<int> vertexTexCoordIndex;
+    std::vector<int> vertexNormalIndex;
+
+    size_t cornerCount = 3*tempGeom.faces.size();
+    unsigned int baseVertex = vertices.size()/3;
+    indices.reserve(indices.size() + cornerCount);
+    vertices.reserve(vertices.size() + 3*positionCount);
+    if(hasTextureCoords)
+    {
+        textureCoords.reserve(textureCoords.size() + 2*positionCount);
+    }
+    if(hasNormals)
+    {
+        normals.reserve(normals.size() + 3*positionCount);
+    }
+    nextVertexWithPosition.reserve(positionCount);
+    vertexTexCoordIndex.reserve(positionCount);
+    vertexNormalIndex.reserve(positionCount);
+
+    for(size_t faceIndex=0; faceIndex<tempGeom.faces.size(); faceIndex++)
+    {
+        const FaceData& face = tempGeom.faces[faceIndex];
+        for(int corner=0; corner<3; corner++)
+        {
+            int positionIndex = face.vertexIndex[corner];
+            int texCoordIndex = hasTextureCoords ? face.texCoordIndex[corner] : -1;
+            int normalIndex = hasNormals ? face.normalIndex[corner] : -1;
+
+            int vertex = firstVertexForPosition[positionIndex];
+            while((vertex >= 0) &&
+                  ((vertexTexCoordIndex[vertex] != texCoordIndex) ||
+                   (vertexNormalIndex[vertex] != normalIndex)))
+            {
+                vertex = nextVertexWithPosition[vertex];
+            }
+
+            if(vertex < 0)
+            {
+                vertex = vertexTexCoordIndex.size();
+                vertexTexCoordIndex.push_back(texCoordIndex);
+                vertexNormalIndex.push_back(normalIndex);
+                nextVertexWithPosition.push_back(firstVertexForPosition[positionIndex]);
+                firstVertexForPosition[positionIndex] = vertex;
+
+                const float* position = &tempGeom.vertices[3*positionIndex];
+                vertices.insert(vertices.end(), position, position+3);
+                if(hasTextureCoords)
+                {
+                    const float zero[2] = {0.0f, 0.0f};
+                    const float* texCoord = (texCoordIndex >= 0) ?
+                        &tempGeom.textureCoords[2*texCoordIndex] : zero;
+                    textureCoords.insert(textureCoords.end(), texCoord, texCoord+2);
+                }
+                if(hasNormals)
+                {
+                    const float zero[3] = {0.0f, 0.0f, 0.0f};
+                    const float* normal = (normalIndex >= 0) ?
+                        &tempGeom.normals[3*normalIndex] : zero;
+                    normals.insert(normals.end(), normal, normal+3);
+                }
             }
+
+            indices.push_back(baseVertex + vertex);
+        }
+    }
+
+    if(hasTangents)
+    {
+        computeTangents(baseVertex, indices.size() - cornerCount);
+    }
+
+    updateShortIndices();
+
+    for(int i=0; i<3; i++)
+    {
+        minimumBounds[i] = vertices.empty() ? 0.0f : vertices[i];
+        maximumBounds[i] = minimumBounds[i];
+    }
+    for(size_t vertex=0; vertex<vertices.size(); vertex+=3)
+    {
+        for(int i=0; i<3; i++)
+        {
+            minimumBounds[i] = std::min(minimumBounds[i], vertices[vertex+i]);
+            maximumBounds[i] = std::max(maximumBounds[i], vertices[vertex+i]);
+        }
+    }
+
+    float center[3];
+    for(int i=0; i<3; i++)
+    {
+        center[i] = 0.5f*(minimumBounds[i] + maximumBounds[i]);
+    }
+    float radiusSquared = 0.0f;
+    for(size_t vertex=0; vertex<vertices.size(); vertex+=3)
+    {
+        float dx = vertices[vertex] - center[0];
+        float dy = vertices[vertex+1] - center[1];
+        float dz = vertices[vertex+2] - center[2];
+        radiusSquared = std::max(radiusSquared, dx*dx + dy*dy + dz*dz);
+    }
+    sphereRadius = sqrt(radiusSquared);
+}
+
+// Tangents (with their handedness in w) for the vertices from firstVertex on, from the faces
+// from firstIndex on (see tangents.h)
+void GeometryData::computeTangents(unsigned int firstVertex, size_t firstIndex)
+{
+    size_t vertexCount = vertices.size()/3;
+    tangents.resize(4*vertexCount, 0.0f);
+    generateTangents(vertices.data(), textureCoords.data(), normals.data(), firstVertex,
+                     vertexCount, indices.data() + firstIndex, indices.size() - firstIndex,
+                     tangents.data());
+}
+
+static void printVertexCacheStats(const char* label, const vector<unsigned int>& indices,
+                                  size_t vertexCount)
+{
+    VertexCacheStats fifo = analyzeVertexCache(indices.data(), indices.size(), vertexCount, 16,
+                                               VERTEX_CACHE_FIFO);
+    VertexCacheStats lru = analyzeVertexCache(indices.data(), indices.size(), vertexCount, 32,
+                                              VERTEX_CACHE_LRU);
+    cout << label << " ACMR " << fifo.acmr << " / " << lru.acmr
+         << ", ATVR " << fifo.atvr << " / " << lru.atvr << " (FIFO 16 / LRU 32)" << endl;
+}
+
+void GeometryData::optimizeMesh()
+{
+    detachFromCache();
+    meshlets.clear();
+    if(indices.empty())
+    {
+        return;
+    }
+
+    size_t vertexTotal = vertices.size()/3;
+    printVertexCacheStats("Before optimizing:", indices, vertexTotal);
+
+    optimizeVertexCache(indices.data(), indices.size(), vertexTotal);
+    optimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertexTotal, 16);
+
+    // Each LOD is drawn on its own, so each gets its own triangle order
+    for(size_t level=1; level<lods.size(); level++)
+    {
+        unsigned int* lodStart = &lodIndices[lods[level].firstIndex - indices.size()];
+        optimizeVertexCache(lodStart, lods[level].indexCount, vertexTotal);
+        optimizeOverdraw(lodStart, lods[level].indexCount, vertices.data(), vertexTotal, 16);
+    }
+
+    // NOTE: The LODs only use vertices of the full mesh, so its order decides the vertex order
+    std::vector<unsigned int> remap;
+    size_t usedVertices = optimizeVertexFetch(indices.data(), indices.size(), vertexTotal, &remap);
+    for(size_t i=0; i<lodIndices.size(); i++)
+    {
+        lodIndices[i] = remap[lodIndices[i]];
+    }
+    remapVertexArray(&vertices, 3, remap, usedVertices);
+    remapVertexArray(&textureCoords, 2, remap, usedVertices);
+    remapVertexArray(&normals, 3, remap, usedVertices);
+    remapVertexArray(&tangents, 4, remap, usedVertices);
+
+    updateShortIndices();
+
+    printVertexCacheStats("After optimizing: ", indices, usedVertices);
+}
+
+// Triangle ratios of the LODs generated after the full mesh
+static const float LOD_TRIANGLE_RATIOS[] = {0.5f, 0.25f, 0.1f, 0.02f};
+
+void GeometryData::generateLODs()
+{
+    detachFromCache();
+    lods.clear();
+    lodIndices.clear();
+    if(indices.empty())
+    {
+        updateShortIndices();
+        return;
+    }
+
+    GeometryLOD full = {0, (unsigned int)indices.size(), 0.0f};
+    lods.push_back(full);
+
+    // NOTE: Simplifying each level from the previous one is much faster than starting from the
+    //       full mesh every time. The error is measured against the previous level, so adding it
+    //       up gives a bound on the error against the full mesh
+    size_t vertexTotal = vertices.size()/3;
+    const float* texCoordData = textureCoords.empty() ? 0 : textureCoords.data();
+    const float* normalData = normals.empty() ? 0 : normals.data();
+    std::vector<unsigned int> previous(indices);
+    std::vector<unsigned int> simplified(indices.size());
+    float error = 0.0f;
+    int ratioCount = sizeof(LOD_TRIANGLE_RATIOS)/sizeof(LOD_TRIANGLE_RATIOS[0]);
+    for(int i=0; (i<ratioCount) && ((int)lods.size() < MESH_CACHE_MAX_LODS); i++)
+    {
+        size_t target = 3*(size_t)(LOD_TRIANGLE_RATIOS[i]*indices.size()/3);
+        float levelError = 0.0f;
+        size_t count = simplifyMesh(simplified.data(), previous.data(), previous.size(),
+                                    vertices.data(), texCoordData, normalData, vertexTotal,
+                                    target, &levelError);
+
+        // Everything that's left is locked (seams and borders), so a level that's barely
+        // smaller than the last one isn't worth drawing
+        if((count == 0) || (count > previous.size()*9/10))
+        {
+            break;
+        }
+
+        error += levelError;
+        GeometryLOD level = {(unsigned int)(indices.size() + lodIndices.size()),
+                             (unsigned int)count, error};
+        lods.push_back(level);
+        lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.begin() + count);
+        previous.assign(simplified.begin(), simplified.begin() + count);
+
+        cout << "Generated LOD " << lods.size() - 1 << " with " << count/3 << " triangles (error "
+             << error << ")" << endl;
+    }
+
+    updateShortIndices();
+}
+
+int GeometryData::lodCount()
+{
+    if(cacheHeader)
+    {
+        return std::max<int>(cacheHeader->lodCount, 1);
+    }
+    return std::max<int>(lods.size(), 1);
+}
+
+GeometryLOD GeometryData::lod(int level)
+{
+    if(cacheHeader && (cacheHeader->lodCount > 0))
+    {
+        const MeshCacheLOD& cached = cacheHeader->lods[level];
+        GeometryLOD result = {cached.firstIndex, cached.indexCount, cached.error};
+        return result;
+    }
+    if(!cacheHeader && !lods.empty())
+    {
+        return lods[level];
+    }
+    GeometryLOD full = {0, (unsigned int)indexCount(), 0.0f};
+    return full;
+}
+
+int GeometryData::lodIndexCount()
+{
+    if(cacheHeader)
+    {
+        return cacheHeader->arraySizes[MESH_CACHE_LOD_INDICES]/cacheHeader->indexSize;
+    }
+    return lodIndices.size();
+}
+
+void* GeometryData::lodIndexData()
+{
+    if(cacheHeader)
+    {
+        return (void*)cachedArray(MESH_CACHE_LOD_INDICES);
+    }
+    if(lodIndices.empty())
+    {
+        return 0;
+    }
+    if(!shortIndices.empty())
+    {
+        return (void*)&shortLodIndices[0];
+    }
+    return (void*)&lodIndices[0];
+}
+
+void GeometryData::generateMeshlets()
+{
+    detachFromCache();
+    meshlets.clear();
+    if(indices.empty())
+    {
+        return;
+    }
+
+    buildMeshlets(indices.data(), indices.size(), vertices.data(), vertices.size()/3, &meshlets);
+    updateShortIndices();
+
+    cout << "Split the mesh into " << meshlets.size() << " meshlets ("
+         << (float)indices.size()/(3*meshlets.size()) << " triangles each on average)" << endl;
+}
+
+int GeometryData::meshletCount()
+{
+    if(cacheHeader)
+    {
+        return cacheHeader->arraySizes[MESH_CACHE_MESHLETS]/sizeof(Meshlet);
+    }
+    return meshlets.size();
+}
+
+const Meshlet* GeometryData::meshletData()
+{
+    if(cacheHeader)
+    {
+        return (const Meshlet*)cachedArray(MESH_CACHE_MESHLETS);
+    }
+    return meshlets.empty() ? 0 : meshlets.data();
+}
+
+// NOTE: Most meshes have few enough vertices to be drawn with 16-bit indices, which halves
+//       the size of the index buffer
+void GeometryData::updateShortIndices()
+{
+    shortIndices.clear();
+    shortLodIndices.clear();
+    if(vertices.size()/3 <= 65536)
+    {
+        shortIndices.assign(indices.begin(), indices.end());
+        shortLodIndices.assign(lodIndices.begin(), lodIndices.end());
+    }
+}
+
+// Whether every index in a cached index array is below vertexCount. The array sizes were checked
+// when the cache was opened, but the values go straight to the GPU and the raycaster
+static bool cachedIndicesInRange(const char* data, uint64_t size, uint32_t indexSize,
+                                 uint32_t vertexCount)
+{
+    uint32_t largest = 0;
+    if(indexSize == 2)
+    {
+        const unsigned short* indices = (const unsigned short*)data;
+        for(size_t i=0; i<size/2; i++)
+        {
+            largest = std::max<uint32_t>(largest, indices[i]);
+        }
+    }
+    else
+    {
+        const unsigned int* indices = (const unsigned int*)data;
+        for(size_t i=0; i<size/4; i++)
+        {
+            largest = std::max<uint32_t>(largest, indices[i]);
         }
     }
+    return (size == 0) || (largest < vertexCount);
+}
+
+bool GeometryData::loadFromCache(const std::string& filename, unsigned int processingFlags,
+                                 float creaseAngle)
+{
+    std::shared_ptr<MappedFile> mapping(new MappedFile());
+    const MeshCacheHeader* header = openMeshCache(filename, processingFlags, mapping.get());
+    if(!header || (header->creaseAngle != creaseAngle))
+    {
+        return false;
+    }
+    const int indexArrays[2] = {MESH_CACHE_INDICES, MESH_CACHE_LOD_INDICES};
+    for(int i=0; i<2; i++)
+    {
+        if(!cachedIndicesInRange(mapping->data() + header->arrayOffsets[indexArrays[i]],
+                                 header->arraySizes[indexArrays[i]], header->indexSize,
+                                 header->vertexCount))
+        {
+            cout << "Mesh cache has indices past its vertices, parsing the file again" << endl;
+            return false;
+        }
+    }
+
+    cacheMapping = mapping;
+    cacheHeader = header;
+    for(int i=0; i<3; i++)
+    {
+        minimumBounds[i] = header->boundsMin[i];
+        maximumBounds[i] = header->boundsMax[i];
+    }
+    sphereRadius = header->boundingRadius;
+    return true;
+}
+
+void GeometryData::writeCache(const std::string& filename, unsigned int processingFlags,
+                              float creaseAngle, const char* sourceData, size_t sourceSize)
+{
+    if(vertexCount() == 0)
+    {
+        return;
+    }
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.vertexCount = vertexCount();
+    header.indexCount = indexCount();
+    header.indexSize = indexSize();
+    header.processingFlags = processingFlags;
+    header.creaseAngle = creaseAngle;
+    header.lodCount = lods.size();
+    for(size_t level=0; level<lods.size(); level++)
+    {
+        header.lods[level].firstIndex = lods[level].firstIndex;
+        header.lods[level].indexCount = lods[level].indexCount;
+        header.lods[level].error = lods[level].error;
+    }
+    for(int i=0; i<3; i++)
+    {
+        header.boundsMin[i] = minimumBounds[i];
+        header.boundsMax[i] = maximumBounds[i];
+    }
+    header.boundingRadius = sphereRadius;
+
+    const void* arrays[MESH_CACHE_ARRAY_COUNT] =
+    {
+        vertices.data(), textureCoords.data(), normals.data(),
+        tangents.data(), indexData(), lodIndexData(), meshletData()
+    };
+    size_t arraySizes[MESH_CACHE_ARRAY_COUNT] =
+    {
+        vertices.size()*sizeof(float), textureCoords.size()*sizeof(float),
+        normals.size()*sizeof(float), tangents.size()*sizeof(float),
+        (size_t)indexCount()*indexSize(),
+        (size_t)lodIndexCount()*indexSize(),
+        meshlets.size()*sizeof(Meshlet)
+    };
+
+    if(!writeMeshCache(filename, sourceData, sourceSize, header, arrays, arraySizes))
+    {
+        cout << "Unable to write mesh cache: " << meshCachePath(filename) << endl;
+    }
+}
+
+// Copies the data out of the mapped cache into our own arrays, so that they can be modified
+void GeometryData::detachFromCache()
+{
+    if(!cacheHeader)
+    {
+        return;
+    }
+
+    std::vector<float>* arrays[4] = {&vertices, &textureCoords, &normals, &tangents};
+    for(int array=0; array<4; array++)
+    {
+        const float* data = (const float*)cachedArray(array);
+        size_t count = cacheHeader->arraySizes[array]/sizeof(float);
+        if(data)
+        {
+            arrays[array]->assign(data, data + count);
+        }
+    }
+
+    const void* cachedIndices = cachedArray(MESH_CACHE_INDICES);
+    size_t count = cacheHeader->indexCount;
+    if(cacheHeader->indexSize == sizeof(unsigned short))
+    {
+        shortIndices.assign((const unsigned short*)cachedIndices,
+                            (const unsigned short*)cachedIndices + count);
+        indices.assign(shortIndices.begin(), shortIndices.end());
+    }
+    else
+    {
+        indices.assign((const unsigned int*)cachedIndices,
+                       (const unsigned int*)cachedIndices + count);
+    }
 
-    cout << "Successfully loaded an OBJ with " << vertices.size()/3 << " vertices " << endl;
+    lods.clear();
+    for(unsigned int level=0; level<cacheHeader->lodCount; level++)
+    {
+        lods.push_back(lod(level));
+    }
+    const void* cachedLodIndices = cachedArray(MESH_CACHE_LOD_INDICES);
+    count = lodIndexCount();
+    if(cacheHeader->indexSize == sizeof(unsigned short))
+    {
+        shortLodIndices.assign((const unsigned short*)cachedLodIndices,
+                               (const unsigned short*)cachedLodIndices + count);
+        lodIndices.assign(shortLodIndices.begin(), shortLodIndices.end());
+    }
+    else
+    {
+        lodIndices.assign((const unsigned int*)cachedLodIndices,
+                          (const unsigned int*)cachedLodIndices + count);
+    }
+
+    const Meshlet* cachedMeshlets = meshletData();
+    meshlets.assign(cachedMeshlets, cachedMeshlets + meshletCount());
+
+    cacheHeader = 0;
+    cacheMapping.reset();
+}
+
+const void* GeometryData::cachedArray(int array)
+{
+    if(!(cacheHeader->arrayMask & (1 << array)))
+    {
+        return 0;
+    }
+    return cacheMapping->data() + cacheHeader->arrayOffsets[array];
 }
 
 int GeometryData::vertexCount()
 {
+    if(cacheHeader)
+    {
+        return cacheHeader->vertexCount;
+    }
     return vertices.size()/3;
 }
 
+int GeometryData::indexCount()
+{
+    if(cacheHeader)
+    {
+        return cacheHeader->indexCount;
+    }
+    return indices.size();
+}
+
+int GeometryData::indexSize()
+{
+    if(cacheHeader)
+    {
+        return cacheHeader->indexSize;
+    }
+    return shortIndices.empty() ? sizeof(unsigned int) : sizeof(unsigned short);
+}
+
+int GeometryData::textureCoordCount()
+{
+    if(cacheHeader)
+    {
+        return cacheHeader->arraySizes[MESH_CACHE_TEXCOORDS]/(2*sizeof(float));
+    }
+    return textureCoords.size()/2;
+}
+
+int GeometryData::normalCount()
+{
+    if(cacheHeader)
+    {
+        return cacheHeader->arraySizes[MESH_CACHE_NORMALS]/(3*sizeof(float));
+    }
+    return normals.size()/3;
+}
+
 void* GeometryData::vertexData()
 {
+    if(cacheHeader)
+    {
+        return (void*)cachedArray(MESH_CACHE_POSITIONS);
+    }
     return (void*)&vertices[0];
 }
 
 void* GeometryData::textureCoordData()
 {
+    if(cacheHeader)
+    {
+        return (void*)cachedArray(MESH_CACHE_TEXCOORDS);
+    }
     return (void*)&textureCoords[0];
 }
 
 void* GeometryData::normalData()
 {
+    if(cacheHeader)
+    {
+        return (void*)cachedArray(MESH_CACHE_NORMALS);
+    }
     return (void*)&normals[0];
 }
 
 void* GeometryData::tangentData()
 {
+    if(cacheHeader)
+    {
+        return (void*)cachedArray(MESH_CACHE_TANGENTS);
+    }
     return (void*)&tangents[0];
 }
 
-void* GeometryData::bitangentData()
+void* GeometryData::indexData()
+{
+    if(cacheHeader)
+    {
+        return (void*)cachedArray(MESH_CACHE_INDICES);
+    }
+    if(!shortIndices.empty())
+    {
+        return (void*)&shortIndices[0];
+    }
+    return (void*)&indices[0];
+}
+
+const float* GeometryData::boundsMin()
 {
-    return (void*)&bitangents[0];
+    return minimumBounds;
 }
+
+const float* GeometryData::boundsMax()
+{
+    return maximumBounds;
+}
+
+float GeometryData::boundingRadius()
+{
+    return sphereRadius;
+}
\ No newline at end of file
@@ -3,6 +3,13 @@
 
 #include <vector>
 #include <string>
+#include <memory>
+#include <functional>
+
+#include "meshlets.h"
+
+class MappedFile;
+struct MeshCacheHeader;
 
 struct FaceData
 {
@@ -11,27 +18,151 @@ struct FaceData
     int normalIndex[3];
 };
 
+// A simplified version of a mesh, drawn with the same vertices as the full one. Each level is a
+// range of the index buffer made of indexData() followed by lodIndexData()
+struct GeometryLOD
+{
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    // Roughly how far the surface moved from the full mesh, in model units
+    float error;
+};
+
+struct GeometryLoadOptions
+{
+    // Number of threads used to parse the file, each taking a newline-aligned chunk of it, and to
+    // generate normals. The result is identical for any thread count. 0 picks one thread per core
+    // (for large files)
+    int threadCount = 0;
+
+    // Reuse the binary cache written next to the OBJ file by an earlier load (see meshcache.h),
+    // or write one if there's no valid cache yet
+    bool useCache = true;
+
+    // Reorder the mesh for the GPU's vertex cache and to reduce overdraw once it's loaded (see
+    // GeometryData::optimizeMesh). Caches remember whether this was done
+    bool optimizeMesh = false;
+
+    // Build a chain of simplified LODs once it's loaded (see GeometryData::generateLODs)
+    bool generateLODs = false;
+
+    // Make smooth normals for files without any vn records (see normals.h), weighted by the angle
+    // at each corner or by triangle area. Where two triangles meet at more than creaseAngle
+    // degrees the edge is kept hard, with 180 smoothing everything. Caches remember all three
+    bool generateNormals = true;
+    bool angleWeightedNormals = true;
+    float creaseAngle = 180.0f;
+
+    // Split the full mesh into meshlets for culling finer than whole objects, after any
+    // optimization (see GeometryData::generateMeshlets). Caches remember whether this was done
+    bool generateMeshlets = false;
+
+    // Called (on the loading thread) as each step of the load starts, with a short description
+    // of it ("parsing", "generating LODs", ...)
+    std::function<void(const char* step)> progress;
+};
+
 class GeometryData
 {
 public:
-    void loadFromOBJFile(std::string filename);
+    GeometryData();
+
+    // Memory-maps the file and parses it in a single pass
+    void loadFromOBJFile(std::string filename,
+                         const GeometryLoadOptions& options = GeometryLoadOptions());
+    // The original istream based loader, kept as a reference for benchmarking the one above. Of
+    // the options it only takes the ones for normals and progress, so that everything after
+    // parsing is the same work as that one does
+    void loadFromOBJFileStream(std::string filename,
+                               const GeometryLoadOptions& options = GeometryLoadOptions());
 
+    // Number of unique v/vt/vn vertices
     int vertexCount();
+    // Number of indices (3 per triangle) into those vertices, each indexSize() bytes wide
+    int indexCount();
+    int indexSize();
+    int textureCoordCount();
+    int normalCount();
 
     void* vertexData();
     void* textureCoordData();
     void* normalData();
+    // x, y, z and handedness per vertex, for meshes with texture coords and normals (see
+    // tangents.h)
     void* tangentData();
-    void* bitangentData();
+    void* indexData();
+
+    // Reorders triangles for the post-transform vertex cache and then roughly outside-in to cut
+    // overdraw, and renumbers vertices in the order they're first used. Prints the simulated
+    // vertex cache statistics before and after
+    void optimizeMesh();
+
+    // Simplifies the mesh to 50%, 25%, 10% and 2% of its triangles (each level from the one
+    // before), stopping early if it won't get any simpler. Loading another object into this
+    // geometry throws the LODs away
+    void generateLODs();
+    // Number of levels of detail, including the full mesh (so always at least 1)
+    int lodCount();
+    GeometryLOD lod(int level);
+    // Indices of every level after the full one, each indexSize() bytes wide
+    int lodIndexCount();
+    void* lodIndexData();
+
+    // Reorders the full mesh's triangles into meshlets of at most MESHLET_MAX_VERTICES vertices
+    // and MESHLET_MAX_TRIANGLES triangles, each with the bounds to cull it by (see meshlets.h).
+    // The LODs aren't split. Optimizing the mesh or loading another object into this geometry
+    // throws the meshlets away
+    void generateMeshlets();
+    // 0 if no meshlets were generated. They cover indexData() in order
+    int meshletCount();
+    const Meshlet* meshletData();
+
+    // Axis-aligned bounding box of all the vertices
+    const float* boundsMin();
+    const float* boundsMax();
+    // Radius of the sphere around the middle of the bounding box that holds every vertex (which
+    // is usually well inside the box's corners)
+    float boundingRadius();
 
 private:
+    bool loadFromCache(const std::string& filename, unsigned int processingFlags,
+                       float creaseAngle);
+    void writeCache(const std::string& filename, unsigned int processingFlags, float creaseAngle,
+                    const char* sourceData, size_t sourceSize);
+    void detachFromCache();
+    const void* cachedArray(int array);
+
+    static void dropInvalidFaces(GeometryData& tempGeom);
+    static void generateMissingNormals(GeometryData& tempGeom, const GeometryLoadOptions& options);
+    void buildVertexArrays(GeometryData& tempGeom);
+    void computeTangents(unsigned int firstVertex, size_t firstIndex);
+    void updateShortIndices();
+
     std::vector<float> vertices;
     std::vector<float> textureCoords;
     std::vector<float> normals;
     std::vector<float> tangents;
-    std::vector<float> bitangents;
+    std::vector<unsigned int> indices;
+    // A 16-bit copy of indices, only filled in when every index fits
+    std::vector<unsigned short> shortIndices;
+
+    // Levels of detail (empty if none were generated) and the indices of all but the first
+    std::vector<GeometryLOD> lods;
+    std::vector<unsigned int> lodIndices;
+    std::vector<unsigned short> shortLodIndices;
+
+    std::vector<Meshlet> meshlets;
 
     std::vector<FaceData> faces;
+
+    float minimumBounds[3];
+    float maximumBounds[3];
+    float sphereRadius;
+
+    // When loaded from a binary cache, the data lives in the mapped file instead of the vectors
+    // above (and the accessors hand out pointers straight into the mapping)
+    std::shared_ptr<MappedFile> cacheMapping;
+    const MeshCacheHeader* cacheHeader;
 };
 
 #endif
@@ -0,0 +1,360 @@
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <string.h>
+#include <stdint.h>
+
+#include "geometryarena.h"
+#include "streambuffer.h"
+
+using namespace std;
+
+static const unsigned int NO_RANGE = ~0u;
+
+// Position as four 16-bit unsigned normalized values (the fourth is padding), then colour as four
+// 8-bit ones
+static const size_t ARENA_POSITION_SIZE = 4*sizeof(uint16_t);
+static const size_t ARENA_VERTEX_SIZE = ARENA_POSITION_SIZE + 4;
+
+// The buffers start with room for this many vertices (and 3 times as many indices), and at least
+// double whenever they fill up, so a scene of small meshes only grows them a few times
+static const unsigned int MIN_ARENA_VERTICES = 1 << 16;
+
+ArenaRanges::ArenaRanges()
+{
+    total = 0;
+}
+
+unsigned int ArenaRanges::allocate(unsigned int size)
+{
+    for(map<unsigned int, unsigned int>::iterator range = freeRanges.begin();
+        range != freeRanges.end(); ++range)
+    {
+        if(range->second < size)
+        {
+            continue;
+        }
+        unsigned int start = range->first;
+        unsigned int remaining = range->second - size;
+        freeRanges.erase(range);
+        if(remaining > 0)
+        {
+            freeRanges[start + size] = remaining;
+        }
+        return start;
+    }
+    return NO_RANGE;
+}
+
+void ArenaRanges::release(unsigned int start, unsigned int size)
+{
+    if(size == 0)
+    {
+        return;
+    }
+    map<unsigned int, unsigned int>::iterator next = freeRanges.lower_bound(start);
+    if((next != freeRanges.end()) && (start + size == next->first))
+    {
+        size += next->second;
+        next = freeRanges.erase(next);
+    }
+    if(next != freeRanges.begin())
+    {
+        map<unsigned int, unsigned int>::iterator previous = std::prev(next);
+        if(previous->first + previous->second == start)
+        {
+            previous->second += size;
+            return;
+        }
+    }
+    freeRanges[start] = size;
+}
+
+void ArenaRanges::grow(unsigned int newCapacity)
+{
+    if(newCapacity <= total)
+    {
+        return;
+    }
+    release(total, newCapacity - total);
+    total = newCapacity;
+}
+
+unsigned int ArenaRanges::capacity()
+{
+    return total;
+}
+
+// Enough to fit another count, even if none of the free space is at the end
+static unsigned int grownCapacity(unsigned int capacity, unsigned int count,
+                                  unsigned int minimumCapacity)
+{
+    return std::max(std::max(2*capacity, capacity + count), minimumCapacity);
+}
+
+// Moves a buffer's contents into a bigger new one, and deletes the old one
+static void growBuffer(GLStateCache& state, GLuint* buffer, size_t oldBytes, size_t newBytes)
+{
+    GLuint grown;
+    glGenBuffers(1, &grown);
+    state.bindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    state.bufferData(GL_COPY_WRITE_BUFFER, newBytes, 0, GL_STATIC_DRAW);
+    if(*buffer)
+    {
+        state.bindBuffer(GL_COPY_READ_BUFFER, *buffer);
+        state.copyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+        glDeleteBuffers(1, buffer);
+
+        // NOTE: Deleting a bound object unbinds it, and its name can be handed out again
+        state.invalidate();
+    }
+    *buffer = grown;
+}
+
+GeometryArena::GeometryArena()
+{
+    vertexArray = 0;
+    vertexBuffer = 0;
+    indexBuffer = 0;
+    commandBuffer = 0;
+    transformBuffer = 0;
+    instancesInStream = false;
+}
+
+bool GeometryArena::supported()
+{
+    return (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect) &&
+           (GLEW_VERSION_4_2 || GLEW_ARB_base_instance);
+}
+
+const char* GeometryArena::vertexFormat()
+{
+    return "unorm16 position, unorm8 colour";
+}
+
+size_t GeometryArena::vertexSize()
+{
+    return ARENA_VERTEX_SIZE;
+}
+
+int GeometryArena::add(GLStateCache& state, const GLMeshData& data)
+{
+    if(!vertexArray)
+    {
+        glGenVertexArrays(1, &vertexArray);
+        glGenBuffers(1, &commandBuffer);
+        glGenBuffers(1, &transformBuffer);
+
+        //the per-instance model matrices, one vec4 column per attribute, hold one identity matrix
+        //until the first draw so the buffer is never empty
+        glm::mat4 identity(1.0f);
+        state.bindVertexArray(vertexArray);
+        state.bindBuffer(GL_ARRAY_BUFFER, transformBuffer);
+        state.bufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4), &identity[0][0], GL_STREAM_DRAW);
+        for(int column=0; column<4; column++)
+        {
+            GLuint attribute = 5 + column;
+            glEnableVertexAttribArray(attribute);
+            glVertexAttribDivisor(attribute, 1);
+        }
+        pointInstanceAttributes(0);
+        instancesInStream = false;
+    }
+
+    ArenaMesh placed;
+    placed.vertexCount = data.colors.size()/3;
+    placed.indexCount = (data.indexBytes + data.lodIndexBytes)/data.indexSize;
+    placed.positionTransform = data.positionTransform;
+    placed.firstVertex = vertexRanges.allocate(placed.vertexCount);
+    placed.firstIndex = indexRanges.allocate(placed.indexCount);
+    if((placed.firstVertex == NO_RANGE) || (placed.firstIndex == NO_RANGE))
+    {
+        if(placed.firstVertex == NO_RANGE)
+        {
+            unsigned int capacity = vertexRanges.capacity();
+            unsigned int grown = grownCapacity(capacity, placed.vertexCount, MIN_ARENA_VERTICES);
+            growBuffer(state, &vertexBuffer, capacity*ARENA_VERTEX_SIZE, grown*ARENA_VERTEX_SIZE);
+            vertexRanges.grow(grown);
+            placed.firstVertex = vertexRanges.allocate(placed.vertexCount);
+        }
+        if(placed.firstIndex == NO_RANGE)
+        {
+            unsigned int capacity = indexRanges.capacity();
+            unsigned int grown = grownCapacity(capacity, placed.indexCount, 3*MIN_ARENA_VERTICES);
+            growBuffer(state, &indexBuffer, capacity*sizeof(unsigned int),
+                       grown*sizeof(unsigned int));
+            indexRanges.grow(grown);
+            placed.firstIndex = indexRanges.allocate(placed.indexCount);
+        }
+        pointAttributes(state);
+    }
+
+    //the packed positions, and the same colours GLMesh gives the mesh
+    const unsigned char* packed = data.packedVertices.data() + data.layout.positionOffset;
+    vector<unsigned char> vertices((size_t)placed.vertexCount*ARENA_VERTEX_SIZE);
+    for(size_t v=0; v<placed.vertexCount; v++)
+    {
+        unsigned char* vertex = &vertices[v*ARENA_VERTEX_SIZE];
+        memcpy(vertex, packed + v*data.layout.stride, ARENA_POSITION_SIZE);
+        for(int k=0; k<3; k++)
+        {
+            vertex[ARENA_POSITION_SIZE + k] = (unsigned char)(data.colors[3*v + k]*255.0f + 0.5f);
+        }
+        vertex[ARENA_POSITION_SIZE + 3] = 255;
+    }
+    state.bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    state.bufferSubData(GL_ARRAY_BUFFER, (size_t)placed.firstVertex*ARENA_VERTEX_SIZE,
+                        vertices.size(), vertices.data());
+
+    //the indices stay relative to the mesh (the draws add the first vertex back on)
+    vector<unsigned int> indices(placed.indexCount);
+    const unsigned char* sources[2] = {data.indices, data.lodIndices};
+    size_t counts[2] = {data.indexBytes/data.indexSize, data.lodIndexBytes/data.indexSize};
+    size_t written = 0;
+    for(int part=0; part<2; part++)
+    {
+        for(size_t i=0; i<counts[part]; i++)
+        {
+            indices[written++] = (data.indexSize == 2) ?
+                ((const unsigned short*)sources[part])[i] : ((const unsigned int*)sources[part])[i];
+        }
+    }
+    state.bindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+    state.bufferSubData(GL_COPY_WRITE_BUFFER, (size_t)placed.firstIndex*sizeof(unsigned int),
+                        indices.size()*sizeof(unsigned int), indices.data());
+
+    int id;
+    if(!freeIds.empty())
+    {
+        id = freeIds.back();
+        freeIds.pop_back();
+        meshes[id] = placed;
+    }
+    else
+    {
+        id = meshes.size();
+        meshes.push_back(placed);
+    }
+    return id;
+}
+
+void GeometryArena::remove(int id)
+{
+    const ArenaMesh& placed = meshes[id];
+    vertexRanges.release(placed.firstVertex, placed.vertexCount);
+    indexRanges.release(placed.firstIndex, placed.indexCount);
+    freeIds.push_back(id);
+}
+
+const ArenaMesh& GeometryArena::mesh(int id)
+{
+    return meshes[id];
+}
+
+// NOTE: As with GLMesh::drawInstanced, the matrices and commands go into the stream buffer's ring
+//       when there is one (the base instances then count from where the matrices were written),
+//       otherwise into freshly allocated stores of the arena's own buffers
+void GeometryArena::drawIndirect(GLStateCache& state, const DrawElementsIndirectCommand* commands,
+                                 int commandCount, const glm::mat4* transforms, int transformCount)
+{
+    if(commandCount == 0)
+    {
+        return;
+    }
+    StreamBuffer* stream = state.streamBuffer();
+    state.bindVertexArray(vertexArray);
+
+    size_t transformBytes = (size_t)transformCount*sizeof(glm::mat4);
+    size_t transformOffset = 0;
+    void* transformData = stream ? stream->map(state, transformBytes, &transformOffset) : 0;
+    if(transformData)
+    {
+        memcpy(transformData, transforms, transformBytes);
+        stream->unmap(state);
+        state.bindBuffer(GL_ARRAY_BUFFER, stream->buffer());
+        pointInstanceAttributes(transformOffset);
+        instancesInStream = true;
+    }
+    else
+    {
+        state.bindBuffer(GL_ARRAY_BUFFER, transformBuffer);
+        state.bufferData(GL_ARRAY_BUFFER, transformBytes, transforms, GL_STREAM_DRAW);
+        if(instancesInStream)
+        {
+            pointInstanceAttributes(0);
+            instancesInStream = false;
+        }
+    }
+
+    size_t commandBytes = (size_t)commandCount*sizeof(DrawElementsIndirectCommand);
+    size_t commandOffset = 0;
+    void* commandData = stream ? stream->map(state, commandBytes, &commandOffset) : 0;
+    if(commandData)
+    {
+        memcpy(commandData, commands, commandBytes);
+        stream->unmap(state);
+        state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, stream->buffer());
+    }
+    else
+    {
+        state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        state.bufferData(GL_DRAW_INDIRECT_BUFFER, commandBytes, commands, GL_STREAM_DRAW);
+        commandOffset = 0;
+    }
+
+    state.multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, commandOffset, commandCount);
+}
+
+void GeometryArena::destroy(GLStateCache& state)
+{
+    if(!vertexArray)
+    {
+        return;
+    }
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteBuffers(1, &commandBuffer);
+    glDeleteBuffers(1, &transformBuffer);
+    glDeleteVertexArrays(1, &vertexArray);
+    vertexArray = 0;
+    vertexBuffer = 0;
+    indexBuffer = 0;
+    commandBuffer = 0;
+    transformBuffer = 0;
+    vertexRanges = ArenaRanges();
+    indexRanges = ArenaRanges();
+    meshes.clear();
+    freeIds.clear();
+
+    state.invalidate();
+}
+
+long long GeometryArena::bufferBytes()
+{
+    return (long long)vertexRanges.capacity()*ARENA_VERTEX_SIZE +
+           (long long)indexRanges.capacity()*sizeof(unsigned int);
+}
+
+//points the vertex attributes and element buffer of the vertex array at the shared buffers (again
+//after they've grown, since the vertex array holds on to the buffers they were in)
+void GeometryArena::pointAttributes(GLStateCache& state)
+{
+    state.bindVertexArray(vertexArray);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    state.bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, ARENA_VERTEX_SIZE, (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_UNSIGNED_BYTE, GL_TRUE, ARENA_VERTEX_SIZE,
+                          (void*)ARENA_POSITION_SIZE);
+}
+
+//points the per-instance matrix attributes at the buffer bound to GL_ARRAY_BUFFER, starting at offset
+void GeometryArena::pointInstanceAttributes(size_t offset)
+{
+    for(int column=0; column<4; column++)
+    {
+        glVertexAttribPointer(5 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void*)(offset + column*sizeof(glm::vec4)));
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef GEOMETRY_ARENA_H
+#define GEOMETRY_ARENA_H
+
+#include <vector>
+#include <map>
+#include <stddef.h>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "geometry.h"
+#include "glmesh.h"
+#include "glstate.h"
+
+// Shared buffers that any number of meshes are suballocated out of, so that the whole scene can
+// be drawn from one vertex array with a single glMultiDrawElementsIndirect: each object is a
+// command in a GL_DRAW_INDIRECT_BUFFER that picks its mesh's range of the index buffer (with the
+// mesh's first vertex as the base vertex) and its own model matrix (with its base instance, which
+// offsets the per-instance matrix attributes at locations 5 to 8, see instanced.vert). There's no
+// binding or uniform to change between objects, so drawing 10,000 distinct objects costs the CPU
+// about as much as writing 10,000 commands.
+//
+// Vertices are a 16-bit position within the mesh's bounds (as in a packed vertex, see vertexpack.h)
+// and an 8-bit colour, interleaved in 12 bytes. Each mesh's dequantize matrix is multiplied onto
+// its objects' model matrices, since there's no uniform to change between them. Indices are
+// 32-bit so that meshes of any size can share the buffer
+
+// One mesh's place in the arena. Its indices are the full mesh's followed by the LODs' (so a LOD's
+// range starts at firstIndex + GeometryLOD::firstIndex), and count from firstVertex
+struct ArenaMesh
+{
+    unsigned int firstVertex;
+    unsigned int vertexCount;
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    // Takes the mesh's positions in the arena to model space
+    glm::mat4 positionTransform;
+};
+
+// The layout glMultiDrawElementsIndirect reads each command in
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// First fit allocation of ranges of [0, capacity), with freed ranges merged back into their
+// neighbours
+class ArenaRanges
+{
+public:
+    ArenaRanges();
+
+    // Returns the start of a free range of the given size, or ~0u if none is big enough
+    unsigned int allocate(unsigned int size);
+    void release(unsigned int start, unsigned int size);
+    // Adds free space at the end
+    void grow(unsigned int newCapacity);
+    unsigned int capacity();
+
+private:
+    std::map<unsigned int, unsigned int> freeRanges;//size of each free range, by its start
+    unsigned int total;
+};
+
+class GeometryArena
+{
+public:
+    GeometryArena();
+
+    // Whether the context has what drawIndirect needs: glMultiDrawElementsIndirect (GL 4.3 or
+    // GL_ARB_multi_draw_indirect) and base instances (GL 4.2 or GL_ARB_base_instance)
+    static bool supported();
+    // Description and size of a vertex in the arena, for reports
+    static const char* vertexFormat();
+    static size_t vertexSize();
+
+    // Copies the positions and colours of a mesh prepared with packed vertices (see
+    // GLMesh::prepare), and its indices (including the LODs), into free space, creating the
+    // buffers or growing them first if there isn't enough. Returns the new mesh's id
+    int add(GLStateCache& state, const GLMeshData& data);
+    // Frees the mesh's space for later adds
+    void remove(int id);
+    const ArenaMesh& mesh(int id);
+
+    // Draws every command with one glMultiDrawElementsIndirect, using whatever program is in use.
+    // Each command's baseInstance is the index of its model matrix in transforms. The commands and
+    // matrices are written into the state cache's stream buffer when it has one, and into buffers
+    // of the arena's own otherwise
+    void drawIndirect(GLStateCache& state, const DrawElementsIndirectCommand* commands,
+                      int commandCount, const glm::mat4* transforms, int transformCount);
+
+    void destroy(GLStateCache& state);
+
+    // Size of the shared vertex and index buffers (including free space)
+    long long bufferBytes();
+
+private:
+    void pointAttributes(GLStateCache& state);
+    void pointInstanceAttributes(size_t offset);
+
+    GLuint vertexArray;
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    GLuint commandBuffer;//commands and matrices, when there's no stream buffer
+    GLuint transformBuffer;
+    bool instancesInStream;//whether the instance attributes point into the stream buffer rather than transformBuffer
+
+    ArenaRanges vertexRanges;
+    ArenaRanges indexRanges;
+    std::vector<ArenaMesh> meshes;
+    std::vector<int> freeIds;
+};
+
+#endif
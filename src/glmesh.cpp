@@ -0,0 +1,373 @@
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "glmesh.h"
+#include "streambuffer.h"
+
+GLMesh::GLMesh()
+{
+    vertexArray = 0;
+    vertexBuffer = 0;
+    colorBuffer = 0;
+    indexBuffer = 0;
+    instanceBuffer = 0;
+    indexType = GL_UNSIGNED_INT;
+    indexSize = sizeof(unsigned int);
+    positionTransform = glm::mat4(1.0f);
+    vertexBufferBytes = 0;
+    uploadedBytes = 0;
+    instancesInStream = false;
+}
+
+const unsigned char* GLMeshData::vertexSource() const
+{
+    return packed ? packedVertices.data() : (const unsigned char*)positions;
+}
+
+size_t GLMeshData::uploadBytes() const
+{
+    return vertexBytes + colors.size()*sizeof(float) + indexBytes + lodIndexBytes;
+}
+
+void GLMesh::upload(GLStateCache& state, GeometryData& geometry, bool packed)
+{
+    GLMeshData data;
+    prepare(geometry, packed, &data);
+    beginUpload(state, data);
+    continueUpload(state, data, data.uploadBytes());
+}
+
+void GLMesh::prepare(GeometryData& geometry, bool packed, GLMeshData* data)
+{
+    int vertexCount = geometry.vertexCount();
+    const float* positions = (const float*)geometry.vertexData();
+
+    //for vertices, either packed or just the float positions
+    data->packed = packed;
+    data->positions = positions;
+    if(packed)
+    {
+        bool hasTextureCoords = (geometry.textureCoordCount() > 0);
+        bool hasNormals = (geometry.normalCount() > 0);
+        bool hasTangents = hasTextureCoords && hasNormals;
+        data->layout = packedVertexLayout(hasTextureCoords, hasNormals, hasTangents);
+        data->packedVertices.resize((size_t)vertexCount*data->layout.stride);
+        packVertices(data->packedVertices.data(), data->layout, vertexCount, positions,
+                     hasTextureCoords ? (const float*)geometry.textureCoordData() : 0,
+                     hasNormals ? (const float*)geometry.normalData() : 0,
+                     hasTangents ? (const float*)geometry.tangentData() : 0,
+                     geometry.boundsMin(), geometry.boundsMax());
+
+        data->vertexBytes = data->packedVertices.size();
+
+        float scale[3];
+        float offset[3];
+        packedPositionTransform(geometry.boundsMin(), geometry.boundsMax(), scale, offset);
+        data->positionTransform = glm::scale(glm::translate(glm::mat4(1.0f), glm::make_vec3(offset)),
+                                             glm::make_vec3(scale));
+    }
+    else
+    {
+        data->packedVertices.clear();
+        data->vertexBytes = (size_t)vertexCount*3*sizeof(float);
+        data->positionTransform = glm::mat4(1.0f);
+    }
+
+    //for colours. prepare runs on loader threads while the main thread carries on, so the colours
+    //come from a generator of the mesh's own (seeded from its size) rather than rand()'s shared one
+    std::minstd_rand random(vertexCount*31u + geometry.indexCount());
+    float range = static_cast<float>(std::minstd_rand::max() - std::minstd_rand::min());
+    data->colors.resize(vertexCount*3);
+    for(int i=0; i<vertexCount*3; ++i)
+    {
+        data->colors[i] = static_cast<float>(random() - std::minstd_rand::min())/range;
+    }
+
+    //for indices (16-bit when the mesh is small enough, see GeometryData::indexSize), with the
+    //LODs after the full mesh
+    data->indexSize = geometry.indexSize();
+    data->indices = (const unsigned char*)geometry.indexData();
+    data->indexBytes = (size_t)geometry.indexCount()*data->indexSize;
+    data->lodIndices = (const unsigned char*)geometry.lodIndexData();
+    data->lodIndexBytes = (size_t)geometry.lodIndexCount()*data->indexSize;
+}
+
+void GLMesh::beginUpload(GLStateCache& state, const GLMeshData& data)
+{
+    //objects are only created once, later uploads just refill them
+    if(!vertexArray)
+    {
+        glGenVertexArrays(1, &vertexArray);
+        glGenBuffers(1, &vertexBuffer);
+        glGenBuffers(1, &colorBuffer);
+        glGenBuffers(1, &indexBuffer);
+        glGenBuffers(1, &instanceBuffer);
+    }
+    state.bindVertexArray(vertexArray);
+
+    //the buffers are only allocated here, continueUpload fills them. The attribute pointers are
+    //recorded in the vertex array along with the buffer they point into
+    state.bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    vertexBufferBytes = data.vertexBytes;
+    state.bufferData(GL_ARRAY_BUFFER, vertexBufferBytes, 0, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    if(data.packed)
+    {
+        // Positions are 0..1 within the bounding box (positionTransform scales them back), and
+        // whichever of the normal, tangent and uvs the mesh has sit right after them
+        const PackedVertexLayout& layout = data.layout;
+        GLsizei stride = layout.stride;
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                              (void*)(size_t)layout.positionOffset);
+        int offsets[3] = {layout.normalOffset, layout.tangentOffset, layout.texCoordOffset};
+        for(int i=0; i<3; i++)
+        {
+            GLuint attribute = 2 + i;
+            if(offsets[i] < 0)
+            {
+                glDisableVertexAttribArray(attribute);
+                continue;
+            }
+            glEnableVertexAttribArray(attribute);
+            if(attribute == 4)
+            {
+                glVertexAttribPointer(attribute, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+                                      (void*)(size_t)offsets[i]);
+            }
+            else
+            {
+                glVertexAttribPointer(attribute, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                                      (void*)(size_t)offsets[i]);
+            }
+        }
+    }
+    else
+    {
+        glVertexAttribPointer(
+            0,                  // 0 to match number in shader
+            3,
+            GL_FLOAT,
+            GL_FALSE,
+            0,
+            (void*)0
+        );
+        for(GLuint attribute=2; attribute<5; attribute++)
+        {
+            glDisableVertexAttribArray(attribute);
+        }
+    }
+    positionTransform = data.positionTransform;
+
+    //for colours
+    state.bindBuffer(GL_ARRAY_BUFFER, colorBuffer);
+    state.bufferData(GL_ARRAY_BUFFER, data.colors.size()*sizeof(float), 0, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(
+        1,                  // attribute. No particular reason for 1, but must match the layout in the shader.
+        3,
+        GL_FLOAT,
+        GL_FALSE,
+        0,
+        (void*)0
+    );
+
+    //for per-instance model matrices, one vec4 column per attribute. They're filled in on each
+    //instanced draw, until then the buffer holds one identity matrix so it's never empty
+    glm::mat4 identity(1.0f);
+    state.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    state.bufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4), &identity[0][0], GL_STREAM_DRAW);
+    for(int column=0; column<4; column++)
+    {
+        GLuint attribute = 5 + column;
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    pointInstanceAttributes(0);
+    instancesInStream = false;
+
+    //for indices
+    indexSize = data.indexSize;
+    indexType = (indexSize == 2) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    state.bufferData(GL_ELEMENT_ARRAY_BUFFER, data.indexBytes + data.lodIndexBytes, 0, GL_STATIC_DRAW);
+
+    uploadedBytes = 0;
+}
+
+// NOTE: The data is treated as the vertices, colours and indices one after the other, and each
+//       call copies the part of that range it gets to into whichever buffers it falls in. With a
+//       stream buffer the data goes through the ring and GL copies it from there into place
+bool GLMesh::continueUpload(GLStateCache& state, const GLMeshData& data, size_t maxBytes)
+{
+    StreamBuffer* stream = state.streamBuffer();
+    const unsigned char* sources[4] = {data.vertexSource(), (const unsigned char*)data.colors.data(),
+                                       data.indices, data.lodIndices};
+    size_t sizes[4] = {data.vertexBytes, data.colors.size()*sizeof(float), data.indexBytes,
+                       data.lodIndexBytes};
+    GLuint buffers[4] = {vertexBuffer, colorBuffer, indexBuffer, indexBuffer};
+    //where each part goes in its buffer (the LODs' indices follow the full mesh's)
+    size_t bufferOffsets[4] = {0, 0, 0, data.indexBytes};
+
+    // The index buffer binding belongs to the vertex array, so it has to be ours that's bound
+    state.bindVertexArray(vertexArray);
+    size_t end = uploadedBytes + maxBytes;
+    size_t bufferStart = 0;
+    for(int i=0; i<4; i++)
+    {
+        size_t bufferEnd = bufferStart + sizes[i];
+        size_t copyStart = std::max(uploadedBytes, bufferStart);
+        size_t copyEnd = std::min(end, bufferEnd);
+        while(copyStart < copyEnd)
+        {
+            //a piece at a time, so that one big upload doesn't need the whole ring to itself
+            size_t copyBytes = copyEnd - copyStart;
+            size_t streamOffset = 0;
+            void* streamData = 0;
+            if(stream)
+            {
+                copyBytes = std::min(copyBytes, stream->capacity()/4);
+                streamData = stream->map(state, copyBytes, &streamOffset);
+            }
+            if(streamData)
+            {
+                memcpy(streamData, sources[i] + (copyStart - bufferStart), copyBytes);
+                stream->unmap(state);
+                state.bindBuffer(GL_COPY_READ_BUFFER, stream->buffer());
+                state.bindBuffer(GL_COPY_WRITE_BUFFER, buffers[i]);
+                state.copyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, streamOffset,
+                                        bufferOffsets[i] + (copyStart - bufferStart), copyBytes);
+            }
+            else
+            {
+                GLenum target = (i >= 2) ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER;
+                state.bindBuffer(target, buffers[i]);
+                state.bufferSubData(target, bufferOffsets[i] + (copyStart - bufferStart), copyBytes,
+                                    sources[i] + (copyStart - bufferStart));
+            }
+            copyStart += copyBytes;
+            uploadedBytes = copyStart;
+        }
+        bufferStart = bufferEnd;
+    }
+    return uploadedBytes >= data.uploadBytes();
+}
+
+void GLMesh::draw(GLStateCache& state, const GeometryLOD& lod)
+{
+    state.bindVertexArray(vertexArray);
+    state.drawElements(GL_TRIANGLES, lod.indexCount, indexType, (size_t)lod.firstIndex*indexSize);
+}
+
+void GLMesh::drawRanges(GLStateCache& state, const unsigned int* firstIndices,
+                        const GLsizei* indexCounts, int rangeCount)
+{
+    rangeOffsets.resize(rangeCount);
+    for(int i=0; i<rangeCount; i++)
+    {
+        rangeOffsets[i] = (const void*)((size_t)firstIndices[i]*indexSize);
+    }
+    state.bindVertexArray(vertexArray);
+    state.multiDrawElements(GL_TRIANGLES, indexCounts, indexType, rangeOffsets.data(), rangeCount);
+}
+
+// NOTE: With a stream buffer the matrices are written into the ring and the instance attributes
+//       point at them there (GL 3.3 has no base instance to offset them with instead). Otherwise
+//       they go into a freshly allocated store of the mesh's own buffer each time (the old one is
+//       orphaned). Either way this doesn't wait for earlier draws that are still reading them
+void GLMesh::drawInstanced(GLStateCache& state, const GeometryLOD& lod,
+                           const glm::mat4* transforms, int instanceCount)
+{
+    StreamBuffer* stream = state.streamBuffer();
+    size_t bytes = (size_t)instanceCount*sizeof(glm::mat4);
+    size_t streamOffset = 0;
+    void* streamData = stream ? stream->map(state, bytes, &streamOffset) : 0;
+    state.bindVertexArray(vertexArray);
+    if(streamData)
+    {
+        memcpy(streamData, transforms, bytes);
+        stream->unmap(state);
+        state.bindBuffer(GL_ARRAY_BUFFER, stream->buffer());
+        pointInstanceAttributes(streamOffset);
+        instancesInStream = true;
+    }
+    else
+    {
+        state.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        state.bufferData(GL_ARRAY_BUFFER, bytes, transforms, GL_STREAM_DRAW);
+        if(instancesInStream)
+        {
+            pointInstanceAttributes(0);
+            instancesInStream = false;
+        }
+    }
+    state.drawElementsInstanced(GL_TRIANGLES, lod.indexCount, indexType,
+                                (size_t)lod.firstIndex*indexSize, instanceCount);
+}
+
+// NOTE: Giving a buffer zero-sized storage orphans the old one, so the driver frees it as soon as
+//       nothing still draws from it
+void GLMesh::release(GLStateCache& state)
+{
+    if(!vertexArray)
+    {
+        return;
+    }
+    //the index buffer binding is part of the vertex array
+    state.bindVertexArray(vertexArray);
+    GLuint arrayBuffers[3] = {vertexBuffer, colorBuffer, instanceBuffer};
+    for(int i=0; i<3; i++)
+    {
+        state.bindBuffer(GL_ARRAY_BUFFER, arrayBuffers[i]);
+        state.bufferData(GL_ARRAY_BUFFER, 0, 0, GL_STATIC_DRAW);
+    }
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    state.bufferData(GL_ELEMENT_ARRAY_BUFFER, 0, 0, GL_STATIC_DRAW);
+    vertexBufferBytes = 0;
+}
+
+void GLMesh::destroy(GLStateCache& state)
+{
+    if(!vertexArray)
+    {
+        return;
+    }
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &colorBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteVertexArrays(1, &vertexArray);
+    vertexArray = 0;
+    vertexBuffer = 0;
+    colorBuffer = 0;
+    indexBuffer = 0;
+    instanceBuffer = 0;
+
+    // NOTE: Deleting a bound object unbinds it, and its name can be handed out again
+    state.invalidate();
+}
+
+//points the per-instance matrix attributes at the buffer bound to GL_ARRAY_BUFFER, starting at offset
+void GLMesh::pointInstanceAttributes(size_t offset)
+{
+    for(int column=0; column<4; column++)
+    {
+        glVertexAttribPointer(5 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void*)(offset + column*sizeof(glm::vec4)));
+    }
+}
+
+const glm::mat4& GLMesh::dequantize()
+{
+    return positionTransform;
+}
+
+long long GLMesh::vertexBytes()
+{
+    return vertexBufferBytes;
+}
@@ -0,0 +1,98 @@
+#ifndef GL_MESH_H
+#define GL_MESH_H
+
+#include <vector>
+#include <stddef.h>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "geometry.h"
+#include "glstate.h"
+#include "vertexpack.h"
+
+// Everything that goes into a GLMesh's buffers, worked out from a GeometryData without touching
+// GL, so that it can be done on any thread (see GLMesh::prepare). Only what has to be worked out
+// (packed vertices and colours) is stored here; float positions and indices are read straight
+// from the geometry (which may be a mapped mesh cache), so it has to outlive the upload
+struct GLMeshData
+{
+    bool packed;
+    PackedVertexLayout layout;//only used when packed
+    std::vector<unsigned char> packedVertices;//only filled when packed
+    const float* positions;//the geometry's, used when not packed
+    size_t vertexBytes;
+    std::vector<float> colors;
+    const unsigned char* indices;//the geometry's, the full mesh's then the LODs' in the buffer
+    size_t indexBytes;
+    const unsigned char* lodIndices;
+    size_t lodIndexBytes;
+    int indexSize;
+    glm::mat4 positionTransform;
+
+    // What goes into the vertex buffer, vertexBytes of it
+    const unsigned char* vertexSource() const;
+    // Bytes that get copied into buffers
+    size_t uploadBytes() const;
+};
+
+// The GPU copy of a GeometryData: its vertex, colour and index buffers, and a vertex array that
+// has the whole attribute layout recorded in it at upload. Drawing is then just binding the
+// vertex array and issuing the draw. There's also a buffer of per-instance model matrices (at
+// attribute locations 5 to 8, see instanced.vert) for drawing many copies in one call. Uploads and
+// instance matrices go through the state cache's stream buffer when it has one
+class GLMesh
+{
+public:
+    GLMesh();
+
+    // Creates the GL objects on first use and (re)fills them from the geometry, with the vertices
+    // either packed (see vertexpack.h) or as float positions. Every vertex gets a random colour
+    void upload(GLStateCache& state, GeometryData& geometry, bool packed);
+
+    // The same upload in steps. prepare does the CPU side and can run on any thread. beginUpload
+    // sets up the GL objects and allocates the buffers, and continueUpload then copies up to
+    // maxBytes more of the data into them on each call, returning true once it's all there (the
+    // mesh mustn't be drawn before that). The data, and the geometry it was prepared from, have to
+    // stay alive and unchanged until then
+    static void prepare(GeometryData& geometry, bool packed, GLMeshData* data);
+    void beginUpload(GLStateCache& state, const GLMeshData& data);
+    bool continueUpload(GLStateCache& state, const GLMeshData& data, size_t maxBytes);
+    // Draws one level of detail of the uploaded geometry, with whatever program is in use
+    void draw(GLStateCache& state, const GeometryLOD& lod);
+    // Draws the given ranges of the full mesh's indices (e.g. the meshlets that weren't culled) in
+    // one multi-draw call
+    void drawRanges(GLStateCache& state, const unsigned int* firstIndices,
+                    const GLsizei* indexCounts, int rangeCount);
+    // Draws a copy of one level of detail for each of the model matrices, in a single call
+    void drawInstanced(GLStateCache& state, const GeometryLOD& lod,
+                       const glm::mat4* transforms, int instanceCount);
+    // Frees the buffers' storage but keeps the GL objects, for a mesh that's no longer drawn but
+    // will be uploaded into again
+    void release(GLStateCache& state);
+    void destroy(GLStateCache& state);
+
+    // Takes the vertex positions in the buffer to model space (identity when not packed)
+    const glm::mat4& dequantize();
+    // Size of the vertex buffer (not counting the colours)
+    long long vertexBytes();
+
+private:
+    void pointInstanceAttributes(size_t offset);
+
+    GLuint vertexArray;
+    GLuint vertexBuffer;
+    GLuint colorBuffer;
+    GLuint indexBuffer;
+    GLuint instanceBuffer;
+    GLenum indexType;
+    int indexSize;
+
+    glm::mat4 positionTransform;
+    long long vertexBufferBytes;
+    size_t uploadedBytes;//how far continueUpload has got through the data
+    std::vector<const void*> rangeOffsets;//byte offsets of the ranges for drawRanges, kept to save reallocating them
+    bool instancesInStream;//whether the instance attributes point into the stream buffer rather than instanceBuffer
+};
+
+#endif
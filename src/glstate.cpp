@@ -0,0 +1,141 @@
+#include "glstate.h"
+
+// Stands for "don't know what's bound". GL never hands out this name, so nothing compares equal
+static const GLuint UNKNOWN_BINDING = ~0u;
+
+GLStateCache::GLStateCache()
+{
+    stream = 0;
+    invalidate();
+}
+
+void GLStateCache::useProgram(GLuint newProgram)
+{
+    if(program == newProgram)
+    {
+        counts.skipped++;
+        return;
+    }
+    glUseProgram(newProgram);
+    program = newProgram;
+    counts.calls++;
+}
+
+void GLStateCache::bindVertexArray(GLuint newVertexArray)
+{
+    if(vertexArray == newVertexArray)
+    {
+        counts.skipped++;
+        return;
+    }
+    glBindVertexArray(newVertexArray);
+    vertexArray = newVertexArray;
+    counts.calls++;
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    if(target == GL_ARRAY_BUFFER)
+    {
+        if(arrayBuffer == buffer)
+        {
+            counts.skipped++;
+            return;
+        }
+        arrayBuffer = buffer;
+    }
+    glBindBuffer(target, buffer);
+    counts.calls++;
+}
+
+void GLStateCache::bufferData(GLenum target, size_t size, const void* data, GLenum usage)
+{
+    glBufferData(target, size, data, usage);
+    counts.calls++;
+    if(data)
+    {
+        counts.uploadBytes += size;
+    }
+}
+
+void GLStateCache::bufferSubData(GLenum target, size_t offset, size_t size, const void* data)
+{
+    glBufferSubData(target, offset, size, data);
+    counts.calls++;
+    counts.uploadBytes += size;
+}
+
+void GLStateCache::copyBufferSubData(GLenum readTarget, GLenum writeTarget, size_t readOffset,
+                                     size_t writeOffset, size_t size)
+{
+    glCopyBufferSubData(readTarget, writeTarget, readOffset, writeOffset, size);
+    counts.calls++;
+}
+
+void GLStateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, size_t offset,
+                                   size_t size)
+{
+    glBindBufferRange(target, index, buffer, offset, size);
+    counts.calls++;
+}
+
+void GLStateCache::uniformMatrix4(GLint location, const float* matrix)
+{
+    glUniformMatrix4fv(location, 1, GL_FALSE, matrix);
+    counts.calls++;
+}
+
+void GLStateCache::drawElements(GLenum mode, GLsizei count, GLenum type, size_t byteOffset)
+{
+    glDrawElements(mode, count, type, (void*)byteOffset);
+    counts.calls++;
+    counts.draws++;
+}
+
+void GLStateCache::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                                         size_t byteOffset, GLsizei instanceCount)
+{
+    glDrawElementsInstanced(mode, count, type, (void*)byteOffset, instanceCount);
+    counts.calls++;
+    counts.draws++;
+}
+
+void GLStateCache::multiDrawElements(GLenum mode, const GLsizei* indexCounts, GLenum type,
+                                     const void* const* byteOffsets, GLsizei drawCount)
+{
+    glMultiDrawElements(mode, indexCounts, type, byteOffsets, drawCount);
+    counts.calls++;
+    counts.draws++;
+}
+
+void GLStateCache::multiDrawElementsIndirect(GLenum mode, GLenum type, size_t byteOffset,
+                                             GLsizei drawCount)
+{
+    glMultiDrawElementsIndirect(mode, type, (const void*)byteOffset, drawCount, 0);
+    counts.calls++;
+    counts.draws++;
+}
+
+void GLStateCache::invalidate()
+{
+    program = UNKNOWN_BINDING;
+    vertexArray = UNKNOWN_BINDING;
+    arrayBuffer = UNKNOWN_BINDING;
+}
+
+void GLStateCache::setStreamBuffer(StreamBuffer* buffer)
+{
+    stream = buffer;
+}
+
+StreamBuffer* GLStateCache::streamBuffer()
+{
+    return stream;
+}
+
+GLCallCounts GLStateCache::endFrame()
+{
+    GLCallCounts frame = counts;
+    counts = GLCallCounts();
+    return frame;
+}
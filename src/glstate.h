@@ -0,0 +1,72 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <stddef.h>
+#include <GL/glew.h>
+
+// GL calls made through a GLStateCache, counted per frame
+struct GLCallCounts
+{
+    // Calls that reached the driver
+    int calls = 0;
+    // Binds that were skipped because the object was already bound
+    int skipped = 0;
+    // Draw calls (also counted in calls)
+    int draws = 0;
+    // Bytes copied into buffers straight from memory with bufferData/bufferSubData (see
+    // StreamBuffer for the rest)
+    long long uploadBytes = 0;
+};
+
+class StreamBuffer;
+
+// Remembers the program, vertex array and array buffer that are bound, so that binding the same
+// one again doesn't go to the driver. Everything that binds these has to go through the cache (or
+// call invalidate afterwards), otherwise it will skip binds that were actually needed
+class GLStateCache
+{
+public:
+    GLStateCache();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    // NOTE: Only GL_ARRAY_BUFFER is cached. The element array binding belongs to the vertex array
+    //       so it's passed straight through (and bindVertexArray is what changes it)
+    void bindBuffer(GLenum target, GLuint buffer);
+
+    void bufferData(GLenum target, size_t size, const void* data, GLenum usage);
+    void bufferSubData(GLenum target, size_t offset, size_t size, const void* data);
+    void copyBufferSubData(GLenum readTarget, GLenum writeTarget, size_t readOffset,
+                           size_t writeOffset, size_t size);
+    // Binds a range of a buffer to an indexed binding point (a uniform block's). Not cached
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, size_t offset, size_t size);
+    void uniformMatrix4(GLint location, const float* matrix);
+    void drawElements(GLenum mode, GLsizei count, GLenum type, size_t byteOffset);
+    void drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, size_t byteOffset,
+                               GLsizei instanceCount);
+    // Draws several ranges of the element buffer in one call (counted as one draw)
+    void multiDrawElements(GLenum mode, const GLsizei* indexCounts, GLenum type,
+                           const void* const* byteOffsets, GLsizei drawCount);
+    // Draws the commands in the bound GL_DRAW_INDIRECT_BUFFER from byteOffset on, in one call (and
+    // one draw, although the GPU does drawCount). Needs GL 4.3 or GL_ARB_multi_draw_indirect
+    void multiDrawElementsIndirect(GLenum mode, GLenum type, size_t byteOffset, GLsizei drawCount);
+
+    // The ring buffer that meshes and per-instance data are streamed through, or null to upload
+    // them with bufferData/bufferSubData
+    void setStreamBuffer(StreamBuffer* buffer);
+    StreamBuffer* streamBuffer();
+
+    // Forgets what's bound, for after GL calls that didn't go through the cache
+    void invalidate();
+    // Returns the counts since the last call and starts counting again
+    GLCallCounts endFrame();
+
+private:
+    GLuint program;
+    GLuint vertexArray;
+    GLuint arrayBuffer;
+    GLCallCounts counts;
+    StreamBuffer* stream;
+};
+
+#endif
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
 
 #include "SDL.h"
 #include <GL/glew.h>
@@ -8,13 +11,26 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/string_cast.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 #include "glwindow.h"
 #include "geometry.h"
+#include "scene.h"
+#include "culling.h"
+#include "meshlets.h"
+#include "bvh.h"
 #include <shader.hpp>
 
 using namespace std;
 
+//scenes with at least this many objects are culled with the hierarchy, smaller ones just test the
+//bounding sphere of every object (which is quicker when there's only a few)
+static const size_t HIERARCHY_CULLING_MIN_OBJECTS = 1024;
+
+//size of the stream buffer ring. Several frames of instance matrices for 10,000 objects, plus a
+//few of the 4MB slices background loads are uploaded in, fit at once
+static const size_t STREAM_BUFFER_BYTES = 32 << 20;
+
 const char* glGetErrorString(GLenum error)
 {
     switch(error)
@@ -100,7 +116,11 @@ GLuint loadShaderProgram(const char* vertShaderFilename,
 
 OpenGLWindow::OpenGLWindow()
 {
-    axis = "z";
+    loadOptions.optimizeMesh = true;
+    loadOptions.generateLODs = true;
+    framebuffer = 0;
+    colorRenderbuffer = 0;
+    depthRenderbuffer = 0;
 }
 
 OpenGLWindow::~OpenGLWindow()
@@ -113,19 +133,25 @@ void OpenGLWindow::initGL()
     // We need to first specify what type of OpenGL context we need before we can create the window
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 
+    Uint32 windowFlags = SDL_WINDOW_OPENGL;
+    if(offscreen)
+    {
+        windowFlags |= SDL_WINDOW_HIDDEN;
+    }
     sdlWin = SDL_CreateWindow("OpenGL Prac 1",
                               SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                              640, 480, SDL_WINDOW_OPENGL);
+                              640, 480, windowFlags);
     if(!sdlWin)
     {
         SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_INFORMATION, "Error", "Unable to create window", 0);
     }
     SDL_GLContext glc = SDL_GL_CreateContext(sdlWin);
     SDL_GL_MakeCurrent(sdlWin, glc);
-    SDL_GL_SetSwapInterval(1);
+    // NOTE: vsync would cap the benchmark at the refresh rate
+    SDL_GL_SetSwapInterval((offscreen || !vsync) ? 0 : 1);
 
     glewExperimental = true;
     GLenum glewInitResult = glewInit();
@@ -156,16 +182,46 @@ void OpenGLWindow::initGL()
     // Accept fragment if it closer to the camera than the former one
     glDepthFunc(GL_LESS); 
 
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    // A hidden window's default framebuffer isn't guaranteed to be rendered to at all, so when
+    // offscreen we draw into our own 640x480 framebuffer object instead
+    if(offscreen)
+    {
+        glGenRenderbuffers(1, &colorRenderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorRenderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 640, 480);
+        glGenRenderbuffers(1, &depthRenderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 640, 480);
+
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                  GL_RENDERBUFFER, colorRenderbuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                  GL_RENDERBUFFER, depthRenderbuffer);
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            cout << "Unable to create offscreen framebuffer" << endl;
+        }
+        glViewport(0, 0, 640, 480);
+    }
 
     //Note - I am using the LoadShaders method from the shaders.cpp file.
     //This file was included with the matrices example provided to us.
     //It was originally from - http://www.opengl-tutorial.org/
     //Original source code available at: https://github.com/opengl-tutorials/ogl
+    Uint64 shaderStart = SDL_GetPerformanceCounter();
     shader = LoadShaders("simple.vert", "simple.frag");
 
     MatrixID = glGetUniformLocation(shader, "MVP");
+    objectShader = LoadShaders("simple.vert", "simple.frag", "#define OBJECT_BLOCK");
+    ObjectDequantizeID = glGetUniformLocation(objectShader, "Dequantize");
+    instancedShader = LoadShaders("instanced.vert", "simple.frag");
+    DequantizeID = glGetUniformLocation(instancedShader, "Dequantize");
+    UniformBlocks::bindProgram(objectShader);
+    UniformBlocks::bindProgram(instancedShader);
+    shaderLoadMilliseconds = 1000.0*(SDL_GetPerformanceCounter() - shaderStart) /
+                             SDL_GetPerformanceFrequency();
 
     // Projection matrix : 30° Field of View, 4:3 ratio, display range : 0.1 unit <-> 100 units
     Projection = glm::perspective(glm::radians(FOV), 4.0f / 3.0f, 0.1f, 100.0f);
@@ -175,143 +231,320 @@ void OpenGLWindow::initGL()
                                 glm::vec3(0,0,0), // camera looks towards
                                 glm::vec3(0,1,0)  // Head is up
                            );
-    Model = glm::mat4(1.0f);//identity matrix - sets the model at the origin
-    
-    MVP = Projection * View * Model; // the model view projection
-    glUseProgram(shader);
-
-    // Load the model that we want to use and buffer the vertex attributes
-    geometry.loadFromOBJFile(object_1);
-    
-    int num_vertices = geometry.vertexCount()*3;
-    void* object_data = geometry.vertexData();
-
-    GLfloat color_data[num_vertices];
+    glState.useProgram(shader);
+    uniformBlocks.create(glState);
 
-    //generate random colours
-    for (int i = 0; i < num_vertices; ++i)
+    if(indirectDrawing && !GeometryArena::supported())
     {
-        float r = static_cast<float>(rand())/static_cast<float>(RAND_MAX);
-        color_data[i] = r;
+        cout << "Multi draw indirect isn't supported, drawing without it" << endl;
+        indirectDrawing = false;
+    }
+    if(streamingUploads)
+    {
+        streamBuffer.create(glState, STREAM_BUFFER_BYTES);
+        glState.setStreamBuffer(&streamBuffer);
+        cout << "Streaming uploads through a " << (STREAM_BUFFER_BYTES >> 20) << "MB "
+             << (streamBuffer.persistent() ? "persistently mapped" : "unsynchronized mapped")
+             << " ring buffer" << endl;
     }
 
-    //for vertices
-    glGenBuffers(1, &vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, num_vertices*sizeof(float), object_data, GL_STATIC_DRAW);
-
-    //for colours
-    glGenBuffers(1, &colorBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
-    glBufferData(GL_ARRAY_BUFFER, num_vertices*sizeof(float), color_data, GL_STATIC_DRAW);;
+    // Load the model that we want to use and buffer the vertex attributes. It goes at the origin
+    Uint64 loadStart = SDL_GetPerformanceCounter();
+    selectObject(scene.addObject(glState, object_1, loadOptions, packedVertices));
+    objectBoundsValid = false;
+    hierarchyValid = false;
+    lastLoadMilliseconds = 1000.0*(SDL_GetPerformanceCounter() - loadStart) /
+                           SDL_GetPerformanceFrequency();
 
     glPrintError("Setup complete", true);
 }
 
 void OpenGLWindow::render()
 {
+    redrawRequested = false;
+    updateLoads();
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glUseProgram(shader);
-
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-    // For vertices
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glVertexAttribPointer(
-        0,                  // 0 to match number in shader
-        3,                  
-        GL_FLOAT,           
-        GL_FALSE,           
-        0,                  
-        (void*)0            
-    );
-
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
-    glVertexAttribPointer(
-        1,                  // attribute. No particular reason for 1, but must match the layout in the shader.
-        3,                  
-        GL_FLOAT,           
-        GL_FALSE,           
-        0,                  
-        (void*)0            
-    );
-    
-
-    glDrawArrays(GL_TRIANGLES, 0, geometry.vertexCount()*3);//vertexCount returns vertices/3
-
-    glDisableVertexAttribArray(0);
+
+    // NOTE: The attribute layout was recorded in the mesh's vertex array at upload, and the state
+    //       cache skips binding the program (and vertex array) when they're still bound from the
+    //       last frame
+    drawnTriangles = 0;
+    lastMeshletsCulled = 0;
+    lastMeshletTrianglesCulled = 0;
+    cullObjects(Projection * View);
+    Uint64 drawStart = SDL_GetPerformanceCounter();
+    uniformBlocks.setCamera(glState, View, Projection);
+    if(indirectDrawing)
+    {
+        drawIndirect();
+    }
+    else if(instancing && !meshletCulling)
+    {
+        drawInstanced();
+    }
+    else
+    {
+        drawPerObject();
+    }
+    lastDrawMicroseconds = 1000000.0*(SDL_GetPerformanceCounter() - drawStart) /
+                           SDL_GetPerformanceFrequency();
+    lastFrameCalls = glState.endFrame();
+    lastStreamStats = streamBuffer.endFrame();
 
     // Swap the front and back buffers on the window, effectively putting what we just "drew"
     // onto the screen (whereas previously it only existed in memory)
-    SDL_GL_SwapWindow(sdlWin);
+    if(!offscreen)
+    {
+        SDL_GL_SwapWindow(sdlWin);
+    }
 }
 
-// The program will exit if this function returns false
-bool OpenGLWindow::handleEvent(SDL_Event e)
+//picks the LOD to draw the object at index i of the scene with, and reports when the selected
+//object's changes
+int OpenGLWindow::objectLOD(int i, GeometryData& geometry, const glm::mat4& model)
 {
-    // A list of keycode constants is available here: https://wiki.libsdl.org/SDL_Keycode
-    // Note that SDL provides both Scancodes (which correspond to physical positions on the keyboard)
-    // and Keycodes (which correspond to symbols on the keyboard, and might differ across layouts)
-    if(e.type == SDL_KEYDOWN)
+    int level = selectLOD(geometry, model);
+    if(scene.objectId(i) == selectedObject)
     {
-        if(e.key.keysym.sym == SDLK_ESCAPE)
+        if((level != currentLOD) && !offscreen)
         {
-            return false;
+            std::cout << "Drawing LOD " << level << std::endl;
         }
-        //switch to transform mode
-        else if(e.key.keysym.sym == SDLK_t)
+        currentLOD = level;
+    }
+    return level;
+}
+
+//each object gets its own LOD and draw call. With uniform buffers the visible objects' model
+//matrices are all written first and each draw binds its own, otherwise each object gets its own
+//MVP (with its mesh's dequantize matrix on the end)
+void OpenGLWindow::drawPerObject()
+{
+    glm::mat4 ProjectionView = Projection * View;
+    if(uniformBuffers)
+    {
+        objectModels.clear();
+        for(int i=0; i<scene.objectCount(); i++)
         {
-            if(mode != "translate")
+            if(objectVisible[i])
             {
-                std::cout << "Translate mode activated" << std::endl;
+                objectModels.push_back(scene.object(i).transform);
             }
-            mode = "translate";
-            if(axis == "x"){axis = "y";}
-            else if(axis == "y"){axis = "z";}
-            else if(axis == "z"){axis = "x";}
-            std::cout<< "Translating on " << axis << " axis" << std::endl;
-            return true;
         }
-        //switch to scale mode
-        else if(e.key.keysym.sym == SDLK_s)
+        uniformBlocks.setObjects(glState, objectModels.data(), objectModels.size());
+        glState.useProgram(objectShader);
+    }
+    else
+    {
+        glState.useProgram(shader);
+    }
+    int drawnObjects = 0;
+    int dequantizedMesh = -1;//mesh whose dequantize matrix is set
+    for(int i=0; i<scene.objectCount(); i++)
+    {
+        if(!objectVisible[i])
         {
-            mode = "scale";
-            std::cout << "Scale mode activated\nLeft click to scale up.\nRight click to scale down" << std::endl;
-            return true;
+            continue;
         }
-        //switch to rotation mode
-        else if (e.key.keysym.sym == SDLK_r)
+        SceneObject& object = scene.object(i);
+        SceneMesh& mesh = scene.mesh(object.mesh);
+        if(uniformBuffers)
         {
-            if(mode != "rotate")
+            uniformBlocks.bindObject(glState, drawnObjects++);
+            if(object.mesh != dequantizedMesh)
             {
-                std::string output = "Rotate mode\n"
-                                "Left/Right click to rotate";
-                std::cout << output << std::endl;
+                glState.uniformMatrix4(ObjectDequantizeID, &mesh.gpu.dequantize()[0][0]);
+                dequantizedMesh = object.mesh;
             }
-            mode = "rotate";
-            if(axis == "x"){axis = "y";}
-            else if(axis == "y"){axis = "z";}
-            else if(axis == "z"){axis = "x";}
-            std::cout<< "Rotating on " << axis << " axis" << std::endl;
-            return true;
         }
-        else if (e.key.keysym.sym == SDLK_z)
+        else
         {
-            mode = "zoom";
-            std::cout << "Zoom mode" << std::endl;
-            return true;
+            glm::mat4 MVP = ProjectionView * object.transform * mesh.gpu.dequantize();
+            glState.uniformMatrix4(MatrixID, &MVP[0][0]);
         }
-        //switch to mode to add second object
-        else if (e.key.keysym.sym == SDLK_a)
+
+        int level = objectLOD(i, mesh.geometry, object.transform);
+        if(meshletCulling && (level == 0) && (mesh.geometry.meshletCount() > 0))
         {
-            mode = "add";
-            std::cout << "Add second object" << std::endl;
-            computeMatrices(mode, e);
-            return true;
+            drawnTriangles += drawMeshlets(mesh, object.transform, ProjectionView);
+            continue;
+        }
+        GeometryLOD lod = mesh.geometry.lod(level);
+        drawnTriangles += lod.indexCount/3;
+
+        mesh.gpu.draw(glState, lod);
+    }
+}
+
+//culls the object's meshlets in its model space (where the bounds are), and draws the ranges of
+//the index buffer that are left in one call. Returns the triangles drawn
+int OpenGLWindow::drawMeshlets(SceneMesh& mesh, const glm::mat4& Model,
+                               const glm::mat4& ProjectionView)
+{
+    Uint64 cullStart = SDL_GetPerformanceCounter();
+    glm::vec4 planes[6];
+    extractFrustumPlanes(ProjectionView*Model, planes);
+    //the camera sits at the origin of view space
+    glm::vec3 camera = glm::vec3(glm::inverse(View*Model)[3]);
+
+    int count = mesh.geometry.meshletCount();
+    const Meshlet* meshlets = mesh.geometry.meshletData();
+    meshletVisible.resize(count);
+    cullMeshlets(meshlets, count, planes, camera, meshletVisible.data());
+
+    meshletFirstIndices.clear();
+    meshletIndexCounts.clear();
+    int triangles = 0;
+    for(int i=0; i<count; i++)
+    {
+        if(!meshletVisible[i])
+        {
+            lastMeshletsCulled++;
+            lastMeshletTrianglesCulled += meshlets[i].triangleCount;
+            continue;
+        }
+        triangles += meshlets[i].triangleCount;
+        GLsizei indexCount = 3*meshlets[i].triangleCount;
+        if((i > 0) && meshletVisible[i-1])
+        {
+            meshletIndexCounts.back() += indexCount;
+        }
+        else
+        {
+            meshletFirstIndices.push_back(meshlets[i].firstIndex);
+            meshletIndexCounts.push_back(indexCount);
+        }
+    }
+    lastCullMicroseconds += 1000000.0*(SDL_GetPerformanceCounter() - cullStart) /
+                            SDL_GetPerformanceFrequency();
+
+    if(!meshletFirstIndices.empty())
+    {
+        mesh.gpu.drawRanges(glState, meshletFirstIndices.data(), meshletIndexCounts.data(),
+                            meshletFirstIndices.size());
+    }
+    return triangles;
+}
+
+//objects are grouped by mesh and LOD, and each group is drawn with one instanced call. The model
+//matrices go to the GPU as they are, the shader puts the camera's view projection (from its
+//uniform block) and dequantize on them
+void OpenGLWindow::drawInstanced()
+{
+    if((int)instanceBatches.size() < scene.meshSlotCount())
+    {
+        instanceBatches.resize(scene.meshSlotCount());
+    }
+    for(int i=0; i<scene.objectCount(); i++)
+    {
+        if(!objectVisible[i])
+        {
+            continue;
+        }
+        SceneObject& object = scene.object(i);
+        GeometryData& geometry = scene.mesh(object.mesh).geometry;
+        int level = objectLOD(i, geometry, object.transform);
+        std::vector<std::vector<glm::mat4> >& batches = instanceBatches[object.mesh];
+        if((int)batches.size() < geometry.lodCount())
+        {
+            batches.resize(geometry.lodCount());
+        }
+        batches[level].push_back(object.transform);
+        drawnTriangles += geometry.lod(level).indexCount/3;
+    }
+
+    glState.useProgram(instancedShader);
+    for(size_t meshIndex=0; meshIndex<instanceBatches.size(); meshIndex++)
+    {
+        std::vector<std::vector<glm::mat4> >& batches = instanceBatches[meshIndex];
+        bool dequantizeSet = false;
+        for(size_t level=0; level<batches.size(); level++)
+        {
+            if(batches[level].empty())
+            {
+                continue;
+            }
+            SceneMesh& mesh = scene.mesh(meshIndex);
+            if(!dequantizeSet)
+            {
+                glState.uniformMatrix4(DequantizeID, &mesh.gpu.dequantize()[0][0]);
+                dequantizeSet = true;
+            }
+            mesh.gpu.drawInstanced(glState, mesh.geometry.lod(level),
+                                   batches[level].data(), batches[level].size());
+            // NOTE: clear keeps the memory, so after the first frame this doesn't allocate
+            batches[level].clear();
         }
     }
+}
+
+//every mesh is in the scene's geometry arena, so every visible object becomes one command (its
+//LOD's range of the arena's index buffer, and its model matrix picked by base instance) and the
+//whole scene is drawn with one call. The arena's positions are packed, and since each mesh has its
+//own dequantize matrix it goes on the end of the model matrix rather than in the uniform
+void OpenGLWindow::drawIndirect()
+{
+    indirectCommands.clear();
+    indirectTransforms.clear();
+    for(int i=0; i<scene.objectCount(); i++)
+    {
+        if(!objectVisible[i])
+        {
+            continue;
+        }
+        SceneObject& object = scene.object(i);
+        GeometryData& geometry = scene.mesh(object.mesh).geometry;
+        int level = objectLOD(i, geometry, object.transform);
+        const ArenaMesh& placed = scene.arenaMesh(glState, object.mesh);
+        GeometryLOD lod = geometry.lod(level);
+        DrawElementsIndirectCommand command;
+        command.count = lod.indexCount;
+        command.instanceCount = 1;
+        command.firstIndex = placed.firstIndex + lod.firstIndex;
+        command.baseVertex = placed.firstVertex;
+        command.baseInstance = indirectTransforms.size();
+        indirectCommands.push_back(command);
+        indirectTransforms.push_back(object.transform * placed.positionTransform);
+        drawnTriangles += lod.indexCount/3;
+    }
+    if(indirectCommands.empty())
+    {
+        return;
+    }
+
+    glState.useProgram(instancedShader);
+    glm::mat4 identity(1.0f);
+    glState.uniformMatrix4(DequantizeID, &identity[0][0]);
+    scene.geometryArena().drawIndirect(glState, indirectCommands.data(), indirectCommands.size(),
+                                       indirectTransforms.data(), indirectTransforms.size());
+}
+
+// The program will exit if this function returns false
+bool OpenGLWindow::handleEvent(const SDL_Event& e)
+{
+    if(recording)
+    {
+        recording->add(e);
+    }
+    // Anything but the mouse moving can change what's drawn (or the window needs drawing again
+    // after being uncovered or resized). User events are other threads asking for a frame
+    if((e.type == SDL_KEYDOWN) || (e.type == SDL_MOUSEBUTTONDOWN) || (e.type == SDL_TEXTINPUT) ||
+       (e.type == SDL_WINDOWEVENT) || (e.type >= SDL_USEREVENT))
+    {
+        redrawRequested = true;
+    }
+    // A list of keycode constants is available here: https://wiki.libsdl.org/SDL_Keycode
+    // Note that SDL provides both Scancodes (which correspond to physical positions on the keyboard)
+    // and Keycodes (which correspond to symbols on the keyboard, and might differ across layouts)
+    if(enteringPath)
+    {
+        return handlePathEntry(e);
+    }
+    if(e.type == SDL_KEYDOWN)
+    {
+        return runCommand(keyBindings.lookup(e.key.keysym.sym));
+    }
     //once mouse is clicked, calculate changes to make to MVP
     else if(e.type == SDL_MOUSEBUTTONDOWN)
     {
@@ -320,20 +553,156 @@ bool OpenGLWindow::handleEvent(SDL_Event e)
     return true;
 }
 
+static const char* AXIS_NAMES[3] = {"x", "y", "z"};
+
+bool OpenGLWindow::runCommand(Command command)
+{
+    switch(command)
+    {
+    case COMMAND_QUIT:
+        return false;
+    //switch to transform mode
+    case COMMAND_TRANSLATE:
+        if((mode != MODE_TRANSLATE) && verbose)
+        {
+            std::cout << "Translate mode activated" << std::endl;
+        }
+        mode = MODE_TRANSLATE;
+        axis = (Axis)((axis + 1) % 3);
+        if(verbose)
+        {
+            std::cout<< "Translating on " << AXIS_NAMES[axis] << " axis" << std::endl;
+        }
+        break;
+    //switch to scale mode
+    case COMMAND_SCALE:
+        mode = MODE_SCALE;
+        if(verbose)
+        {
+            std::cout << "Scale mode activated\nLeft click to scale up.\nRight click to scale down" << std::endl;
+        }
+        break;
+    //switch to rotation mode
+    case COMMAND_ROTATE:
+        if((mode != MODE_ROTATE) && verbose)
+        {
+            std::cout << "Rotate mode\nLeft/Right click to rotate" << std::endl;
+        }
+        mode = MODE_ROTATE;
+        axis = (Axis)((axis + 1) % 3);
+        if(verbose)
+        {
+            std::cout<< "Rotating on " << AXIS_NAMES[axis] << " axis" << std::endl;
+        }
+        break;
+    //switch to picking objects by clicking on them
+    case COMMAND_PICK:
+        mode = MODE_PICK;
+        if(verbose)
+        {
+            std::cout << "Pick mode\nClick on an object to select it" << std::endl;
+        }
+        break;
+    case COMMAND_ZOOM:
+        mode = MODE_ZOOM;
+        if(verbose)
+        {
+            std::cout << "Zoom mode" << std::endl;
+        }
+        break;
+    //add another object
+    case COMMAND_ADD_OBJECT:
+        if(verbose)
+        {
+            std::cout << "Add second object" << std::endl;
+        }
+        startPathEntry();
+        break;
+    //select the next object for transformations to apply to
+    case COMMAND_SELECT_NEXT:
+        if(scene.objectCount() > 0)
+        {
+            int index = 0;
+            for(int i=0; i<scene.objectCount(); i++)
+            {
+                if(scene.objectId(i) == selectedObject)
+                {
+                    index = (i + 1) % scene.objectCount();
+                }
+            }
+            selectObject(scene.objectId(index));
+        }
+        break;
+    //remove the selected object
+    case COMMAND_REMOVE:
+        if(scene.contains(selectedObject))
+        {
+            if(verbose)
+            {
+                std::cout << "Removed object " << selectedObject << std::endl;
+            }
+            scene.removeObject(glState, selectedObject);
+            objectBoundsValid = false;
+            hierarchyValid = false;
+            selectObject(scene.objectCount() > 0 ? scene.objectId(scene.objectCount() - 1) : -1);
+        }
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+bool OpenGLWindow::wantsRedraw()
+{
+    return redrawRequested || (loadsPending() > 0);
+}
+
+void OpenGLWindow::requestRedraw()
+{
+    redrawRequested = true;
+}
+
 void OpenGLWindow::cleanup()
 {
-    glDeleteBuffers(1, &vertexBuffer);
-    glDeleteVertexArrays(1, &vao);
+    if(uploading.mesh)
+    {
+        uploading.mesh->gpu.destroy(glState);
+    }
+    scene.destroy(glState);
+    glState.setStreamBuffer(0);
+    streamBuffer.destroy(glState);
+    uniformBlocks.destroy(glState);
+    glDeleteProgram(shader);
+    glDeleteProgram(objectShader);
+    glDeleteProgram(instancedShader);
+    if(offscreen)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &colorRenderbuffer);
+        glDeleteRenderbuffers(1, &depthRenderbuffer);
+    }
     SDL_DestroyWindow(sdlWin);
 }
 
 //Given a transformation type, compute the changes to the MVP
-void OpenGLWindow::computeMatrices(std::string & type, SDL_Event e)
+void OpenGLWindow::computeMatrices(TransformMode type, const SDL_Event& e)
 {
-    if(type == "translate")
+    //transformations only move the selected object
+    bool transform = (type == MODE_TRANSLATE) || (type == MODE_SCALE) || (type == MODE_ROTATE);
+    if(transform && !scene.contains(selectedObject))
+    {
+        return;
+    }
+    if(transform)
+    {
+        objectBoundsValid = false;
+        hierarchyMoved = true;
+    }
+    if(type == MODE_TRANSLATE)
     {
         float speed = 1.0f;
-        glm::vec3 translateVec;
+        glm::vec3 translateVec(0.0f);
         
         if(e.button.button == SDL_BUTTON_LEFT)//increase
         {
@@ -344,13 +713,11 @@ void OpenGLWindow::computeMatrices(std::string & type, SDL_Event e)
             speed = -1.0f;
         }
         
-        if(axis == "x"){translateVec = glm::vec3(speed,0,0);}
-        if(axis == "y"){translateVec = glm::vec3(0,speed,0);}
-        if(axis == "z"){translateVec = glm::vec3(0,0,speed);}
+        translateVec[axis] = speed;
+        glm::mat4& Model = scene.transform(selectedObject);
         Model = glm::translate(Model, translateVec);
-        MVP = Projection * View * Model;
     }
-    else if(type == "scale")
+    else if(type == MODE_SCALE)
     {
         float speed;
 
@@ -363,17 +730,16 @@ void OpenGLWindow::computeMatrices(std::string & type, SDL_Event e)
             speed = 0.5f;
         }
 
+        glm::mat4& Model = scene.transform(selectedObject);
         Model = glm::scale(Model, glm::vec3(speed,speed,speed));
-        MVP = Projection * View * Model;
     }
-    else if(type == "rotate")
+    else if(type == MODE_ROTATE)
     {
-        glm::vec3 axisOfRotation;
-        if(axis == "x"){axisOfRotation = glm::vec3(1,0,0);}
-        if(axis == "y"){axisOfRotation = glm::vec3(0,1,0);}
-        if(axis == "z"){axisOfRotation = glm::vec3(0,0,1);}
+        glm::vec3 axisOfRotation(0.0f);
+        axisOfRotation[axis] = 1.0f;
 
         float angle = 30.0f;
+        glm::mat4& Model = scene.transform(selectedObject);
         if(e.button.button == SDL_BUTTON_LEFT)
         {
             Model = glm::rotate(Model, glm::radians(angle), axisOfRotation);
@@ -382,9 +748,8 @@ void OpenGLWindow::computeMatrices(std::string & type, SDL_Event e)
         {
             Model = glm::rotate(Model, glm::radians(-1.0f*angle), axisOfRotation);
         }
-        MVP = Projection * View * Model;
     }
-    else if(type == "zoom")
+    else if(type == MODE_ZOOM)
     {
         if(e.button.button == SDL_BUTTON_LEFT)//increase
         {
@@ -396,42 +761,486 @@ void OpenGLWindow::computeMatrices(std::string & type, SDL_Event e)
         }
 
         Projection = glm::perspective(glm::radians(FOV), 4.0f / 3.0f, 0.1f, 100.0f);
-        MVP = Projection * View * Model;
     }
-    else if(type == "add")
+    else if((type == MODE_PICK) || (type == MODE_NONE))
+    {
+        Uint64 pickStart = SDL_GetPerformanceCounter();
+        PickResult picked;
+        bool found = pick(e.button.x, e.button.y, &picked);
+        double pickMicroseconds = 1000000.0*(SDL_GetPerformanceCounter() - pickStart) /
+                                  SDL_GetPerformanceFrequency();
+        if(!found)
+        {
+            if(verbose)
+            {
+                std::cout << "Nothing there (" << pickMicroseconds << " us)" << std::endl;
+            }
+            return;
+        }
+        if(verbose)
+        {
+            std::cout << "Hit triangle " << picked.hit.triangle << " at distance " << picked.hit.distance
+                      << ", barycentrics (" << 1.0f - picked.hit.u - picked.hit.v << ", " << picked.hit.u
+                      << ", " << picked.hit.v << ") in " << pickMicroseconds << " us" << std::endl;
+        }
+        selectObject(picked.object);
+    }
+}
+
+//the path is typed into the window (see handlePathEntry), so rendering carries on meanwhile
+void OpenGLWindow::startPathEntry()
+{
+    std::cout << "Type the path of the object to add (it shows in the window title) and press "
+                 "enter, or escape to cancel" << std::endl;
+    enteringPath = true;
+    enteredPath.clear();
+    //NOTE: The text event for the 'a' that started this is already queued
+    SDL_FlushEvent(SDL_TEXTINPUT);
+    SDL_StartTextInput();
+    setStatus("add object: _");
+    mode = MODE_NONE;
+}
+
+void OpenGLWindow::setCamera(glm::vec3 position, glm::vec3 target)
+{
+    View = glm::lookAt(position, target, glm::vec3(0,1,0));
+}
+
+void OpenGLWindow::addCopies(int count)
+{
+    if(!scene.contains(selectedObject) || (count < 2))
     {
-        Model = glm::mat4(1.0f);
-        MVP = Projection * View * Model;
-        std::cout << "Enter path of second object" << std::endl;
-        std::string path;
-        std::cin >> path;
-        addSecondObject(path);
-        mode = "none";
+        return;
     }
+    int firstId = selectedObject;
+    GeometryData& geometry = scene.meshOf(firstId).geometry;
+    glm::vec3 boundsMin = glm::make_vec3(geometry.boundsMin());
+    glm::vec3 boundsMax = glm::make_vec3(geometry.boundsMax());
+    glm::vec3 center = 0.5f*(boundsMin + boundsMax);
+    float extent = std::max(boundsMax.x - boundsMin.x, boundsMax.z - boundsMin.z);
+
+    //each copy goes in the middle of its own cell of a side x side grid on the xz plane
+    int side = (int)ceil(sqrt((double)count));
+    for(int i=0; i<count; i++)
+    {
+        int id = (i == 0) ? firstId : scene.addInstance(firstId);
+        glm::vec3 cell(((i % side) + 0.5f)/side - 0.5f, 0.0f, ((i / side) + 0.5f)/side - 0.5f);
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), center + cell*extent);
+        transform = glm::scale(transform, glm::vec3(1.0f/side));
+        scene.transform(id) = glm::translate(transform, -center);
+    }
+    objectBoundsValid = false;
+    hierarchyValid = false;
+}
+
+int OpenGLWindow::triangleCount()
+{
+    return drawnTriangles;
 }
 
-//given a path of an object, load it into geometry, generate random colours and reload buffers.
+//the largest scale a model matrix applies along any axis, which is how much bounding spheres grow
+static float maximumScale(const glm::mat4& Model)
+{
+    return std::max(glm::length(glm::vec3(Model[0])),
+                    std::max(glm::length(glm::vec3(Model[1])), glm::length(glm::vec3(Model[2]))));
+}
+
+//puts every object's bounding sphere and box in world space
+void OpenGLWindow::updateObjectBounds()
+{
+    size_t count = scene.objectCount();
+    sphereX.resize(count);
+    sphereY.resize(count);
+    sphereZ.resize(count);
+    sphereRadius.resize(count);
+    objectBoundsMin.resize(count);
+    objectBoundsMax.resize(count);
+    for(size_t i=0; i<count; i++)
+    {
+        SceneObject& object = scene.object(i);
+        GeometryData& geometry = scene.mesh(object.mesh).geometry;
+        glm::vec3 boundsMin = glm::make_vec3(geometry.boundsMin());
+        glm::vec3 boundsMax = glm::make_vec3(geometry.boundsMax());
+        glm::vec3 center = 0.5f*(boundsMin + boundsMax);
+        glm::vec3 worldCenter = glm::vec3(object.transform*glm::vec4(center, 1.0f));
+        sphereX[i] = worldCenter.x;
+        sphereY[i] = worldCenter.y;
+        sphereZ[i] = worldCenter.z;
+        sphereRadius[i] = geometry.boundingRadius()*maximumScale(object.transform);
+
+        //the box that holds the transformed box: each world axis gets the absolute values of the
+        //row of the matrix times the half size
+        glm::vec3 halfSize = 0.5f*(boundsMax - boundsMin);
+        glm::vec3 worldHalfSize;
+        for(int axis=0; axis<3; axis++)
+        {
+            worldHalfSize[axis] = fabs(object.transform[0][axis])*halfSize.x +
+                                  fabs(object.transform[1][axis])*halfSize.y +
+                                  fabs(object.transform[2][axis])*halfSize.z;
+        }
+        objectBoundsMin[i] = worldCenter - worldHalfSize;
+        objectBoundsMax[i] = worldCenter + worldHalfSize;
+    }
+    objectBoundsValid = true;
+}
+
+//builds the hierarchy over the object boxes, or just refits it if the objects have only moved
+void OpenGLWindow::updateObjectHierarchy()
+{
+    if(!objectBoundsValid)
+    {
+        updateObjectBounds();
+    }
+    if(!hierarchyValid)
+    {
+        objectHierarchy.build(objectBoundsMin.data(), objectBoundsMax.data(), scene.objectCount());
+        hierarchyValid = true;
+    }
+    else if(hierarchyMoved)
+    {
+        objectHierarchy.refit(objectBoundsMin.data(), objectBoundsMax.data());
+    }
+    hierarchyMoved = false;
+}
+
+//the ray through the pixel goes from the near plane to the far plane, which are at depth -1 and 1
+//once projected. The hierarchy finds the objects whose boxes it passes through, and each of those
+//has the ray taken into its model space (which keeps distances along the ray the same, since the
+//direction isn't normalized again) to be cast at its mesh
+bool OpenGLWindow::pick(int x, int y, PickResult* result)
+{
+    int width, height;
+    SDL_GetWindowSize(sdlWin, &width, &height);
+    glm::vec2 position(2.0f*(x + 0.5f)/width - 1.0f, 1.0f - 2.0f*(y + 0.5f)/height);
+    glm::mat4 inverseViewProjection = glm::inverse(Projection * View);
+    glm::vec4 nearPoint = inverseViewProjection*glm::vec4(position, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverseViewProjection*glm::vec4(position, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(nearPoint)/nearPoint.w;
+    glm::vec3 direction = glm::normalize(glm::vec3(farPoint)/farPoint.w - origin);
+
+    updateObjectHierarchy();
+    RayHit closestHit;
+    float distance;
+    int index = objectHierarchy.raycast(origin, direction, 1e30f,
+        [&](unsigned int object, float closest)
+        {
+            SceneObject& sceneObject = scene.object(object);
+            glm::mat4 inverseModel = glm::inverse(sceneObject.transform);
+            glm::vec3 modelOrigin = glm::vec3(inverseModel*glm::vec4(origin, 1.0f));
+            glm::vec3 modelDirection = glm::vec3(inverseModel*glm::vec4(direction, 0.0f));
+            RayHit hit;
+            if(!scene.raycaster(sceneObject.mesh).raycast(modelOrigin, modelDirection, closest, &hit))
+            {
+                return closest;
+            }
+            closestHit = hit;
+            return hit.distance;
+        }, &distance);
+    if(index < 0)
+    {
+        return false;
+    }
+    result->object = scene.objectId(index);
+    result->hit = closestHit;
+    return true;
+}
+
+//tests the objects against the view frustum, either through the hierarchy or one sphere at a time
+void OpenGLWindow::cullObjects(const glm::mat4& viewProjection)
+{
+    Uint64 cullStart = SDL_GetPerformanceCounter();
+    size_t count = scene.objectCount();
+    objectVisible.resize(count);
+    if(!frustumCulling)
+    {
+        std::fill(objectVisible.begin(), objectVisible.end(), 1);
+        lastCulled = 0;
+        lastCullMicroseconds = 0.0;
+        return;
+    }
+
+    if(!objectBoundsValid)
+    {
+        updateObjectBounds();
+    }
+    glm::vec4 planes[6];
+    extractFrustumPlanes(viewProjection, planes);
+    size_t visibleCount;
+    if(count >= HIERARCHY_CULLING_MIN_OBJECTS)
+    {
+        updateObjectHierarchy();
+        visibleCount = objectHierarchy.cullFrustum(planes, objectVisible.data());
+    }
+    else
+    {
+        visibleCount = cullSpheres(sphereX.data(), sphereY.data(), sphereZ.data(),
+                                   sphereRadius.data(), count, planes, objectVisible.data());
+    }
+    lastCulled = count - visibleCount;
+    lastCullMicroseconds = 1000000.0*(SDL_GetPerformanceCounter() - cullStart) /
+                           SDL_GetPerformanceFrequency();
+}
+
+//picks the simplest LOD whose error would still be less than a pixel on screen. The bounding
+//sphere gives the nearest the object gets to the camera, which decides how big the error can look
+int OpenGLWindow::selectLOD(GeometryData& geometry, const glm::mat4& Model)
+{
+    const float maximumPixelError = 1.0f;
+    const float viewportHeight = 480.0f;
+
+    glm::vec3 boundsMin = glm::make_vec3(geometry.boundsMin());
+    glm::vec3 boundsMax = glm::make_vec3(geometry.boundsMax());
+    glm::vec3 center = 0.5f*(boundsMin + boundsMax);
+    float radius = geometry.boundingRadius();
+
+    //scale mode scales the model matrix, so the sphere (and the error) grows with its largest axis
+    float scale = maximumScale(Model);
+    glm::vec4 viewCenter = View*Model*glm::vec4(center, 1.0f);
+    float nearestDistance = -viewCenter.z - radius*scale;
+    if(nearestDistance <= 0.0f)
+    {
+        return 0;//the camera is inside the sphere
+    }
+
+    //Projection[1][1] is 1/tan(FOV/2), which takes view space heights to the -1..1 viewport
+    float pixelsPerUnit = Projection[1][1]*0.5f*viewportHeight/nearestDistance;
+    int level = 0;
+    for(int i=1; i<geometry.lodCount(); i++)
+    {
+        if(geometry.lod(i).error*scale*pixelsPerUnit <= maximumPixelError)
+        {
+            level = i;
+        }
+    }
+    return level;
+}
+
+double OpenGLWindow::loadMilliseconds()
+{
+    return lastLoadMilliseconds;
+}
+
+double OpenGLWindow::shaderMilliseconds()
+{
+    return shaderLoadMilliseconds;
+}
+
+long long OpenGLWindow::vertexBytes()
+{
+    return scene.vertexBytes();
+}
+
+int OpenGLWindow::objectCount()
+{
+    return scene.objectCount();
+}
+
+GLCallCounts OpenGLWindow::glCallCounts()
+{
+    return lastFrameCalls;
+}
+
+int OpenGLWindow::culledCount()
+{
+    return lastCulled;
+}
+
+double OpenGLWindow::cullMicroseconds()
+{
+    return lastCullMicroseconds;
+}
+
+int OpenGLWindow::culledMeshletCount()
+{
+    return lastMeshletsCulled;
+}
+
+int OpenGLWindow::culledMeshletTriangles()
+{
+    return lastMeshletTrianglesCulled;
+}
+
+StreamStats OpenGLWindow::streamStats()
+{
+    return lastStreamStats;
+}
+
+double OpenGLWindow::drawMicroseconds()
+{
+    return lastDrawMicroseconds;
+}
+
+bool OpenGLWindow::persistentStreaming()
+{
+    return streamBuffer.persistent();
+}
+
+//given a path of an object, add it to the scene at the origin and select it. Objects already in
+//the scene keep their buffers and transforms (and a file that's already loaded isn't loaded again).
+//New files are loaded in the background and only show up once they're on the GPU (see updateLoads)
 void OpenGLWindow::addSecondObject(std::string & path)
 {
-    geometry.loadFromOBJFile(path);
-    int num_vertices = geometry.vertexCount()*3;
-    void* object_data = geometry.vertexData();
+    if(scene.hasMesh(path))
+    {
+        Uint64 loadStart = SDL_GetPerformanceCounter();
+        int id = scene.addObject(glState, path, loadOptions, packedVertices);
+        objectBoundsValid = false;
+        hierarchyValid = false;
+        lastLoadMilliseconds = 1000.0*(SDL_GetPerformanceCounter() - loadStart) /
+                               SDL_GetPerformanceFrequency();
+        selectObject(id);
+        return;
+    }
+    if(loadsPending() == 0)
+    {
+        loadFrames = 0;
+        slowestLoadFrame = 0.0;
+    }
+    meshLoader.request(path, loadOptions, packedVertices);
+}
+
+int OpenGLWindow::loadsPending()
+{
+    return meshLoader.pendingCount() + (uploading.mesh ? 1 : 0);
+}
+
+//called at the start of every frame: takes a mesh the loader has finished with, copies up to
+//uploadBytesPerFrame of it to the GPU, and adds it to the scene once it's all there. The load's
+//progress goes in the window title (and each step it gets to is printed)
+void OpenGLWindow::updateLoads()
+{
+    Uint64 frameStart = SDL_GetPerformanceCounter();
+    bool pending = (loadsPending() > 0);
+    if(pending && (lastFrameStart != 0))
+    {
+        double frameMilliseconds = 1000.0*(frameStart - lastFrameStart)/SDL_GetPerformanceFrequency();
+        slowestLoadFrame = std::max(slowestLoadFrame, frameMilliseconds);
+        loadFrames++;
+    }
+    lastFrameStart = frameStart;
+    if(!pending)
+    {
+        return;
+    }
+
+    if(!uploading.mesh && meshLoader.poll(&uploading) && !uploading.mesh)
+    {
+        std::cout << "Unable to add " << uploading.path << std::endl;
+    }
 
-    GLfloat color_data[num_vertices];
+    std::string step;
+    std::string status;
+    if(uploading.mesh)
+    {
+        //a file that got loaded twice at once is only uploaded once (see Scene::addLoadedObject)
+        bool uploaded = true;
+        if(!scene.hasMesh(uploading.path))
+        {
+            if(uploadFrames == 0)
+            {
+                uploading.mesh->gpu = scene.takeSpareGpuMesh();
+                uploading.mesh->gpu.beginUpload(glState, uploading.gpuData);
+            }
+            size_t totalBytes = uploading.gpuData.uploadBytes();
+            size_t sliceBytes = (uploadBytesPerFrame > 0) ? uploadBytesPerFrame : totalBytes;
+            uploaded = uploading.mesh->gpu.continueUpload(glState, uploading.gpuData, sliceBytes);
+            uploadFrames++;
+            step = uploading.path + ": uploading";
+            status = step + " (" + std::to_string(std::min<size_t>(uploadFrames*sliceBytes, totalBytes)*100 /
+                                                  std::max<size_t>(totalBytes, 1)) + "%)";
+        }
+        if(uploaded)
+        {
+            double totalMilliseconds = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - uploading.requested).count();
+            int id = scene.addLoadedObject(glState, std::move(uploading.mesh));
+            objectBoundsValid = false;
+            hierarchyValid = false;
+            lastLoadMilliseconds = totalMilliseconds;
+            std::cout << "Added " << uploading.path << " after " << totalMilliseconds << " ms ("
+                      << uploading.loadMilliseconds << " ms loading, uploaded over " << uploadFrames
+                      << " frames). Slowest of the " << loadFrames << " frames meanwhile took "
+                      << slowestLoadFrame << " ms" << std::endl;
+            selectObject(id);
+            uploading = LoadedMesh();
+            uploadFrames = 0;
+        }
+    }
+    if(step.empty())
+    {
+        std::vector<MeshLoadProgress> loads;
+        meshLoader.progress(&loads);
+        if(!loads.empty())
+        {
+            step = loads[0].path + ": " + loads[0].step;
+            status = step;
+        }
+    }
+    if(!step.empty() && (step != loadStep))
+    {
+        std::cout << "Loading " << step << std::endl;
+    }
+    loadStep = step;
+    if(!enteringPath)
+    {
+        setStatus(status);
+    }
+}
 
-    for (int i = 0; i < num_vertices; ++i)
+//while a path is being typed, every event goes here instead of to the usual controls. Enter queues
+//the load and escape gives up
+bool OpenGLWindow::handlePathEntry(const SDL_Event& e)
+{
+    if(e.type == SDL_TEXTINPUT)
     {
-        float r = static_cast<float>(rand())/static_cast<float>(RAND_MAX);
-        color_data[i] = r;
+        enteredPath += e.text.text;
     }
+    else if((e.type == SDL_KEYDOWN) && (e.key.keysym.sym == SDLK_BACKSPACE) && !enteredPath.empty())
+    {
+        enteredPath.erase(enteredPath.size() - 1);
+    }
+    else if((e.type == SDL_KEYDOWN) &&
+            ((e.key.keysym.sym == SDLK_RETURN) || (e.key.keysym.sym == SDLK_KP_ENTER) ||
+             (e.key.keysym.sym == SDLK_ESCAPE)))
+    {
+        enteringPath = false;
+        SDL_StopTextInput();
+        setStatus("");
+        if((e.key.keysym.sym != SDLK_ESCAPE) && !enteredPath.empty())
+        {
+            std::cout << "Adding " << enteredPath << std::endl;
+            addSecondObject(enteredPath);
+        }
+        return true;
+    }
+    else
+    {
+        return true;
+    }
+    setStatus("add object: " + enteredPath + "_");
+    return true;
+}
 
-    //relaod buffers
-    glGenBuffers(1, &vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, num_vertices*sizeof(float), object_data, GL_STATIC_DRAW);
+//shows what's going on after the window's name in its title bar
+void OpenGLWindow::setStatus(const std::string& status)
+{
+    std::string title = "OpenGL Prac 1";
+    if(!status.empty())
+    {
+        title += " - " + status;
+    }
+    if(title != windowTitle)
+    {
+        SDL_SetWindowTitle(sdlWin, title.c_str());
+        windowTitle = title;
+    }
+}
 
-    //for colours
-    glGenBuffers(1, &colorBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
-    glBufferData(GL_ARRAY_BUFFER, num_vertices*sizeof(float), color_data, GL_STATIC_DRAW);
-}
\ No newline at end of file
+void OpenGLWindow::selectObject(int id)
+{
+    selectedObject = id;
+    if((id >= 0) && verbose)
+    {
+        std::cout << "Selected object " << id << " (" << scene.meshOf(id).path << ")" << std::endl;
+    }
+}
@@ -2,47 +2,190 @@
 #define GL_WINDOW_H
 
 #include <string>
+#include <vector>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "geometry.h"
+#include "glstate.h"
+#include "scene.h"
+#include "bvh.h"
+#include "meshloader.h"
+#include "streambuffer.h"
+#include "uniformblocks.h"
+#include "keybindings.h"
+#include "inputrecording.h"
+
+// What's under the mouse (see OpenGLWindow::pick)
+struct PickResult
+{
+    int object;//id of the object in the scene
+    RayHit hit;//triangle of the object's mesh, with the distance from the camera in world units
+};
+
+// What clicking does
+enum TransformMode
+{
+    MODE_NONE,//same as picking
+    MODE_TRANSLATE,
+    MODE_SCALE,
+    MODE_ROTATE,
+    MODE_PICK,
+    MODE_ZOOM
+};
+
+// Axis that translating and rotating go along (the index of the component of a vector)
+enum Axis
+{
+    AXIS_X,
+    AXIS_Y,
+    AXIS_Z
+};
 
 class OpenGLWindow
 {
 public:
     std::string object_1;//path of first object (parsed from main.cpp)
-    std::string mode;//the current transformation mode
-    std::string axis;//the current axis in transformation
+    TransformMode mode = MODE_NONE;//the current transformation mode
+    Axis axis = AXIS_Z;//the current axis in transformation
+    KeyBindings keyBindings;//which key runs which command (see runCommand)
+    bool verbose = true;//print what key presses and clicks did (the event benchmark turns it off)
+    InputRecording* recording = 0;//every event handled gets added to it when set
+    bool offscreen = false;//hidden window, no vsync, render into a framebuffer object (for benchmarking)
+    bool vsync = true;//wait for vertical sync when presenting (see FrameScheduler::wantsVsync)
+    bool packedVertices = true;//upload compact interleaved vertices instead of float positions (see vertexpack.h)
+    bool instancing = true;//draw all the objects sharing a mesh (and LOD) in one call instead of one call each
+    bool frustumCulling = true;//skip objects whose bounding sphere is outside the view (see culling.h)
+    bool meshletCulling = false;//skip meshlets of full detail objects that are out of view or face away (see meshlets.h). Draws one object at a time and needs loadOptions.generateMeshlets
+    bool indirectDrawing = false;//put every mesh in one geometry arena and draw the whole scene with one indirect call (see geometryarena.h). Ignored without GL 4.3 or the extensions
+    bool uniformBuffers = true;//draw objects one at a time with their model matrices in a uniform buffer written once per frame, instead of an MVP uniform worked out for each one (see uniformblocks.h)
+    bool streamingUploads = true;//send mesh data and instance matrices through a ring buffer (see streambuffer.h)
+    GeometryLoadOptions loadOptions;//how objects get loaded (meshes are optimized for the GPU and get LODs by default)
+    int uploadBytesPerFrame = 4 << 20;//most of a background loaded mesh to copy to the GPU each frame (0 for all at once)
     OpenGLWindow();
     ~OpenGLWindow();
 
     void initGL();
     void render();
-    bool handleEvent(SDL_Event e);
+    bool handleEvent(const SDL_Event& e);
+    bool wantsRedraw();//whether anything has changed since the last render (or a background load needs frames to finish)
+    void requestRedraw();
     void cleanup();
-    void computeMatrices(std::string & type, SDL_Event e);
+    bool runCommand(Command command);//returns false to quit, like handleEvent
+    void computeMatrices(TransformMode type, const SDL_Event& e);
     void addSecondObject(std::string & path);
+    int loadsPending();//objects being loaded in the background (see addSecondObject) that aren't in the scene yet
+
+    //moves the camera (used by the benchmark to fly along a scripted path)
+    void setCamera(glm::vec3 position, glm::vec3 target);
+    //finds the object under a point in the window (in pixels from the top left). Returns false if
+    //there's nothing there
+    bool pick(int x, int y, PickResult* result);
+    //replaces the first object with a square grid of copies of it, shrunk to fit in the space it took up
+    void addCopies(int count);
+    int triangleCount();//triangles drawn by the last render (depends on the LODs picked)
+    double loadMilliseconds();//time taken to load and upload the last object (from asking for it to it being drawn)
+    double shaderMilliseconds();//time taken to compile (or load from the program cache) the shaders
+    long long vertexBytes();//size of the vertex buffers of every mesh (not counting the colours)
+    int objectCount();//objects in the scene
+    GLCallCounts glCallCounts();//GL calls made by the last render
+    int culledCount();//objects skipped by the last render for being out of view
+    double cullMicroseconds();//time the last render spent culling (objects and meshlets)
+    int culledMeshletCount();//meshlets skipped by the last render (see meshletCulling)
+    int culledMeshletTriangles();//triangles in them
+    double drawMicroseconds();//CPU time the last render spent submitting draws (after culling)
+    StreamStats streamStats();//what went through the stream buffer during the last render
+    bool persistentStreaming();//whether the stream buffer is persistently mapped
 
     SDL_Window* sdlWin;
 
-    
 
 private:
+    int selectLOD(GeometryData& geometry, const glm::mat4& model);
+    int objectLOD(int i, GeometryData& geometry, const glm::mat4& model);
+    void cullObjects(const glm::mat4& viewProjection);
+    void updateObjectBounds();
+    void updateObjectHierarchy();
+    void drawPerObject();
+    int drawMeshlets(SceneMesh& mesh, const glm::mat4& Model, const glm::mat4& ProjectionView);
+    void drawInstanced();
+    void drawIndirect();
+    void selectObject(int id);
+    void updateLoads();
+    void startPathEntry();
+    bool handlePathEntry(const SDL_Event& e);
+    void setStatus(const std::string& status);
 
-    GLuint vao;
     GLuint shader;
-    GLuint vertexBuffer;
-    GLuint colorBuffer;
     GLuint MatrixID;//used for camera
+    GLuint objectShader;//simple.vert taking the camera and model matrices from uniform blocks
+    GLuint ObjectDequantizeID;
+    GLuint instancedShader;//takes the model matrices as per-instance attributes (see instanced.vert)
+    GLuint DequantizeID;
+
+    //offscreen render target, only used when offscreen is set
+    GLuint framebuffer;
+    GLuint colorRenderbuffer;
+    GLuint depthRenderbuffer;
+
+    double lastLoadMilliseconds = 0.0;
+    double shaderLoadMilliseconds = 0.0;
+    int currentLOD = 0;//LOD the selected object was drawn with by the last render
+    int drawnTriangles = 0;
+    GLCallCounts lastFrameCalls;
+    StreamStats lastStreamStats;
+    int lastCulled = 0;
+    double lastCullMicroseconds = 0.0;
+    int lastMeshletsCulled = 0;
+    int lastMeshletTrianglesCulled = 0;
+    double lastDrawMicroseconds = 0.0;
     
     //matrices for MVP model
     glm::mat4 Projection;
     glm::mat4 View;
-    glm::mat4 Model;
-    glm::mat4 MVP;
     
-    GeometryData geometry;//geometry for object/s
+    Scene scene;//every object, each with its own mesh and model matrix
+    int selectedObject = -1;//object that transformations apply to (the last one added by default)
+    GLStateCache glState;//every bind and draw goes through this
+    StreamBuffer streamBuffer;//ring that uploads and instance matrices are written into, when streamingUploads is set
+    UniformBlocks uniformBlocks;//camera matrices for every shader, and model matrices for objectShader
+    MeshLoader meshLoader;//loads added objects on a worker thread
+    LoadedMesh uploading;//finished load being copied to the GPU a slice per frame (its mesh is null when there isn't one)
+    int uploadFrames = 0;//frames the current upload has taken so far
+    int loadFrames = 0;//frames drawn while the current loads have been pending
+    double slowestLoadFrame = 0.0;//longest time between frames while they were pending (ms)
+    Uint64 lastFrameStart = 0;
+    std::string loadStep;//what the oldest pending load is doing, printed whenever it changes
+    std::string windowTitle;
+    bool redrawRequested = true;
+    bool enteringPath = false;//typing the path of an object to add (in the window title)
+    std::string enteredPath;
+    std::vector<std::vector<std::vector<glm::mat4> > > instanceBatches;//model matrices to draw, by mesh and LOD
+    std::vector<glm::mat4> objectModels;//model matrices of the objects drawPerObject draws, in order
+    //world space bounding spheres (one array per component) and boxes of the objects, in scene
+    //order. They're only worked out again after objects are added, removed or moved
+    std::vector<float> sphereX;
+    std::vector<float> sphereY;
+    std::vector<float> sphereZ;
+    std::vector<float> sphereRadius;
+    std::vector<glm::vec3> objectBoundsMin;
+    std::vector<glm::vec3> objectBoundsMax;
+    bool objectBoundsValid = false;
+    //hierarchy over the object boxes for culling large scenes. It's built again when objects are
+    //added or removed, and refit when they're moved
+    BoundingVolumeHierarchy objectHierarchy;
+    bool hierarchyValid = false;
+    bool hierarchyMoved = false;
+    std::vector<unsigned char> objectVisible;//whether each object is in view, filled in by cullObjects
+    //which meshlets of the object being drawn survived culling, and the index ranges they make up
+    //(neighbouring meshlets are next to each other in the index buffer, so they merge into one)
+    std::vector<unsigned char> meshletVisible;
+    std::vector<unsigned int> meshletFirstIndices;
+    std::vector<GLsizei> meshletIndexCounts;
+    //what drawIndirect sends, one command and model matrix per visible object
+    std::vector<DrawElementsIndirectCommand> indirectCommands;
+    std::vector<glm::mat4> indirectTransforms;
 
     float FOV = 30.0f;//original angle of field of view
 };
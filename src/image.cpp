@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+
+#include "image.h"
+
+bool writePPM(const std::string& path, int width, int height, const unsigned char* rgb)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if(!file)
+    {
+        return false;
+    }
+    size_t size = (size_t)width*height*3;
+    bool success = (fprintf(file, "P6\n%d %d\n255\n", width, height) > 0) &&
+                   (fwrite(rgb, 1, size, file) == size);
+    success = (fclose(file) == 0) && success;
+    return success;
+}
+
+bool readPPM(const std::string& path, int* width, int* height, std::vector<unsigned char>* rgb)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file)
+    {
+        return false;
+    }
+    int maxValue = 0;
+    // NOTE: The fgetc skips the single whitespace character between the header and the data
+    bool success = (fscanf(file, "P6 %d %d %d", width, height, &maxValue) == 3) &&
+                   (maxValue == 255) && (*width > 0) && (*height > 0) && (fgetc(file) != EOF);
+    if(success)
+    {
+        rgb->resize((size_t)(*width)*(*height)*3);
+        success = (fread(rgb->data(), 1, rgb->size(), file) == rgb->size());
+    }
+    fclose(file);
+    return success;
+}
+
+static uint32_t crc32Update(uint32_t crc, const unsigned char* data, size_t size)
+{
+    // NOTE: Only a few chunks get written per image, so the table isn't worth keeping around
+    uint32_t table[256];
+    for(uint32_t n=0; n<256; n++)
+    {
+        uint32_t c = n;
+        for(int bit=0; bit<8; bit++)
+        {
+            c = (c & 1) ? (0xedb88320u ^ (c >> 1)) : (c >> 1);
+        }
+        table[n] = c;
+    }
+    crc = ~crc;
+    for(size_t i=0; i<size; i++)
+    {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void appendBigEndian(std::vector<unsigned char>& bytes, uint32_t value)
+{
+    bytes.push_back(value >> 24);
+    bytes.push_back(value >> 16);
+    bytes.push_back(value >> 8);
+    bytes.push_back(value);
+}
+
+static bool writeChunk(FILE* file, const char* type, const std::vector<unsigned char>& data)
+{
+    std::vector<unsigned char> chunk;
+    appendBigEndian(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    appendBigEndian(chunk, crc32Update(0, &chunk[4], chunk.size() - 4));
+    return fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size();
+}
+
+// NOTE: The image data of a PNG is a zlib stream, but deflate allows blocks to be stored as they
+//       are (up to 65535 bytes each), so no compressor is needed to write a valid one
+bool writePNG(const std::string& path, int width, int height, const unsigned char* rgb)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if(!file)
+    {
+        return false;
+    }
+    const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    bool success = (fwrite(signature, 1, 8, file) == 8);
+
+    std::vector<unsigned char> header;
+    appendBigEndian(header, width);
+    appendBigEndian(header, height);
+    header.push_back(8);//bits per channel
+    header.push_back(2);//RGB
+    header.push_back(0);//deflate
+    header.push_back(0);//adaptive filtering (every row uses filter 0, none)
+    header.push_back(0);//not interlaced
+    success = success && writeChunk(file, "IHDR", header);
+
+    // Every row starts with its filter type
+    size_t rowSize = (size_t)width*3;
+    std::vector<unsigned char> raw;
+    raw.reserve((rowSize + 1)*height);
+    for(int y=0; y<height; y++)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb + y*rowSize, rgb + (y+1)*rowSize);
+    }
+
+    std::vector<unsigned char> zlib;
+    zlib.reserve(raw.size() + raw.size()/65535*5 + 16);
+    zlib.push_back(0x78);//deflate with a 32K window
+    zlib.push_back(0x01);//no preset dictionary, and makes the first two bytes a multiple of 31
+    uint32_t adlerA = 1;
+    uint32_t adlerB = 0;
+    size_t offset = 0;
+    do
+    {
+        size_t blockSize = std::min(raw.size() - offset, (size_t)65535);
+        bool lastBlock = (offset + blockSize == raw.size());
+        zlib.push_back(lastBlock ? 1 : 0);
+        zlib.push_back(blockSize & 0xff);
+        zlib.push_back(blockSize >> 8);
+        zlib.push_back(~blockSize & 0xff);
+        zlib.push_back((~blockSize >> 8) & 0xff);
+        for(size_t i=offset; i<offset+blockSize; i++)
+        {
+            zlib.push_back(raw[i]);
+            adlerA = (adlerA + raw[i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+        offset += blockSize;
+    }
+    while(offset < raw.size());
+    appendBigEndian(zlib, (adlerB << 16) | adlerA);
+    success = success && writeChunk(file, "IDAT", zlib);
+    success = success && writeChunk(file, "IEND", std::vector<unsigned char>());
+
+    success = (fclose(file) == 0) && success;
+    return success;
+}
+
+int countDifferentPixels(const unsigned char* a, const unsigned char* b, int width, int height,
+                         int threshold)
+{
+    int different = 0;
+    for(size_t pixel=0; pixel<(size_t)width*height; pixel++)
+    {
+        for(int channel=0; channel<3; channel++)
+        {
+            if(abs((int)a[3*pixel + channel] - (int)b[3*pixel + channel]) > threshold)
+            {
+                different++;
+                break;
+            }
+        }
+    }
+    return different;
+}
@@ -0,0 +1,23 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <string>
+#include <vector>
+
+// Writing and reading 8-bit RGB images, rows from the top, with no libraries needed. Used to save
+// what the software rasterizer drew and compare it against golden images
+
+// Binary PPM (P6). Quick to write and trivial for other tools to read
+bool writePPM(const std::string& path, int width, int height, const unsigned char* rgb);
+// Reads a binary PPM with a maximum value of 255, as writePPM writes them
+bool readPPM(const std::string& path, int* width, int* height, std::vector<unsigned char>* rgb);
+
+// PNG with the image data stored rather than compressed (so it's about the same size as a PPM),
+// which every image viewer and diff tool opens
+bool writePNG(const std::string& path, int width, int height, const unsigned char* rgb);
+
+// Pixels of two images of the same size that differ by more than threshold in any channel
+int countDifferentPixels(const unsigned char* a, const unsigned char* b, int width, int height,
+                         int threshold);
+
+#endif
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <string.h>
+#include <random>
+
+#include "inputrecording.h"
+
+static bool replayable(const SDL_Event& e)
+{
+    return (e.type < SDL_USEREVENT) && (e.type != SDL_SYSWMEVENT) &&
+           (e.type != SDL_DROPFILE) && (e.type != SDL_DROPTEXT);
+}
+
+void InputRecording::add(const SDL_Event& e)
+{
+    if(replayable(e))
+    {
+        recorded.push_back(e);
+    }
+}
+
+void InputRecording::clear()
+{
+    recorded.clear();
+}
+
+const std::vector<SDL_Event>& InputRecording::events() const
+{
+    return recorded;
+}
+
+bool InputRecording::save(const std::string& path) const
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if(!file)
+    {
+        return false;
+    }
+    InputRecordingHeader header;
+    header.magic = INPUT_RECORDING_MAGIC;
+    header.version = INPUT_RECORDING_VERSION;
+    header.eventSize = sizeof(SDL_Event);
+    header.eventCount = recorded.size();
+    bool success = (fwrite(&header, sizeof(header), 1, file) == 1) &&
+                   (fwrite(recorded.data(), sizeof(SDL_Event), recorded.size(), file) == recorded.size());
+    success = (fclose(file) == 0) && success;
+    return success;
+}
+
+bool InputRecording::load(const std::string& path)
+{
+    recorded.clear();
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file)
+    {
+        return false;
+    }
+    InputRecordingHeader header;
+    bool success = (fread(&header, sizeof(header), 1, file) == 1) &&
+                   (header.magic == INPUT_RECORDING_MAGIC) &&
+                   (header.version == INPUT_RECORDING_VERSION) &&
+                   (header.eventSize == sizeof(SDL_Event));
+    if(success)
+    {
+        recorded.resize(header.eventCount);
+        success = (fread(recorded.data(), sizeof(SDL_Event), recorded.size(), file) == recorded.size());
+    }
+    fclose(file);
+    if(!success)
+    {
+        recorded.clear();
+    }
+    return success;
+}
+
+void InputRecording::synthesize(const KeyBindings& bindings, int count, uint32_t seed,
+                                int width, int height)
+{
+    const Command keyCommands[] = {COMMAND_TRANSLATE, COMMAND_SCALE, COMMAND_ROTATE, COMMAND_PICK,
+                                   COMMAND_ZOOM, COMMAND_SELECT_NEXT};
+    const int keyCommandCount = sizeof(keyCommands)/sizeof(keyCommands[0]);
+
+    // NOTE: The engine's raw output is the same on every platform, where the distributions in
+    //       <random> are allowed to differ, so the values are taken from it directly
+    std::mt19937 random(seed);
+    recorded.clear();
+    recorded.reserve(count);
+    Uint32 timestamp = 0;
+    while((int)recorded.size() < count)
+    {
+        SDL_Event e;
+        memset(&e, 0, sizeof(e));
+        int x = random() % width;
+        int y = random() % height;
+        uint32_t kind = random() % 100;
+        if(kind < 60)
+        {
+            e.type = SDL_MOUSEMOTION;
+            e.motion.x = x;
+            e.motion.y = y;
+            e.common.timestamp = timestamp++;
+            recorded.push_back(e);
+        }
+        else if(kind < 90)
+        {
+            Uint8 buttons[2] = {SDL_BUTTON_LEFT, SDL_BUTTON_RIGHT};
+            for(int click=0; click<2; click++)
+            {
+                for(int press=0; press<2; press++)
+                {
+                    memset(&e, 0, sizeof(e));
+                    e.type = (press == 0) ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+                    e.button.state = (press == 0) ? SDL_PRESSED : SDL_RELEASED;
+                    e.button.button = buttons[click];
+                    e.button.x = x;
+                    e.button.y = y;
+                    e.common.timestamp = timestamp++;
+                    recorded.push_back(e);
+                }
+            }
+        }
+        else
+        {
+            SDL_Keycode key = bindings.keyFor(keyCommands[random() % keyCommandCount]);
+            if(key == SDLK_UNKNOWN)
+            {
+                continue;
+            }
+            for(int press=0; press<2; press++)
+            {
+                memset(&e, 0, sizeof(e));
+                e.type = (press == 0) ? SDL_KEYDOWN : SDL_KEYUP;
+                e.key.state = (press == 0) ? SDL_PRESSED : SDL_RELEASED;
+                e.key.keysym.sym = key;
+                e.common.timestamp = timestamp++;
+                recorded.push_back(e);
+            }
+        }
+    }
+    recorded.resize(count);
+}
@@ -0,0 +1,51 @@
+#ifndef INPUT_RECORDING_H
+#define INPUT_RECORDING_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "SDL.h"
+
+#include "keybindings.h"
+
+// A recording file is an InputRecordingHeader followed by the events, each stored as the whole
+// SDL_Event. That keeps recording to a copy per event, but ties the file to the SDL_Event layout,
+// so the header has its size and a file from a build where it differs isn't loaded
+
+#define INPUT_RECORDING_MAGIC 0x4e495050 // "PPIN"
+#define INPUT_RECORDING_VERSION 1
+
+struct InputRecordingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t eventSize;
+    uint32_t eventCount;
+};
+
+// Events handed to the window, in order, to be replayed later (see runEventBenchmark). Events
+// that point at memory of their own (dropped files, user events) can't be replayed, so they're
+// left out
+class InputRecording
+{
+public:
+    void add(const SDL_Event& e);
+    void clear();
+    const std::vector<SDL_Event>& events() const;
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // Makes up count events of the kinds a user sends, the same ones every time for a seed: mostly
+    // mouse movement, then clicks on random points of a width x height window, then presses of the
+    // keys bound to switching modes and selecting. Clicks come in pairs (left then right on the same
+    // point) that undo each other's transformation, so the scene doesn't drift away however many
+    // events there are
+    void synthesize(const KeyBindings& bindings, int count, uint32_t seed, int width, int height);
+
+private:
+    std::vector<SDL_Event> recorded;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include <string.h>
+
+#include "keybindings.h"
+
+static const char* COMMAND_NAMES[COMMAND_COUNT] =
+{
+    "none", "quit", "translate", "scale", "rotate", "pick", "zoom", "add", "next", "remove"
+};
+
+KeyBindings::KeyBindings()
+{
+    reset();
+}
+
+bool KeyBindings::bind(SDL_Keycode key, Command command)
+{
+    int slot = keySlot(key);
+    if((slot < 0) || (command >= COMMAND_COUNT))
+    {
+        return false;
+    }
+    commands[slot] = command;
+    return true;
+}
+
+void KeyBindings::unbind(Command command)
+{
+    for(size_t slot=0; slot<sizeof(commands); slot++)
+    {
+        if(commands[slot] == command)
+        {
+            commands[slot] = COMMAND_NONE;
+        }
+    }
+}
+
+void KeyBindings::reset()
+{
+    memset(commands, COMMAND_NONE, sizeof(commands));
+    bind(SDLK_ESCAPE, COMMAND_QUIT);
+    bind(SDLK_t, COMMAND_TRANSLATE);
+    bind(SDLK_s, COMMAND_SCALE);
+    bind(SDLK_r, COMMAND_ROTATE);
+    bind(SDLK_p, COMMAND_PICK);
+    bind(SDLK_z, COMMAND_ZOOM);
+    bind(SDLK_a, COMMAND_ADD_OBJECT);
+    bind(SDLK_n, COMMAND_SELECT_NEXT);
+    bind(SDLK_d, COMMAND_REMOVE);
+}
+
+bool KeyBindings::bind(const std::string& binding)
+{
+    size_t separator = binding.rfind('=');
+    if((separator == std::string::npos) || (separator == 0))
+    {
+        return false;
+    }
+    Command command = commandFromName(binding.substr(separator + 1));
+    SDL_Keycode key = SDL_GetKeyFromName(binding.substr(0, separator).c_str());
+    if((command == COMMAND_COUNT) || (key == SDLK_UNKNOWN))
+    {
+        return false;
+    }
+    return bind(key, command);
+}
+
+SDL_Keycode KeyBindings::keyFor(Command command) const
+{
+    for(size_t slot=0; slot<sizeof(commands); slot++)
+    {
+        if(commands[slot] == command)
+        {
+            return slotKey(slot);
+        }
+    }
+    return SDLK_UNKNOWN;
+}
+
+const char* KeyBindings::commandName(Command command)
+{
+    return (command < COMMAND_COUNT) ? COMMAND_NAMES[command] : "unknown";
+}
+
+Command KeyBindings::commandFromName(const std::string& name)
+{
+    for(int command=0; command<COMMAND_COUNT; command++)
+    {
+        if(name == COMMAND_NAMES[command])
+        {
+            return (Command)command;
+        }
+    }
+    return COMMAND_COUNT;
+}
+
+SDL_Keycode KeyBindings::slotKey(int slot)
+{
+    return (slot < 128) ? slot : ((slot - 128) | SDLK_SCANCODE_MASK);
+}
@@ -0,0 +1,76 @@
+#ifndef KEY_BINDINGS_H
+#define KEY_BINDINGS_H
+
+#include <string>
+
+#include "SDL.h"
+
+// What a key press does in the viewer (see OpenGLWindow::runCommand)
+enum Command
+{
+    COMMAND_NONE,
+    COMMAND_QUIT,
+    COMMAND_TRANSLATE,//translate mode, or the next axis if already in it
+    COMMAND_SCALE,
+    COMMAND_ROTATE,//rotate mode, or the next axis if already in it
+    COMMAND_PICK,
+    COMMAND_ZOOM,
+    COMMAND_ADD_OBJECT,//type in the path of an object to load
+    COMMAND_SELECT_NEXT,
+    COMMAND_REMOVE,//remove the selected object
+    COMMAND_COUNT
+};
+
+// Which key does what. Looking a key up is one array access, so it costs the same whatever is
+// bound, and keys can be bound again at any time (from the command line with --bind, say)
+class KeyBindings
+{
+public:
+    // Starts with the default bindings
+    KeyBindings();
+
+    Command lookup(SDL_Keycode key) const
+    {
+        int slot = keySlot(key);
+        return (slot >= 0) ? (Command)commands[slot] : COMMAND_NONE;
+    }
+
+    // Returns false for keys that can't be bound: ones that are neither ASCII nor have a scancode
+    // of their own (such as letters with accents on some layouts)
+    bool bind(SDL_Keycode key, Command command);
+    // Unbinds every key bound to the command
+    void unbind(Command command);
+    void reset();
+    // Binds from a "key=command" string, where key is an SDL key name ("T", "Space", "F1"...) and
+    // command is one of the names from commandName. Returns false if either isn't recognised
+    bool bind(const std::string& binding);
+    // The first key bound to the command (SDLK_UNKNOWN if there isn't one)
+    SDL_Keycode keyFor(Command command) const;
+
+    static const char* commandName(Command command);
+    // COMMAND_COUNT for a name that isn't a command
+    static Command commandFromName(const std::string& name);
+
+private:
+    // NOTE: Keycodes are either the character the key types (below 128 for everything the
+    //       defaults use) or SDLK_SCANCODE_MASK plus the key's scancode, so one flat table covers
+    //       both ranges
+    static int keySlot(SDL_Keycode key)
+    {
+        if((key >= 0) && (key < 128))
+        {
+            return key;
+        }
+        int scancode = key & ~SDLK_SCANCODE_MASK;
+        if((key & SDLK_SCANCODE_MASK) && (scancode < SDL_NUM_SCANCODES))
+        {
+            return 128 + scancode;
+        }
+        return -1;
+    }
+    static SDL_Keycode slotKey(int slot);
+
+    unsigned char commands[128 + SDL_NUM_SCANCODES];
+};
+
+#endif
@@ -1,8 +1,13 @@
 #include <string>
 #include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
 #include "SDL.h"
 
 #include "glwindow.h"
+#include "benchmark.h"
+#include "framescheduler.h"
+#include "inputrecording.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 // In order to make cross-platform development and deployment easy, SDL implements its own main
@@ -17,41 +22,292 @@ int SDL_main(int argc, char** argv)
 {
     if(argc < 2)
     {
-        std::cout << "Usage: prac1 <path of an object>" << std::endl;
+        std::cout << "Usage: prac1 <path of an object> [--render on-demand|fixed|unthrottled] [--fps <frames per second>] [--frame-stats] [--bind <key>=<command>]... [--record <path>]" << std::endl;
+        std::cout << "       prac1 --bench <path of an object> [frames] [--out <json path>] [--no-optimize] [--no-lod] [--unpacked] [--instances <count>] [--no-instancing] [--no-culling] [--meshlets] [--indirect] [--no-uniform-buffers] [--no-shader-cache] [--background-load <path of an object>] [--upload-slice <KB per frame>] [--no-streaming]" << std::endl;
+        std::cout << "       prac1 --pacing <path of an object> [seconds per phase] [--fps <frames per second>] [--out <json path>]" << std::endl;
+        std::cout << "       prac1 --events <path of an object> [events] [--replay <path>] [--seed <n>] [--passes <n>] [--instances <count>] [--bind <key>=<command>]... [--out <json path>]" << std::endl;
+        std::cout << "       prac1 --raster <path of an object>... [--frames <n>] [--size <width>x<height>] [--threads <n>] [--images <directory>] [--png] [--golden <directory>] [--threshold <n>] [--tolerance <fraction>] [--out <json path>]" << std::endl;
         return 1;
     }
+
+    // Software rendering, which needs no window or GPU, so it comes before SDL is initialized
+    if(std::string(argv[1]) == "--raster")
+    {
+        RasterBenchmarkOptions options;
+        for(int arg=2; arg<argc; arg++)
+        {
+            std::string value(argv[arg]);
+            if((value == "--out") && (arg+1 < argc))
+            {
+                options.outputPath = argv[++arg];
+            }
+            else if((value == "--frames") && (arg+1 < argc))
+            {
+                options.frameCount = atoi(argv[++arg]);
+            }
+            else if((value == "--size") && (arg+1 < argc))
+            {
+                if(sscanf(argv[++arg], "%dx%d", &options.width, &options.height) != 2)
+                {
+                    std::cout << "Expected the size as <width>x<height>" << std::endl;
+                    return 1;
+                }
+            }
+            else if((value == "--threads") && (arg+1 < argc))
+            {
+                options.threadCount = atoi(argv[++arg]);
+            }
+            else if((value == "--images") && (arg+1 < argc))
+            {
+                options.imageDirectory = argv[++arg];
+            }
+            else if(value == "--png")
+            {
+                options.png = true;
+            }
+            else if((value == "--golden") && (arg+1 < argc))
+            {
+                options.goldenDirectory = argv[++arg];
+            }
+            else if((value == "--threshold") && (arg+1 < argc))
+            {
+                options.pixelThreshold = atoi(argv[++arg]);
+            }
+            else if((value == "--tolerance") && (arg+1 < argc))
+            {
+                options.tolerance = atof(argv[++arg]);
+            }
+            else
+            {
+                options.objectPaths.push_back(value);
+            }
+        }
+        return runRasterBenchmark(options);
+    }
+
     if(SDL_Init(SDL_INIT_VIDEO) != 0)
     {
         SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_INFORMATION, "Error", "Unable to initialize SDL", 0);
         return 1;
     }
 
-    std::string object_path(argv[1]);
+    // Benchmark mode renders offscreen as fast as possible and reports frame times, instead of
+    // running the interactive loop below
+    if(std::string(argv[1]) == "--bench")
+    {
+        FrameBenchmarkOptions options;
+        for(int arg=2; arg<argc; arg++)
+        {
+            std::string value(argv[arg]);
+            if((value == "--out") && (arg+1 < argc))
+            {
+                options.outputPath = argv[++arg];
+            }
+            else if(value == "--no-optimize")
+            {
+                options.optimizeMesh = false;
+            }
+            else if(value == "--no-lod")
+            {
+                options.generateLODs = false;
+            }
+            else if(value == "--unpacked")
+            {
+                options.packedVertices = false;
+            }
+            else if((value == "--instances") && (arg+1 < argc))
+            {
+                options.instanceCount = atoi(argv[++arg]);
+            }
+            else if(value == "--no-instancing")
+            {
+                options.instancing = false;
+            }
+            else if(value == "--no-culling")
+            {
+                options.frustumCulling = false;
+            }
+            else if(value == "--meshlets")
+            {
+                options.meshletCulling = true;
+            }
+            else if(value == "--indirect")
+            {
+                options.indirectDrawing = true;
+            }
+            else if(value == "--no-uniform-buffers")
+            {
+                options.uniformBuffers = false;
+            }
+            else if(value == "--no-shader-cache")
+            {
+                options.programCache = false;
+            }
+            else if(value == "--no-streaming")
+            {
+                options.streamingUploads = false;
+            }
+            else if((value == "--background-load") && (arg+1 < argc))
+            {
+                options.backgroundLoadPath = argv[++arg];
+            }
+            else if((value == "--upload-slice") && (arg+1 < argc))
+            {
+                options.uploadBytesPerFrame = atoi(argv[++arg])*1024;
+            }
+            else if(options.objectPath.empty())
+            {
+                options.objectPath = value;
+            }
+            else
+            {
+                options.frameCount = atoi(value.c_str());
+            }
+        }
+        int result = runFrameBenchmark(options);
+        SDL_Quit();
+        return result;
+    }
 
-    OpenGLWindow window;
-    window.object_1 = object_path;
-    window.initGL();
+    // Input latency and CPU use of each render mode, with the object on screen
+    if(std::string(argv[1]) == "--pacing")
+    {
+        PacingBenchmarkOptions options;
+        for(int arg=2; arg<argc; arg++)
+        {
+            std::string value(argv[arg]);
+            if((value == "--out") && (arg+1 < argc))
+            {
+                options.outputPath = argv[++arg];
+            }
+            else if((value == "--fps") && (arg+1 < argc))
+            {
+                options.targetFPS = atof(argv[++arg]);
+            }
+            else if(options.objectPath.empty())
+            {
+                options.objectPath = value;
+            }
+            else
+            {
+                options.phaseSeconds = atof(value.c_str());
+            }
+        }
+        int result = runPacingBenchmark(options);
+        SDL_Quit();
+        return result;
+    }
 
-    bool running = true;
-    while(running)
+    // Event handling throughput, replaying recorded or made up input as fast as possible
+    if(std::string(argv[1]) == "--events")
     {
-        // Check for a quit event before passing to the GLWindow
-        SDL_Event e;
-        while(SDL_PollEvent(&e))
+        EventBenchmarkOptions options;
+        for(int arg=2; arg<argc; arg++)
         {
-            if(e.type == SDL_QUIT)
+            std::string value(argv[arg]);
+            if((value == "--out") && (arg+1 < argc))
+            {
+                options.outputPath = argv[++arg];
+            }
+            else if((value == "--replay") && (arg+1 < argc))
+            {
+                options.replayPath = argv[++arg];
+            }
+            else if((value == "--seed") && (arg+1 < argc))
+            {
+                options.seed = strtoul(argv[++arg], 0, 10);
+            }
+            else if((value == "--passes") && (arg+1 < argc))
             {
-                running = false;
+                options.passes = atoi(argv[++arg]);
             }
-            else if(!window.handleEvent(e))
+            else if((value == "--instances") && (arg+1 < argc))
             {
-                running = false;
+                options.instanceCount = atoi(argv[++arg]);
             }
+            else if((value == "--bind") && (arg+1 < argc))
+            {
+                options.bindings.push_back(argv[++arg]);
+            }
+            else if(options.objectPath.empty())
+            {
+                options.objectPath = value;
+            }
+            else
+            {
+                options.eventCount = atoi(value.c_str());
+            }
+        }
+        int result = runEventBenchmark(options);
+        SDL_Quit();
+        return result;
+    }
+
+    std::string object_path(argv[1]);
+    RenderMode renderMode = RENDER_ON_DEMAND;
+    double targetFPS = 60.0;
+    double reportSeconds = 0.0;
+    std::vector<std::string> bindings;
+    std::string recordPath;
+    for(int arg=2; arg<argc; arg++)
+    {
+        std::string value(argv[arg]);
+        if((value == "--render") && (arg+1 < argc))
+        {
+            std::string mode(argv[++arg]);
+            renderMode = (mode == "fixed") ? RENDER_FIXED_RATE :
+                         (mode == "unthrottled") ? RENDER_UNTHROTTLED : RENDER_ON_DEMAND;
+        }
+        else if((value == "--fps") && (arg+1 < argc))
+        {
+            targetFPS = atof(argv[++arg]);
+        }
+        else if(value == "--frame-stats")
+        {
+            reportSeconds = 5.0;
+        }
+        else if((value == "--bind") && (arg+1 < argc))
+        {
+            bindings.push_back(argv[++arg]);
+        }
+        else if((value == "--record") && (arg+1 < argc))
+        {
+            recordPath = argv[++arg];
+        }
+    }
+
+    // NOTE: Frames are only drawn when something changes by default (rather than continuously with
+    //       a sleep in between), so a still scene doesn't use any CPU and input isn't kept waiting
+    FrameScheduler scheduler(renderMode, targetFPS);
+    OpenGLWindow window;
+    window.object_1 = object_path;
+    window.vsync = scheduler.wantsVsync();
+    for(size_t i=0; i<bindings.size(); i++)
+    {
+        if(!window.keyBindings.bind(bindings[i]))
+        {
+            std::cout << "Unable to bind " << bindings[i] << " (expected <key name>=<command>)" << std::endl;
         }
-        window.render();
+    }
+    InputRecording recording;
+    if(!recordPath.empty())
+    {
+        window.recording = &recording;
+    }
+    window.initGL();
+
+    runEventLoop(window, scheduler, reportSeconds);
 
-        // We sleep for 10ms here so as to prevent excessive CPU usage
-        SDL_Delay(10);
+    if(!recordPath.empty())
+    {
+        if(recording.save(recordPath))
+        {
+            std::cout << "Recorded " << recording.events().size() << " events to " << recordPath << std::endl;
+        }
+        else
+        {
+            std::cout << "Unable to write the input recording to " << recordPath << std::endl;
+        }
     }
 
     window.cleanup();
@@ -0,0 +1,149 @@
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile()
+{
+    mappedData = 0;
+    mappedSize = 0;
+    opened = false;
+#ifdef _WIN32
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = 0;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+#ifdef _WIN32
+    fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if(fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(fileHandle, &fileSize))
+    {
+        close();
+        return false;
+    }
+    mappedSize = (size_t)fileSize.QuadPart;
+
+    // NOTE: Windows refuses to map empty files, but an empty file is still a valid (empty) view
+    if(mappedSize > 0)
+    {
+        mappingHandle = CreateFileMappingA(fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+        if(!mappingHandle)
+        {
+            close();
+            return false;
+        }
+        mappedData = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        if(!mappedData)
+        {
+            close();
+            return false;
+        }
+    }
+    opened = true;
+    return true;
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    mappedSize = (size_t)fileStat.st_size;
+
+    if(mappedSize > 0)
+    {
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        // Fault the whole file in up front rather than one page at a time as the parser walks it
+        flags |= MAP_POPULATE;
+#endif
+        void* mapping = mmap(0, mappedSize, PROT_READ, flags, fd, 0);
+        if(mapping == MAP_FAILED)
+        {
+            ::close(fd);
+            mappedSize = 0;
+            return false;
+        }
+        // We read the whole file front to back, so let the kernel read ahead aggressively
+        madvise(mapping, mappedSize, MADV_SEQUENTIAL);
+        mappedData = (const char*)mapping;
+    }
+
+    // NOTE: The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    opened = true;
+    return true;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if(mappedData)
+    {
+        UnmapViewOfFile(mappedData);
+    }
+    if(mappingHandle)
+    {
+        CloseHandle(mappingHandle);
+    }
+    if(fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(fileHandle);
+    }
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = 0;
+#else
+    if(mappedData)
+    {
+        munmap((void*)mappedData, mappedSize);
+    }
+#endif
+    mappedData = 0;
+    mappedSize = 0;
+    opened = false;
+}
+
+bool MappedFile::isOpen() const
+{
+    return opened;
+}
+
+const char* MappedFile::data() const
+{
+    return mappedData;
+}
+
+size_t MappedFile::size() const
+{
+    return mappedSize;
+}
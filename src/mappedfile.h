@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <stddef.h>
+
+// A read-only view of a whole file, mapped straight into our address space so that parsers can
+// walk it as one contiguous block of memory without going through stream buffers
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& filename);
+    void close();
+
+    bool isOpen() const;
+    const char* data() const;
+    size_t size() const;
+
+private:
+    // NOTE: Mappings own OS handles, so copying one around would double-unmap
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* mappedData;
+    size_t mappedSize;
+    bool opened;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+#endif
@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "meshcache.h"
+#include "meshlets.h"
+
+std::string meshCachePath(const std::string& sourcePath)
+{
+    return sourcePath + ".meshcache";
+}
+
+static bool statMeshSource(const std::string& sourcePath, MeshSourceInfo* info)
+{
+#ifdef _WIN32
+    struct _stat64 fileStat;
+    if(_stat64(sourcePath.c_str(), &fileStat) != 0)
+    {
+        return false;
+    }
+#else
+    struct stat fileStat;
+    if(stat(sourcePath.c_str(), &fileStat) != 0)
+    {
+        return false;
+    }
+#endif
+    info->size = fileStat.st_size;
+    info->modifiedTime = fileStat.st_mtime;
+    info->hash = 0;
+    return true;
+}
+
+// NOTE: This doesn't need to be cryptographic, just fast and good at noticing edits. Four
+//       independent multiply-xorshift lanes over 8-byte words keep the multiplier busy, so hashing
+//       is much cheaper than even mapping the file in
+uint64_t hashMeshSource(const char* data, size_t size)
+{
+    const uint64_t prime = 0x9e3779b97f4a7c15ull;
+    uint64_t lanes[4] = {size, prime, ~size, ~prime};
+
+    size_t wordCount = size/8;
+    size_t index = 0;
+    for(; index+4<=wordCount; index+=4)
+    {
+        for(int lane=0; lane<4; lane++)
+        {
+            uint64_t word;
+            memcpy(&word, data + 8*(index+lane), 8);
+            lanes[lane] = (lanes[lane] ^ word) * prime;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+
+    uint64_t hash = lanes[0] ^ (lanes[1] * 3) ^ (lanes[2] * 5) ^ (lanes[3] * 7);
+    for(size_t byte=8*index; byte<size; byte++)
+    {
+        hash = (hash ^ (unsigned char)data[byte]) * prime;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+// Whether the arrays are the sizes the header's counts say they are, and every range of indices
+// the header and meshlets refer to is inside the index arrays. The arrays are handed out as they
+// are, so a cache that gets this wrong would have them read past their ends. The arrays have to
+// be known to fit in the mapping already
+static bool meshCacheArraysConsistent(const MeshCacheHeader* header, const char* data)
+{
+    const uint64_t* sizes = header->arraySizes;
+    uint64_t vertexCount = header->vertexCount;
+    uint64_t indexCount = header->indexCount;
+    if(((header->indexSize != 2) && (header->indexSize != 4)) ||
+       (sizes[MESH_CACHE_POSITIONS] != vertexCount*3*sizeof(float)) ||
+       !(header->arrayMask & (1 << MESH_CACHE_INDICES)) ||
+       (sizes[MESH_CACHE_INDICES] != indexCount*header->indexSize))
+    {
+        return false;
+    }
+    // Optional per-vertex arrays are either absent (size 0) or have one element per vertex
+    const uint64_t floatsPerVertex[3] = {2, 3, 4};
+    const int vertexArrays[3] = {MESH_CACHE_TEXCOORDS, MESH_CACHE_NORMALS, MESH_CACHE_TANGENTS};
+    for(int i=0; i<3; i++)
+    {
+        uint64_t size = sizes[vertexArrays[i]];
+        if((size != 0) && (size != vertexCount*floatsPerVertex[i]*sizeof(float)))
+        {
+            return false;
+        }
+    }
+
+    if(sizes[MESH_CACHE_LOD_INDICES] % header->indexSize != 0)
+    {
+        return false;
+    }
+    uint64_t totalIndexCount = indexCount + sizes[MESH_CACHE_LOD_INDICES]/header->indexSize;
+    for(uint32_t level=0; level<header->lodCount; level++)
+    {
+        if((uint64_t)header->lods[level].firstIndex + header->lods[level].indexCount >
+           totalIndexCount)
+        {
+            return false;
+        }
+    }
+
+    if(sizes[MESH_CACHE_MESHLETS] % sizeof(Meshlet) != 0)
+    {
+        return false;
+    }
+    const Meshlet* meshlets = (const Meshlet*)(data + header->arrayOffsets[MESH_CACHE_MESHLETS]);
+    size_t meshletCount = sizes[MESH_CACHE_MESHLETS]/sizeof(Meshlet);
+    for(size_t i=0; i<meshletCount; i++)
+    {
+        if((uint64_t)meshlets[i].firstIndex + 3*(uint64_t)meshlets[i].triangleCount > indexCount)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+const MeshCacheHeader* openMeshCache(const std::string& sourcePath, uint32_t processingFlags,
+                                     MappedFile* mapping)
+{
+    MeshSourceInfo source;
+    if(!statMeshSource(sourcePath, &source))
+    {
+        return 0;
+    }
+
+    if(!mapping->open(meshCachePath(sourcePath)) || (mapping->size() < sizeof(MeshCacheHeader)))
+    {
+        mapping->close();
+        return 0;
+    }
+
+    const MeshCacheHeader* header = (const MeshCacheHeader*)mapping->data();
+    bool valid = (header->magic == MESH_CACHE_MAGIC) &&
+                 (header->version == MESH_CACHE_VERSION) &&
+                 (header->headerSize == sizeof(MeshCacheHeader)) &&
+                 (header->processingFlags == processingFlags) &&
+                 (header->lodCount <= MESH_CACHE_MAX_LODS) &&
+                 (header->source.size == source.size) &&
+                 (header->source.modifiedTime == source.modifiedTime);
+    for(int array=0; valid && (array<MESH_CACHE_ARRAY_COUNT); array++)
+    {
+        if(header->arrayMask & (1 << array))
+        {
+            valid = (header->arrayOffsets[array] % MESH_CACHE_ALIGNMENT == 0) &&
+                    (header->arrayOffsets[array] <= mapping->size()) &&
+                    (header->arraySizes[array] <= mapping->size() - header->arrayOffsets[array]);
+        }
+        else
+        {
+            valid = (header->arraySizes[array] == 0);
+        }
+    }
+    valid = valid && meshCacheArraysConsistent(header, mapping->data());
+
+    // NOTE: Size and time alone miss edits that keep both (e.g. a restored backup), so the
+    //       contents have to match too. We only pay for reading the source once the cheap
+    //       checks have passed
+    if(valid)
+    {
+        MappedFile sourceFile;
+        valid = sourceFile.open(sourcePath) &&
+                (hashMeshSource(sourceFile.data(), sourceFile.size()) == header->source.hash);
+    }
+
+    if(!valid)
+    {
+        mapping->close();
+        return 0;
+    }
+    return header;
+}
+
+bool writeMeshCache(const std::string& sourcePath, const char* sourceData, size_t sourceSize,
+                    MeshCacheHeader header,
+                    const void* const arrays[MESH_CACHE_ARRAY_COUNT],
+                    const size_t arraySizes[MESH_CACHE_ARRAY_COUNT])
+{
+    if(!statMeshSource(sourcePath, &header.source) || (header.source.size != sourceSize))
+    {
+        return false;
+    }
+    header.source.hash = hashMeshSource(sourceData, sourceSize);
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.headerSize = sizeof(MeshCacheHeader);
+    header.arrayMask = 0;
+
+    uint64_t offset = sizeof(MeshCacheHeader);
+    for(int array=0; array<MESH_CACHE_ARRAY_COUNT; array++)
+    {
+        offset = (offset + MESH_CACHE_ALIGNMENT-1) & ~(uint64_t)(MESH_CACHE_ALIGNMENT-1);
+        header.arrayOffsets[array] = 0;
+        header.arraySizes[array] = 0;
+        if(arrays[array] && (arraySizes[array] > 0))
+        {
+            header.arrayMask |= (1 << array);
+            header.arrayOffsets[array] = offset;
+            header.arraySizes[array] = arraySizes[array];
+            offset += arraySizes[array];
+        }
+    }
+
+    // NOTE: We write to a temporary file and rename it into place, so that a crash halfway
+    //       through (or another instance loading at the same time) never sees a partial cache
+    std::string cachePath = meshCachePath(sourcePath);
+    std::string tempPath = cachePath + ".tmp";
+    FILE* cacheFile = fopen(tempPath.c_str(), "wb");
+    if(!cacheFile)
+    {
+        return false;
+    }
+
+    bool success = (fwrite(&header, sizeof(header), 1, cacheFile) == 1);
+    uint64_t written = sizeof(header);
+    const char padding[MESH_CACHE_ALIGNMENT] = {};
+    for(int array=0; success && (array<MESH_CACHE_ARRAY_COUNT); array++)
+    {
+        if(!(header.arrayMask & (1 << array)))
+        {
+            continue;
+        }
+        size_t paddingSize = header.arrayOffsets[array] - written;
+        success = (fwrite(padding, 1, paddingSize, cacheFile) == paddingSize) &&
+                  (fwrite(arrays[array], 1, arraySizes[array], cacheFile) == arraySizes[array]);
+        written = header.arrayOffsets[array] + arraySizes[array];
+    }
+    success = (fclose(cacheFile) == 0) && success;
+
+    if(success)
+    {
+        remove(cachePath.c_str());
+        success = (rename(tempPath.c_str(), cachePath.c_str()) == 0);
+    }
+    if(!success)
+    {
+        remove(tempPath.c_str());
+    }
+    return success;
+}
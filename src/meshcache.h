@@ -0,0 +1,112 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "mappedfile.h"
+
+// A binary mesh cache file is a MeshCacheHeader followed by the arrays of a loaded GeometryData,
+// each starting on a MESH_CACHE_ALIGNMENT boundary. Since the file is mapped at a page boundary,
+// the arrays can be handed straight to the GPU from the mapping without any copying
+
+#define MESH_CACHE_MAGIC 0x48534d50 // "PMSH"
+#define MESH_CACHE_VERSION 7
+#define MESH_CACHE_ALIGNMENT 64
+#define MESH_CACHE_MAX_LODS 8
+
+// Processing that was applied to the mesh after parsing. A cache is only reused by a load that
+// asks for the same processing
+#define MESH_CACHE_OPTIMIZED 0x1
+#define MESH_CACHE_LODS 0x2
+// Normals were generated if the file had none, weighted by area rather than angle for the second
+#define MESH_CACHE_GENERATED_NORMALS 0x4
+#define MESH_CACHE_AREA_WEIGHTED_NORMALS 0x8
+#define MESH_CACHE_GENERATED_MESHLETS 0x10
+
+enum MeshCacheArray
+{
+    MESH_CACHE_POSITIONS,
+    MESH_CACHE_TEXCOORDS,
+    MESH_CACHE_NORMALS,
+    // 4 floats per vertex, the last being the handedness
+    MESH_CACHE_TANGENTS,
+    MESH_CACHE_INDICES,
+    // Indices of every level of detail after the full one, one after the other
+    MESH_CACHE_LOD_INDICES,
+    // Meshlet structs covering MESH_CACHE_INDICES (see meshlets.h)
+    MESH_CACHE_MESHLETS,
+    MESH_CACHE_ARRAY_COUNT
+};
+
+// Identifies the exact OBJ file a cache was built from, so a stale cache is never used
+struct MeshSourceInfo
+{
+    uint64_t size;
+    int64_t modifiedTime;
+    uint64_t hash;
+};
+
+// A level of detail, as a range of the index buffer made of MESH_CACHE_INDICES followed by
+// MESH_CACHE_LOD_INDICES (see GeometryLOD)
+struct MeshCacheLOD
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+    uint32_t reserved;
+};
+
+struct MeshCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t processingFlags;
+
+    MeshSourceInfo source;
+
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexSize;
+    // One bit per MeshCacheArray that is present in the file
+    uint32_t arrayMask;
+
+    float boundsMin[3];
+    float boundsMax[3];
+
+    // Levels of detail including the full one, or 0 if none were generated
+    uint32_t lodCount;
+    // See GeometryData::boundingRadius
+    float boundingRadius;
+    // The crease angle normals were generated with (see GeometryLoadOptions), if they were
+    float creaseAngle;
+    uint32_t reserved;
+    MeshCacheLOD lods[MESH_CACHE_MAX_LODS];
+
+    // Byte offsets and sizes of each array from the start of the file
+    uint64_t arrayOffsets[MESH_CACHE_ARRAY_COUNT];
+    uint64_t arraySizes[MESH_CACHE_ARRAY_COUNT];
+};
+
+// The cache for an OBJ file lives next to it, with ".meshcache" appended to the name
+std::string meshCachePath(const std::string& sourcePath);
+
+uint64_t hashMeshSource(const char* data, size_t size);
+
+// Maps the cache for an OBJ file and checks it against the file's current size, modification time
+// and contents, and against the processing flags. Returns the header (pointing into the mapping)
+// or 0 if the cache is missing, corrupt or stale
+const MeshCacheHeader* openMeshCache(const std::string& sourcePath, uint32_t processingFlags,
+                                     MappedFile* mapping);
+
+// Writes the cache for an OBJ file whose contents are sourceData. Arrays that are absent may be
+// 0. The source info, offsets, sizes and array mask of the header are filled in here, everything
+// else (including the processing flags) is up to the caller
+bool writeMeshCache(const std::string& sourcePath, const char* sourceData, size_t sourceSize,
+                    MeshCacheHeader header,
+                    const void* const arrays[MESH_CACHE_ARRAY_COUNT],
+                    const size_t arraySizes[MESH_CACHE_ARRAY_COUNT]);
+
+#endif
@@ -0,0 +1,323 @@
+#include "meshlets.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+using namespace std;
+
+// Cones whose normals spread further than about 84 degrees from the axis are only culled from a
+// sliver of viewpoints, so they're marked as never culled instead
+static const float MIN_CONE_DOT = 0.1f;
+
+static const unsigned int NO_TRIANGLE = ~0u;
+static const unsigned int NO_MESHLET = ~0u;
+
+static inline float dot3(const float* a, const float* b)
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+// Unit normal of a triangle, or zero for one with no area
+static void triangleNormal(const unsigned int* triangle, const float* positions, float* normal)
+{
+    const float* p0 = &positions[3*triangle[0]];
+    const float* p1 = &positions[3*triangle[1]];
+    const float* p2 = &positions[3*triangle[2]];
+    float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    normal[0] = e1[1]*e2[2] - e1[2]*e2[1];
+    normal[1] = e1[2]*e2[0] - e1[0]*e2[2];
+    normal[2] = e1[0]*e2[1] - e1[1]*e2[0];
+    float length = sqrtf(dot3(normal, normal));
+    float scale = (length > 0.0f) ? 1.0f/length : 0.0f;
+    for(int k=0; k<3; k++)
+    {
+        normal[k] *= scale;
+    }
+}
+
+// Whether a triangle faces close enough to a meshlet's average normal to join it. Triangles with no
+// area (and meshlets made only of them so far) go with anything
+static inline bool canJoin(const float* normal, const float* axis, float minJoinDot)
+{
+    return (dot3(normal, normal) == 0.0f) || (dot3(axis, axis) == 0.0f) ||
+           (dot3(normal, axis) >= minJoinDot);
+}
+
+// Bounding sphere (around the middle of the vertices' box) and normal cone of a finished meshlet.
+// The cone's axis is the average of the triangles' normals and its cutoff comes from the normal
+// furthest from it. The apex is pulled back along the axis until it's behind (or on) the plane of
+// every triangle, which is what makes looking down the cone from anywhere inside it see only backs
+static void computeBounds(Meshlet* meshlet, const unsigned int* vertices,
+                          const unsigned int* triangles, const unsigned int* indices,
+                          const float* positions, const float* normals)
+{
+    float boxMin[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float boxMax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for(unsigned int i=0; i<meshlet->vertexCount; i++)
+    {
+        const float* p = &positions[3*vertices[i]];
+        for(int k=0; k<3; k++)
+        {
+            boxMin[k] = min(boxMin[k], p[k]);
+            boxMax[k] = max(boxMax[k], p[k]);
+        }
+    }
+    float radiusSquared = 0.0f;
+    for(int k=0; k<3; k++)
+    {
+        meshlet->center[k] = 0.5f*(boxMin[k] + boxMax[k]);
+    }
+    for(unsigned int i=0; i<meshlet->vertexCount; i++)
+    {
+        const float* p = &positions[3*vertices[i]];
+        float offset[3] = {p[0] - meshlet->center[0], p[1] - meshlet->center[1],
+                           p[2] - meshlet->center[2]};
+        radiusSquared = max(radiusSquared, dot3(offset, offset));
+    }
+    meshlet->radius = sqrtf(radiusSquared);
+
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    for(unsigned int i=0; i<meshlet->triangleCount; i++)
+    {
+        const float* n = &normals[3*triangles[i]];
+        for(int k=0; k<3; k++)
+        {
+            axis[k] += n[k];
+        }
+    }
+    float axisLength = sqrtf(dot3(axis, axis));
+    float minimumDot = -1.0f;
+    if(axisLength > 0.0f)
+    {
+        minimumDot = 1.0f;
+        for(int k=0; k<3; k++)
+        {
+            axis[k] /= axisLength;
+        }
+        for(unsigned int i=0; i<meshlet->triangleCount; i++)
+        {
+            // Triangles with no area can't be seen from anywhere, so they don't widen the cone
+            const float* n = &normals[3*triangles[i]];
+            if(dot3(n, n) > 0.0f)
+            {
+                minimumDot = min(minimumDot, dot3(n, axis));
+            }
+        }
+    }
+
+    for(int k=0; k<3; k++)
+    {
+        meshlet->coneAxis[k] = axis[k];
+        meshlet->coneApex[k] = meshlet->center[k];
+    }
+    if(minimumDot <= MIN_CONE_DOT)
+    {
+        meshlet->coneCutoff = 2.0f;
+        return;
+    }
+
+    // NOTE: Every normal is within MIN_CONE_DOT of the axis here, so the divisions are safe
+    float furthest = -FLT_MAX;
+    for(unsigned int i=0; i<meshlet->triangleCount; i++)
+    {
+        const float* n = &normals[3*triangles[i]];
+        if(dot3(n, n) == 0.0f)
+        {
+            continue;
+        }
+        const float* p0 = &positions[3*indices[3*triangles[i]]];
+        float toCenter[3] = {meshlet->center[0] - p0[0], meshlet->center[1] - p0[1],
+                             meshlet->center[2] - p0[2]};
+        furthest = max(furthest, dot3(toCenter, n)/dot3(axis, n));
+    }
+    for(int k=0; k<3; k++)
+    {
+        meshlet->coneApex[k] = meshlet->center[k] - axis[k]*furthest;
+    }
+    meshlet->coneCutoff = sqrtf(1.0f - minimumDot*minimumDot);
+}
+
+void buildMeshlets(unsigned int* indices, size_t indexCount, const float* positions,
+                   size_t vertexCount, std::vector<Meshlet>* meshlets, float coneWeight,
+                   float minJoinDot)
+{
+    size_t triangleCount = indexCount/3;
+    if(triangleCount == 0)
+    {
+        return;
+    }
+
+    vector<float> normals(3*triangleCount);
+    for(size_t t=0; t<triangleCount; t++)
+    {
+        triangleNormal(&indices[3*t], positions, &normals[3*t]);
+    }
+
+    // The triangles around each vertex, as ranges of one array
+    vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+    for(size_t i=0; i<indexCount; i++)
+    {
+        adjacencyOffsets[indices[i] + 1]++;
+    }
+    for(size_t v=0; v<vertexCount; v++)
+    {
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    }
+    vector<unsigned int> adjacency(3*triangleCount);
+    vector<unsigned int> nextSlot(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for(size_t i=0; i<3*triangleCount; i++)
+    {
+        adjacency[nextSlot[indices[i]]++] = i/3;
+    }
+
+    // NOTE: A vertex belongs to the meshlet being built when it's marked with the meshlet's
+    //       number, so nothing has to be cleared between meshlets
+    vector<unsigned int> vertexMeshlet(vertexCount, NO_MESHLET);
+    vector<char> emitted(triangleCount, 0);
+    vector<unsigned int> reordered;
+    reordered.reserve(3*triangleCount);
+    unsigned int meshletVertices[MESHLET_MAX_VERTICES];
+    unsigned int meshletTriangles[MESHLET_MAX_TRIANGLES];
+    size_t nextSeed = 0;
+    while(reordered.size() < 3*triangleCount)
+    {
+        unsigned int id = meshlets->size();
+        Meshlet meshlet;
+        meshlet.firstIndex = reordered.size();
+        meshlet.triangleCount = 0;
+        meshlet.vertexCount = 0;
+        float normalSum[3] = {0.0f, 0.0f, 0.0f};
+
+        while(emitted[nextSeed])
+        {
+            nextSeed++;
+        }
+        unsigned int triangle = nextSeed;
+        while(triangle != NO_TRIANGLE)
+        {
+            emitted[triangle] = 1;
+            meshletTriangles[meshlet.triangleCount++] = triangle;
+            for(int k=0; k<3; k++)
+            {
+                unsigned int vertex = indices[3*triangle + k];
+                reordered.push_back(vertex);
+                if(vertexMeshlet[vertex] != id)
+                {
+                    vertexMeshlet[vertex] = id;
+                    meshletVertices[meshlet.vertexCount++] = vertex;
+                }
+                normalSum[k] += normals[3*triangle + k];
+            }
+            if(meshlet.triangleCount == MESHLET_MAX_TRIANGLES)
+            {
+                break;
+            }
+
+            float axis[3] = {normalSum[0], normalSum[1], normalSum[2]};
+            float axisLength = sqrtf(dot3(axis, axis));
+            for(int k=0; k<3; k++)
+            {
+                axis[k] = (axisLength > 0.0f) ? axis[k]/axisLength : 0.0f;
+            }
+
+            // The unused triangle touching the meshlet that adds the fewest vertices, with ties
+            // (and near ties) going to the one that keeps the normals closest together
+            triangle = NO_TRIANGLE;
+            float bestScore = FLT_MAX;
+            for(unsigned int slot=0; slot<meshlet.vertexCount; slot++)
+            {
+                unsigned int vertex = meshletVertices[slot];
+                for(unsigned int a=adjacencyOffsets[vertex]; a<adjacencyOffsets[vertex + 1]; a++)
+                {
+                    unsigned int candidate = adjacency[a];
+                    if(emitted[candidate])
+                    {
+                        continue;
+                    }
+                    const unsigned int* corners = &indices[3*candidate];
+                    unsigned int added = (vertexMeshlet[corners[0]] != id) +
+                                         (vertexMeshlet[corners[1]] != id) +
+                                         (vertexMeshlet[corners[2]] != id);
+                    if(meshlet.vertexCount + added > MESHLET_MAX_VERTICES)
+                    {
+                        continue;
+                    }
+                    const float* normal = &normals[3*candidate];
+                    if(!canJoin(normal, axis, minJoinDot))
+                    {
+                        continue;
+                    }
+                    float score = added + coneWeight*(1.0f - dot3(normal, axis));
+                    if(score < bestScore)
+                    {
+                        bestScore = score;
+                        triangle = candidate;
+                    }
+                }
+            }
+
+            // Nothing connected fits (the end of a separate piece of the mesh, or a sharp bend), so
+            // carry on with the next triangle in order, which is usually nearby in an optimized mesh
+            if(triangle == NO_TRIANGLE)
+            {
+                while((nextSeed < triangleCount) && emitted[nextSeed])
+                {
+                    nextSeed++;
+                }
+                if(nextSeed < triangleCount)
+                {
+                    const unsigned int* corners = &indices[3*nextSeed];
+                    unsigned int added = (vertexMeshlet[corners[0]] != id) +
+                                         (vertexMeshlet[corners[1]] != id) +
+                                         (vertexMeshlet[corners[2]] != id);
+                    if((meshlet.vertexCount + added <= MESHLET_MAX_VERTICES) &&
+                       canJoin(&normals[3*nextSeed], axis, minJoinDot))
+                    {
+                        triangle = nextSeed;
+                    }
+                }
+            }
+        }
+
+        computeBounds(&meshlet, meshletVertices, meshletTriangles, indices, positions,
+                      normals.data());
+        meshlets->push_back(meshlet);
+    }
+
+    std::copy(reordered.begin(), reordered.end(), indices);
+}
+
+size_t cullMeshlets(const Meshlet* meshlets, size_t count, const glm::vec4 planes[6],
+                    const glm::vec3& cameraPosition, unsigned char* visible)
+{
+    size_t visibleCount = 0;
+    for(size_t i=0; i<count; i++)
+    {
+        const Meshlet& meshlet = meshlets[i];
+        glm::vec3 center(meshlet.center[0], meshlet.center[1], meshlet.center[2]);
+        bool inside = true;
+        for(int p=0; p<6; p++)
+        {
+            if(glm::dot(glm::vec3(planes[p]), center) + planes[p].w < -meshlet.radius)
+            {
+                inside = false;
+            }
+        }
+
+        // NOTE: dot(normalize(apex - camera), axis) >= cutoff, without dividing by the length
+        bool facing = true;
+        if(inside && (meshlet.coneCutoff <= 1.0f))
+        {
+            glm::vec3 toApex = glm::vec3(meshlet.coneApex[0], meshlet.coneApex[1],
+                                         meshlet.coneApex[2]) - cameraPosition;
+            glm::vec3 axis(meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2]);
+            facing = glm::dot(toApex, axis) < meshlet.coneCutoff*glm::length(toApex);
+        }
+
+        visible[i] = inside && facing;
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
@@ -0,0 +1,62 @@
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include <vector>
+#include <stddef.h>
+#include <glm/glm.hpp>
+
+// Splits a mesh into small clusters of neighbouring triangles (meshlets) that can each be culled
+// on their own, which is much finer than culling a whole dense object. Every meshlet has a
+// bounding sphere for frustum culling, and a cone that holds the normals of all its triangles: when
+// the camera is inside the cone's backwards extension, every triangle in the meshlet faces away
+// from it and the whole meshlet can be skipped
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+// Defaults for how tight buildMeshlets keeps the cones (see there). Triangles more than about 45
+// degrees from a meshlet's average don't join it, and the weight is high enough to outweigh a new
+// vertex, so it picks a neighbour facing the same way over one that shares more vertices. On
+// dragon.obj this culls a fifth of the triangles by cones from the side (from 15.5% with 0.5 and
+// 0.5), for half as many meshlets again (see bench_meshlets)
+#define MESHLET_CONE_WEIGHT 16.0f
+#define MESHLET_MIN_JOIN_DOT 0.7f
+
+// A meshlet is a contiguous range of the index buffer. Everything is in model space. The layout is
+// fixed (it's saved in mesh caches as it is)
+struct Meshlet
+{
+    unsigned int firstIndex;
+    unsigned int triangleCount;
+    unsigned int vertexCount;
+    float center[3];
+    float radius;
+    // The meshlet faces away from a camera at p when dot(normalize(coneApex - p), coneAxis) is at
+    // least coneCutoff, which is more than 1 for meshlets whose normals are too spread out to say
+    float coneApex[3];
+    float coneAxis[3];
+    float coneCutoff;
+};
+
+// Reorders the triangles of an index buffer so that each meshlet's triangles come one after the
+// other, and appends the meshlets to meshlets. Each one is grown from a seed triangle by adding
+// the neighbouring triangle that brings in the fewest new vertices and whose normal is closest to
+// the meshlet's, until it's full or runs out of neighbours that face roughly the same way. Seeds
+// are taken in index buffer order, so a cache optimized mesh keeps most of its vertex cache
+// locality. positions are x, y, z floats.
+// coneWeight is how much a neighbour whose normal points away from the meshlet's average counts
+// against it, in new vertices (a normal at right angles costs this much), and a triangle whose
+// normal is further from the average than minJoinDot (a cosine) doesn't join at all. Raising
+// either gives tighter cones, which get culled from more viewpoints, but smaller meshlets with
+// more vertices per triangle
+void buildMeshlets(unsigned int* indices, size_t indexCount, const float* positions,
+                   size_t vertexCount, std::vector<Meshlet>* meshlets,
+                   float coneWeight = MESHLET_CONE_WEIGHT, float minJoinDot = MESHLET_MIN_JOIN_DOT);
+
+// Sets visible[i] to 1 for every meshlet that is at least partly inside the frustum and has a
+// triangle facing the camera, and to 0 for the rest, and returns how many were visible. The planes
+// (see extractFrustumPlanes) and camera position have to be in the meshes' model space
+size_t cullMeshlets(const Meshlet* meshlets, size_t count, const glm::vec4 planes[6],
+                    const glm::vec3& cameraPosition, unsigned char* visible);
+
+#endif
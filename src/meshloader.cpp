@@ -0,0 +1,126 @@
+#include <iostream>
+#include <algorithm>
+
+#include "meshloader.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+MeshLoader::MeshLoader(int threadCount) : pool(threadCount)
+{
+    nextRequest = 0;
+    stopping = false;
+}
+
+MeshLoader::~MeshLoader()
+{
+    lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+}
+
+int MeshLoader::request(const std::string& path, const GeometryLoadOptions& options,
+                        bool packedVertices)
+{
+    MeshLoadProgress progress;
+    progress.path = path;
+    progress.step = "queued";
+    progress.requested = Clock::now();
+    {
+        lock_guard<std::mutex> lock(mutex);
+        progress.request = nextRequest++;
+        running.push_back(progress);
+    }
+
+    // NOTE: The parse splits the file over every core by default, which would leave the render
+    //       thread fighting the workers for time, so background loads keep one core free
+    GeometryLoadOptions loadOptions = options;
+    if(loadOptions.threadCount <= 0)
+    {
+        loadOptions.threadCount = std::max(ThreadPool::hardwareThreadCount() - 1, 1);
+    }
+    int request = progress.request;
+    pool.enqueue([=]() { load(request, path, loadOptions, packedVertices); });
+    return request;
+}
+
+bool MeshLoader::poll(LoadedMesh* loaded)
+{
+    lock_guard<std::mutex> lock(mutex);
+    if(finished.empty())
+    {
+        return false;
+    }
+    *loaded = std::move(finished.front());
+    finished.pop_front();
+    return true;
+}
+
+int MeshLoader::pendingCount()
+{
+    lock_guard<std::mutex> lock(mutex);
+    return running.size() + finished.size();
+}
+
+void MeshLoader::progress(std::vector<MeshLoadProgress>* loads)
+{
+    lock_guard<std::mutex> lock(mutex);
+    *loads = running;
+}
+
+void MeshLoader::load(int request, const std::string& path, GeometryLoadOptions options,
+                      bool packedVertices)
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        if(stopping)
+        {
+            return;
+        }
+    }
+    Clock::time_point start = Clock::now();
+    options.progress = [=](const char* step) { setStep(request, step); };
+
+    LoadedMesh loaded;
+    loaded.request = request;
+    loaded.path = path;
+    loaded.mesh.reset(new SceneMesh());
+    loaded.mesh->path = path;
+    loaded.mesh->users = 0;
+    loaded.mesh->geometry.loadFromOBJFile(path, options);
+    if(loaded.mesh->geometry.indexCount() == 0)
+    {
+        cout << "Not adding " << path << " to the scene since it has no triangles" << endl;
+        loaded.mesh.reset();
+    }
+    else
+    {
+        setStep(request, "packing");
+        GLMesh::prepare(loaded.mesh->geometry, packedVertices, &loaded.gpuData);
+    }
+    loaded.loadMilliseconds = chrono::duration<double, milli>(Clock::now() - start).count();
+
+    lock_guard<std::mutex> lock(mutex);
+    for(size_t i=0; i<running.size(); i++)
+    {
+        if(running[i].request == request)
+        {
+            loaded.requested = running[i].requested;
+            running.erase(running.begin() + i);
+            break;
+        }
+    }
+    finished.push_back(std::move(loaded));
+}
+
+void MeshLoader::setStep(int request, const char* step)
+{
+    lock_guard<std::mutex> lock(mutex);
+    for(size_t i=0; i<running.size(); i++)
+    {
+        if(running[i].request == request)
+        {
+            running[i].step = step;
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef MESH_LOADER_H
+#define MESH_LOADER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+#include "geometry.h"
+#include "glmesh.h"
+#include "scene.h"
+#include "threadpool.h"
+
+// Where a MeshLoader request has got to
+struct MeshLoadProgress
+{
+    int request;
+    std::string path;
+    // What the worker is doing: "queued", "packing" or one of the steps of
+    // GeometryData::loadFromOBJFile (see GeometryLoadOptions::progress)
+    const char* step;
+    std::chrono::steady_clock::time_point requested;
+};
+
+// A finished MeshLoader request, ready to be uploaded
+struct LoadedMesh
+{
+    int request;
+    std::string path;
+    // The mesh with its geometry loaded but nothing uploaded yet. Null when the file couldn't be
+    // loaded or has no triangles
+    std::unique_ptr<SceneMesh> mesh;
+    // What goes into the mesh's buffers (see GLMesh::beginUpload), partly pointing into its geometry
+    GLMeshData gpuData;
+    std::chrono::steady_clock::time_point requested;
+    // Time spent on the worker (not counting waiting in the queue)
+    double loadMilliseconds;
+};
+
+// Loads OBJ files on worker threads. Parsing, building the vertex arrays, LODs, optimization and
+// packing the vertices for the GPU all happen there, and nothing here touches GL: finished meshes
+// wait in a queue for the thread with the GL context to take with poll and upload
+class MeshLoader
+{
+public:
+    // Requests are worked on threadCount at a time
+    explicit MeshLoader(int threadCount = 1);
+    // Requests that haven't started are dropped, but one that is being loaded is finished first
+    ~MeshLoader();
+
+    // Queues a file to be loaded, and returns a number for the request
+    int request(const std::string& path, const GeometryLoadOptions& options, bool packedVertices);
+    // Takes the oldest finished load, if there is one. Never blocks
+    bool poll(LoadedMesh* loaded);
+    // Requests that haven't been taken by poll yet
+    int pendingCount();
+    // Where each of the requests that haven't finished has got to, oldest first
+    void progress(std::vector<MeshLoadProgress>* loads);
+
+private:
+    MeshLoader(const MeshLoader&);
+    MeshLoader& operator=(const MeshLoader&);
+
+    void load(int request, const std::string& path, GeometryLoadOptions options,
+              bool packedVertices);
+    void setStep(int request, const char* step);
+
+    std::mutex mutex;//guards everything below but the pool
+    std::vector<MeshLoadProgress> running;
+    std::deque<LoadedMesh> finished;
+    int nextRequest;
+    bool stopping;
+    // NOTE: Last, so that its workers are stopped before anything they use is destroyed
+    ThreadPool pool;
+};
+
+#endif
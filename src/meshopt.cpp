@@ -0,0 +1,434 @@
+#include "meshopt.h"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount,
+                                    size_t vertexCount, int cacheSize, VertexCacheModel model)
+{
+    VertexCacheStats stats;
+    stats.acmr = 0.0f;
+    stats.atvr = 0.0f;
+    if(indexCount < 3)
+    {
+        return stats;
+    }
+
+    size_t misses = 0;
+    size_t usedVertices = 0;
+    vector<bool> used(vertexCount, false);
+    if(model == VERTEX_CACHE_FIFO)
+    {
+        // NOTE: A vertex is in a FIFO cache exactly when fewer than cacheSize misses have
+        //       happened since it was inserted, so a miss counter per vertex is enough
+        vector<size_t> insertedAt(vertexCount, 0);
+        for(size_t i=0; i<indexCount; i++)
+        {
+            unsigned int vertex = indices[i];
+            if(!used[vertex] || (misses - insertedAt[vertex] >= (size_t)cacheSize))
+            {
+                insertedAt[vertex] = misses;
+                misses++;
+            }
+            if(!used[vertex])
+            {
+                used[vertex] = true;
+                usedVertices++;
+            }
+        }
+    }
+    else
+    {
+        vector<unsigned int> cache;
+        cache.reserve(cacheSize);
+        for(size_t i=0; i<indexCount; i++)
+        {
+            unsigned int vertex = indices[i];
+            vector<unsigned int>::iterator entry = find(cache.begin(), cache.end(), vertex);
+            if(entry == cache.end())
+            {
+                misses++;
+                if(cache.size() == (size_t)cacheSize)
+                {
+                    cache.pop_back();
+                }
+                cache.insert(cache.begin(), vertex);
+            }
+            else
+            {
+                rotate(cache.begin(), entry, entry + 1);
+            }
+            if(!used[vertex])
+            {
+                used[vertex] = true;
+                usedVertices++;
+            }
+        }
+    }
+
+    stats.acmr = (float)misses/(indexCount/3);
+    stats.atvr = (float)misses/usedVertices;
+    return stats;
+}
+
+// Tuning values from Forsyth's article
+static const int FORSYTH_CACHE_SIZE = 32;
+static const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+static const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+// Vertices with more triangles left than this all get the smallest valence boost
+static const int FORSYTH_MAX_VALENCE = 32;
+
+struct ForsythScoreTable
+{
+    float cachePositionScore[FORSYTH_CACHE_SIZE];
+    float valenceScore[FORSYTH_MAX_VALENCE + 1];
+};
+
+// NOTE: Scores only depend on the cache position and the number of triangles left, both of which
+//       are small integers, so a table saves calling powf twice per vertex update
+static void buildForsythScoreTable(ForsythScoreTable* table)
+{
+    for(int position=0; position<FORSYTH_CACHE_SIZE; position++)
+    {
+        if(position < 3)
+        {
+            // Vertices of the triangle just drawn get a fixed score, so that we don't favour
+            // strips over fans
+            table->cachePositionScore[position] = FORSYTH_LAST_TRIANGLE_SCORE;
+        }
+        else
+        {
+            float scale = 1.0f/(FORSYTH_CACHE_SIZE - 3);
+            table->cachePositionScore[position] =
+                powf(1.0f - (position - 3)*scale, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+    // Boost vertices with few triangles left, so we finish them off instead of leaving lone
+    // triangles behind that will need their vertices transformed again later
+    table->valenceScore[0] = 0.0f;
+    for(int valence=1; valence<=FORSYTH_MAX_VALENCE; valence++)
+    {
+        table->valenceScore[valence] =
+            FORSYTH_VALENCE_BOOST_SCALE*powf((float)valence, -FORSYTH_VALENCE_BOOST_POWER);
+    }
+}
+
+static float forsythVertexScore(const ForsythScoreTable& table, int cachePosition,
+                                unsigned int remainingTriangles)
+{
+    if(remainingTriangles == 0)
+    {
+        // No triangles left to draw with this vertex, so it shouldn't attract anything
+        return -1.0f;
+    }
+    float score = (cachePosition >= 0) ? table.cachePositionScore[cachePosition] : 0.0f;
+    return score + table.valenceScore[min(remainingTriangles, (unsigned int)FORSYTH_MAX_VALENCE)];
+}
+
+void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount)
+{
+    size_t triangleCount = indexCount/3;
+    if(triangleCount == 0)
+    {
+        return;
+    }
+
+    // Triangles using each vertex, as ranges in one flat array. The first remainingTriangles[v]
+    // entries of a vertex's range are the triangles that haven't been drawn yet
+    vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+    for(size_t i=0; i<triangleCount*3; i++)
+    {
+        firstTriangle[indices[i] + 1]++;
+    }
+    for(size_t v=0; v<vertexCount; v++)
+    {
+        firstTriangle[v + 1] += firstTriangle[v];
+    }
+    vector<unsigned int> remainingTriangles(vertexCount, 0);
+    vector<unsigned int> vertexTriangles(triangleCount*3);
+    for(size_t t=0; t<triangleCount; t++)
+    {
+        for(int corner=0; corner<3; corner++)
+        {
+            unsigned int vertex = indices[t*3 + corner];
+            vertexTriangles[firstTriangle[vertex] + remainingTriangles[vertex]] = t;
+            remainingTriangles[vertex]++;
+        }
+    }
+
+    ForsythScoreTable scoreTable;
+    buildForsythScoreTable(&scoreTable);
+
+    vector<int> cachePositions(vertexCount, -1);
+    vector<float> vertexScores(vertexCount);
+    for(size_t v=0; v<vertexCount; v++)
+    {
+        vertexScores[v] = forsythVertexScore(scoreTable, -1, remainingTriangles[v]);
+    }
+
+    vector<float> triangleScores(triangleCount);
+    vector<bool> drawn(triangleCount, false);
+    int bestTriangle = 0;
+    for(size_t t=0; t<triangleCount; t++)
+    {
+        triangleScores[t] = vertexScores[indices[t*3]] + vertexScores[indices[t*3 + 1]] +
+                            vertexScores[indices[t*3 + 2]];
+        if(triangleScores[t] > triangleScores[bestTriangle])
+        {
+            bestTriangle = t;
+        }
+    }
+
+    // The cache briefly holds 3 more vertices than its size, so that the ones pushed out by the
+    // latest triangle can have their scores updated
+    unsigned int cache[FORSYTH_CACHE_SIZE + 3];
+    unsigned int newCache[FORSYTH_CACHE_SIZE + 3];
+    int cacheCount = 0;
+
+    vector<unsigned int> output(triangleCount*3);
+    size_t nextUndrawn = 0;
+    for(size_t drawnCount=0; drawnCount<triangleCount; drawnCount++)
+    {
+        if(bestTriangle < 0)
+        {
+            // Nothing in the cache is connected to anything left, so start over somewhere new.
+            // Forsyth scans for the best remaining triangle here, but taking the next one in the
+            // original order keeps this linear and works just as well on real meshes
+            while(drawn[nextUndrawn])
+            {
+                nextUndrawn++;
+            }
+            bestTriangle = nextUndrawn;
+        }
+
+        const unsigned int* triangle = &indices[bestTriangle*3];
+        output[drawnCount*3] = triangle[0];
+        output[drawnCount*3 + 1] = triangle[1];
+        output[drawnCount*3 + 2] = triangle[2];
+        drawn[bestTriangle] = true;
+
+        int newCacheCount = 0;
+        for(int corner=0; corner<3; corner++)
+        {
+            unsigned int vertex = triangle[corner];
+            newCache[newCacheCount++] = vertex;
+
+            // Move the triangle past the end of the vertex's remaining triangles
+            unsigned int* begin = &vertexTriangles[firstTriangle[vertex]];
+            unsigned int* end = begin + remainingTriangles[vertex];
+            unsigned int* entry = find(begin, end, (unsigned int)bestTriangle);
+            swap(*entry, *(end - 1));
+            remainingTriangles[vertex]--;
+        }
+        for(int i=0; i<cacheCount; i++)
+        {
+            unsigned int vertex = cache[i];
+            if((vertex != triangle[0]) && (vertex != triangle[1]) && (vertex != triangle[2]))
+            {
+                newCache[newCacheCount++] = vertex;
+            }
+        }
+
+        // Rescore everything in the cache, including the vertices that just fell out of it,
+        // and pick the best triangle touching any of them to draw next
+        for(int i=0; i<newCacheCount; i++)
+        {
+            unsigned int vertex = newCache[i];
+            cachePositions[vertex] = (i < FORSYTH_CACHE_SIZE) ? i : -1;
+            vertexScores[vertex] = forsythVertexScore(scoreTable, cachePositions[vertex], remainingTriangles[vertex]);
+        }
+        bestTriangle = -1;
+        float bestScore = 0.0f;
+        for(int i=0; i<newCacheCount; i++)
+        {
+            unsigned int vertex = newCache[i];
+            const unsigned int* adjacent = &vertexTriangles[firstTriangle[vertex]];
+            for(unsigned int j=0; j<remainingTriangles[vertex]; j++)
+            {
+                unsigned int t = adjacent[j];
+                triangleScores[t] = vertexScores[indices[t*3]] + vertexScores[indices[t*3 + 1]] +
+                                    vertexScores[indices[t*3 + 2]];
+                if((i < FORSYTH_CACHE_SIZE) && (triangleScores[t] > bestScore))
+                {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cacheCount = min(newCacheCount, FORSYTH_CACHE_SIZE);
+        copy(newCache, newCache + cacheCount, cache);
+    }
+
+    copy(output.begin(), output.end(), indices);
+}
+
+struct TriangleCluster
+{
+    size_t firstIndex;
+    size_t indexCount;
+    float sortKey;
+};
+
+static bool drawClusterFirst(const TriangleCluster& a, const TriangleCluster& b)
+{
+    return a.sortKey > b.sortKey;
+}
+
+void optimizeOverdraw(unsigned int* indices, size_t indexCount,
+                      const float* positions, size_t vertexCount, int cacheSize)
+{
+    size_t triangleCount = indexCount/3;
+    if(triangleCount == 0)
+    {
+        return;
+    }
+
+    // Cut the triangle order wherever a triangle misses the cache on all three vertices. The
+    // optimizer has already run out of neighbours at those points, so moving the pieces around
+    // barely changes the number of vertices transformed. Tiny clusters are merged into the
+    // previous one since they aren't worth sorting on their own
+    const size_t minimumClusterTriangles = 16;
+    vector<TriangleCluster> clusters;
+    vector<size_t> insertedAt(vertexCount, 0);
+    vector<bool> seen(vertexCount, false);
+    size_t misses = 0;
+    for(size_t t=0; t<triangleCount; t++)
+    {
+        int triangleMisses = 0;
+        for(int corner=0; corner<3; corner++)
+        {
+            unsigned int vertex = indices[t*3 + corner];
+            if(!seen[vertex] || (misses - insertedAt[vertex] >= (size_t)cacheSize))
+            {
+                seen[vertex] = true;
+                insertedAt[vertex] = misses;
+                misses++;
+                triangleMisses++;
+            }
+        }
+        if(clusters.empty() ||
+           ((triangleMisses == 3) && (clusters.back().indexCount >= minimumClusterTriangles*3)))
+        {
+            TriangleCluster cluster;
+            cluster.firstIndex = t*3;
+            cluster.indexCount = 0;
+            cluster.sortKey = 0.0f;
+            clusters.push_back(cluster);
+        }
+        clusters.back().indexCount += 3;
+    }
+    if(clusters.size() < 2)
+    {
+        return;
+    }
+
+    // Area weighted centroid of the whole mesh
+    float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    float meshArea = 0.0f;
+    vector<float> clusterData(clusters.size()*7, 0.0f);
+    for(size_t c=0; c<clusters.size(); c++)
+    {
+        float* data = &clusterData[c*7];
+        for(size_t i=clusters[c].firstIndex; i<clusters[c].firstIndex + clusters[c].indexCount; i+=3)
+        {
+            const float* p0 = &positions[indices[i]*3];
+            const float* p1 = &positions[indices[i + 1]*3];
+            const float* p2 = &positions[indices[i + 2]*3];
+            float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            float normal[3] = {e1[1]*e2[2] - e1[2]*e2[1],
+                               e1[2]*e2[0] - e1[0]*e2[2],
+                               e1[0]*e2[1] - e1[1]*e2[0]};
+            float area = sqrtf(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+            for(int k=0; k<3; k++)
+            {
+                // Unnormalized face normals are already weighted by area
+                data[k] += area*(p0[k] + p1[k] + p2[k])/3.0f;
+                data[3 + k] += normal[k];
+            }
+            data[6] += area;
+        }
+        for(int k=0; k<3; k++)
+        {
+            meshCentroid[k] += data[k];
+        }
+        meshArea += data[6];
+    }
+    if(meshArea <= 0.0f)
+    {
+        return;
+    }
+    for(int k=0; k<3; k++)
+    {
+        meshCentroid[k] /= meshArea;
+    }
+
+    // Clusters that face away from the middle of the mesh are the ones that occlude the rest of
+    // it from most directions (Sander et al., "Fast Triangle Reordering for Vertex Locality and
+    // Reduced Overdraw"), so draw them first
+    for(size_t c=0; c<clusters.size(); c++)
+    {
+        const float* data = &clusterData[c*7];
+        float normalLength = sqrtf(data[3]*data[3] + data[4]*data[4] + data[5]*data[5]);
+        if((data[6] <= 0.0f) || (normalLength <= 0.0f))
+        {
+            continue;
+        }
+        for(int k=0; k<3; k++)
+        {
+            clusters[c].sortKey += (data[k]/data[6] - meshCentroid[k])*data[3 + k]/normalLength;
+        }
+    }
+    stable_sort(clusters.begin(), clusters.end(), drawClusterFirst);
+
+    vector<unsigned int> output;
+    output.reserve(triangleCount*3);
+    for(size_t c=0; c<clusters.size(); c++)
+    {
+        output.insert(output.end(), indices + clusters[c].firstIndex,
+                      indices + clusters[c].firstIndex + clusters[c].indexCount);
+    }
+    copy(output.begin(), output.end(), indices);
+}
+
+size_t optimizeVertexFetch(unsigned int* indices, size_t indexCount, size_t vertexCount,
+                           vector<unsigned int>* remap)
+{
+    remap->assign(vertexCount, ~0u);
+    unsigned int nextVertex = 0;
+    for(size_t i=0; i<indexCount; i++)
+    {
+        unsigned int& newIndex = (*remap)[indices[i]];
+        if(newIndex == ~0u)
+        {
+            newIndex = nextVertex++;
+        }
+        indices[i] = newIndex;
+    }
+    return nextVertex;
+}
+
+void remapVertexArray(vector<float>* array, int components,
+                      const vector<unsigned int>& remap, size_t newVertexCount)
+{
+    if(array->empty())
+    {
+        return;
+    }
+    vector<float> remapped(newVertexCount*components);
+    for(size_t v=0; v<remap.size(); v++)
+    {
+        if(remap[v] != ~0u)
+        {
+            copy(array->begin() + v*components, array->begin() + (v + 1)*components,
+                 remapped.begin() + remap[v]*components);
+        }
+    }
+    array->swap(remapped);
+}
@@ -0,0 +1,50 @@
+#ifndef MESH_OPT_H
+#define MESH_OPT_H
+
+#include <vector>
+#include <stddef.h>
+
+// Triangle and vertex reordering passes for indexed triangle lists. None of these change what
+// gets drawn, only the order it gets drawn in
+
+enum VertexCacheModel
+{
+    VERTEX_CACHE_FIFO,
+    VERTEX_CACHE_LRU
+};
+
+struct VertexCacheStats
+{
+    // Average cache miss ratio: vertex shader invocations per triangle. 3 is the worst case and
+    // ~0.5 is the best a regular grid can do
+    float acmr;
+    // Average transformed vertex ratio: vertex shader invocations per unique vertex. 1 is ideal
+    float atvr;
+};
+
+// Simulates a post-transform vertex cache of the given size over an index buffer. GPUs differ
+// in cache size and replacement policy, so it's worth looking at a couple of configurations
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount,
+                                    size_t vertexCount, int cacheSize, VertexCacheModel model);
+
+// Reorders triangles to maximise post-transform vertex cache hits, using Tom Forsyth's linear-speed
+// vertex cache optimisation (https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html)
+void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+// Splits an already cache-optimized triangle order into clusters at points where the cache would
+// have been flushed anyway, and sorts the clusters so that outward facing ones (which tend to
+// occlude the rest of the mesh) are drawn first. This cuts overdraw at a small cost in ACMR
+void optimizeOverdraw(unsigned int* indices, size_t indexCount,
+                      const float* positions, size_t vertexCount, int cacheSize);
+
+// Renumbers vertices in the order the index buffer first uses them, so vertex fetches walk
+// through memory sequentially. Fills remap with the new index of every old vertex (or ~0u for
+// vertices that are never used) and returns the number of vertices still in use
+size_t optimizeVertexFetch(unsigned int* indices, size_t indexCount, size_t vertexCount,
+                           std::vector<unsigned int>* remap);
+
+// Applies a remap from optimizeVertexFetch to an array with the given number of floats per vertex
+void remapVertexArray(std::vector<float>* array, int components,
+                      const std::vector<unsigned int>& remap, size_t newVertexCount);
+
+#endif
@@ -0,0 +1,227 @@
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "meshraycast.h"
+
+// Triangles per leaf, one SSE register's worth
+static const int LEAF_TRIANGLES = 4;
+
+// Moller-Trumbore ray/triangle intersection ("Fast, Minimum Storage Ray/Triangle Intersection").
+// Returns the distance along the ray, or -1 for a miss
+static float intersectTriangle(const glm::vec3& origin, const glm::vec3& direction,
+                               const glm::vec3& corner, const glm::vec3& edge1,
+                               const glm::vec3& edge2, float* u, float* v)
+{
+    glm::vec3 p = glm::cross(direction, edge2);
+    float determinant = glm::dot(edge1, p);
+    if(determinant == 0.0f)
+    {
+        return -1.0f;//the ray is parallel to the triangle
+    }
+    float inverseDeterminant = 1.0f/determinant;
+    glm::vec3 toOrigin = origin - corner;
+    *u = glm::dot(toOrigin, p)*inverseDeterminant;
+    glm::vec3 q = glm::cross(toOrigin, edge1);
+    *v = glm::dot(direction, q)*inverseDeterminant;
+    float distance = glm::dot(edge2, q)*inverseDeterminant;
+    if((*u < 0.0f) || (*v < 0.0f) || (*u + *v > 1.0f) || (distance < 0.0f))
+    {
+        return -1.0f;
+    }
+    return distance;
+}
+
+MeshRaycaster::MeshRaycaster()
+{
+}
+
+void MeshRaycaster::build(const float* positions, const unsigned int* indices, size_t indexCount)
+{
+    size_t count = indexCount/3;
+    std::vector<glm::vec3> boundsMin(count), boundsMax(count);
+    for(size_t triangle=0; triangle<count; triangle++)
+    {
+        glm::vec3 a(positions[3*indices[3*triangle]], positions[3*indices[3*triangle]+1],
+                    positions[3*indices[3*triangle]+2]);
+        glm::vec3 b(positions[3*indices[3*triangle+1]], positions[3*indices[3*triangle+1]+1],
+                    positions[3*indices[3*triangle+1]+2]);
+        glm::vec3 c(positions[3*indices[3*triangle+2]], positions[3*indices[3*triangle+2]+1],
+                    positions[3*indices[3*triangle+2]+2]);
+        boundsMin[triangle] = glm::min(a, glm::min(b, c));
+        boundsMax[triangle] = glm::max(a, glm::max(b, c));
+    }
+    hierarchy.build(boundsMin.data(), boundsMax.data(), count, LEAF_TRIANGLES);
+
+    const unsigned int* order = hierarchy.primitiveOrder();
+    for(int axis=0; axis<3; axis++)
+    {
+        corner[axis].assign(count + LEAF_TRIANGLES, 0.0f);
+        edge1[axis].assign(count + LEAF_TRIANGLES, 0.0f);
+        edge2[axis].assign(count + LEAF_TRIANGLES, 0.0f);
+        for(size_t i=0; i<count; i++)
+        {
+            const unsigned int* triangle = &indices[3*order[i]];
+            float a = positions[3*triangle[0] + axis];
+            corner[axis][i] = a;
+            edge1[axis][i] = positions[3*triangle[1] + axis] - a;
+            edge2[axis][i] = positions[3*triangle[2] + axis] - a;
+        }
+    }
+}
+
+bool MeshRaycaster::empty()
+{
+    return hierarchy.primitiveCount() == 0;
+}
+
+bool MeshRaycaster::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                            RayHit* hit)
+{
+    float hitU = 0.0f;
+    float hitV = 0.0f;
+    const unsigned int* order = hierarchy.primitiveOrder();
+
+#if defined(__SSE2__)
+    __m128 originX = _mm_set1_ps(origin.x), originY = _mm_set1_ps(origin.y), originZ = _mm_set1_ps(origin.z);
+    __m128 directionX = _mm_set1_ps(direction.x), directionY = _mm_set1_ps(direction.y),
+           directionZ = _mm_set1_ps(direction.z);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+#endif
+
+    float distance;
+    int triangle = hierarchy.raycastLeaves(origin, direction, maxDistance,
+        [&](unsigned int first, unsigned int count, float* closest)
+        {
+            int closestTriangle = -1;
+#if defined(__SSE2__)
+            // The same steps as intersectTriangle, on all the leaf's triangles at once
+            __m128 e1x = _mm_loadu_ps(&edge1[0][first]);
+            __m128 e1y = _mm_loadu_ps(&edge1[1][first]);
+            __m128 e1z = _mm_loadu_ps(&edge1[2][first]);
+            __m128 e2x = _mm_loadu_ps(&edge2[0][first]);
+            __m128 e2y = _mm_loadu_ps(&edge2[1][first]);
+            __m128 e2z = _mm_loadu_ps(&edge2[2][first]);
+
+            __m128 px = _mm_sub_ps(_mm_mul_ps(directionY, e2z), _mm_mul_ps(e2y, directionZ));
+            __m128 py = _mm_sub_ps(_mm_mul_ps(directionZ, e2x), _mm_mul_ps(e2z, directionX));
+            __m128 pz = _mm_sub_ps(_mm_mul_ps(directionX, e2y), _mm_mul_ps(e2x, directionY));
+            __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)),
+                                            _mm_mul_ps(e1z, pz));
+            __m128 inverseDeterminant = _mm_div_ps(one, determinant);
+
+            __m128 tx = _mm_sub_ps(originX, _mm_loadu_ps(&corner[0][first]));
+            __m128 ty = _mm_sub_ps(originY, _mm_loadu_ps(&corner[1][first]));
+            __m128 tz = _mm_sub_ps(originZ, _mm_loadu_ps(&corner[2][first]));
+            __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)),
+                                             _mm_mul_ps(tz, pz)), inverseDeterminant);
+
+            __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(e1y, tz));
+            __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(e1z, tx));
+            __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(e1x, ty));
+            __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(directionX, qx),
+                                                        _mm_mul_ps(directionY, qy)),
+                                             _mm_mul_ps(directionZ, qz)), inverseDeterminant);
+            __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)),
+                                             _mm_mul_ps(e2z, qz)), inverseDeterminant);
+
+            // NOTE: A zero determinant makes u, v and t infinite or NaN, which fail these anyway
+            __m128 valid = _mm_cmplt_ps(lanes, _mm_set1_ps((float)count));
+            valid = _mm_and_ps(valid, _mm_cmpneq_ps(determinant, zero));
+            valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+            valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+            valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), one));
+            valid = _mm_and_ps(valid, _mm_cmpge_ps(t, zero));
+            valid = _mm_and_ps(valid, _mm_cmplt_ps(t, _mm_set1_ps(*closest)));
+            int mask = _mm_movemask_ps(valid);
+            if(mask == 0)
+            {
+                return -1;
+            }
+
+            float distances[4], us[4], vs[4];
+            _mm_storeu_ps(distances, t);
+            _mm_storeu_ps(us, u);
+            _mm_storeu_ps(vs, v);
+            for(int lane=0; lane<4; lane++)
+            {
+                if(((mask >> lane) & 1) && (distances[lane] < *closest))
+                {
+                    *closest = distances[lane];
+                    hitU = us[lane];
+                    hitV = vs[lane];
+                    closestTriangle = order[first + lane];
+                }
+            }
+#else
+            for(unsigned int i=first; i<first+count; i++)
+            {
+                float u, v;
+                float t = intersectTriangle(origin, direction,
+                                            glm::vec3(corner[0][i], corner[1][i], corner[2][i]),
+                                            glm::vec3(edge1[0][i], edge1[1][i], edge1[2][i]),
+                                            glm::vec3(edge2[0][i], edge2[1][i], edge2[2][i]), &u, &v);
+                if((t >= 0.0f) && (t < *closest))
+                {
+                    *closest = t;
+                    hitU = u;
+                    hitV = v;
+                    closestTriangle = order[i];
+                }
+            }
+#endif
+            return closestTriangle;
+        }, &distance);
+
+    if(triangle < 0)
+    {
+        return false;
+    }
+    hit->triangle = triangle;
+    hit->u = hitU;
+    hit->v = hitV;
+    hit->distance = distance;
+    return true;
+}
+
+bool MeshRaycaster::raycastAll(const glm::vec3& origin, const glm::vec3& direction,
+                               float maxDistance, RayHit* hit)
+{
+    const unsigned int* order = hierarchy.primitiveOrder();
+    float closest = maxDistance;
+    bool found = false;
+    for(size_t i=0; i<hierarchy.primitiveCount(); i++)
+    {
+        float u, v;
+        float t = intersectTriangle(origin, direction,
+                                    glm::vec3(corner[0][i], corner[1][i], corner[2][i]),
+                                    glm::vec3(edge1[0][i], edge1[1][i], edge1[2][i]),
+                                    glm::vec3(edge2[0][i], edge2[1][i], edge2[2][i]), &u, &v);
+        if((t >= 0.0f) && (t < closest))
+        {
+            closest = t;
+            hit->triangle = order[i];
+            hit->u = u;
+            hit->v = v;
+            hit->distance = t;
+            found = true;
+        }
+    }
+    return found;
+}
+
+size_t MeshRaycaster::triangleCount()
+{
+    return hierarchy.primitiveCount();
+}
+
+size_t MeshRaycaster::memoryBytes()
+{
+    return hierarchy.nodeCount()*sizeof(BVHNode) +
+           hierarchy.primitiveCount()*(sizeof(unsigned int) + 2*sizeof(glm::vec3)) +
+           9*corner[0].size()*sizeof(float);
+}
@@ -0,0 +1,55 @@
+#ifndef MESH_RAYCAST_H
+#define MESH_RAYCAST_H
+
+#include <vector>
+#include <stddef.h>
+
+#include <glm/glm.hpp>
+
+#include "bvh.h"
+
+// Where a ray hit a triangle mesh
+struct RayHit
+{
+    // Triangle number (index of its first corner / 3 in the index buffer)
+    unsigned int triangle;
+    // Barycentric coordinates of the hit: weights of the second and third corners (the first
+    // gets 1 - u - v)
+    float u;
+    float v;
+    // Distance along the ray, in units of the ray direction's length
+    float distance;
+};
+
+// Casts rays against the triangles of a mesh, through a bounding volume hierarchy over them. The
+// triangles are copied into the hierarchy's leaf order as separate arrays of corner and edge
+// components, so the triangles of a leaf are tested 4 at a time with SSE
+class MeshRaycaster
+{
+public:
+    MeshRaycaster();
+
+    // Builds the hierarchy over a triangle list (3 floats per position)
+    void build(const float* positions, const unsigned int* indices, size_t indexCount);
+    bool empty();
+
+    // Finds the closest triangle (from either side) the ray hits before maxDistance. Returns
+    // false if it doesn't hit any
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit* hit);
+    // The same, testing every triangle one at a time, as a reference for the above
+    bool raycastAll(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit* hit);
+
+    size_t triangleCount();
+    // Bytes taken by the hierarchy and the triangle copies
+    size_t memoryBytes();
+
+private:
+    BoundingVolumeHierarchy hierarchy;
+    // Triangle data in the hierarchy's primitive order: the first corner and the two edges from
+    // it, one array per component, padded so 4 can always be loaded from any leaf
+    std::vector<float> corner[3];
+    std::vector<float> edge1[3];
+    std::vector<float> edge2[3];
+};
+
+#endif
@@ -0,0 +1,441 @@
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "normals.h"
+#include "threadpool.h"
+
+using namespace std;
+
+// Spelled out, since MSVC's math.h doesn't have M_PI
+static const float PI = 3.14159265f;
+// NOTE: Below a few tens of thousands of triangles waking threads up costs more than it saves
+static const size_t TRIANGLES_PER_THREAD = 65536;
+// Sorting the corners into ranges moves about three times as much memory as adding them up in
+// place, so without creases it's only worth it with at least this many threads
+static const int MIN_PARTITIONED_THREADS = 4;
+// The positions are cut into at least this many ranges per thread, so that a thread that finishes
+// its ranges early can pick up more while a thread with a dense part of the mesh is still busy,
+// and into ranges of at most 2^MAX_RANGE_SHIFT positions, so that sorting a range's corners stays
+// in cache while there are still few enough ranges that scattering corners into them doesn't
+// thrash the TLB. Ranges are a power of two positions long, so finding a position's range is a
+// shift
+static const int RANGES_PER_THREAD = 8;
+static const int MAX_RANGE_SHIFT = 13;
+
+// A triangle corner (3 per triangle, in triangle order), the position it's at, and its
+// triangle's unit normal and the weight it adds it with. Once its range has been summed up the
+// position is replaced by the index of its normal in the range's list
+struct PositionCorner
+{
+    unsigned int corner;
+    unsigned int position;
+    float normal[3];
+    float weight;
+};
+
+// Runs task(0) to task(taskCount-1), spread over the pool if there is one
+static void runTasks(ThreadPool* pool, int taskCount, const function<void(int)>& task)
+{
+    if(!pool)
+    {
+        for(int i=0; i<taskCount; i++)
+        {
+            task(i);
+        }
+        return;
+    }
+    for(int i=0; i<taskCount; i++)
+    {
+        pool->enqueue([&task, i]() { task(i); });
+    }
+    pool->wait();
+}
+
+// The angle whose sine and cosine are proportional to sine and cosine (sine being positive), to
+// within about 1e-5 radians. It's atan2 with a polynomial for the arctangent, which is several
+// times quicker than the C library's for something that's only used as a weight
+static inline float cornerAngle(float sine, float cosine)
+{
+    float x = fabsf(cosine);
+    if((sine == 0.0f) && (x == 0.0f))
+    {
+        return 0.0f;
+    }
+    bool steep = (sine > x);
+    float t = steep ? x/sine : sine/x;
+    float t2 = t*t;
+    float angle = t*(0.9998660f + t2*(-0.3302995f + t2*(0.1801410f +
+                     t2*(-0.0851330f + t2*0.0208351f))));
+    if(steep)
+    {
+        angle = 0.5f*PI - angle;
+    }
+    return (cosine < 0.0f) ? PI - angle : angle;
+}
+
+// The unit normal of a triangle (all zero if it has no area) and the weight each of its corners
+// adds it with
+static void faceNormal(const float* positions, const int* triangleCorners,
+                       NormalWeighting weighting, float normal[3], float weights[3])
+{
+    const float* p[3] =
+    {
+        &positions[3*triangleCorners[0]],
+        &positions[3*triangleCorners[1]],
+        &positions[3*triangleCorners[2]]
+    };
+    float e1[3], e2[3];
+    for(int i=0; i<3; i++)
+    {
+        e1[i] = p[1][i] - p[0][i];
+        e2[i] = p[2][i] - p[0][i];
+    }
+    float cross[3] =
+    {
+        e1[1]*e2[2] - e1[2]*e2[1],
+        e1[2]*e2[0] - e1[0]*e2[2],
+        e1[0]*e2[1] - e1[1]*e2[0]
+    };
+    // Twice the area, and also the length of the cross product of the two edges at any corner
+    float length = sqrtf(cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]);
+    float scale = (length > 0.0f) ? 1.0f/length : 0.0f;
+    normal[0] = cross[0]*scale;
+    normal[1] = cross[1]*scale;
+    normal[2] = cross[2]*scale;
+
+    for(int corner=0; corner<3; corner++)
+    {
+        if(weighting == NORMAL_WEIGHT_AREA)
+        {
+            weights[corner] = length;
+            continue;
+        }
+        const float* a = p[corner];
+        const float* b = p[(corner + 1)%3];
+        const float* c = p[(corner + 2)%3];
+        float dot = (b[0] - a[0])*(c[0] - a[0]) + (b[1] - a[1])*(c[1] - a[1]) +
+                    (b[2] - a[2])*(c[2] - a[2]);
+        weights[corner] = cornerAngle(length, dot);
+    }
+}
+
+static void appendNormal(vector<float>* normals, const float sum[3])
+{
+    float length = sqrtf(sum[0]*sum[0] + sum[1]*sum[1] + sum[2]*sum[2]);
+    if(length > 0.0f)
+    {
+        normals->push_back(sum[0]/length);
+        normals->push_back(sum[1]/length);
+        normals->push_back(sum[2]/length);
+    }
+    else
+    {
+        // Only degenerate triangles (or ones facing exactly opposite ways) meet here, so there's
+        // no right answer, but a unit vector keeps the lighting finite
+        normals->push_back(0.0f);
+        normals->push_back(0.0f);
+        normals->push_back(1.0f);
+    }
+}
+
+// Without creases and with few threads, every corner adds its triangle straight into its
+// position's sum on one thread. The sums are made in the same (triangle) order as the ranges
+// below make them, so this gives exactly the same normals, just without sorting the corners first
+static size_t smoothNormalsInPlace(const float* positions, size_t positionCount,
+                                   const int* corners, int* cornerNormals, size_t stride,
+                                   size_t triangleCount, NormalWeighting weighting,
+                                   std::vector<float>* normals)
+{
+    vector<float> sums(3*positionCount, 0.0f);
+    vector<int> positionNormals(positionCount, -1);
+    for(size_t triangle=0; triangle<triangleCount; triangle++)
+    {
+        float normal[3], weights[3];
+        faceNormal(positions, &corners[stride*triangle], weighting, normal, weights);
+        for(int corner=0; corner<3; corner++)
+        {
+            int position = corners[stride*triangle + corner];
+            float* sum = &sums[3*position];
+            sum[0] += normal[0]*weights[corner];
+            sum[1] += normal[1]*weights[corner];
+            sum[2] += normal[2]*weights[corner];
+            positionNormals[position] = 0;
+        }
+    }
+
+    // Numbered in position order, skipping positions no triangle uses
+    normals->reserve(3*positionCount);
+    for(size_t position=0; position<positionCount; position++)
+    {
+        if(positionNormals[position] >= 0)
+        {
+            positionNormals[position] = normals->size()/3;
+            appendNormal(normals, &sums[3*position]);
+        }
+    }
+    for(size_t triangle=0; triangle<triangleCount; triangle++)
+    {
+        for(int corner=0; corner<3; corner++)
+        {
+            cornerNormals[stride*triangle + corner] =
+                positionNormals[corners[stride*triangle + corner]];
+        }
+    }
+    return normals->size()/3;
+}
+
+size_t generateNormals(const float* positions, size_t positionCount, const int* corners,
+                       int* cornerNormals, size_t stride, size_t triangleCount,
+                       NormalWeighting weighting, float creaseAngle, int threadCount,
+                       std::vector<float>* normals)
+{
+    normals->clear();
+    if((triangleCount == 0) || (positionCount == 0))
+    {
+        return 0;
+    }
+
+    if(threadCount <= 0)
+    {
+        threadCount = min<size_t>(ThreadPool::hardwareThreadCount(),
+                                  triangleCount/TRIANGLES_PER_THREAD + 1);
+    }
+    threadCount = max(1, threadCount);
+    bool smoothAll = (creaseAngle >= 180.0f);
+    if(smoothAll && (threadCount < MIN_PARTITIONED_THREADS))
+    {
+        return smoothNormalsInPlace(positions, positionCount, corners, cornerNormals, stride,
+                                    triangleCount, weighting, normals);
+    }
+    unique_ptr<ThreadPool> pool;
+    if(threadCount > 1)
+    {
+        pool.reset(new ThreadPool(threadCount));
+    }
+
+    int rangeShift = 0;
+    while((rangeShift < MAX_RANGE_SHIFT) &&
+          (((size_t)threadCount*RANGES_PER_THREAD) << rangeShift) < positionCount)
+    {
+        rangeShift++;
+    }
+    size_t rangeSize = (size_t)1 << rangeShift;
+    size_t rangeCount = (positionCount + rangeSize - 1) >> rangeShift;
+
+    // Step 1: each thread takes a run of triangles and counts how many of their corners land in
+    //         each position range
+    vector<size_t> rangeCounts(threadCount*rangeCount, 0);
+    auto firstTriangleOf = [=](int thread) { return (triangleCount*thread)/threadCount; };
+    runTasks(pool.get(), threadCount, [&](int thread)
+    {
+        size_t firstTriangle = firstTriangleOf(thread);
+        size_t lastTriangle = firstTriangleOf(thread+1);
+        size_t* counts = &rangeCounts[thread*rangeCount];
+        for(size_t triangle=firstTriangle; triangle<lastTriangle; triangle++)
+        {
+            for(int corner=0; corner<3; corner++)
+            {
+                counts[corners[stride*triangle + corner] >> rangeShift]++;
+            }
+        }
+    });
+
+    // Step 2: every thread works out its triangles' normals and copies their corners into each
+    //         range after those of the threads before it, so each range lists its corners in
+    //         triangle order without any locking. The normals go along with the corners so that
+    //         step 3 only ever reads its own range's corners
+    vector<size_t> rangeStarts(rangeCount+1, 0);
+    vector<size_t> writeOffsets(threadCount*rangeCount);
+    for(size_t range=0; range<rangeCount; range++)
+    {
+        size_t offset = rangeStarts[range];
+        for(int thread=0; thread<threadCount; thread++)
+        {
+            writeOffsets[thread*rangeCount + range] = offset;
+            offset += rangeCounts[thread*rangeCount + range];
+        }
+        rangeStarts[range+1] = offset;
+    }
+    // NOTE: This is left uninitialized (unlike a vector) since every element gets written before
+    //       it's read, and clearing hundreds of megabytes first would be a pass of its own
+    unique_ptr<PositionCorner[]> rangeCorners(new PositionCorner[3*triangleCount]);
+    runTasks(pool.get(), threadCount, [&](int thread)
+    {
+        size_t* offsets = &writeOffsets[thread*rangeCount];
+        for(size_t triangle=firstTriangleOf(thread); triangle<firstTriangleOf(thread+1); triangle++)
+        {
+            float normal[3], weights[3];
+            faceNormal(positions, &corners[stride*triangle], weighting, normal, weights);
+            for(int corner=0; corner<3; corner++)
+            {
+                PositionCorner entry;
+                entry.corner = 3*triangle + corner;
+                entry.position = corners[stride*triangle + corner];
+                entry.normal[0] = normal[0];
+                entry.normal[1] = normal[1];
+                entry.normal[2] = normal[2];
+                entry.weight = weights[corner];
+                rangeCorners[offsets[entry.position >> rangeShift]++] = entry;
+            }
+        }
+    });
+
+    // Step 3: each range sorts its corners by position (keeping them in triangle order within a
+    //         position) and sums every position's normals into its own list
+    float creaseCosine = cosf(creaseAngle*PI/180.0f);
+    vector<vector<float> > rangeNormals(rangeCount);
+    runTasks(pool.get(), rangeCount, [&](int range)
+    {
+        size_t firstPosition = range*rangeSize;
+        size_t positionsInRange = min(rangeSize, positionCount - firstPosition);
+        PositionCorner* unsorted = &rangeCorners[rangeStarts[range]];
+        size_t cornerCount = rangeStarts[range+1] - rangeStarts[range];
+
+        vector<unsigned int> positionStarts(positionsInRange+1, 0);
+        for(size_t i=0; i<cornerCount; i++)
+        {
+            positionStarts[unsorted[i].position - firstPosition + 1]++;
+        }
+        for(size_t position=0; position<positionsInRange; position++)
+        {
+            positionStarts[position+1] += positionStarts[position];
+        }
+        // Indices into unsorted
+        vector<unsigned int> sorted(cornerCount);
+        vector<unsigned int> next(positionStarts.begin(), positionStarts.end() - 1);
+        for(size_t i=0; i<cornerCount; i++)
+        {
+            sorted[next[unsorted[i].position - firstPosition]++] = i;
+        }
+
+        // The unit normal and weight of each of a position's corners, and for every corner a
+        // bit per corner saying whether it smooths with it
+        vector<float> cornerData;
+        vector<uint64_t> smoothsWith;
+        vector<size_t> groups;
+        vector<float>& localNormals = rangeNormals[range];
+        localNormals.reserve(3*positionsInRange);
+        for(size_t position=0; position<positionsInRange; position++)
+        {
+            const unsigned int* positionCorners = &sorted[positionStarts[position]];
+            size_t count = positionStarts[position+1] - positionStarts[position];
+            if(count == 0)
+            {
+                continue;
+            }
+
+            cornerData.resize(4*count);
+            for(size_t i=0; i<count; i++)
+            {
+                const PositionCorner& entry = unsorted[positionCorners[i]];
+                float* cornerNormal = &cornerData[4*i];
+                cornerNormal[0] = entry.normal[0];
+                cornerNormal[1] = entry.normal[1];
+                cornerNormal[2] = entry.normal[2];
+                cornerNormal[3] = entry.weight;
+            }
+
+            if(smoothAll)
+            {
+                float sum[3] = {0.0f, 0.0f, 0.0f};
+                for(size_t i=0; i<count; i++)
+                {
+                    const float* cornerNormal = &cornerData[4*i];
+                    sum[0] += cornerNormal[0]*cornerNormal[3];
+                    sum[1] += cornerNormal[1]*cornerNormal[3];
+                    sum[2] += cornerNormal[2]*cornerNormal[3];
+                }
+                unsigned int normalIndex = localNormals.size()/3;
+                appendNormal(&localNormals, sum);
+                for(size_t i=0; i<count; i++)
+                {
+                    unsorted[positionCorners[i]].position = normalIndex;
+                }
+                continue;
+            }
+
+            // Each corner gets the sum of the triangles around it that are within the crease
+            // angle of its own. Corners that smooth with exactly the same triangles (those on
+            // the same side of every crease) share one normal, so a position is only split
+            // where there really is an edge. Summing in the same order as above means a
+            // position without creases gets the very same normal it would with none
+            size_t words = (count + 63)/64;
+            smoothsWith.assign(words*count, 0);
+            for(size_t i=0; i<count; i++)
+            {
+                const float* a = &cornerData[4*i];
+                smoothsWith[words*i + i/64] |= (uint64_t)1 << (i%64);
+                for(size_t j=i+1; j<count; j++)
+                {
+                    const float* b = &cornerData[4*j];
+                    if(a[0]*b[0] + a[1]*b[1] + a[2]*b[2] >= creaseCosine)
+                    {
+                        smoothsWith[words*i + j/64] |= (uint64_t)1 << (j%64);
+                        smoothsWith[words*j + i/64] |= (uint64_t)1 << (i%64);
+                    }
+                }
+            }
+
+            groups.clear();
+            size_t firstNormal = localNormals.size()/3;
+            for(size_t i=0; i<count; i++)
+            {
+                const uint64_t* bits = &smoothsWith[words*i];
+                size_t group = 0;
+                while((group < groups.size()) &&
+                      (memcmp(&smoothsWith[words*groups[group]], bits,
+                              words*sizeof(uint64_t)) != 0))
+                {
+                    group++;
+                }
+                if(group == groups.size())
+                {
+                    groups.push_back(i);
+                    float sum[3] = {0.0f, 0.0f, 0.0f};
+                    for(size_t j=0; j<count; j++)
+                    {
+                        if(bits[j/64] & ((uint64_t)1 << (j%64)))
+                        {
+                            const float* cornerNormal = &cornerData[4*j];
+                            sum[0] += cornerNormal[0]*cornerNormal[3];
+                            sum[1] += cornerNormal[1]*cornerNormal[3];
+                            sum[2] += cornerNormal[2]*cornerNormal[3];
+                        }
+                    }
+                    appendNormal(&localNormals, sum);
+                }
+                unsorted[positionCorners[i]].position = firstNormal + group;
+            }
+        }
+    });
+
+    // Step 4: the lists go one after the other in range order, so the normals are in position
+    //         order whatever the number of threads or ranges was, and each corner is given its
+    //         normal's index in the combined list
+    vector<size_t> normalStarts(rangeCount+1, 0);
+    for(size_t range=0; range<rangeCount; range++)
+    {
+        normalStarts[range+1] = normalStarts[range] + rangeNormals[range].size()/3;
+    }
+    normals->resize(3*normalStarts[rangeCount]);
+    runTasks(pool.get(), rangeCount, [&](int range)
+    {
+        vector<float>& localNormals = rangeNormals[range];
+        copy(localNormals.begin(), localNormals.end(), normals->begin() + 3*normalStarts[range]);
+        vector<float>().swap(localNormals);
+
+        size_t offset = normalStarts[range];
+        for(size_t i=rangeStarts[range]; i<rangeStarts[range+1]; i++)
+        {
+            size_t corner = rangeCorners[i].corner;
+            cornerNormals[stride*(corner/3) + corner%3] = offset + rangeCorners[i].position;
+        }
+    });
+
+    return normalStarts[rangeCount];
+}
@@ -0,0 +1,42 @@
+#ifndef NORMALS_H
+#define NORMALS_H
+
+#include <vector>
+#include <stddef.h>
+
+// Smooth vertex normals for meshes whose file doesn't have any. Every triangle's unit normal is
+// added to its three corners, weighted by either the triangle's area or the angle at that corner
+// (which doesn't change when a flat region is split into more triangles), and each sum is then
+// normalized.
+//
+// With a crease angle, a corner only smooths with the triangles around its position whose normals
+// are within that angle of its own triangle's, so hard edges stay hard: the position ends up with
+// one normal per side of the edge, and the vertex gets split in two when the vertices are built.
+//
+// The work is spread over threads without any atomics or per-thread copies of the normals: the
+// positions are split into ranges, each triangle corner is first sorted into the range its
+// position falls in, and then every range is summed up by one thread on its own. Corners are
+// always summed in triangle order, so the result is identical for any thread count (including
+// with too few threads for this to pay off, when smooth normals are simply summed in place)
+
+enum NormalWeighting
+{
+    NORMAL_WEIGHT_AREA,
+    NORMAL_WEIGHT_ANGLE
+};
+
+// Makes normals for the triangles whose position indices are corners[stride*t] to
+// corners[stride*t + 2] (so that the indices can be read straight out of an array of structs),
+// and sets cornerNormals[stride*t] to cornerNormals[stride*t + 2] to the indices of the corners'
+// normals. positions are x, y, z floats, and every corner has to be below positionCount (nothing
+// is checked: GeometryData drops faces with bad indices before it gets here).
+//
+// A creaseAngle (in degrees) of 180 or more smooths every corner of a position together, giving
+// one normal per used position. threadCount 0 picks one per core for large meshes. Returns the
+// number of normals written to normals (3 floats each, replacing anything already there)
+size_t generateNormals(const float* positions, size_t positionCount, const int* corners,
+                       int* cornerNormals, size_t stride, size_t triangleCount,
+                       NormalWeighting weighting, float creaseAngle, int threadCount,
+                       std::vector<float>* normals);
+
+#endif
@@ -0,0 +1,556 @@
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <cmath>
+#include <algorithm>
+
+#include "rasterizer.h"
+
+// Vertices are snapped to 1/16 of a pixel, and samples are at pixel centres
+static const int SUBPIXEL_BITS = 4;
+static const int SUBPIXEL_SCALE = 1 << SUBPIXEL_BITS;
+static const int SUBPIXEL_HALF = SUBPIXEL_SCALE/2;
+
+static const int TILE_BITS = 6;
+static const int TILE_SIZE = 1 << TILE_BITS;
+
+// Triangles set up by one job
+static const size_t BATCH_TRIANGLES = 4096;
+// Vertices transformed by one job
+static const size_t TRANSFORM_VERTICES = 16384;
+
+// NOTE: Edge functions are exact in 32 bits within a tile as long as no coordinate is more than
+//       2^17 subpixels from the origin: the edge coefficients are then below 2^18 and a tile's
+//       pixels are less than 2^10 subpixels apart, so an edge changes by less than 2^29 across a
+//       tile. Triangles are clipped to a guard band a little inside that, and an edge that is
+//       further than EDGE_LIMIT from zero at a tile's corner is inside or outside the whole tile
+static const float GUARD_BAND_PIXELS = 8000.0f;
+static const int64_t EDGE_LIMIT = (int64_t)1 << 29;
+
+#if defined(__AVX2__)
+static const int LANES = 8;
+#elif defined(__SSE2__)
+static const int LANES = 4;
+#else
+static const int LANES = 1;
+#endif
+
+static uint32_t packColor(const glm::vec3& color)
+{
+    glm::vec3 clamped = glm::clamp(color, 0.0f, 1.0f)*255.0f + 0.5f;
+    return (uint32_t)clamped.r | ((uint32_t)clamped.g << 8) | ((uint32_t)clamped.b << 16) | 0xff000000u;
+}
+
+static bool finite(const glm::vec4& v)
+{
+    return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z) && std::isfinite(v.w);
+}
+
+SoftwareRasterizer::SoftwareRasterizer(int threadCount) : pool(threadCount)
+{
+    viewportWidth = 0;
+    viewportHeight = 0;
+    tilesX = 0;
+    tilesY = 0;
+    stride = 0;
+    usedBatches = 0;
+}
+
+void SoftwareRasterizer::resize(int width, int height)
+{
+    viewportWidth = width;
+    viewportHeight = height;
+    tilesX = (width + TILE_SIZE-1)/TILE_SIZE;
+    tilesY = (height + TILE_SIZE-1)/TILE_SIZE;
+    // NOTE: Rows are padded out to whole tiles, so the SIMD loops never need to stop short of a
+    //       tile's right edge
+    stride = tilesX*TILE_SIZE;
+    colorBuffer.assign((size_t)stride*tilesY*TILE_SIZE, 0);
+    depthBuffer.assign((size_t)stride*tilesY*TILE_SIZE, 1.0f);
+    usedBatches = 0;
+}
+
+int SoftwareRasterizer::width()
+{
+    return viewportWidth;
+}
+
+int SoftwareRasterizer::height()
+{
+    return viewportHeight;
+}
+
+int SoftwareRasterizer::threadCount()
+{
+    return pool.threadCount();
+}
+
+void SoftwareRasterizer::clear(const glm::vec3& color)
+{
+    std::fill(colorBuffer.begin(), colorBuffer.end(), packColor(color));
+    std::fill(depthBuffer.begin(), depthBuffer.end(), 1.0f);
+    usedBatches = 0;
+}
+
+void SoftwareRasterizer::draw(GeometryData& geometry, const glm::mat4& model,
+                              const glm::mat4& viewProjection, int level)
+{
+    if(geometry.indexCount() == 0)
+    {
+        return;
+    }
+    GeometryLOD lod = geometry.lod(level);
+    const unsigned char* indices = (const unsigned char*)geometry.indexData();
+    size_t firstIndex = lod.firstIndex;
+    if(firstIndex >= (size_t)geometry.indexCount())
+    {
+        indices = (const unsigned char*)geometry.lodIndexData();
+        firstIndex -= geometry.indexCount();
+    }
+    drawTriangles((const float*)geometry.vertexData(), geometry.vertexCount(),
+                  indices + firstIndex*geometry.indexSize(), geometry.indexSize(), lod.indexCount,
+                  model, viewProjection);
+}
+
+void SoftwareRasterizer::drawTriangles(const float* positions, int vertexCount, const void* indices,
+                                       int indexSize, size_t indexCount, const glm::mat4& model,
+                                       const glm::mat4& viewProjection)
+{
+    if((vertexCount <= 0) || (indexCount < 3) || (stride == 0))
+    {
+        return;
+    }
+
+    glm::mat4 MVP = viewProjection*model;
+    clipPositions.resize(vertexCount);
+    for(size_t first=0; first<(size_t)vertexCount; first+=TRANSFORM_VERTICES)
+    {
+        size_t last = std::min(first + TRANSFORM_VERTICES, (size_t)vertexCount);
+        pool.enqueue([this, positions, MVP, first, last]()
+        {
+            for(size_t i=first; i<last; i++)
+            {
+                clipPositions[i] = MVP*glm::vec4(positions[3*i], positions[3*i+1], positions[3*i+2], 1.0f);
+            }
+        });
+    }
+    pool.wait();
+
+    // Normals go to world space for lighting with the inverse transpose, which keeps them
+    // perpendicular to the surface under non-uniform scaling
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+    size_t triangleCount = indexCount/3;
+    size_t batchCount = (triangleCount + BATCH_TRIANGLES-1)/BATCH_TRIANGLES;
+    if(batches.size() < usedBatches + batchCount)
+    {
+        batches.resize(usedBatches + batchCount);
+    }
+    for(size_t i=0; i<batchCount; i++)
+    {
+        TriangleBatch* batch = &batches[usedBatches + i];
+        size_t firstIndex = 3*i*BATCH_TRIANGLES;
+        size_t batchIndices = std::min(3*BATCH_TRIANGLES, 3*triangleCount - firstIndex);
+        pool.enqueue([=]()
+        {
+            setupBatch(*batch, indices, indexSize, firstIndex, batchIndices, positions, normalMatrix);
+        });
+    }
+    pool.wait();
+    usedBatches += batchCount;
+}
+
+void SoftwareRasterizer::setupBatch(TriangleBatch& batch, const void* indices, int indexSize,
+                                    size_t firstIndex, size_t indexCount, const float* positions,
+                                    const glm::mat3& normalMatrix)
+{
+    // NOTE: clear keeps the memory, so after the first frame this doesn't allocate
+    batch.triangles.clear();
+    batch.bins.resize(tilesX*tilesY);
+    for(size_t tile=0; tile<batch.bins.size(); tile++)
+    {
+        batch.bins[tile].clear();
+    }
+    batch.stats = RasterStats();
+
+    glm::vec3 light = glm::normalize(lightDirection);
+    for(size_t i=firstIndex; i<firstIndex+indexCount; i+=3)
+    {
+        batch.stats.triangles++;
+        unsigned int vertices[3];
+        for(int k=0; k<3; k++)
+        {
+            vertices[k] = (indexSize == 2) ? ((const unsigned short*)indices)[i+k] :
+                                             ((const unsigned int*)indices)[i+k];
+        }
+        glm::vec4 clip[3] = {clipPositions[vertices[0]], clipPositions[vertices[1]],
+                             clipPositions[vertices[2]]};
+
+        // Entirely outside one of the planes of the view
+        bool outside = false;
+        for(int axis=0; axis<3; axis++)
+        {
+            outside = outside ||
+                      ((clip[0][axis] < -clip[0].w) && (clip[1][axis] < -clip[1].w) && (clip[2][axis] < -clip[2].w)) ||
+                      ((clip[0][axis] > clip[0].w) && (clip[1][axis] > clip[1].w) && (clip[2][axis] > clip[2].w));
+        }
+        if(outside || !finite(clip[0]) || !finite(clip[1]) || !finite(clip[2]))
+        {
+            batch.stats.culled++;
+            continue;
+        }
+
+        const float* p0 = positions + 3*vertices[0];
+        const float* p1 = positions + 3*vertices[1];
+        const float* p2 = positions + 3*vertices[2];
+        glm::vec3 normal = normalMatrix*glm::cross(glm::vec3(p1[0]-p0[0], p1[1]-p0[1], p1[2]-p0[2]),
+                                                   glm::vec3(p2[0]-p0[0], p2[1]-p0[1], p2[2]-p0[2]));
+        float length = glm::length(normal);
+        float diffuse = (length > 0.0f) ? std::max(glm::dot(normal, light)/length, 0.0f) : 0.0f;
+        uint32_t color = packColor(surfaceColor*(ambient + (1.0f - ambient)*diffuse));
+
+        float guardX = 2.0f*GUARD_BAND_PIXELS/viewportWidth - 1.0f;
+        float guardY = 2.0f*GUARD_BAND_PIXELS/viewportHeight - 1.0f;
+        bool inside = true;
+        for(int k=0; k<3; k++)
+        {
+            inside = inside && (clip[k].z >= -clip[k].w) &&
+                     (fabsf(clip[k].x) <= guardX*clip[k].w) && (fabsf(clip[k].y) <= guardY*clip[k].w);
+        }
+        if(inside)
+        {
+            setupTriangle(batch, clip, color);
+        }
+        else
+        {
+            batch.stats.clipped++;
+            clipTriangle(batch, clip, color);
+        }
+    }
+}
+
+void SoftwareRasterizer::setupTriangle(TriangleBatch& batch, const glm::vec4 clip[3], uint32_t color)
+{
+    int32_t x[3];
+    int32_t y[3];
+    float depth[3];
+    for(int k=0; k<3; k++)
+    {
+        float invW = 1.0f/clip[k].w;
+        // NOTE: Rows go from the top, where GL's y goes up
+        x[k] = (int32_t)lrintf((clip[k].x*invW*0.5f + 0.5f)*viewportWidth*SUBPIXEL_SCALE);
+        y[k] = (int32_t)lrintf((0.5f - clip[k].y*invW*0.5f)*viewportHeight*SUBPIXEL_SCALE);
+        depth[k] = clip[k].z*invW*0.5f + 0.5f;
+    }
+
+    // Counterclockwise front faces turn clockwise when y is flipped, which makes this negative
+    int64_t area = (int64_t)(x[1]-x[0])*(y[2]-y[0]) - (int64_t)(y[1]-y[0])*(x[2]-x[0]);
+    if(area >= 0)
+    {
+        batch.stats.culled++;
+        return;
+    }
+    std::swap(x[1], x[2]);
+    std::swap(y[1], y[2]);
+    std::swap(depth[1], depth[2]);
+
+    // Pixels whose centres are inside the bounding box
+    SetupTriangle triangle;
+    int minX = (std::min(std::min(x[0], x[1]), x[2]) - SUBPIXEL_HALF + SUBPIXEL_SCALE-1) >> SUBPIXEL_BITS;
+    int minY = (std::min(std::min(y[0], y[1]), y[2]) - SUBPIXEL_HALF + SUBPIXEL_SCALE-1) >> SUBPIXEL_BITS;
+    int maxX = (std::max(std::max(x[0], x[1]), x[2]) - SUBPIXEL_HALF) >> SUBPIXEL_BITS;
+    int maxY = (std::max(std::max(y[0], y[1]), y[2]) - SUBPIXEL_HALF) >> SUBPIXEL_BITS;
+    minX = std::max(minX, 0);
+    minY = std::max(minY, 0);
+    maxX = std::min(maxX, viewportWidth-1);
+    maxY = std::min(maxY, viewportHeight-1);
+    if((minX > maxX) || (minY > maxY))
+    {
+        batch.stats.culled++;
+        return;
+    }
+    triangle.minX = minX;
+    triangle.minY = minY;
+    triangle.maxX = maxX;
+    triangle.maxY = maxY;
+
+    // Edge k goes from vertex k to the next one. Samples exactly on an edge only belong to the
+    // triangle if it's a top or left edge, so the ones that aren't are moved in by one
+    for(int k=0; k<3; k++)
+    {
+        int next = (k + 1) % 3;
+        triangle.a[k] = y[k] - y[next];
+        triangle.b[k] = x[next] - x[k];
+        triangle.c[k] = -(int64_t)triangle.a[k]*x[k] - (int64_t)triangle.b[k]*y[k];
+        bool topLeft = (triangle.a[k] > 0) || ((triangle.a[k] == 0) && (triangle.b[k] > 0));
+        if(!topLeft)
+        {
+            triangle.c[k] -= 1;
+        }
+    }
+
+    // Depth is linear in screen space, so it's a plane through the three vertices
+    // (the integer area is exact, where working it out again in floats could cancel to 0)
+    float x0 = (float)x[0]/SUBPIXEL_SCALE;
+    float y0 = (float)y[0]/SUBPIXEL_SCALE;
+    float dx1 = (float)(x[1]-x[0])/SUBPIXEL_SCALE;
+    float dy1 = (float)(y[1]-y[0])/SUBPIXEL_SCALE;
+    float dx2 = (float)(x[2]-x[0])/SUBPIXEL_SCALE;
+    float dy2 = (float)(y[2]-y[0])/SUBPIXEL_SCALE;
+    float invArea = (float)(SUBPIXEL_SCALE*SUBPIXEL_SCALE)/(float)(-area);
+    triangle.depthX = ((depth[1]-depth[0])*dy2 - (depth[2]-depth[0])*dy1)*invArea;
+    triangle.depthY = ((depth[2]-depth[0])*dx1 - (depth[1]-depth[0])*dx2)*invArea;
+    triangle.depth0 = depth[0] - triangle.depthX*x0 - triangle.depthY*y0;
+    triangle.color = color;
+
+    uint32_t index = batch.triangles.size();
+    batch.triangles.push_back(triangle);
+    for(int tileY=(minY >> TILE_BITS); tileY<=(maxY >> TILE_BITS); tileY++)
+    {
+        for(int tileX=(minX >> TILE_BITS); tileX<=(maxX >> TILE_BITS); tileX++)
+        {
+            batch.bins[tileY*tilesX + tileX].push_back(index);
+            batch.stats.binned++;
+        }
+    }
+}
+
+// Cuts the triangle down to the part in front of the near plane and inside the guard band
+// (Sutherland-Hodgman), and sets up the fan of triangles that's left
+void SoftwareRasterizer::clipTriangle(TriangleBatch& batch, const glm::vec4 clip[3], uint32_t color)
+{
+    float guardX = 2.0f*GUARD_BAND_PIXELS/viewportWidth - 1.0f;
+    float guardY = 2.0f*GUARD_BAND_PIXELS/viewportHeight - 1.0f;
+    // Each plane is a dot product with the clip space position that's positive on the inside
+    const glm::vec4 planes[5] =
+    {
+        glm::vec4(0, 0, 1, 1),
+        glm::vec4(-1, 0, 0, guardX),
+        glm::vec4(1, 0, 0, guardX),
+        glm::vec4(0, -1, 0, guardY),
+        glm::vec4(0, 1, 0, guardY)
+    };
+
+    glm::vec4 polygon[8] = {clip[0], clip[1], clip[2]};
+    int count = 3;
+    for(int plane=0; (plane<5) && (count >= 3); plane++)
+    {
+        glm::vec4 clipped[8];
+        int clippedCount = 0;
+        for(int i=0; i<count; i++)
+        {
+            const glm::vec4& current = polygon[i];
+            const glm::vec4& next = polygon[(i + 1) % count];
+            float currentDistance = glm::dot(planes[plane], current);
+            float nextDistance = glm::dot(planes[plane], next);
+            if(currentDistance >= 0.0f)
+            {
+                clipped[clippedCount++] = current;
+            }
+            if((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+            {
+                float t = currentDistance/(currentDistance - nextDistance);
+                clipped[clippedCount++] = current + t*(next - current);
+            }
+        }
+        count = clippedCount;
+        std::copy(clipped, clipped + count, polygon);
+    }
+
+    for(int i=1; i+1<count; i++)
+    {
+        glm::vec4 triangle[3] = {polygon[0], polygon[i], polygon[i+1]};
+        setupTriangle(batch, triangle, color);
+    }
+}
+
+void SoftwareRasterizer::finish()
+{
+    for(int tile=0; tile<tilesX*tilesY; tile++)
+    {
+        pool.enqueue([this, tile]() { rasterizeTile(tile); });
+    }
+    pool.wait();
+}
+
+void SoftwareRasterizer::rasterizeTile(int tile)
+{
+    int tileX = tile % tilesX;
+    int tileY = tile / tilesX;
+    for(size_t b=0; b<usedBatches; b++)
+    {
+        const TriangleBatch& batch = batches[b];
+        const std::vector<uint32_t>& bin = batch.bins[tile];
+        for(size_t i=0; i<bin.size(); i++)
+        {
+            rasterizeTriangle(batch.triangles[bin[i]], tileX, tileY);
+        }
+    }
+}
+
+void SoftwareRasterizer::rasterizeTriangle(const SetupTriangle& triangle, int tileX, int tileY)
+{
+    int x0 = std::max((int)triangle.minX, tileX*TILE_SIZE);
+    int y0 = std::max((int)triangle.minY, tileY*TILE_SIZE);
+    int x1 = std::min((int)triangle.maxX, tileX*TILE_SIZE + TILE_SIZE-1);
+    int y1 = std::min((int)triangle.maxY, tileY*TILE_SIZE + TILE_SIZE-1);
+    if((x0 > x1) || (y0 > y1))
+    {
+        return;
+    }
+    // NOTE: Tiles start on a multiple of the lane count, so aligning down stays in the tile
+    x0 &= ~(LANES-1);
+
+    // Each edge at the first sample, and how much it changes from one pixel to the next
+    int32_t edge[3];
+    int32_t stepX[3];
+    int32_t stepY[3];
+    int64_t sampleX = (int64_t)x0*SUBPIXEL_SCALE + SUBPIXEL_HALF;
+    int64_t sampleY = (int64_t)y0*SUBPIXEL_SCALE + SUBPIXEL_HALF;
+    for(int k=0; k<3; k++)
+    {
+        int64_t value = triangle.c[k] + triangle.a[k]*sampleX + triangle.b[k]*sampleY;
+        if(value < -EDGE_LIMIT)
+        {
+            return;//the whole tile is outside this edge
+        }
+        if(value >= EDGE_LIMIT)
+        {
+            //the whole tile is inside this edge, so it can stay at a constant that passes
+            edge[k] = (int32_t)EDGE_LIMIT;
+            stepX[k] = 0;
+            stepY[k] = 0;
+        }
+        else
+        {
+            edge[k] = (int32_t)value;
+            stepX[k] = triangle.a[k]*SUBPIXEL_SCALE;
+            stepY[k] = triangle.b[k]*SUBPIXEL_SCALE;
+        }
+    }
+
+    for(int y=y0; y<=y1; y++)
+    {
+        int32_t row[3];
+        for(int k=0; k<3; k++)
+        {
+            row[k] = edge[k] + stepY[k]*(y - y0);
+        }
+        float rowDepth = triangle.depth0 + triangle.depthY*(y + 0.5f);
+        uint32_t* colors = &colorBuffer[(size_t)y*stride];
+        float* depths = &depthBuffer[(size_t)y*stride];
+#if defined(__AVX2__)
+        __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i w0 = _mm256_add_epi32(_mm256_set1_epi32(row[0]), _mm256_mullo_epi32(laneOffsets, _mm256_set1_epi32(stepX[0])));
+        __m256i w1 = _mm256_add_epi32(_mm256_set1_epi32(row[1]), _mm256_mullo_epi32(laneOffsets, _mm256_set1_epi32(stepX[1])));
+        __m256i w2 = _mm256_add_epi32(_mm256_set1_epi32(row[2]), _mm256_mullo_epi32(laneOffsets, _mm256_set1_epi32(stepX[2])));
+        __m256i step0 = _mm256_set1_epi32(stepX[0]*LANES);
+        __m256i step1 = _mm256_set1_epi32(stepX[1]*LANES);
+        __m256i step2 = _mm256_set1_epi32(stepX[2]*LANES);
+        __m256 depthOffsets = _mm256_mul_ps(_mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_ps(triangle.depthX));
+        __m256i color = _mm256_set1_epi32(triangle.color);
+        for(int x=x0; x<=x1; x+=LANES)
+        {
+            // The sign bit of any edge being set means the sample is outside
+            __m256i outside = _mm256_srai_epi32(_mm256_or_si256(_mm256_or_si256(w0, w1), w2), 31);
+            if(_mm256_movemask_epi8(outside) != -1)
+            {
+                __m256 depth = _mm256_add_ps(_mm256_set1_ps(rowDepth + triangle.depthX*(x + 0.5f)), depthOffsets);
+                __m256 oldDepth = _mm256_loadu_ps(depths + x);
+                __m256 pass = _mm256_andnot_ps(_mm256_castsi256_ps(outside), _mm256_cmp_ps(depth, oldDepth, _CMP_LT_OQ));
+                _mm256_storeu_ps(depths + x, _mm256_blendv_ps(oldDepth, depth, pass));
+                __m256i oldColor = _mm256_loadu_si256((__m256i*)(colors + x));
+                _mm256_storeu_si256((__m256i*)(colors + x),
+                                    _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(oldColor), _mm256_castsi256_ps(color), pass)));
+            }
+            w0 = _mm256_add_epi32(w0, step0);
+            w1 = _mm256_add_epi32(w1, step1);
+            w2 = _mm256_add_epi32(w2, step2);
+        }
+#elif defined(__SSE2__)
+        // NOTE: SSE2 has no 32-bit multiply, but the offsets for 4 lanes are just 0, s, 2s, 3s
+        __m128i w0 = _mm_add_epi32(_mm_set1_epi32(row[0]), _mm_setr_epi32(0, stepX[0], 2*stepX[0], 3*stepX[0]));
+        __m128i w1 = _mm_add_epi32(_mm_set1_epi32(row[1]), _mm_setr_epi32(0, stepX[1], 2*stepX[1], 3*stepX[1]));
+        __m128i w2 = _mm_add_epi32(_mm_set1_epi32(row[2]), _mm_setr_epi32(0, stepX[2], 2*stepX[2], 3*stepX[2]));
+        __m128i step0 = _mm_set1_epi32(stepX[0]*LANES);
+        __m128i step1 = _mm_set1_epi32(stepX[1]*LANES);
+        __m128i step2 = _mm_set1_epi32(stepX[2]*LANES);
+        __m128 depthOffsets = _mm_mul_ps(_mm_setr_ps(0, 1, 2, 3), _mm_set1_ps(triangle.depthX));
+        __m128i color = _mm_set1_epi32(triangle.color);
+        for(int x=x0; x<=x1; x+=LANES)
+        {
+            // The sign bit of any edge being set means the sample is outside
+            __m128i outside = _mm_srai_epi32(_mm_or_si128(_mm_or_si128(w0, w1), w2), 31);
+            if(_mm_movemask_epi8(outside) != 0xffff)
+            {
+                __m128 depth = _mm_add_ps(_mm_set1_ps(rowDepth + triangle.depthX*(x + 0.5f)), depthOffsets);
+                __m128 oldDepth = _mm_loadu_ps(depths + x);
+                __m128i pass = _mm_andnot_si128(outside, _mm_castps_si128(_mm_cmplt_ps(depth, oldDepth)));
+                _mm_storeu_ps(depths + x, _mm_or_ps(_mm_and_ps(_mm_castsi128_ps(pass), depth),
+                                                    _mm_andnot_ps(_mm_castsi128_ps(pass), oldDepth)));
+                __m128i oldColor = _mm_loadu_si128((__m128i*)(colors + x));
+                _mm_storeu_si128((__m128i*)(colors + x), _mm_or_si128(_mm_and_si128(pass, color),
+                                                                      _mm_andnot_si128(pass, oldColor)));
+            }
+            w0 = _mm_add_epi32(w0, step0);
+            w1 = _mm_add_epi32(w1, step1);
+            w2 = _mm_add_epi32(w2, step2);
+        }
+#else
+        for(int x=x0; x<=x1; x++)
+        {
+            int32_t w0 = row[0] + stepX[0]*(x - x0);
+            int32_t w1 = row[1] + stepX[1]*(x - x0);
+            int32_t w2 = row[2] + stepX[2]*(x - x0);
+            float depth = rowDepth + triangle.depthX*(x + 0.5f);
+            if(((w0 | w1 | w2) >= 0) && (depth < depths[x]))
+            {
+                depths[x] = depth;
+                colors[x] = triangle.color;
+            }
+        }
+#endif
+    }
+}
+
+void SoftwareRasterizer::readPixels(std::vector<unsigned char>* rgb)
+{
+    rgb->resize((size_t)viewportWidth*viewportHeight*3);
+    unsigned char* out = rgb->data();
+    for(int y=0; y<viewportHeight; y++)
+    {
+        const uint32_t* row = &colorBuffer[(size_t)y*stride];
+        for(int x=0; x<viewportWidth; x++)
+        {
+            *out++ = row[x] & 0xff;
+            *out++ = (row[x] >> 8) & 0xff;
+            *out++ = (row[x] >> 16) & 0xff;
+        }
+    }
+}
+
+RasterStats SoftwareRasterizer::stats()
+{
+    RasterStats total;
+    for(size_t b=0; b<usedBatches; b++)
+    {
+        total.triangles += batches[b].stats.triangles;
+        total.culled += batches[b].stats.culled;
+        total.clipped += batches[b].stats.clipped;
+        total.binned += batches[b].stats.binned;
+    }
+    return total;
+}
+
+const char* SoftwareRasterizer::instructionSet()
+{
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
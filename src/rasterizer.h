@@ -0,0 +1,122 @@
+#ifndef RASTERIZER_H
+#define RASTERIZER_H
+
+#include <vector>
+#include <stdint.h>
+#include <glm/glm.hpp>
+
+#include "geometry.h"
+#include "threadpool.h"
+
+// What a SoftwareRasterizer did since the last clear
+struct RasterStats
+{
+    long long triangles = 0;//submitted by draw calls
+    long long culled = 0;//back facing, too small to cover a sample, or outside the view
+    long long clipped = 0;//crossed the near plane or the guard band, and were cut to fit
+    long long binned = 0;//triangle and tile pairs rasterized
+};
+
+// Draws triangle meshes on the CPU, for rendering without a GPU (e.g. to check every model still
+// renders the same on machines that have none). It follows the GL state the viewer sets up:
+// back faces culled (counterclockwise is front), depth tested with GL_LESS and the same clip
+// space, so the same model and view projection matrices put things in the same place. Surfaces are
+// flat shaded with one light, rather than the viewer's random vertex colours, so that images are
+// the same on every run.
+//
+// draw transforms the vertices and sets up each triangle's edge functions, then sorts them into
+// the 64x64 pixel tiles they touch. finish rasterizes every tile as its own job. Edges are tested
+// with integer arithmetic on vertices snapped to 1/16 pixel with the top-left fill rule (so shared
+// edges have no gaps or double hits), 8 pixels at a time with AVX2 or 4 with SSE2. Triangles are
+// rasterized in the order they were drawn whatever the thread count, so images are identical
+// across thread counts too
+class SoftwareRasterizer
+{
+public:
+    // A thread count of 0 uses one thread per hardware core
+    explicit SoftwareRasterizer(int threadCount = 0);
+
+    void resize(int width, int height);
+    int width();
+    int height();
+    int threadCount();
+
+    // Clears the colour (to the given colour) and depth (to the far plane), and forgets
+    // everything drawn so far
+    void clear(const glm::vec3& color);
+    // Draws a level of detail of a mesh, at full detail by default
+    void draw(GeometryData& geometry, const glm::mat4& model, const glm::mat4& viewProjection,
+              int level = 0);
+    // Draws indexed triangles. positions are x, y, z floats and indices are 2 or 4 bytes each,
+    // as in GeometryData. Nothing is kept pointing into them after this returns
+    void drawTriangles(const float* positions, int vertexCount, const void* indices,
+                       int indexSize, size_t indexCount, const glm::mat4& model,
+                       const glm::mat4& viewProjection);
+    // Rasterizes everything drawn since the last clear. Waits for it to finish
+    void finish();
+
+    // The image as RGB bytes, rows from the top
+    void readPixels(std::vector<unsigned char>* rgb);
+    RasterStats stats();
+
+    // Colour of the surfaces, lit from lightDirection (in world space, pointing at the light),
+    // with ambient light so that faces turned away are still visible
+    glm::vec3 surfaceColor = glm::vec3(0.85f, 0.85f, 0.8f);
+    glm::vec3 lightDirection = glm::vec3(0.40f, 0.80f, 0.45f);
+    float ambient = 0.2f;
+
+    // "AVX2", "SSE2" or "scalar", whichever the edge tests were built with
+    static const char* instructionSet();
+
+private:
+    SoftwareRasterizer(const SoftwareRasterizer&);
+    SoftwareRasterizer& operator=(const SoftwareRasterizer&);
+
+    // A triangle ready to be rasterized. Edge functions are in 1/16 pixel units, each
+    // a*x + b*y + c at sample (x, y) and non-negative inside. Depth is a plane over the pixels
+    struct SetupTriangle
+    {
+        int32_t a[3];
+        int32_t b[3];
+        int64_t c[3];
+        float depth0;
+        float depthX;
+        float depthY;
+        uint32_t color;
+        int16_t minX;
+        int16_t minY;
+        int16_t maxX;
+        int16_t maxY;
+    };
+
+    // The triangles of a fixed size range of one draw call, set up by one job, with the ones
+    // touching each tile listed by tile
+    struct TriangleBatch
+    {
+        std::vector<SetupTriangle> triangles;
+        std::vector<std::vector<uint32_t> > bins;
+        RasterStats stats;
+    };
+
+    void setupBatch(TriangleBatch& batch, const void* indices, int indexSize, size_t firstIndex,
+                    size_t indexCount, const float* positions, const glm::mat3& normalMatrix);
+    void setupTriangle(TriangleBatch& batch, const glm::vec4 clip[3], uint32_t color);
+    void clipTriangle(TriangleBatch& batch, const glm::vec4 clip[3], uint32_t color);
+    void rasterizeTile(int tile);
+    void rasterizeTriangle(const SetupTriangle& triangle, int tileX, int tileY);
+
+    int viewportWidth;
+    int viewportHeight;
+    int tilesX;
+    int tilesY;
+    int stride;//pixels from one row to the next (padded to whole tiles)
+    std::vector<uint32_t> colorBuffer;//RGBA, R in the lowest byte
+    std::vector<float> depthBuffer;
+    std::vector<glm::vec4> clipPositions;//positions of the current draw call's vertices, after transforming
+    std::vector<TriangleBatch> batches;
+    size_t usedBatches;
+    // NOTE: Last, so that its workers are stopped before anything they use is destroyed
+    ThreadPool pool;
+};
+
+#endif
@@ -0,0 +1,285 @@
+#include <iostream>
+
+#include "scene.h"
+
+using namespace std;
+
+// Freed meshes whose GL objects are kept for reuse, past which they're deleted
+static const size_t MAX_SPARE_GPU_MESHES = 4;
+
+Scene::Scene()
+{
+}
+
+int Scene::addObject(GLStateCache& state, const std::string& path,
+                     const GeometryLoadOptions& options, bool packedVertices)
+{
+    int meshIndex = loadMesh(state, path, options, packedVertices);
+    if(meshIndex < 0)
+    {
+        return -1;
+    }
+    return insertObject(meshIndex);
+}
+
+int Scene::addLoadedObject(GLStateCache& state, std::unique_ptr<SceneMesh> mesh)
+{
+    std::unordered_map<std::string, int>::iterator existing = meshesByPath.find(mesh->path);
+    if(existing != meshesByPath.end())
+    {
+        parkGpuMesh(state, mesh->gpu);
+        return insertObject(existing->second);
+    }
+    mesh->users = 0;
+    return insertObject(insertMesh(std::move(mesh)));
+}
+
+int Scene::addInstance(int sourceId)
+{
+    return insertObject(objects[objectIndices[sourceId]].mesh);
+}
+
+void Scene::removeObject(GLStateCache& state, int id)
+{
+    if(!contains(id))
+    {
+        return;
+    }
+
+    // Move the last object into the hole, so the array stays packed
+    int index = objectIndices[id];
+    int meshIndex = objects[index].mesh;
+    int lastIndex = objects.size() - 1;
+    objects[index] = objects[lastIndex];
+    objectIds[index] = objectIds[lastIndex];
+    objectIndices[objectIds[index]] = index;
+    objects.pop_back();
+    objectIds.pop_back();
+    objectIndices[id] = -1;
+    freeIds.push_back(id);
+
+    meshes[meshIndex]->users--;
+    if(meshes[meshIndex]->users == 0)
+    {
+        releaseMesh(state, meshIndex);
+    }
+}
+
+bool Scene::contains(int id)
+{
+    return (id >= 0) && (id < (int)objectIndices.size()) && (objectIndices[id] >= 0);
+}
+
+glm::mat4& Scene::transform(int id)
+{
+    return objects[objectIndices[id]].transform;
+}
+
+SceneMesh& Scene::meshOf(int id)
+{
+    return *meshes[objects[objectIndices[id]].mesh];
+}
+
+int Scene::objectCount()
+{
+    return objects.size();
+}
+
+SceneObject& Scene::object(int index)
+{
+    return objects[index];
+}
+
+int Scene::objectId(int index)
+{
+    return objectIds[index];
+}
+
+SceneMesh& Scene::mesh(int meshIndex)
+{
+    return *meshes[meshIndex];
+}
+
+int Scene::meshSlotCount()
+{
+    return meshes.size();
+}
+
+bool Scene::hasMesh(const std::string& path)
+{
+    return meshesByPath.find(path) != meshesByPath.end();
+}
+
+GLMesh Scene::takeSpareGpuMesh()
+{
+    if(spareGpuMeshes.empty())
+    {
+        return GLMesh();
+    }
+    GLMesh gpu = spareGpuMeshes.back();
+    spareGpuMeshes.pop_back();
+    return gpu;
+}
+
+MeshRaycaster& Scene::raycaster(int meshIndex)
+{
+    SceneMesh& mesh = *meshes[meshIndex];
+    GeometryData& geometry = mesh.geometry;
+    if(mesh.raycaster.empty() && (geometry.indexCount() > 0))
+    {
+        std::vector<unsigned int> indices(geometry.indexCount());
+        for(size_t i=0; i<indices.size(); i++)
+        {
+            indices[i] = (geometry.indexSize() == 2) ? ((const unsigned short*)geometry.indexData())[i] :
+                                                        ((const unsigned int*)geometry.indexData())[i];
+        }
+        mesh.raycaster.build((const float*)geometry.vertexData(), indices.data(), indices.size());
+    }
+    return mesh.raycaster;
+}
+
+GeometryArena& Scene::geometryArena()
+{
+    return arena;
+}
+
+const ArenaMesh& Scene::arenaMesh(GLStateCache& state, int meshIndex)
+{
+    SceneMesh& mesh = *meshes[meshIndex];
+    if(mesh.arenaMesh < 0)
+    {
+        //the arena always takes packed positions, whichever way the mesh's own buffers have them
+        GLMeshData data;
+        GLMesh::prepare(mesh.geometry, true, &data);
+        mesh.arenaMesh = arena.add(state, data);
+    }
+    return arena.mesh(mesh.arenaMesh);
+}
+
+long long Scene::vertexBytes()
+{
+    long long total = 0;
+    for(size_t i=0; i<meshes.size(); i++)
+    {
+        if(meshes[i])
+        {
+            total += meshes[i]->gpu.vertexBytes();
+        }
+    }
+    return total;
+}
+
+void Scene::destroy(GLStateCache& state)
+{
+    for(size_t i=0; i<meshes.size(); i++)
+    {
+        if(meshes[i])
+        {
+            meshes[i]->gpu.destroy(state);
+        }
+    }
+    for(size_t i=0; i<spareGpuMeshes.size(); i++)
+    {
+        spareGpuMeshes[i].destroy(state);
+    }
+    arena.destroy(state);
+    objects.clear();
+    objectIds.clear();
+    objectIndices.clear();
+    freeIds.clear();
+    meshes.clear();
+    freeMeshes.clear();
+    meshesByPath.clear();
+    spareGpuMeshes.clear();
+}
+
+int Scene::insertObject(int meshIndex)
+{
+    int id;
+    if(!freeIds.empty())
+    {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    else
+    {
+        id = objectIndices.size();
+        objectIndices.push_back(-1);
+    }
+
+    SceneObject object;
+    object.mesh = meshIndex;
+    object.transform = glm::mat4(1.0f);
+    objectIndices[id] = objects.size();
+    objects.push_back(object);
+    objectIds.push_back(id);
+    meshes[meshIndex]->users++;
+    return id;
+}
+
+int Scene::loadMesh(GLStateCache& state, const std::string& path,
+                    const GeometryLoadOptions& options, bool packedVertices)
+{
+    std::unordered_map<std::string, int>::iterator existing = meshesByPath.find(path);
+    if(existing != meshesByPath.end())
+    {
+        return existing->second;
+    }
+
+    std::unique_ptr<SceneMesh> mesh(new SceneMesh());
+    mesh->path = path;
+    mesh->users = 0;
+    mesh->geometry.loadFromOBJFile(path, options);
+    if(mesh->geometry.indexCount() == 0)
+    {
+        cout << "Not adding " << path << " to the scene since it has no triangles" << endl;
+        return -1;
+    }
+
+    mesh->gpu = takeSpareGpuMesh();
+    mesh->gpu.upload(state, mesh->geometry, packedVertices);
+    return insertMesh(std::move(mesh));
+}
+
+int Scene::insertMesh(std::unique_ptr<SceneMesh> mesh)
+{
+    int meshIndex;
+    if(!freeMeshes.empty())
+    {
+        meshIndex = freeMeshes.back();
+        freeMeshes.pop_back();
+    }
+    else
+    {
+        meshIndex = meshes.size();
+        meshes.push_back(std::unique_ptr<SceneMesh>());
+    }
+    meshesByPath[mesh->path] = meshIndex;
+    meshes[meshIndex] = std::move(mesh);
+    return meshIndex;
+}
+
+void Scene::releaseMesh(GLStateCache& state, int meshIndex)
+{
+    if(meshes[meshIndex]->arenaMesh >= 0)
+    {
+        arena.remove(meshes[meshIndex]->arenaMesh);
+    }
+    parkGpuMesh(state, meshes[meshIndex]->gpu);
+    meshesByPath.erase(meshes[meshIndex]->path);
+    meshes[meshIndex].reset();
+    freeMeshes.push_back(meshIndex);
+}
+
+// NOTE: The GL objects are kept rather than deleted, since the next mesh to be loaded needs the
+//       same set of them anyway. Their storage isn't though, as it can be as big as the mesh was
+void Scene::parkGpuMesh(GLStateCache& state, GLMesh& gpu)
+{
+    if(spareGpuMeshes.size() >= MAX_SPARE_GPU_MESHES)
+    {
+        gpu.destroy(state);
+        return;
+    }
+    gpu.release(state);
+    spareGpuMeshes.push_back(gpu);
+}
@@ -0,0 +1,113 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "geometry.h"
+#include "glmesh.h"
+#include "geometryarena.h"
+#include "glstate.h"
+#include "meshraycast.h"
+
+// A loaded model and its GPU copy, shared by every object in the scene drawn with it
+struct SceneMesh
+{
+    std::string path;
+    GeometryData geometry;
+    GLMesh gpu;
+    // Triangle hierarchy for picking, built the first time a ray is cast at the mesh
+    MeshRaycaster raycaster;
+    int users;
+    // Id of the mesh's copy in the scene's geometry arena, or -1 until it's drawn from there
+    int arenaMesh = -1;
+};
+
+// One thing drawn in the scene: a mesh with its own placement
+struct SceneObject
+{
+    int mesh;
+    glm::mat4 transform;
+};
+
+// Every object in the scene and the meshes they use. Objects are kept packed in one array for
+// drawing, and referred to from outside by ids that stay the same when other objects are added or
+// removed (ids of removed objects get reused). Adding and removing objects is O(1). Meshes are
+// loaded once per file, and freed when their last object is removed, with a few of their GL
+// objects kept (emptied) for the next meshes to be uploaded into
+class Scene
+{
+public:
+    Scene();
+
+    // Adds an object at the origin drawn with the mesh in the given file, loading it unless the
+    // scene already has it. Returns the new object's id, or -1 if the file has no triangles
+    int addObject(GLStateCache& state, const std::string& path,
+                  const GeometryLoadOptions& options, bool packedVertices);
+    // Adds an object at the origin drawn with a mesh that was loaded and uploaded elsewhere (see
+    // MeshLoader). If the scene already has a mesh from the same file by then, that one is used
+    // and the new one's GL objects are kept as spares. Returns the new object's id
+    int addLoadedObject(GLStateCache& state, std::unique_ptr<SceneMesh> mesh);
+    // Adds another object drawn with the same mesh as an existing one
+    int addInstance(int sourceId);
+    void removeObject(GLStateCache& state, int id);
+    bool contains(int id);
+    glm::mat4& transform(int id);
+    SceneMesh& meshOf(int id);
+
+    // Objects in drawing order, which changes when objects are removed
+    int objectCount();
+    SceneObject& object(int index);
+    int objectId(int index);
+    SceneMesh& mesh(int meshIndex);
+    // Mesh indices are below this (some may be unused, but no object refers to those)
+    int meshSlotCount();
+
+    // Whether a mesh from the file is already loaded
+    bool hasMesh(const std::string& path);
+    // GL objects of a freed mesh to upload a new one into, or fresh (uncreated) ones if there
+    // aren't any
+    GLMesh takeSpareGpuMesh();
+
+    // The mesh's raycaster, building it first if needed
+    MeshRaycaster& raycaster(int meshIndex);
+
+    // The buffers every mesh can be drawn from together (see GeometryArena), and where a mesh is
+    // in them, copying it in first if needed. A mesh leaves the arena when it's freed
+    GeometryArena& geometryArena();
+    const ArenaMesh& arenaMesh(GLStateCache& state, int meshIndex);
+
+    // Total size of the vertex buffers of all the meshes
+    long long vertexBytes();
+
+    // Deletes all the GL objects (including the spare ones) and empties the scene
+    void destroy(GLStateCache& state);
+
+private:
+    int loadMesh(GLStateCache& state, const std::string& path,
+                 const GeometryLoadOptions& options, bool packedVertices);
+    int insertMesh(std::unique_ptr<SceneMesh> mesh);
+    int insertObject(int meshIndex);
+    void releaseMesh(GLStateCache& state, int meshIndex);
+    void parkGpuMesh(GLStateCache& state, GLMesh& gpu);
+
+    std::vector<SceneObject> objects;
+    // Id of each entry in objects, and the index in objects of each id (-1 for unused ids)
+    std::vector<int> objectIds;
+    std::vector<int> objectIndices;
+    std::vector<int> freeIds;
+
+    // Meshes by index (null for unused indices)
+    std::vector<std::unique_ptr<SceneMesh> > meshes;
+    std::vector<int> freeMeshes;
+    std::unordered_map<std::string, int> meshesByPath;
+    // GL objects of freed meshes, with their buffers emptied, ready to be uploaded into again
+    std::vector<GLMesh> spareGpuMeshes;
+    GeometryArena arena;
+};
+
+#endif
@@ -9,16 +9,145 @@ using namespace std;
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 #include <GL/glew.h>
 
 #include "shader.hpp"
+#include "meshcache.h"
 
-GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
+// A program cache file is a ProgramCacheHeader followed by the program binary. The key is a hash of
+// everything that can change the binary: both sources, the defines, and the GL vendor, renderer
+// and version (a driver update can change the binary format without changing its number)
+#define PROGRAM_CACHE_MAGIC 0x47525050 // "PPRG"
+#define PROGRAM_CACHE_VERSION 1
 
-	// Create the shaders
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+struct ProgramCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint32_t binaryFormat;
+	uint32_t binarySize;
+};
+
+static bool ProgramCacheEnabled = true;
+
+void SetProgramCacheEnabled(bool enabled){
+	ProgramCacheEnabled = enabled;
+}
+
+// Puts the defines right after the #version line, which has to stay first
+static std::string AddDefines(const std::string & code, const char * defines){
+	if(!defines || !defines[0]){
+		return code;
+	}
+	size_t insertAt = 0;
+	if(code.compare(0, 8, "#version") == 0){
+		insertAt = code.find('\n');
+		insertAt = (insertAt == std::string::npos) ? code.size() : insertAt + 1;
+	}
+	std::string define_block(defines);
+	if(define_block[define_block.size()-1] != '\n'){
+		define_block += '\n';
+	}
+	return code.substr(0, insertAt) + define_block + code.substr(insertAt);
+}
+
+static bool ProgramBinariesSupported(){
+	if(!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary){
+		return false;
+	}
+	// NOTE: Some drivers expose the extension without supporting any binary formats
+	GLint FormatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &FormatCount);
+	return FormatCount > 0;
+}
+
+static uint64_t ProgramCacheKey(const std::string & VertexShaderCode, const std::string & FragmentShaderCode,
+                                const char * defines){
+	std::string KeySource = VertexShaderCode + '\0' + FragmentShaderCode + '\0' + defines + '\0';
+	KeySource += (const char*)glGetString(GL_VENDOR);
+	KeySource += '\0';
+	KeySource += (const char*)glGetString(GL_RENDERER);
+	KeySource += '\0';
+	KeySource += (const char*)glGetString(GL_VERSION);
+	return hashMeshSource(KeySource.data(), KeySource.size());
+}
+
+// One cache file per vertex shader, fragment shader and defines, next to the vertex shader
+static std::string ProgramCachePath(const char * vertex_file_path, const char * fragment_file_path,
+                                    const char * defines){
+	std::string Name = std::string(vertex_file_path) + '\0' + fragment_file_path + '\0' + defines;
+	char Suffix[32];
+	snprintf(Suffix, sizeof(Suffix), "-%08x.programcache",
+	         (unsigned int)hashMeshSource(Name.data(), Name.size()));
+	return std::string(vertex_file_path) + Suffix;
+}
+
+// Returns 0 if there's no cache, it's for other sources or another driver, or the driver won't take it
+static GLuint LoadProgramBinary(const std::string & path, uint64_t key){
+	std::ifstream CacheStream(path.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+	if(!CacheStream){
+		return 0;
+	}
+	std::streamoff FileSize = CacheStream.tellg();
+	CacheStream.seekg(0);
+	// NOTE: A file cut short, or with anything after the binary, was written by something else or
+	//       interrupted, and the size in its header can't be trusted to allocate with
+	ProgramCacheHeader Header;
+	if(!CacheStream.read((char*)&Header, sizeof(Header)) ||
+	   (Header.magic != PROGRAM_CACHE_MAGIC) || (Header.version != PROGRAM_CACHE_VERSION) ||
+	   (Header.key != key) || ((std::streamoff)sizeof(Header) + Header.binarySize != FileSize)){
+		return 0;
+	}
+	std::vector<char> Binary(Header.binarySize);
+	if(!CacheStream.read(Binary.data(), Binary.size())){
+		return 0;
+	}
+
+	GLuint ProgramID = glCreateProgram();
+	glProgramBinary(ProgramID, Header.binaryFormat, Binary.data(), Binary.size());
+	GLint Result = GL_FALSE;
+	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+	if(Result != GL_TRUE){
+		glDeleteProgram(ProgramID);
+		return 0;
+	}
+	return ProgramID;
+}
+
+static void SaveProgramBinary(GLuint ProgramID, const std::string & path, uint64_t key){
+	GLint BinaryLength = 0;
+	glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &BinaryLength);
+	if(BinaryLength <= 0){
+		return;
+	}
+	std::vector<char> Binary(BinaryLength);
+	ProgramCacheHeader Header;
+	memset(&Header, 0, sizeof(Header));
+	glGetProgramBinary(ProgramID, BinaryLength, NULL, &Header.binaryFormat, Binary.data());
+	Header.magic = PROGRAM_CACHE_MAGIC;
+	Header.version = PROGRAM_CACHE_VERSION;
+	Header.key = key;
+	Header.binarySize = BinaryLength;
+
+	// Written to a temporary file and renamed, so a crash never leaves half a cache behind
+	std::string TempPath = path + ".tmp";
+	std::ofstream CacheStream(TempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	CacheStream.write((const char*)&Header, sizeof(Header));
+	CacheStream.write(Binary.data(), Binary.size());
+	CacheStream.close();
+	if(CacheStream.fail() || (rename(TempPath.c_str(), path.c_str()) != 0)){
+		remove(TempPath.c_str());
+		printf("Unable to write program cache %s\n", path.c_str());
+	}
+}
+
+GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path, const char * defines){
+	if(!defines){
+		defines = "";
+	}
 
 	// Read the Vertex Shader code from the file
 	std::string VertexShaderCode;
@@ -43,6 +172,26 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 		FragmentShaderCode = sstr.str();
 		FragmentShaderStream.close();
 	}
+	VertexShaderCode = AddDefines(VertexShaderCode, defines);
+	FragmentShaderCode = AddDefines(FragmentShaderCode, defines);
+
+	// Use the program binary from the last run if it was built from the same sources by the same driver
+	bool UseCache = ProgramCacheEnabled && ProgramBinariesSupported();
+	uint64_t CacheKey = 0;
+	std::string CachePath;
+	if(UseCache){
+		CacheKey = ProgramCacheKey(VertexShaderCode, FragmentShaderCode, defines);
+		CachePath = ProgramCachePath(vertex_file_path, fragment_file_path, defines);
+		GLuint CachedProgramID = LoadProgramBinary(CachePath, CacheKey);
+		if(CachedProgramID){
+			printf("Loaded program from cache : %s\n", CachePath.c_str());
+			return CachedProgramID;
+		}
+	}
+
+	// Create the shaders
+	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
 
 	GLint Result = GL_FALSE;
 	int InfoLogLength;
@@ -87,6 +236,9 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 	GLuint ProgramID = glCreateProgram();
 	glAttachShader(ProgramID, VertexShaderID);
 	glAttachShader(ProgramID, FragmentShaderID);
+	if(UseCache){
+		glProgramParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	glLinkProgram(ProgramID);
 
 	// Check the program
@@ -105,6 +257,10 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
+	if(UseCache && (Result == GL_TRUE)){
+		SaveProgramBinary(ProgramID, CachePath, CacheKey);
+	}
+
 	return ProgramID;
 }
 
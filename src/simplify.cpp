@@ -0,0 +1,495 @@
+#include "simplify.h"
+
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+
+using namespace std;
+
+// How much a difference in the attributes of merged vertices counts for, compared to moving the
+// surface. Positions are scaled so that the mesh is 1 unit across before measuring anything, so
+// e.g. a difference of 1 in a normal costs as much as moving the surface 5% of the way across
+static const float SIMPLIFY_NORMAL_WEIGHT = 0.05f;
+static const float SIMPLIFY_TEXCOORD_WEIGHT = 0.1f;
+static const int SIMPLIFY_MAX_ATTRIBUTES = 5;
+
+// Each pass collapses edges from the cheaper half of the candidates only. The rest wait for the
+// next pass, by which time their neighbourhood may have changed enough to make them cheaper
+static const float SIMPLIFY_PASS_FRACTION = 0.5f;
+
+// A collapse is refused if it would turn any remaining triangle around it by more than ~75
+// degrees, since that triangle would be folding over its neighbours
+static const float SIMPLIFY_MIN_NORMAL_DOT = 0.25f;
+
+// Sum of the squared distances to a set of planes, weighted by the area of the triangle each
+// plane came from: Q(p) = p.A.p + 2b.p + c
+struct PositionQuadric
+{
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double weight;
+};
+
+// Area weighted sum of the squared distances from a set of attribute values, so that it measures
+// how far the attributes of everything merged into a vertex are from that vertex's attributes
+struct AttributeQuadric
+{
+    double weight;
+    double sum[SIMPLIFY_MAX_ATTRIBUTES];
+    double sumSquares;
+};
+
+static void addPlane(PositionQuadric* q, const double normal[3], double distance, double weight)
+{
+    q->a00 += weight*normal[0]*normal[0];
+    q->a01 += weight*normal[0]*normal[1];
+    q->a02 += weight*normal[0]*normal[2];
+    q->a11 += weight*normal[1]*normal[1];
+    q->a12 += weight*normal[1]*normal[2];
+    q->a22 += weight*normal[2]*normal[2];
+    q->b0 += weight*normal[0]*distance;
+    q->b1 += weight*normal[1]*distance;
+    q->b2 += weight*normal[2]*distance;
+    q->c += weight*distance*distance;
+    q->weight += weight;
+}
+
+static void addQuadric(PositionQuadric* q, const PositionQuadric& other)
+{
+    q->a00 += other.a00;
+    q->a01 += other.a01;
+    q->a02 += other.a02;
+    q->a11 += other.a11;
+    q->a12 += other.a12;
+    q->a22 += other.a22;
+    q->b0 += other.b0;
+    q->b1 += other.b1;
+    q->b2 += other.b2;
+    q->c += other.c;
+    q->weight += other.weight;
+}
+
+static double evaluateQuadric(const PositionQuadric& q, const float* p)
+{
+    double x = p[0];
+    double y = p[1];
+    double z = p[2];
+    double result = q.a00*x*x + q.a11*y*y + q.a22*z*z +
+                    2.0*(q.a01*x*y + q.a02*x*z + q.a12*y*z) +
+                    2.0*(q.b0*x + q.b1*y + q.b2*z) + q.c;
+    // NOTE: Rounding can push this slightly below zero for points on all the planes
+    return (result > 0.0) ? result : 0.0;
+}
+
+static void addAttributes(AttributeQuadric* q, const float* attributes, int count, double weight)
+{
+    q->weight += weight;
+    for(int i=0; i<count; i++)
+    {
+        q->sum[i] += weight*attributes[i];
+        q->sumSquares += weight*attributes[i]*attributes[i];
+    }
+}
+
+static void addQuadric(AttributeQuadric* q, const AttributeQuadric& other, int count)
+{
+    q->weight += other.weight;
+    for(int i=0; i<count; i++)
+    {
+        q->sum[i] += other.sum[i];
+    }
+    q->sumSquares += other.sumSquares;
+}
+
+static double evaluateQuadric(const AttributeQuadric& q, const float* attributes, int count)
+{
+    double result = q.sumSquares;
+    for(int i=0; i<count; i++)
+    {
+        result += q.weight*attributes[i]*attributes[i] - 2.0*q.sum[i]*attributes[i];
+    }
+    return (result > 0.0) ? result : 0.0;
+}
+
+static void triangleNormal(const float* p0, const float* p1, const float* p2, double normal[3])
+{
+    double e1[3] = {(double)p1[0] - p0[0], (double)p1[1] - p0[1], (double)p1[2] - p0[2]};
+    double e2[3] = {(double)p2[0] - p0[0], (double)p2[1] - p0[1], (double)p2[2] - p0[2]};
+    normal[0] = e1[1]*e2[2] - e1[2]*e2[1];
+    normal[1] = e1[2]*e2[0] - e1[0]*e2[2];
+    normal[2] = e1[0]*e2[1] - e1[1]*e2[0];
+}
+
+// Vertices are looked up by the bits of their position, so that the vertices made for each
+// distinct uv/normal at the same point (a seam) end up together
+struct PositionHash
+{
+    const float* positions;
+
+    size_t operator()(unsigned int vertex) const
+    {
+        uint32_t bits[3];
+        memcpy(bits, &positions[vertex*3], sizeof(bits));
+        return (bits[0]*73856093u) ^ (bits[1]*19349663u) ^ (bits[2]*83492791u);
+    }
+};
+
+struct PositionEqual
+{
+    const float* positions;
+
+    bool operator()(unsigned int a, unsigned int b) const
+    {
+        return memcmp(&positions[a*3], &positions[b*3], 3*sizeof(float)) == 0;
+    }
+};
+
+struct EdgeCollapse
+{
+    unsigned int vertex;
+    unsigned int target;
+    double cost;
+};
+
+static bool cheaperCollapse(const EdgeCollapse& a, const EdgeCollapse& b)
+{
+    // Ties are broken by vertex so the result doesn't depend on the sort implementation
+    return (a.cost < b.cost) || ((a.cost == b.cost) && (a.vertex < b.vertex));
+}
+
+static bool collapseFoldsTriangle(const unsigned int* indices, const unsigned int* triangles,
+                                  unsigned int triangleCount, unsigned int vertex,
+                                  unsigned int target, const float* positions)
+{
+    for(unsigned int i=0; i<triangleCount; i++)
+    {
+        const unsigned int* triangle = &indices[triangles[i]*3];
+        if((triangle[0] == target) || (triangle[1] == target) || (triangle[2] == target))
+        {
+            // This one disappears with the collapse
+            continue;
+        }
+
+        const float* corners[3];
+        for(int corner=0; corner<3; corner++)
+        {
+            corners[corner] = &positions[triangle[corner]*3];
+        }
+        double before[3];
+        triangleNormal(corners[0], corners[1], corners[2], before);
+        for(int corner=0; corner<3; corner++)
+        {
+            if(triangle[corner] == vertex)
+            {
+                corners[corner] = &positions[target*3];
+            }
+        }
+        double after[3];
+        triangleNormal(corners[0], corners[1], corners[2], after);
+
+        double dot = before[0]*after[0] + before[1]*after[1] + before[2]*after[2];
+        double lengths = sqrt(before[0]*before[0] + before[1]*before[1] + before[2]*before[2])*
+                         sqrt(after[0]*after[0] + after[1]*after[1] + after[2]*after[2]);
+        if(dot < SIMPLIFY_MIN_NORMAL_DOT*lengths)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t simplifyMesh(unsigned int* destination, const unsigned int* indices, size_t indexCount,
+                    const float* positions, const float* textureCoords, const float* normals,
+                    size_t vertexCount, size_t targetIndexCount, float* resultError)
+{
+    if(resultError)
+    {
+        *resultError = 0.0f;
+    }
+    indexCount -= indexCount % 3;
+    vector<unsigned int> current(indices, indices + indexCount);
+    if((indexCount <= targetIndexCount) || (vertexCount == 0))
+    {
+        copy(current.begin(), current.end(), destination);
+        return current.size();
+    }
+
+    // Scale the mesh to fit in a unit cube, so that the attribute weights and the error don't
+    // depend on the units the model happens to be in
+    float boundsMin[3] = {positions[0], positions[1], positions[2]};
+    float boundsMax[3] = {positions[0], positions[1], positions[2]};
+    for(size_t v=0; v<vertexCount; v++)
+    {
+        for(int k=0; k<3; k++)
+        {
+            boundsMin[k] = min(boundsMin[k], positions[v*3 + k]);
+            boundsMax[k] = max(boundsMax[k], positions[v*3 + k]);
+        }
+    }
+    float extent = max(boundsMax[0] - boundsMin[0],
+                       max(boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2]));
+    float scale = (extent > 0.0f) ? 1.0f/extent : 1.0f;
+    vector<float> scaled(vertexCount*3);
+    for(size_t v=0; v<vertexCount; v++)
+    {
+        for(int k=0; k<3; k++)
+        {
+            scaled[v*3 + k] = (positions[v*3 + k] - boundsMin[k])*scale;
+        }
+    }
+
+    int attributeCount = 0;
+    if(textureCoords)
+    {
+        attributeCount += 2;
+    }
+    if(normals)
+    {
+        attributeCount += 3;
+    }
+    vector<float> attributes(vertexCount*attributeCount);
+    for(size_t v=0; v<vertexCount; v++)
+    {
+        float* attribute = &attributes[v*attributeCount];
+        if(textureCoords)
+        {
+            *attribute++ = textureCoords[v*2]*SIMPLIFY_TEXCOORD_WEIGHT;
+            *attribute++ = textureCoords[v*2 + 1]*SIMPLIFY_TEXCOORD_WEIGHT;
+        }
+        if(normals)
+        {
+            for(int k=0; k<3; k++)
+            {
+                *attribute++ = normals[v*3 + k]*SIMPLIFY_NORMAL_WEIGHT;
+            }
+        }
+    }
+
+    // Every vertex's position quadric is kept on the first vertex at that position, so that all
+    // sides of a seam share one
+    PositionHash hash = {positions};
+    PositionEqual equal = {positions};
+    unordered_map<unsigned int, unsigned int, PositionHash, PositionEqual>
+        firstAtPosition(vertexCount, hash, equal);
+    vector<unsigned int> canonical(vertexCount);
+    vector<unsigned int> verticesAtPosition(vertexCount, 0);
+    for(size_t v=0; v<vertexCount; v++)
+    {
+        canonical[v] = firstAtPosition.insert(make_pair((unsigned int)v, (unsigned int)v)).first->second;
+        verticesAtPosition[canonical[v]]++;
+    }
+
+    vector<PositionQuadric> positionQuadrics(vertexCount);
+    vector<AttributeQuadric> attributeQuadrics(vertexCount);
+    memset(positionQuadrics.data(), 0, vertexCount*sizeof(PositionQuadric));
+    memset(attributeQuadrics.data(), 0, vertexCount*sizeof(AttributeQuadric));
+    unordered_set<uint64_t> edges(indexCount);
+    for(size_t i=0; i<indexCount; i+=3)
+    {
+        const float* p0 = &scaled[current[i]*3];
+        double normal[3];
+        triangleNormal(p0, &scaled[current[i + 1]*3], &scaled[current[i + 2]*3], normal);
+        double length = sqrt(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+        if(length > 0.0)
+        {
+            for(int k=0; k<3; k++)
+            {
+                normal[k] /= length;
+            }
+            double distance = -(normal[0]*p0[0] + normal[1]*p0[1] + normal[2]*p0[2]);
+            double area = 0.5*length;
+            for(int corner=0; corner<3; corner++)
+            {
+                unsigned int vertex = current[i + corner];
+                addPlane(&positionQuadrics[canonical[vertex]], normal, distance, area);
+                addAttributes(&attributeQuadrics[vertex], &attributes[vertex*attributeCount],
+                              attributeCount, area/3.0);
+            }
+        }
+        for(int corner=0; corner<3; corner++)
+        {
+            uint64_t from = canonical[current[i + corner]];
+            uint64_t to = canonical[current[i + (corner + 1) % 3]];
+            edges.insert((from << 32) | to);
+        }
+    }
+
+    // Removing a vertex on an open border would eat into the hole, and removing one on a seam
+    // would tear the seam open, so both stay put (though other vertices can collapse onto them)
+    vector<bool> locked(vertexCount, false);
+    for(unordered_set<uint64_t>::iterator edge=edges.begin(); edge!=edges.end(); ++edge)
+    {
+        uint64_t from = *edge >> 32;
+        uint64_t to = *edge & 0xffffffffu;
+        if(edges.find((to << 32) | from) == edges.end())
+        {
+            locked[from] = true;
+            locked[to] = true;
+        }
+    }
+    for(size_t v=0; v<vertexCount; v++)
+    {
+        locked[v] = locked[canonical[v]] || (verticesAtPosition[canonical[v]] > 1);
+    }
+
+    double largestError = 0.0;
+    vector<unsigned int> firstTriangle(vertexCount + 1);
+    vector<unsigned int> vertexTriangles;
+    vector<unsigned int> collapseTarget(vertexCount);
+    vector<bool> touched(vertexCount);
+    vector<EdgeCollapse> collapses;
+    while(current.size() > targetIndexCount)
+    {
+        size_t triangleCount = current.size()/3;
+
+        // Triangles using each vertex, as ranges in one flat array
+        fill(firstTriangle.begin(), firstTriangle.end(), 0);
+        for(size_t i=0; i<current.size(); i++)
+        {
+            firstTriangle[current[i] + 1]++;
+        }
+        for(size_t v=0; v<vertexCount; v++)
+        {
+            firstTriangle[v + 1] += firstTriangle[v];
+        }
+        vertexTriangles.resize(current.size());
+        vector<unsigned int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+        for(size_t i=0; i<current.size(); i++)
+        {
+            vertexTriangles[filled[current[i]]++] = i/3;
+        }
+
+        // The cheapest way to remove each vertex: moving it onto whichever neighbour its
+        // accumulated quadrics say is closest
+        collapses.clear();
+        for(size_t v=0; v<vertexCount; v++)
+        {
+            if(locked[v] || (firstTriangle[v] == firstTriangle[v + 1]))
+            {
+                continue;
+            }
+            EdgeCollapse best;
+            best.vertex = v;
+            best.target = v;
+            best.cost = 0.0;
+            for(unsigned int j=firstTriangle[v]; j<firstTriangle[v + 1]; j++)
+            {
+                const unsigned int* triangle = &current[vertexTriangles[j]*3];
+                for(int corner=0; corner<3; corner++)
+                {
+                    unsigned int target = triangle[corner];
+                    if(target == v)
+                    {
+                        continue;
+                    }
+                    double cost = evaluateQuadric(positionQuadrics[v], &scaled[target*3]) +
+                                  evaluateQuadric(attributeQuadrics[v],
+                                                  &attributes[target*attributeCount],
+                                                  attributeCount);
+                    if((best.target == v) || (cost < best.cost))
+                    {
+                        best.target = target;
+                        best.cost = cost;
+                    }
+                }
+            }
+            if(best.target != v)
+            {
+                collapses.push_back(best);
+            }
+        }
+        sort(collapses.begin(), collapses.end(), cheaperCollapse);
+
+        // Collapses whose neighbourhoods overlap can't both be done in one pass, since the
+        // second one's cost and fold check were worked out on a mesh that no longer exists
+        size_t trianglesToRemove = triangleCount - targetIndexCount/3;
+        size_t trianglesRemoved = 0;
+        size_t considered = max<size_t>(1, (size_t)(collapses.size()*SIMPLIFY_PASS_FRACTION));
+        bool collapsed = false;
+        for(size_t v=0; v<vertexCount; v++)
+        {
+            collapseTarget[v] = v;
+        }
+        fill(touched.begin(), touched.end(), false);
+        for(size_t i=0; (i<considered) && (i<collapses.size()); i++)
+        {
+            const EdgeCollapse& collapse = collapses[i];
+            unsigned int vertex = collapse.vertex;
+            unsigned int target = collapse.target;
+            if(touched[vertex] || touched[target])
+            {
+                continue;
+            }
+            const unsigned int* triangles = &vertexTriangles[firstTriangle[vertex]];
+            unsigned int valence = firstTriangle[vertex + 1] - firstTriangle[vertex];
+            if(collapseFoldsTriangle(current.data(), triangles, valence, vertex, target,
+                                     scaled.data()))
+            {
+                continue;
+            }
+
+            const PositionQuadric& quadric = positionQuadrics[vertex];
+            if(quadric.weight > 0.0)
+            {
+                largestError = max(largestError,
+                                   evaluateQuadric(quadric, &scaled[target*3])/quadric.weight);
+            }
+            addQuadric(&positionQuadrics[canonical[target]], quadric);
+            addQuadric(&attributeQuadrics[target], attributeQuadrics[vertex], attributeCount);
+            collapseTarget[vertex] = target;
+            collapsed = true;
+
+            for(unsigned int j=0; j<valence; j++)
+            {
+                const unsigned int* triangle = &current[triangles[j]*3];
+                bool removed = false;
+                for(int corner=0; corner<3; corner++)
+                {
+                    touched[triangle[corner]] = true;
+                    removed = removed || (triangle[corner] == target);
+                }
+                if(removed)
+                {
+                    trianglesRemoved++;
+                }
+            }
+            if(trianglesRemoved >= trianglesToRemove)
+            {
+                break;
+            }
+        }
+        if(!collapsed)
+        {
+            break;
+        }
+
+        // NOTE: No vertex is both collapsed and collapsed onto in the same pass (they're all
+        //       touched), so one lookup per index is enough
+        size_t written = 0;
+        for(size_t i=0; i<current.size(); i+=3)
+        {
+            unsigned int a = collapseTarget[current[i]];
+            unsigned int b = collapseTarget[current[i + 1]];
+            unsigned int c = collapseTarget[current[i + 2]];
+            if((a != b) && (b != c) && (a != c))
+            {
+                current[written++] = a;
+                current[written++] = b;
+                current[written++] = c;
+            }
+        }
+        current.resize(written);
+    }
+
+    copy(current.begin(), current.end(), destination);
+    if(resultError)
+    {
+        *resultError = (float)(sqrt(largestError)/scale);
+    }
+    return current.size();
+}
@@ -0,0 +1,25 @@
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <stddef.h>
+
+// Mesh simplification for generating levels of detail. The simplified mesh reuses the vertices of
+// the original (every collapse moves a vertex onto one of its neighbours), so all the LODs of a
+// mesh can share one vertex buffer and differ only in their indices
+
+// Reduces an indexed triangle list to roughly targetIndexCount indices using quadric error metric
+// edge collapses (Garland & Heckbert, "Surface Simplification Using Quadric Error Metrics"). The
+// error of a collapse combines the distance moved from the original surface with how far the
+// texture coordinates and normals (either may be 0) of the merged vertices are from the ones
+// they're replaced with. Vertices on open borders and on uv/normal seams are never removed, so
+// the result can stay above the target.
+//
+// destination needs room for indexCount indices (it can't be the same array as indices). Returns
+// the number of indices written, and if resultError isn't 0 sets it to roughly how far the surface
+// moved (the largest RMS distance from a collapsed vertex's surroundings to where it went), in the
+// same units as the positions
+size_t simplifyMesh(unsigned int* destination, const unsigned int* indices, size_t indexCount,
+                    const float* positions, const float* textureCoords, const float* normals,
+                    size_t vertexCount, size_t targetIndexCount, float* resultError);
+
+#endif
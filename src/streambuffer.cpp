@@ -0,0 +1,221 @@
+#include <chrono>
+
+#include "streambuffer.h"
+
+// Every write starts on a multiple of this. It's the most GL_MIN_MAP_BUFFER_ALIGNMENT is allowed
+// to be, and more than vertex attributes and copies need
+static const size_t STREAM_ALIGNMENT = 64;
+
+StreamBuffer::StreamBuffer()
+{
+    bufferName = 0;
+    bufferCapacity = 0;
+    persistentMapping = false;
+    persistentData = 0;
+    mapped = false;
+    head = 0;
+    usedBytes = 0;
+    unfencedBytes = 0;
+}
+
+void StreamBuffer::create(GLStateCache& state, size_t capacity)
+{
+    if(bufferName)
+    {
+        destroy(state);
+    }
+    bufferCapacity = capacity;
+    glGenBuffers(1, &bufferName);
+    state.bindBuffer(GL_COPY_READ_BUFFER, bufferName);
+
+    persistentMapping = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    if(persistentMapping)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_READ_BUFFER, capacity, 0, flags);
+        persistentData = (unsigned char*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, capacity, flags);
+        persistentMapping = (persistentData != 0);
+    }
+    if(!persistentMapping)
+    {
+        glBufferData(GL_COPY_READ_BUFFER, capacity, 0, GL_STREAM_DRAW);
+    }
+    head = 0;
+    usedBytes = 0;
+    unfencedBytes = 0;
+    stats = StreamStats();
+}
+
+void StreamBuffer::destroy(GLStateCache& state)
+{
+    if(!bufferName)
+    {
+        return;
+    }
+    for(size_t i=0; i<segments.size(); i++)
+    {
+        glDeleteSync(segments[i].fence);
+    }
+    segments.clear();
+    if(persistentData || mapped)
+    {
+        state.bindBuffer(GL_COPY_READ_BUFFER, bufferName);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+    }
+    glDeleteBuffers(1, &bufferName);
+    bufferName = 0;
+    persistentData = 0;
+    mapped = false;
+
+    // NOTE: Deleting a bound buffer unbinds it, and its name can be handed out again
+    state.invalidate();
+}
+
+bool StreamBuffer::created()
+{
+    return bufferName != 0;
+}
+
+void* StreamBuffer::map(GLStateCache& state, size_t size, size_t* offset)
+{
+    if(!bufferName || (size > bufferCapacity))
+    {
+        return 0;
+    }
+
+    reclaimFinished();
+    size_t start;
+    size_t needed;
+    while(true)
+    {
+        // With nothing in flight, the next write might as well start from the beginning
+        if(usedBytes == 0)
+        {
+            head = 0;
+        }
+        start = (head + STREAM_ALIGNMENT-1) & ~(STREAM_ALIGNMENT-1);
+        if(start + size > bufferCapacity)
+        {
+            // Skip what's left at the end and start again from the beginning
+            needed = bufferCapacity - head + size;
+            start = 0;
+        }
+        else
+        {
+            needed = start - head + size;
+        }
+        if(usedBytes + needed <= bufferCapacity)
+        {
+            break;
+        }
+
+        // Data written this frame can be what's in the way when a lot is written at once (such
+        // as a whole mesh being uploaded), so it gets its own fence to wait on
+        if(segments.empty())
+        {
+            fenceSegment();
+        }
+        reclaimOldest();
+    }
+
+    head = start + size;
+    usedBytes += needed;
+    unfencedBytes += needed;
+    stats.bytes += size;
+    *offset = start;
+    if(persistentMapping)
+    {
+        return persistentData + start;
+    }
+
+    // NOTE: The fences already guarantee GL is done with this range, so the driver doesn't need to
+    //       synchronize (or keep the old contents)
+    state.bindBuffer(GL_COPY_READ_BUFFER, bufferName);
+    mapped = true;
+    return glMapBufferRange(GL_COPY_READ_BUFFER, start, size,
+                            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+}
+
+void StreamBuffer::unmap(GLStateCache& state)
+{
+    if(!mapped)
+    {
+        return;
+    }
+    state.bindBuffer(GL_COPY_READ_BUFFER, bufferName);
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+    mapped = false;
+}
+
+StreamStats StreamBuffer::endFrame()
+{
+    if(bufferName && (unfencedBytes > 0))
+    {
+        fenceSegment();
+    }
+    reclaimFinished();
+    StreamStats frame = stats;
+    stats = StreamStats();
+    return frame;
+}
+
+GLuint StreamBuffer::buffer()
+{
+    return bufferName;
+}
+
+size_t StreamBuffer::capacity()
+{
+    return bufferCapacity;
+}
+
+bool StreamBuffer::persistent()
+{
+    return persistentMapping;
+}
+
+void StreamBuffer::fenceSegment()
+{
+    Segment segment;
+    segment.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    segment.bytes = unfencedBytes;
+    segments.push_back(segment);
+    unfencedBytes = 0;
+}
+
+void StreamBuffer::reclaimFinished()
+{
+    while(!segments.empty())
+    {
+        GLenum status = glClientWaitSync(segments.front().fence, 0, 0);
+        if((status != GL_ALREADY_SIGNALED) && (status != GL_CONDITION_SATISFIED))
+        {
+            return;
+        }
+        glDeleteSync(segments.front().fence);
+        usedBytes -= segments.front().bytes;
+        segments.pop_front();
+    }
+}
+
+void StreamBuffer::reclaimOldest()
+{
+    Segment& oldest = segments.front();
+    GLenum status = glClientWaitSync(oldest.fence, 0, 0);
+    if((status != GL_ALREADY_SIGNALED) && (status != GL_CONDITION_SATISFIED))
+    {
+        std::chrono::steady_clock::time_point stallStart = std::chrono::steady_clock::now();
+        // NOTE: The fence might not even have been sent to the GPU yet, hence the flush
+        do
+        {
+            status = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        }
+        while(status == GL_TIMEOUT_EXPIRED);
+        stats.stalls++;
+        stats.stallMicroseconds += std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - stallStart).count();
+    }
+    glDeleteSync(oldest.fence);
+    usedBytes -= oldest.bytes;
+    segments.pop_front();
+}
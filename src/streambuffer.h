@@ -0,0 +1,84 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <deque>
+#include <stddef.h>
+
+#include <GL/glew.h>
+
+#include "glstate.h"
+
+// What a StreamBuffer did over one frame
+struct StreamStats
+{
+    // Bytes written into the ring
+    long long bytes = 0;
+    // Times it had to wait for the GPU to finish with older data before there was room, and how
+    // long those waits took altogether
+    int stalls = 0;
+    double stallMicroseconds = 0.0;
+};
+
+// A ring buffer for streaming data to the GPU without reallocating anything. Data is written
+// straight into mapped buffer memory at the ring's head, and GL then reads it from there (a vertex
+// attribute pointing into it, or a copy into a static buffer). The buffer is mapped once for good
+// with GL_ARB_buffer_storage (persistent and coherent, so nothing needs flushing); without it each
+// write maps its range unsynchronized. A fence goes in after every frame's commands, and the space
+// written during the frame is only reused once the GPU has passed its fence, so the ring waits on
+// the GPU (a stall) only when it's filled faster than the GPU catches up
+class StreamBuffer
+{
+public:
+    StreamBuffer();
+
+    void create(GLStateCache& state, size_t capacity);
+    void destroy(GLStateCache& state);
+    bool created();
+
+    // Reserves size bytes of the ring (aligned for any use) and returns where to write them,
+    // setting offset to where they are in buffer(). Waits for the GPU if the ring is full of data
+    // it might still be reading. Returns null if size is more than the whole ring
+    void* map(GLStateCache& state, size_t size, size_t* offset);
+    // Has to be called after writing what map returned, before GL reads it
+    void unmap(GLStateCache& state);
+
+    // Fences everything issued so far (call it once all of a frame's commands are in), and returns
+    // the stats since the last call
+    StreamStats endFrame();
+
+    GLuint buffer();
+    size_t capacity();
+    // Whether the buffer is persistently mapped rather than mapped for each write
+    bool persistent();
+
+private:
+    // Space written between two fences, reusable once the GPU has passed the fence
+    struct Segment
+    {
+        GLsync fence;
+        size_t bytes;
+    };
+
+    void fenceSegment();
+    // Frees the segments the GPU has finished with, without waiting
+    void reclaimFinished();
+    // Frees the oldest segment, waiting for the GPU if it hasn't finished with it
+    void reclaimOldest();
+
+    GLuint bufferName;
+    size_t bufferCapacity;
+    bool persistentMapping;
+    unsigned char* persistentData;
+    bool mapped;
+
+    // Where the next write goes, bytes between the oldest unfinished segment and head (including
+    // what's been skipped at the end when wrapping around), and how many of those haven't been
+    // fenced yet
+    size_t head;
+    size_t usedBytes;
+    size_t unfencedBytes;
+    std::deque<Segment> segments;
+    StreamStats stats;
+};
+
+#endif
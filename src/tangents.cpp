@@ -0,0 +1,387 @@
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <vector>
+#include <math.h>
+
+#include "tangents.h"
+
+using namespace std;
+
+// NOTE: While they're being added up, each vertex's tangent is 4 floats: the area weighted sum of
+//       its triangles' tangents, and the sum of their areas with the sign of their handedness. So
+//       a triangle corner is added to its vertex with a single vector add.
+//       The SIMD versions below do the same operations in the same order as the functions here,
+//       so both give the same results (without -ffast-math or FMA contraction)
+
+// The tangent of a triangle scaled to its (doubled) area, the cross product of its edges, and its
+// area negated if its uvs are mirrored. All zero if its uvs or positions are degenerate
+static void faceTangent(const float* positions, const float* textureCoords,
+                        const unsigned int* corners, float tangent[4], float cross[3])
+{
+    const float* p0 = &positions[3*corners[0]];
+    const float* p1 = &positions[3*corners[1]];
+    const float* p2 = &positions[3*corners[2]];
+    const float* uv0 = &textureCoords[2*corners[0]];
+    const float* uv1 = &textureCoords[2*corners[1]];
+    const float* uv2 = &textureCoords[2*corners[2]];
+
+    float e1x = p1[0] - p0[0];
+    float e1y = p1[1] - p0[1];
+    float e1z = p1[2] - p0[2];
+    float e2x = p2[0] - p0[0];
+    float e2y = p2[1] - p0[1];
+    float e2z = p2[2] - p0[2];
+    float du1 = uv1[0] - uv0[0];
+    float dv1 = uv1[1] - uv0[1];
+    float du2 = uv2[0] - uv0[0];
+    float dv2 = uv2[1] - uv0[1];
+
+    // The tangent is (dv2*e1 - dv1*e2)/det. Only its direction is needed, so rather than
+    // dividing by the determinant (which is 0 when the uvs are all in a line) it's flipped when
+    // the determinant is negative, and dropped when it's 0
+    float det = du1*dv2 - du2*dv1;
+    float tx = dv2*e1x - dv1*e2x;
+    float ty = dv2*e1y - dv1*e2y;
+    float tz = dv2*e1z - dv1*e2z;
+    cross[0] = e1y*e2z - e1z*e2y;
+    cross[1] = e1z*e2x - e1x*e2z;
+    cross[2] = e1x*e2y - e1y*e2x;
+    float area = sqrtf(cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]);
+    float tangentLength = sqrtf(tx*tx + ty*ty + tz*tz);
+
+    float scale = 0.0f;
+    tangent[3] = 0.0f;
+    if((det != 0.0f) && (tangentLength > 0.0f))
+    {
+        scale = (det < 0.0f) ? -(area/tangentLength) : area/tangentLength;
+        tangent[3] = (det < 0.0f) ? -area : area;
+    }
+    tangent[0] = tx*scale;
+    tangent[1] = ty*scale;
+    tangent[2] = tz*scale;
+}
+
+static void addFaceTangent(float* sums, const float* normals, size_t firstVertex,
+                           const unsigned int* corners, const float tangent[4],
+                           const float cross[3])
+{
+    for(int corner=0; corner<3; corner++)
+    {
+        // The handedness is relative to the side the triangle faces, so it flips if the vertex's
+        // normal points the other way
+        const float* normal = &normals[3*corners[corner]];
+        float facing = normal[0]*cross[0] + normal[1]*cross[1] + normal[2]*cross[2];
+        float* sum = &sums[4*(corners[corner] - firstVertex)];
+        sum[0] += tangent[0];
+        sum[1] += tangent[1];
+        sum[2] += tangent[2];
+        sum[3] += (facing < 0.0f) ? -tangent[3] : tangent[3];
+    }
+}
+
+// Makes the summed tangent perpendicular to the normal (which needn't be exactly unit length,
+// or even there) and unit length
+static void finishTangent(const float* normal, const float* sum, float* tangent)
+{
+    float x = sum[0];
+    float y = sum[1];
+    float z = sum[2];
+    float normalLengthSquared = normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2];
+    float dot = normal[0]*x + normal[1]*y + normal[2]*z;
+    float along = (normalLengthSquared > 0.0f) ? dot/normalLengthSquared : 0.0f;
+    x = x - normal[0]*along;
+    y = y - normal[1]*along;
+    z = z - normal[2]*along;
+    float length = sqrtf(x*x + y*y + z*z);
+    if(!(length > 0.0f))
+    {
+        // Nothing to go on (or the tangents were all along the normal), so any direction
+        // perpendicular to the normal will do
+        x = (fabsf(normal[0]) < 0.9f*sqrtf(normalLengthSquared)) ? 1.0f : 0.0f;
+        y = 1.0f - x;
+        z = 0.0f;
+        dot = normal[0]*x + normal[1]*y + normal[2]*z;
+        along = (normalLengthSquared > 0.0f) ? dot/normalLengthSquared : 0.0f;
+        x = x - normal[0]*along;
+        y = y - normal[1]*along;
+        z = z - normal[2]*along;
+        length = sqrtf(x*x + y*y + z*z);
+    }
+    tangent[0] = x/length;
+    tangent[1] = y/length;
+    tangent[2] = z/length;
+    tangent[3] = (sum[3] < 0.0f) ? -1.0f : 1.0f;
+}
+
+void generateTangentsScalar(const float* positions, const float* textureCoords,
+                            const float* normals, size_t firstVertex, size_t vertexCount,
+                            const unsigned int* indices, size_t indexCount, float* tangents)
+{
+    vector<float> sums(4*(vertexCount - firstVertex), 0.0f);
+    for(size_t index=0; index+2<indexCount; index+=3)
+    {
+        float tangent[4];
+        float cross[3];
+        faceTangent(positions, textureCoords, &indices[index], tangent, cross);
+        addFaceTangent(sums.data(), normals, firstVertex, &indices[index], tangent, cross);
+    }
+    for(size_t vertex=firstVertex; vertex<vertexCount; vertex++)
+    {
+        finishTangent(&normals[3*vertex], &sums[4*(vertex - firstVertex)], &tangents[4*vertex]);
+    }
+}
+
+#if defined(__AVX__)
+// One coordinate of one corner of 8 triangles (whose indices are at triangles)
+static inline __m256 gatherCorners(const float* array, int components, int component,
+                                   const unsigned int* triangles, int corner)
+{
+    return _mm256_setr_ps(array[components*triangles[corner] + component],
+                          array[components*triangles[3 + corner] + component],
+                          array[components*triangles[6 + corner] + component],
+                          array[components*triangles[9 + corner] + component],
+                          array[components*triangles[12 + corner] + component],
+                          array[components*triangles[15 + corner] + component],
+                          array[components*triangles[18 + corner] + component],
+                          array[components*triangles[21 + corner] + component]);
+}
+#elif defined(__SSE2__)
+// One coordinate of one corner of 4 triangles (whose indices are at triangles)
+static inline __m128 gatherCorners(const float* array, int components, int component,
+                                   const unsigned int* triangles, int corner)
+{
+    return _mm_setr_ps(array[components*triangles[corner] + component],
+                       array[components*triangles[3 + corner] + component],
+                       array[components*triangles[6 + corner] + component],
+                       array[components*triangles[9 + corner] + component]);
+}
+#endif
+
+#if defined(__AVX__) || defined(__SSE2__)
+// Adds 4 triangles' tangents (transposed from x, y, z, w vectors) to their vertices at one corner
+static inline void addCornerTangents(float* sums, size_t firstVertex, const unsigned int* triangles,
+                                     int corner, __m128 x, __m128 y, __m128 z, __m128 w)
+{
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    __m128 rows[4] = {x, y, z, w};
+    for(int lane=0; lane<4; lane++)
+    {
+        float* sum = &sums[4*(triangles[3*lane + corner] - firstVertex)];
+        _mm_storeu_ps(sum, _mm_add_ps(_mm_loadu_ps(sum), rows[lane]));
+    }
+}
+#endif
+
+void generateTangents(const float* positions, const float* textureCoords, const float* normals,
+                      size_t firstVertex, size_t vertexCount,
+                      const unsigned int* indices, size_t indexCount, float* tangents)
+{
+    vector<float> sums(4*(vertexCount - firstVertex), 0.0f);
+    size_t triangleCount = indexCount/3;
+    size_t triangle = 0;
+
+#if defined(__AVX__)
+    // Eight triangles at a time: their corners are gathered into one vector per coordinate,
+    // their tangents worked out together, and then added to each vertex with one vector add
+    __m256 zero = _mm256_setzero_ps();
+    __m256 signBit = _mm256_set1_ps(-0.0f);
+    for(; triangle+8<=triangleCount; triangle+=8)
+    {
+        const unsigned int* triangles = &indices[3*triangle];
+        __m256 p0x = gatherCorners(positions, 3, 0, triangles, 0);
+        __m256 p0y = gatherCorners(positions, 3, 1, triangles, 0);
+        __m256 p0z = gatherCorners(positions, 3, 2, triangles, 0);
+        __m256 e1x = _mm256_sub_ps(gatherCorners(positions, 3, 0, triangles, 1), p0x);
+        __m256 e1y = _mm256_sub_ps(gatherCorners(positions, 3, 1, triangles, 1), p0y);
+        __m256 e1z = _mm256_sub_ps(gatherCorners(positions, 3, 2, triangles, 1), p0z);
+        __m256 e2x = _mm256_sub_ps(gatherCorners(positions, 3, 0, triangles, 2), p0x);
+        __m256 e2y = _mm256_sub_ps(gatherCorners(positions, 3, 1, triangles, 2), p0y);
+        __m256 e2z = _mm256_sub_ps(gatherCorners(positions, 3, 2, triangles, 2), p0z);
+        __m256 u0 = gatherCorners(textureCoords, 2, 0, triangles, 0);
+        __m256 v0 = gatherCorners(textureCoords, 2, 1, triangles, 0);
+        __m256 du1 = _mm256_sub_ps(gatherCorners(textureCoords, 2, 0, triangles, 1), u0);
+        __m256 dv1 = _mm256_sub_ps(gatherCorners(textureCoords, 2, 1, triangles, 1), v0);
+        __m256 du2 = _mm256_sub_ps(gatherCorners(textureCoords, 2, 0, triangles, 2), u0);
+        __m256 dv2 = _mm256_sub_ps(gatherCorners(textureCoords, 2, 1, triangles, 2), v0);
+
+        __m256 det = _mm256_sub_ps(_mm256_mul_ps(du1, dv2), _mm256_mul_ps(du2, dv1));
+        __m256 tx = _mm256_sub_ps(_mm256_mul_ps(dv2, e1x), _mm256_mul_ps(dv1, e2x));
+        __m256 ty = _mm256_sub_ps(_mm256_mul_ps(dv2, e1y), _mm256_mul_ps(dv1, e2y));
+        __m256 tz = _mm256_sub_ps(_mm256_mul_ps(dv2, e1z), _mm256_mul_ps(dv1, e2z));
+        __m256 cx = _mm256_sub_ps(_mm256_mul_ps(e1y, e2z), _mm256_mul_ps(e1z, e2y));
+        __m256 cy = _mm256_sub_ps(_mm256_mul_ps(e1z, e2x), _mm256_mul_ps(e1x, e2z));
+        __m256 cz = _mm256_sub_ps(_mm256_mul_ps(e1x, e2y), _mm256_mul_ps(e1y, e2x));
+        __m256 area = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx),
+                                                                 _mm256_mul_ps(cy, cy)),
+                                                   _mm256_mul_ps(cz, cz)));
+        __m256 tangentLength = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tx, tx),
+                                                                          _mm256_mul_ps(ty, ty)),
+                                                            _mm256_mul_ps(tz, tz)));
+
+        // NOTE: Degenerate triangles divide by zero here, and are then masked out to zero
+        __m256 valid = _mm256_and_ps(_mm256_cmp_ps(det, zero, _CMP_NEQ_UQ),
+                                     _mm256_cmp_ps(tangentLength, zero, _CMP_GT_OQ));
+        __m256 detSign = _mm256_and_ps(det, signBit);
+        __m256 scale = _mm256_and_ps(valid, _mm256_xor_ps(_mm256_div_ps(area, tangentLength), detSign));
+        tx = _mm256_mul_ps(tx, scale);
+        ty = _mm256_mul_ps(ty, scale);
+        tz = _mm256_mul_ps(tz, scale);
+        __m256 handedness = _mm256_and_ps(valid, _mm256_xor_ps(area, detSign));
+
+        for(int corner=0; corner<3; corner++)
+        {
+            __m256 facing = _mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(gatherCorners(normals, 3, 0, triangles, corner), cx),
+                _mm256_mul_ps(gatherCorners(normals, 3, 1, triangles, corner), cy)),
+                _mm256_mul_ps(gatherCorners(normals, 3, 2, triangles, corner), cz));
+            __m256 w = _mm256_xor_ps(handedness,
+                                     _mm256_and_ps(_mm256_cmp_ps(facing, zero, _CMP_LT_OQ), signBit));
+            addCornerTangents(sums.data(), firstVertex, triangles, corner,
+                              _mm256_castps256_ps128(tx), _mm256_castps256_ps128(ty),
+                              _mm256_castps256_ps128(tz), _mm256_castps256_ps128(w));
+            addCornerTangents(sums.data(), firstVertex, triangles + 12, corner,
+                              _mm256_extractf128_ps(tx, 1), _mm256_extractf128_ps(ty, 1),
+                              _mm256_extractf128_ps(tz, 1), _mm256_extractf128_ps(w, 1));
+        }
+    }
+#elif defined(__SSE2__)
+    // Four triangles at a time, as above
+    __m128 zero = _mm_setzero_ps();
+    __m128 signBit = _mm_set1_ps(-0.0f);
+    for(; triangle+4<=triangleCount; triangle+=4)
+    {
+        const unsigned int* triangles = &indices[3*triangle];
+        __m128 p0x = gatherCorners(positions, 3, 0, triangles, 0);
+        __m128 p0y = gatherCorners(positions, 3, 1, triangles, 0);
+        __m128 p0z = gatherCorners(positions, 3, 2, triangles, 0);
+        __m128 e1x = _mm_sub_ps(gatherCorners(positions, 3, 0, triangles, 1), p0x);
+        __m128 e1y = _mm_sub_ps(gatherCorners(positions, 3, 1, triangles, 1), p0y);
+        __m128 e1z = _mm_sub_ps(gatherCorners(positions, 3, 2, triangles, 1), p0z);
+        __m128 e2x = _mm_sub_ps(gatherCorners(positions, 3, 0, triangles, 2), p0x);
+        __m128 e2y = _mm_sub_ps(gatherCorners(positions, 3, 1, triangles, 2), p0y);
+        __m128 e2z = _mm_sub_ps(gatherCorners(positions, 3, 2, triangles, 2), p0z);
+        __m128 u0 = gatherCorners(textureCoords, 2, 0, triangles, 0);
+        __m128 v0 = gatherCorners(textureCoords, 2, 1, triangles, 0);
+        __m128 du1 = _mm_sub_ps(gatherCorners(textureCoords, 2, 0, triangles, 1), u0);
+        __m128 dv1 = _mm_sub_ps(gatherCorners(textureCoords, 2, 1, triangles, 1), v0);
+        __m128 du2 = _mm_sub_ps(gatherCorners(textureCoords, 2, 0, triangles, 2), u0);
+        __m128 dv2 = _mm_sub_ps(gatherCorners(textureCoords, 2, 1, triangles, 2), v0);
+
+        __m128 det = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1));
+        __m128 tx = _mm_sub_ps(_mm_mul_ps(dv2, e1x), _mm_mul_ps(dv1, e2x));
+        __m128 ty = _mm_sub_ps(_mm_mul_ps(dv2, e1y), _mm_mul_ps(dv1, e2y));
+        __m128 tz = _mm_sub_ps(_mm_mul_ps(dv2, e1z), _mm_mul_ps(dv1, e2z));
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x));
+        __m128 area = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)),
+                                             _mm_mul_ps(cz, cz)));
+        __m128 tangentLength = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx),
+                                                                 _mm_mul_ps(ty, ty)),
+                                                      _mm_mul_ps(tz, tz)));
+
+        // NOTE: Degenerate triangles divide by zero here, and are then masked out to zero
+        __m128 valid = _mm_and_ps(_mm_cmpneq_ps(det, zero), _mm_cmpgt_ps(tangentLength, zero));
+        __m128 detSign = _mm_and_ps(det, signBit);
+        __m128 scale = _mm_and_ps(valid, _mm_xor_ps(_mm_div_ps(area, tangentLength), detSign));
+        tx = _mm_mul_ps(tx, scale);
+        ty = _mm_mul_ps(ty, scale);
+        tz = _mm_mul_ps(tz, scale);
+        __m128 handedness = _mm_and_ps(valid, _mm_xor_ps(area, detSign));
+
+        for(int corner=0; corner<3; corner++)
+        {
+            __m128 facing = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(gatherCorners(normals, 3, 0, triangles, corner), cx),
+                _mm_mul_ps(gatherCorners(normals, 3, 1, triangles, corner), cy)),
+                _mm_mul_ps(gatherCorners(normals, 3, 2, triangles, corner), cz));
+            __m128 w = _mm_xor_ps(handedness, _mm_and_ps(_mm_cmplt_ps(facing, zero), signBit));
+            addCornerTangents(sums.data(), firstVertex, triangles, corner, tx, ty, tz, w);
+        }
+    }
+#endif
+
+    // Whatever doesn't fill a whole vector
+    for(; triangle<triangleCount; triangle++)
+    {
+        float tangent[4];
+        float cross[3];
+        faceTangent(positions, textureCoords, &indices[3*triangle], tangent, cross);
+        addFaceTangent(sums.data(), normals, firstVertex, &indices[3*triangle], tangent, cross);
+    }
+
+    size_t vertex = firstVertex;
+#if defined(__SSE2__)
+    // Four vertices at a time (even with AVX, since this is mostly moving data around), with their
+    // sums transposed to one vector per coordinate and back
+    __m128 zero4 = _mm_setzero_ps();
+    for(; vertex+4<=vertexCount; vertex+=4)
+    {
+        const float* sum = &sums[4*(vertex - firstVertex)];
+        __m128 x = _mm_loadu_ps(sum);
+        __m128 y = _mm_loadu_ps(sum + 4);
+        __m128 z = _mm_loadu_ps(sum + 8);
+        __m128 w = _mm_loadu_ps(sum + 12);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        const float* normal = &normals[3*vertex];
+        __m128 nx = _mm_setr_ps(normal[0], normal[3], normal[6], normal[9]);
+        __m128 ny = _mm_setr_ps(normal[1], normal[4], normal[7], normal[10]);
+        __m128 nz = _mm_setr_ps(normal[2], normal[5], normal[8], normal[11]);
+
+        __m128 normalLengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)),
+                                                _mm_mul_ps(nz, nz));
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, x), _mm_mul_ps(ny, y)), _mm_mul_ps(nz, z));
+        __m128 along = _mm_and_ps(_mm_cmpgt_ps(normalLengthSquared, zero4),
+                                  _mm_div_ps(dot, normalLengthSquared));
+        x = _mm_sub_ps(x, _mm_mul_ps(nx, along));
+        y = _mm_sub_ps(y, _mm_mul_ps(ny, along));
+        z = _mm_sub_ps(z, _mm_mul_ps(nz, along));
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+                                               _mm_mul_ps(z, z)));
+        int validMask = _mm_movemask_ps(_mm_cmpgt_ps(length, zero4));
+        x = _mm_div_ps(x, length);
+        y = _mm_div_ps(y, length);
+        z = _mm_div_ps(z, length);
+        w = _mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(_mm_cmplt_ps(w, zero4), _mm_set1_ps(-0.0f)));
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        float* output = &tangents[4*vertex];
+        _mm_storeu_ps(output, x);
+        _mm_storeu_ps(output + 4, y);
+        _mm_storeu_ps(output + 8, z);
+        _mm_storeu_ps(output + 12, w);
+
+        // Vertices with nothing to go on are rare, so they're redone one at a time
+        if(validMask != 0xf)
+        {
+            for(int lane=0; lane<4; lane++)
+            {
+                if(!((validMask >> lane) & 1))
+                {
+                    finishTangent(&normals[3*(vertex+lane)], &sums[4*(vertex + lane - firstVertex)],
+                                  &tangents[4*(vertex+lane)]);
+                }
+            }
+        }
+    }
+#endif
+
+    for(; vertex<vertexCount; vertex++)
+    {
+        finishTangent(&normals[3*vertex], &sums[4*(vertex - firstVertex)], &tangents[4*vertex]);
+    }
+}
+
+const char* tangentInstructionSet()
+{
+#if defined(__AVX__)
+    return "AVX";
+#elif defined(__SSE2__)
+    return "SSE";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,31 @@
+#ifndef TANGENTS_H
+#define TANGENTS_H
+
+#include <stddef.h>
+
+// Tangent frames for normal mapping. Each vertex gets a tangent as 4 floats: a unit vector
+// perpendicular to its normal pointing along increasing u, and in w the handedness of the frame
+// (1 or -1), so the bitangent is cross(normal, tangent)*w and doesn't need to be stored
+//
+// Every triangle's tangent is weighted by its area and added to its three vertices, then each
+// vertex's sum is made perpendicular to the normal (Gram-Schmidt) and normalized. Triangles whose
+// uvs don't span an area (or whose positions don't) add nothing, and a vertex left with no
+// tangent gets an arbitrary one perpendicular to its normal, so the result is always finite.
+// The triangles are worked on 8 at a time with AVX or 4 with SSE, with their corners gathered
+// into one vector per coordinate first
+
+// Sets the tangents (4 floats each) of vertices firstVertex to vertexCount-1 from the triangles in
+// indices, which must only use those vertices. positions and normals are x, y, z floats and
+// textureCoords u, v floats, all for every vertex
+void generateTangents(const float* positions, const float* textureCoords, const float* normals,
+                      size_t firstVertex, size_t vertexCount,
+                      const unsigned int* indices, size_t indexCount, float* tangents);
+// The same, one triangle and vertex at a time, as a reference for the above
+void generateTangentsScalar(const float* positions, const float* textureCoords,
+                            const float* normals, size_t firstVertex, size_t vertexCount,
+                            const unsigned int* indices, size_t indexCount, float* tangents);
+
+// "AVX", "SSE" or "scalar", whichever generateTangents was built with
+const char* tangentInstructionSet();
+
+#endif
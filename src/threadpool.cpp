@@ -0,0 +1,92 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(int threadCount)
+{
+    activeTaskCount = 0;
+    stopping = false;
+
+    if(threadCount <= 0)
+    {
+        threadCount = hardwareThreadCount();
+    }
+    for(int i=0; i<threadCount; i++)
+    {
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for(size_t i=0; i<workers.size(); i++)
+    {
+        workers[i].join();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        tasks.push_back(task);
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while(!tasks.empty() || (activeTaskCount > 0))
+    {
+        tasksFinished.wait(lock);
+    }
+}
+
+int ThreadPool::threadCount() const
+{
+    return workers.size();
+}
+
+int ThreadPool::hardwareThreadCount()
+{
+    // NOTE: hardware_concurrency is allowed to return 0 when it can't tell
+    int count = std::thread::hardware_concurrency();
+    return (count > 0) ? count : 1;
+}
+
+void ThreadPool::workerLoop()
+{
+    while(true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            while(tasks.empty() && !stopping)
+            {
+                taskAvailable.wait(lock);
+            }
+            if(tasks.empty())
+            {
+                return;
+            }
+            task = tasks.front();
+            tasks.pop_front();
+            activeTaskCount++;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            activeTaskCount--;
+            if(tasks.empty() && (activeTaskCount == 0))
+            {
+                tasksFinished.notify_all();
+            }
+        }
+    }
+}
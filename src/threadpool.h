@@ -0,0 +1,42 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// A fixed set of worker threads pulling tasks off a shared queue
+class ThreadPool
+{
+public:
+    // A thread count of 0 uses one thread per hardware core
+    explicit ThreadPool(int threadCount = 0);
+    ~ThreadPool();
+
+    void enqueue(std::function<void()> task);
+    // Blocks until every task enqueued so far has finished
+    void wait();
+
+    int threadCount() const;
+
+    static int hardwareThreadCount();
+
+private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()> > tasks;
+    std::mutex queueMutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable tasksFinished;
+    int activeTaskCount;
+    bool stopping;
+};
+
+#endif
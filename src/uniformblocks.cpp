@@ -0,0 +1,121 @@
+#include <string.h>
+
+#include "uniformblocks.h"
+#include "streambuffer.h"
+
+UniformBlocks::UniformBlocks()
+{
+    cameraBuffer = 0;
+    objectBuffer = 0;
+    objectSource = 0;
+    objectOffset = 0;
+    objectStride = sizeof(glm::mat4);
+}
+
+void UniformBlocks::create(GLStateCache& state)
+{
+    if(cameraBuffer)
+    {
+        destroy(state);
+    }
+    glGenBuffers(1, &cameraBuffer);
+    glGenBuffers(1, &objectBuffer);
+    CameraBlock camera;
+    state.bindBuffer(GL_UNIFORM_BUFFER, cameraBuffer);
+    state.bufferData(GL_UNIFORM_BUFFER, sizeof(camera), &camera, GL_DYNAMIC_DRAW);
+    //nothing else uses the camera's binding point, so it stays bound for good
+    state.bindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, cameraBuffer, 0, sizeof(camera));
+
+    //each model matrix gets a whole number of alignment units, so every one can be bound
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if(alignment < 1)
+    {
+        alignment = 1;
+    }
+    objectStride = ((sizeof(glm::mat4) + alignment-1)/alignment)*alignment;
+}
+
+void UniformBlocks::destroy(GLStateCache& state)
+{
+    glDeleteBuffers(1, &cameraBuffer);
+    glDeleteBuffers(1, &objectBuffer);
+    cameraBuffer = 0;
+    objectBuffer = 0;
+    objectSource = 0;
+
+    // NOTE: Deleting a bound buffer unbinds it, and its name can be handed out again
+    state.invalidate();
+}
+
+void UniformBlocks::bindProgram(GLuint program)
+{
+    GLuint camera = glGetUniformBlockIndex(program, "Camera");
+    if(camera != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(program, camera, CAMERA_BLOCK_BINDING);
+    }
+    GLuint object = glGetUniformBlockIndex(program, "Object");
+    if(object != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(program, object, OBJECT_BLOCK_BINDING);
+    }
+}
+
+void UniformBlocks::setCamera(GLStateCache& state, const glm::mat4& view,
+                              const glm::mat4& projection)
+{
+    CameraBlock camera;
+    camera.viewProjection = projection * view;
+    camera.view = view;
+    camera.projection = projection;
+    // NOTE: Orphaning the old storage means the driver doesn't have to wait for last frame's draws
+    //       to finish reading it
+    state.bindBuffer(GL_UNIFORM_BUFFER, cameraBuffer);
+    state.bufferData(GL_UNIFORM_BUFFER, sizeof(camera), &camera, GL_DYNAMIC_DRAW);
+}
+
+void UniformBlocks::setObjects(GLStateCache& state, const glm::mat4* models, int count)
+{
+    if(count <= 0)
+    {
+        return;
+    }
+    size_t bytes = count*objectStride;
+    StreamBuffer* stream = state.streamBuffer();
+    if(stream)
+    {
+        //the ring only aligns writes to 64 bytes, so there's room left to move up to the next
+        //alignment unit
+        size_t offset;
+        unsigned char* data = (unsigned char*)stream->map(state, bytes + objectStride, &offset);
+        if(data)
+        {
+            size_t padding = (objectStride - offset % objectStride) % objectStride;
+            for(int i=0; i<count; i++)
+            {
+                memcpy(data + padding + i*objectStride, &models[i][0][0], sizeof(glm::mat4));
+            }
+            stream->unmap(state);
+            objectSource = stream->buffer();
+            objectOffset = offset + padding;
+            return;
+        }
+    }
+
+    staging.resize(bytes);
+    for(int i=0; i<count; i++)
+    {
+        memcpy(&staging[i*objectStride], &models[i][0][0], sizeof(glm::mat4));
+    }
+    state.bindBuffer(GL_UNIFORM_BUFFER, objectBuffer);
+    state.bufferData(GL_UNIFORM_BUFFER, bytes, staging.data(), GL_STREAM_DRAW);
+    objectSource = objectBuffer;
+    objectOffset = 0;
+}
+
+void UniformBlocks::bindObject(GLStateCache& state, int index)
+{
+    state.bindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK_BINDING, objectSource,
+                          objectOffset + index*objectStride, sizeof(glm::mat4));
+}
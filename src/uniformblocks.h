@@ -0,0 +1,62 @@
+#ifndef UNIFORM_BLOCKS_H
+#define UNIFORM_BLOCKS_H
+
+#include <vector>
+#include <stddef.h>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "glstate.h"
+
+// Uniform buffers for what the shaders need each frame, so that drawing an object doesn't take an
+// MVP worked out on the CPU and a glUniformMatrix4fv. The camera's matrices are written once per
+// frame into the Camera block, and the model matrices of everything about to be drawn are written
+// together into one buffer, with the Object block pointed at each object's in turn
+// (glBindBufferRange). The shaders multiply them together, so all the CPU does per object is copy
+// its model matrix
+
+// Binding points of the blocks (see bindProgram)
+#define CAMERA_BLOCK_BINDING 0
+#define OBJECT_BLOCK_BINDING 1
+
+// The Camera block, in std140 layout (a mat4 is 4 vec4 columns, so nothing needs padding)
+struct CameraBlock
+{
+    glm::mat4 viewProjection;
+    glm::mat4 view;
+    glm::mat4 projection;
+};
+
+class UniformBlocks
+{
+public:
+    UniformBlocks();
+
+    void create(GLStateCache& state);
+    void destroy(GLStateCache& state);
+
+    // Points the program's Camera and Object blocks (whichever it has) at their binding points.
+    // Has to be done for every program that uses them, after linking or loading it
+    static void bindProgram(GLuint program);
+
+    // Replaces the Camera block. Call it once per frame, before anything is drawn
+    void setCamera(GLStateCache& state, const glm::mat4& view, const glm::mat4& projection);
+
+    // Writes the model matrices of the objects about to be drawn, each at a multiple of
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. They go into the state cache's stream buffer when it has
+    // one (and they fit), and into a buffer of the blocks' own otherwise
+    void setObjects(GLStateCache& state, const glm::mat4* models, int count);
+    // Points the Object block at the model matrix at index of the last setObjects
+    void bindObject(GLStateCache& state, int index);
+
+private:
+    GLuint cameraBuffer;
+    GLuint objectBuffer;
+    GLuint objectSource;//buffer the last setObjects wrote into (objectBuffer or the stream buffer)
+    size_t objectOffset;//where in it the first model matrix is
+    size_t objectStride;//bytes from one model matrix to the next
+    std::vector<unsigned char> staging;//model matrices spaced out for objectBuffer
+};
+
+#endif
@@ -0,0 +1,198 @@
+#include "vertexpack.h"
+
+#include <math.h>
+#include <string.h>
+
+uint16_t packHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if(((bits >> 23) & 0xff) == 0xff)
+    {
+        // Infinity stays infinity, and NaN stays NaN
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    }
+    if(exponent >= 31)
+    {
+        return sign | 0x7c00;
+    }
+    if(exponent <= 0)
+    {
+        // Too small for a normal half, so it becomes a denormal (or zero)
+        if(exponent < -10)
+        {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        // Round to nearest, ties to even
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if((remainder > halfway) || ((remainder == halfway) && (half & 1)))
+        {
+            half++;
+        }
+        return sign | half;
+    }
+
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1fff;
+    // NOTE: Rounding up can carry into the exponent, which is still the right answer (even when
+    //       it reaches infinity)
+    if((remainder > 0x1000) || ((remainder == 0x1000) && (half & 1)))
+    {
+        half++;
+    }
+    return sign | half;
+}
+
+float unpackHalf(uint16_t value)
+{
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+    if(exponent == 0)
+    {
+        float result = ldexpf((float)mantissa, -24);
+        return sign ? -result : result;
+    }
+    else if(exponent == 31)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+static int32_t quantizeSnorm(float value, int bits)
+{
+    float maximum = (float)((1 << (bits - 1)) - 1);
+    if(!(value > -1.0f))
+    {
+        value = -1.0f;
+    }
+    if(value > 1.0f)
+    {
+        value = 1.0f;
+    }
+    return (int32_t)lroundf(value*maximum);
+}
+
+uint32_t packSnorm1010102(float x, float y, float z, float w)
+{
+    return ((uint32_t)quantizeSnorm(x, 10) & 0x3ff) |
+           (((uint32_t)quantizeSnorm(y, 10) & 0x3ff) << 10) |
+           (((uint32_t)quantizeSnorm(z, 10) & 0x3ff) << 20) |
+           (((uint32_t)quantizeSnorm(w, 2) & 0x3) << 30);
+}
+
+void unpackSnorm1010102(uint32_t value, float result[4])
+{
+    // Sign extend each field by shifting it to the top of an int and back down
+    int32_t fields[4] =
+    {
+        (int32_t)(value << 22) >> 22,
+        (int32_t)(value << 12) >> 22,
+        (int32_t)(value << 2) >> 22,
+        (int32_t)value >> 30
+    };
+    for(int i=0; i<3; i++)
+    {
+        result[i] = fmaxf(fields[i]/511.0f, -1.0f);
+    }
+    result[3] = fmaxf((float)fields[3], -1.0f);
+}
+
+void packedPositionTransform(const float boundsMin[3], const float boundsMax[3],
+                             float scale[3], float offset[3])
+{
+    for(int k=0; k<3; k++)
+    {
+        // A flat box (e.g. a single triangle facing an axis) still needs an invertible scale
+        scale[k] = (boundsMax[k] > boundsMin[k]) ? boundsMax[k] - boundsMin[k] : 1.0f;
+        offset[k] = boundsMin[k];
+    }
+}
+
+PackedVertexLayout packedVertexLayout(bool hasTextureCoords, bool hasNormals, bool hasTangents)
+{
+    PackedVertexLayout layout;
+    layout.positionOffset = 0;
+    layout.stride = 4*sizeof(uint16_t);
+    layout.normalOffset = -1;
+    layout.tangentOffset = -1;
+    layout.texCoordOffset = -1;
+    if(hasNormals)
+    {
+        layout.normalOffset = layout.stride;
+        layout.stride += sizeof(uint32_t);
+    }
+    if(hasTangents)
+    {
+        layout.tangentOffset = layout.stride;
+        layout.stride += sizeof(uint32_t);
+    }
+    if(hasTextureCoords)
+    {
+        layout.texCoordOffset = layout.stride;
+        layout.stride += 2*sizeof(uint16_t);
+    }
+    return layout;
+}
+
+void packVertices(void* output, const PackedVertexLayout& layout, size_t vertexCount,
+                  const float* positions, const float* textureCoords, const float* normals,
+                  const float* tangents,
+                  const float boundsMin[3], const float boundsMax[3])
+{
+    float scale[3];
+    float offset[3];
+    packedPositionTransform(boundsMin, boundsMax, scale, offset);
+
+    // NOTE: Every attribute is 4-byte aligned within the vertex, and the stride is a multiple of
+    //       4, so they can be written directly
+    unsigned char* vertex = (unsigned char*)output;
+    for(size_t v=0; v<vertexCount; v++, vertex+=layout.stride)
+    {
+        uint16_t* position = (uint16_t*)(vertex + layout.positionOffset);
+        for(int k=0; k<3; k++)
+        {
+            float t = (positions[v*3 + k] - offset[k])/scale[k];
+            t = (t < 0.0f) ? 0.0f : ((t > 1.0f) ? 1.0f : t);
+            position[k] = (uint16_t)lroundf(t*65535.0f);
+        }
+        position[3] = 0;
+
+        const float* normal = normals ? &normals[v*3] : 0;
+        if(layout.normalOffset >= 0)
+        {
+            *(uint32_t*)(vertex + layout.normalOffset) =
+                packSnorm1010102(normal[0], normal[1], normal[2], 0.0f);
+        }
+
+        if(layout.tangentOffset >= 0)
+        {
+            const float* tangent = &tangents[v*4];
+            *(uint32_t*)(vertex + layout.tangentOffset) =
+                packSnorm1010102(tangent[0], tangent[1], tangent[2], tangent[3]);
+        }
+
+        if(layout.texCoordOffset >= 0)
+        {
+            uint16_t* texCoord = (uint16_t*)(vertex + layout.texCoordOffset);
+            texCoord[0] = packHalf(textureCoords[v*2]);
+            texCoord[1] = packHalf(textureCoords[v*2 + 1]);
+        }
+    }
+}
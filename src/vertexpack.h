@@ -0,0 +1,47 @@
+#ifndef VERTEX_PACK_H
+#define VERTEX_PACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// A compact interleaved vertex format. Every attribute maps straight onto a vertex format OpenGL
+// 3.3 can fetch, so shaders see ordinary floats:
+//  - Position within the mesh's bounding box as four 16-bit unsigned normalized values (0..1 on
+//    each axis, to be scaled back with the transform from packedPositionTransform). The fourth is
+//    padding that keeps the attributes after it aligned
+//  - Normal and tangent as signed normalized 10:10:10:2 (GL_INT_2_10_10_10_REV). The tangent's w
+//    is the handedness of the tangent frame, so the bitangent is cross(normal, tangent)*w
+//  - Texture coordinates as two half floats
+// Attributes the mesh doesn't have take no space, so a vertex with everything is 20 bytes against
+// the 48 it takes in the separate float arrays of GeometryData, and positions alone are 8 bytes
+
+// Byte offsets of each attribute in a packed vertex, or -1 when it isn't there
+struct PackedVertexLayout
+{
+    int stride;
+    int positionOffset;
+    int normalOffset;
+    int tangentOffset;
+    int texCoordOffset;
+};
+
+PackedVertexLayout packedVertexLayout(bool hasTextureCoords, bool hasNormals, bool hasTangents);
+
+uint16_t packHalf(float value);
+float unpackHalf(uint16_t value);
+uint32_t packSnorm1010102(float x, float y, float z, float w);
+void unpackSnorm1010102(uint32_t value, float result[4]);
+
+// Scale and offset that take packed positions (0..1) back to model space: p*scale + offset
+void packedPositionTransform(const float boundsMin[3], const float boundsMax[3],
+                             float scale[3], float offset[3]);
+
+// Packs vertexCount vertices into output, which needs room for vertexCount*layout.stride bytes.
+// Arrays for attributes that aren't in the layout are ignored. Tangents are 4 floats each, with
+// the handedness in w, as GeometryData has them
+void packVertices(void* output, const PackedVertexLayout& layout, size_t vertexCount,
+                  const float* positions, const float* textureCoords, const float* normals,
+                  const float* tangents,
+                  const float boundsMin[3], const float boundsMax[3]);
+
+#endif